@@ -1414,6 +1414,8 @@ Emits all entities, particles, and lights to the refresh
 */
 void CL_AddEntities(void)
 {
+    unsigned int stage_start;
+
     if (cls.state != ca_active)
         return;
 
@@ -1445,14 +1447,18 @@ void CL_AddEntities(void)
 
     CL_CalcViewValues();
     // PMM - moved this here so the heat beam has the right values for the vieworg, and can lock the beam to the gun
+    stage_start = CL_TimeDemoStageBegin();
     CL_AddPacketEntities(&cl.frame);
+    CL_TimeDemoStageEnd(TDSTAGE_ENTITIES, stage_start);
 #if 0
     CL_AddProjectiles ();
 #endif
+    stage_start = CL_TimeDemoStageBegin();
     CL_AddTEnts();
     CL_AddParticles();
     CL_AddDLights();
     CL_AddLightStyles();
+    CL_TimeDemoStageEnd(TDSTAGE_EFFECTS, stage_start);
 }
 
 /*
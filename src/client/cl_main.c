@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // cl_main.c  -- client main loop
 
 #include "client.h"
+#include "common/q_prof.h"
 
 cvar_t * freelook;
 
@@ -59,6 +60,7 @@ cvar_t * cl_showclamp;
 
 cvar_t * cl_paused;
 cvar_t * cl_timedemo;
+cvar_t * cl_timedemo_quit;
 
 cvar_t * lookspring;
 cvar_t * lookstrafe;
@@ -619,6 +621,179 @@ void CL_ClearState(void)
     SZ_Clear(&cls.netchan.message);
 }
 
+/*
+=======================================================================
+
+TIMEDEMO BENCHMARK
+
+LAMPERT: Every frame rendered during a timedemo records its total
+time plus the time spent in each timedemo_stage_t. The samples are
+kept until the demo ends, so that we can report percentiles.
+
+=======================================================================
+*/
+
+// Sample column 0 is the whole frame, followed by the TDSTAGE_* timings.
+#define TDSTAT_FRAME 0
+#define TDSTAT_COUNT (TDSTAGE_COUNT + 1)
+
+typedef struct
+{
+    unsigned int usec[TDSTAT_COUNT];
+} timedemo_sample_t;
+
+static const char * cl_timedemo_stat_names[TDSTAT_COUNT] =
+{
+    "frame",
+    "parse",
+    "entities",
+    "effects",
+    "render"
+};
+
+static unsigned int cl_timedemo_stage_usec[TDSTAGE_COUNT];
+static timedemo_sample_t * cl_timedemo_samples;
+static int cl_timedemo_num_samples;
+static int cl_timedemo_max_samples;
+
+/*
+=====================
+CL_TimeDemoStageBegin
+=====================
+*/
+unsigned int CL_TimeDemoStageBegin(void)
+{
+    return cl_timedemo->value ? Sys_Microseconds() : 0;
+}
+
+/*
+=====================
+CL_TimeDemoStageEnd
+=====================
+*/
+void CL_TimeDemoStageEnd(timedemo_stage_t stage, unsigned int start_us)
+{
+    if (cl_timedemo->value)
+    {
+        cl_timedemo_stage_usec[stage] += Sys_Microseconds() - start_us;
+    }
+}
+
+/*
+=====================
+CL_TimeDemoEndFrame
+
+Records a sample once the demo has started rendering (cl.timedemo_start set).
+=====================
+*/
+void CL_TimeDemoEndFrame(unsigned int frame_start_us)
+{
+    int i;
+    timedemo_sample_t * sample;
+
+    if (cl_timedemo->value && cl.timedemo_start)
+    {
+        if (cl_timedemo_num_samples == cl_timedemo_max_samples)
+        {
+            timedemo_sample_t * old_samples = cl_timedemo_samples;
+
+            cl_timedemo_max_samples = (cl_timedemo_max_samples > 0) ? (cl_timedemo_max_samples * 2) : 4096;
+            cl_timedemo_samples = Z_Malloc(cl_timedemo_max_samples * sizeof(timedemo_sample_t));
+
+            if (old_samples != NULL)
+            {
+                memcpy(cl_timedemo_samples, old_samples, cl_timedemo_num_samples * sizeof(timedemo_sample_t));
+                Z_Free(old_samples);
+            }
+        }
+
+        sample = &cl_timedemo_samples[cl_timedemo_num_samples++];
+        sample->usec[TDSTAT_FRAME] = Sys_Microseconds() - frame_start_us;
+
+        for (i = 0; i < TDSTAGE_COUNT; ++i)
+        {
+            sample->usec[i + 1] = cl_timedemo_stage_usec[i];
+        }
+    }
+
+    memset(cl_timedemo_stage_usec, 0, sizeof(cl_timedemo_stage_usec));
+}
+
+static int CL_TimeDemoCompareUInt(const void * a, const void * b)
+{
+    const unsigned int ua = *(const unsigned int *)a;
+    const unsigned int ub = *(const unsigned int *)b;
+    return (ua < ub) ? -1 : ((ua > ub) ? 1 : 0);
+}
+
+/*
+=====================
+CL_TimeDemoReport
+
+Prints min/avg/p99/max for the frame and each stage, then
+writes the same table to <gamedir>/timedemo.csv and frees the samples.
+=====================
+*/
+void CL_TimeDemoReport(void)
+{
+    int i, s, n;
+    double total;
+    unsigned int * sorted;
+    char name[MAX_OSPATH];
+    FILE * f;
+
+    n = cl_timedemo_num_samples;
+    if (n == 0)
+    {
+        return;
+    }
+
+    Com_sprintf(name, sizeof(name), "%s/timedemo.csv", FS_Gamedir());
+    f = fopen(name, "w");
+    if (f)
+    {
+        fprintf(f, "stat,frames,min_ms,avg_ms,p99_ms,max_ms\n");
+    }
+
+    Com_Printf("stat       min ms   avg ms   p99 ms   max ms\n");
+    sorted = Z_Malloc(n * sizeof(unsigned int));
+
+    for (s = 0; s < TDSTAT_COUNT; ++s)
+    {
+        total = 0.0;
+        for (i = 0; i < n; ++i)
+        {
+            sorted[i] = cl_timedemo_samples[i].usec[s];
+            total += sorted[i];
+        }
+
+        qsort(sorted, n, sizeof(unsigned int), CL_TimeDemoCompareUInt);
+
+        Com_Printf("%-8s %8.3f %8.3f %8.3f %8.3f\n", cl_timedemo_stat_names[s],
+                   sorted[0] / 1000.0, total / n / 1000.0,
+                   sorted[(n - 1) * 99 / 100] / 1000.0, sorted[n - 1] / 1000.0);
+        if (f)
+        {
+            fprintf(f, "%s,%d,%.3f,%.3f,%.3f,%.3f\n", cl_timedemo_stat_names[s], n,
+                    sorted[0] / 1000.0, total / n / 1000.0,
+                    sorted[(n - 1) * 99 / 100] / 1000.0, sorted[n - 1] / 1000.0);
+        }
+    }
+
+    if (f)
+    {
+        fclose(f);
+        Com_Printf("Wrote %s\n", name);
+    }
+
+    Z_Free(sorted);
+    Z_Free(cl_timedemo_samples);
+
+    cl_timedemo_samples = NULL;
+    cl_timedemo_num_samples = 0;
+    cl_timedemo_max_samples = 0;
+}
+
 /*
 =====================
 CL_Disconnect
@@ -645,6 +820,14 @@ void CL_Disconnect(void)
             Com_Printf("%i frames, %3.1f seconds: %3.1f fps\n", cl.timedemo_frames,
                        time / 1000.0, cl.timedemo_frames * 1000.0 / time);
         }
+
+        CL_TimeDemoReport();
+
+        // For scripted benchmark runs.
+        if (cl_timedemo_quit->value)
+        {
+            Cbuf_AddText("quit\n");
+        }
     }
 
     VectorClear(cl.refdef.blend);
@@ -1005,6 +1188,8 @@ CL_ReadPackets
 */
 void CL_ReadPackets(void)
 {
+    unsigned int parse_start;
+
     while (NET_GetPacket(NS_CLIENT, &net_from, &net_message))
     {
         //  Com_Printf ("packet\n");
@@ -1038,7 +1223,9 @@ void CL_ReadPackets(void)
         if (!Netchan_Process(&cls.netchan, &net_message))
             continue; // wasn't accepted for some reason
 
+        parse_start = CL_TimeDemoStageBegin();
         CL_ParseServerMessage();
+        CL_TimeDemoStageEnd(TDSTAGE_PARSE, parse_start);
     }
 
     //
@@ -1423,8 +1610,14 @@ void CL_RequestNextDownload(void)
     }
 
     //ZOID
+    // LAMPERT: read ahead on the async loader and
+    // show the load progress on the loading plaque
+    FS_BeginLoadProgress();
+    CL_PrefetchRefresh();
     CL_RegisterSounds();
     CL_PrepRefresh();
+    FS_AsyncFlush();
+    FS_EndLoadProgress();
 
     MSG_WriteByte(&cls.netchan.message, clc_stringcmd);
     MSG_WriteString(&cls.netchan.message, va("begin %i\n", precache_spawncount));
@@ -1524,6 +1717,7 @@ void CL_InitLocal(void)
     cl_timeout = Cvar_Get("cl_timeout", "120", 0);
     cl_paused = Cvar_Get("paused", "0", 0);
     cl_timedemo = Cvar_Get("timedemo", "0", 0);
+    cl_timedemo_quit = Cvar_Get("timedemo_quit", "0", 0);
 
     rcon_client_password = Cvar_Get("rcon_password", "", 0);
     rcon_address = Cvar_Get("rcon_address", "", 0);
@@ -1732,6 +1926,7 @@ void CL_Frame(int msec)
 {
     static int extratime;
     static int lasttimecalled;
+    unsigned int frame_start, effects_start;
 
     if (dedicated->value)
     {
@@ -1752,6 +1947,8 @@ void CL_Frame(int msec)
         }
     }
 
+    frame_start = CL_TimeDemoStageBegin();
+
     // let the mouse activate or deactivate
     IN_Frame();
 
@@ -1814,16 +2011,22 @@ void CL_Frame(int msec)
     }
 
     // update audio
+    Prof_Begin("S_Update");
     S_Update(cl.refdef.vieworg, cl.v_forward, cl.v_right, cl.v_up);
+    Prof_End();
 
     CDAudio_Update();
 
     // advance local effects for next frame
+    effects_start = CL_TimeDemoStageBegin();
     CL_RunDLights();
     CL_RunLightStyles();
+    CL_TimeDemoStageEnd(TDSTAGE_EFFECTS, effects_start);
     SCR_RunCinematic();
     SCR_RunConsole();
 
+    CL_TimeDemoEndFrame(frame_start);
+
     cls.framecount++;
 
     if (log_stats->value)
@@ -189,6 +189,7 @@ void CL_RegisterSounds(void)
         Sys_SendKeyEvents(); // pump message loop
     }
     S_EndRegistration();
+    SCR_UpdateScreen(); // LAMPERT: the sounds are loaded by now, update the progress bar
 }
 
 /*
@@ -39,6 +39,9 @@ float scr_conlines;    // 0.0 to 1.0 lines of console to display
 
 qboolean scr_initialized; // ready to draw
 int scr_draw_loading;
+static qboolean scr_plaque_up;     // LAMPERT: the plaque was drawn and is still up
+static int scr_plaque_update_time; // LAMPERT: last progress bar redraw
+static int scr_plaque_drawn_bytes; // LAMPERT: load progress the bar shows
 vrect_t scr_vrect; // position of render window on screen
 
 cvar_t * scr_viewsize;
@@ -579,6 +582,9 @@ void SCR_BeginLoadingPlaque(void)
     SCR_UpdateScreen();
     cls.disable_screen = Sys_Milliseconds();
     cls.disable_servercount = cl.servercount;
+    scr_plaque_up = true;
+    scr_plaque_update_time = 0;
+    scr_plaque_drawn_bytes = 0;
 }
 
 /*
@@ -591,9 +597,69 @@ void SCR_EndLoadingPlaque(void)
     Com_DPrintf("*** SCR_EndLoadingPlaque ***\n");
 
     cls.disable_screen = 0;
+    scr_plaque_up = false;
     Con_ClearNotify();
 }
 
+/*
+================
+SCR_UpdateLoadingPlaque
+
+LAMPERT: Redraws the loading plaque with a progress bar under it,
+from the byte counts the file system collects while loading.
+Called by SCR_UpdateScreen while the plaque is up, which the
+registration code does between loading each thing, so it only
+redraws when the count moved, and a few times per second at most.
+================
+*/
+void SCR_UpdateLoadingPlaque(void)
+{
+    enum
+    {
+        PLAQUE_UPDATE_MSEC = 100,
+        PLAQUE_BAR_HEIGHT  = 4,
+        PLAQUE_BAR_COLOR   = 15, // white
+        PLAQUE_BACK_COLOR  = 8   // gray
+    };
+
+    int w, h, x, y;
+    int done, total;
+    int now;
+
+    if (!scr_plaque_up || !cls.disable_screen)
+    {
+        return;
+    }
+
+    now = Sys_Milliseconds();
+    if (now - scr_plaque_update_time < PLAQUE_UPDATE_MSEC)
+    {
+        return;
+    }
+    scr_plaque_update_time = now;
+
+    FS_GetLoadProgress(&done, &total);
+    if (total <= 0 || done == scr_plaque_drawn_bytes)
+    {
+        return;
+    }
+    scr_plaque_drawn_bytes = done;
+    if (done > total)
+    {
+        done = total; // reads outside FS_LoadFile aren't in the total
+    }
+
+    re.DrawGetPicSize(&w, &h, "loading");
+    x = (viddef.width - w) / 2;
+    y = (viddef.height - h) / 2;
+
+    re.BeginFrame(0);
+    re.DrawPic(x, y, "loading");
+    re.DrawFill(x, y + h + PLAQUE_BAR_HEIGHT, w, PLAQUE_BAR_HEIGHT, PLAQUE_BACK_COLOR);
+    re.DrawFill(x, y + h + PLAQUE_BAR_HEIGHT, (int)((float)w * done / total), PLAQUE_BAR_HEIGHT, PLAQUE_BAR_COLOR);
+    re.EndFrame();
+}
+
 /*
 ================
 SCR_Loading_f
@@ -1282,6 +1348,7 @@ void SCR_UpdateScreen(void)
             cls.disable_screen = 0;
             Com_Printf("Loading plaque timed out.\n");
         }
+        SCR_UpdateLoadingPlaque(); // LAMPERT: only the progress bar
         return;
     }
 
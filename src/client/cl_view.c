@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // cl_view.c -- player rendering positioning
 
 #include "client.h"
+#include "common/q_ltrace.h"
 
 //=============
 //
@@ -36,6 +37,7 @@ cvar_t * cl_testentities;
 cvar_t * cl_testlights;
 cvar_t * cl_testblend;
 cvar_t * cl_stats;
+cvar_t * cl_prefetch; // LAMPERT: CL_PrefetchRefresh on/off
 
 int r_numdlights;
 dlight_t r_dlights[MAX_DLIGHTS];
@@ -245,6 +247,52 @@ void V_TestLights(void)
 
 //===================================================================
 
+/*
+=================
+CL_PrefetchRefresh
+
+LAMPERT: Queues the map, models and pics CL_PrepRefresh is about
+to register on the async loader, so they are read in the background
+while the previous ones are parsed. The renderer still loads them
+with FS_LoadFile, which picks up the prefetched buffers. Anything
+it doesn't ask for (already cached) is dropped by FS_AsyncFlush.
+Off with 'cl_prefetch 0', which the null refresh sets since it
+doesn't load any of them.
+=================
+*/
+void CL_PrefetchRefresh(void)
+{
+    int i;
+    const char * name;
+
+    if (!cl_prefetch->value)
+    {
+        return;
+    }
+
+    for (i = 1; i < MAX_MODELS && cl.configstrings[CS_MODELS + i][0]; i++)
+    {
+        name = cl.configstrings[CS_MODELS + i];
+        if (name[0] != '*' && name[0] != '#')
+        {
+            FS_AsyncQueue(name, FS_PRIO_NORMAL, NULL, NULL);
+        }
+    }
+
+    for (i = 1; i < MAX_IMAGES && cl.configstrings[CS_IMAGES + i][0]; i++)
+    {
+        name = cl.configstrings[CS_IMAGES + i];
+        if (name[0] != '/' && name[0] != '\\')
+        {
+            FS_AsyncQueue(va("pics/%s.pcx", name), FS_PRIO_LOW, NULL, NULL);
+        }
+        else
+        {
+            FS_AsyncQueue(name + 1, FS_PRIO_LOW, NULL, NULL);
+        }
+    }
+}
+
 /*
 =================
 CL_PrepRefresh
@@ -355,6 +403,9 @@ void CL_PrepRefresh(void)
     // the renderer can now free unneeded stuff
     re.EndRegistration();
 
+    // LAMPERT: summary of the level load, if ltrace_enable is set
+    LTrace_Report(mapname);
+
     // clear any lines of console text
     Con_ClearNotify();
 
@@ -454,6 +505,7 @@ V_RenderView
 void V_RenderView(float stereo_separation)
 {
     extern int entitycmpfnc(const entity_t *, const entity_t *);
+    unsigned int render_start;
 
     if (cls.state != ca_active)
     {
@@ -564,7 +616,9 @@ void V_RenderView(float stereo_separation)
               (int (*)(const void *, const void *))entitycmpfnc);
     }
 
+    render_start = CL_TimeDemoStageBegin();
     re.RenderFrame(&cl.refdef);
+    CL_TimeDemoStageEnd(TDSTAGE_RENDER, render_start);
 
     if (cl_stats->value)
     {
@@ -614,4 +668,5 @@ void V_Init(void)
     cl_testentities = Cvar_Get("cl_testentities", "0", 0);
     cl_testlights = Cvar_Get("cl_testlights", "0", 0);
     cl_stats = Cvar_Get("cl_stats", "0", 0);
+    cl_prefetch = Cvar_Get("cl_prefetch", "1", 0);
 }
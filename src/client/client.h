@@ -428,6 +428,7 @@ void CL_AddLightStyles(void);
 //=================================================
 
 void CL_PrepRefresh(void);
+void CL_PrefetchRefresh(void);
 void CL_RegisterSounds(void);
 void CL_Quit_f(void);
 void CL_ParseLayout(void);
@@ -447,6 +448,26 @@ void CL_PingServers_f(void);
 void CL_Snd_Restart_f(void);
 void CL_RequestNextDownload(void);
 
+//
+// LAMPERT: Per-stage frame timings for the timedemo benchmark.
+// Stages are only timed while the timedemo cvar is set. The
+// report is printed and written to <gamedir>/timedemo.csv when
+// the demo finishes (see CL_TimeDemoReport).
+//
+typedef enum
+{
+    TDSTAGE_PARSE,    // CL_ParseServerMessage
+    TDSTAGE_ENTITIES, // CL_AddPacketEntities
+    TDSTAGE_EFFECTS,  // Particles, dlights, temp ents and light styles (cl_fx/cl_tent)
+    TDSTAGE_RENDER,   // re.RenderFrame from V_RenderView
+    TDSTAGE_COUNT
+} timedemo_stage_t;
+
+unsigned int CL_TimeDemoStageBegin(void);
+void CL_TimeDemoStageEnd(timedemo_stage_t stage, unsigned int start_us);
+void CL_TimeDemoEndFrame(unsigned int frame_start_us);
+void CL_TimeDemoReport(void);
+
 //
 // cl_input
 //
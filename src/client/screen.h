@@ -42,6 +42,7 @@ void SCR_SizeDown(void);
 void SCR_CenterPrint(const char * str);
 void SCR_BeginLoadingPlaque(void);
 void SCR_EndLoadingPlaque(void);
+void SCR_UpdateLoadingPlaque(void);
 void SCR_DebugGraph(float value, int color);
 void SCR_TouchPics(void);
 void SCR_RunConsole(void);
@@ -319,6 +319,7 @@ void S_EndRegistration(void)
     int i;
     sfx_t * sfx;
     int size;
+    char namebuffer[MAX_QPATH];
 
     // free any sounds not from this registration sequence
     for (i = 0, sfx = known_sfx; i < num_sfx; i++, sfx++)
@@ -342,12 +343,19 @@ void S_EndRegistration(void)
     }
 
     // load everything in
+    // LAMPERT: through the async loader, so the next files are read
+    // while the callbacks resample the previous ones. Sounds that can't
+    // be queued (e.g. two sexed sounds sharing a file) load the old way.
     for (i = 0, sfx = known_sfx; i < num_sfx; i++, sfx++)
     {
-        if (!sfx->name[0])
+        if (!sfx->name[0] || sfx->cache)
             continue;
-        S_LoadSound(sfx);
+        if (!S_SoundFileName(sfx, namebuffer, sizeof(namebuffer)))
+            continue;
+        if (!FS_AsyncQueue(namebuffer, FS_PRIO_HIGH, S_SoundLoaded, sfx))
+            S_LoadSound(sfx);
     }
+    FS_AsyncWait();
 
     s_registering = false;
 }
@@ -571,7 +579,6 @@ struct sfx_s * S_RegisterSexedSound(entity_state_t * ent, char * base)
     int n;
     char * p;
     struct sfx_s * sfx;
-    FILE * f;
     char model[MAX_QPATH];
     char sexedFilename[MAX_QPATH];
     char maleFilename[MAX_QPATH];
@@ -602,11 +609,10 @@ struct sfx_s * S_RegisterSexedSound(entity_state_t * ent, char * base)
     if (!sfx)
     {
         // no, so see if it exists
-        FS_FOpenFile(&sexedFilename[1], &f);
-        if (f)
+        // LAMPERT: just check for the file, no need to open it
+        if (FS_LoadFile(&sexedFilename[1], NULL) != -1)
         {
-            // yes, close the file and register it
-            FS_FCloseFile(f);
+            // yes, register it
             sfx = S_RegisterSound(sexedFilename);
         }
         else
@@ -146,6 +146,9 @@ extern cvar_t * s_primary;
 wavinfo_t GetWavinfo(char * name, byte * wav, int wavlength);
 void S_InitScaletable(void);
 sfxcache_t * S_LoadSound(sfx_t * s);
+qboolean S_SoundFileName(sfx_t * s, char * namebuffer, int size);
+sfxcache_t * S_DecodeSound(sfx_t * s, byte * data, int size);
+void S_SoundLoaded(const char * path, void * buffer, int length, void * user);
 void S_IssuePlaysound(playsound_t * ps);
 void S_PaintChannels(int endtime);
 
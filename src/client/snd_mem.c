@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "client.h"
 #include "snd_loc.h"
+#include "common/q_ltrace.h"
 
 int cache_full_cycle;
 
@@ -39,11 +40,14 @@ void ResampleSfx(sfx_t * sfx, int inrate, int inwidth, byte * data)
     int i;
     int sample, samplefrac, fracstep;
     sfxcache_t * sc;
+    unsigned int trace_start;
 
     sc = sfx->cache;
     if (!sc)
         return;
 
+    trace_start = LTrace_Start();
+
     stepscale = (float)inrate / dma.speed; // this is usually 0.5, 1, or 2
 
     outcount = sc->length / stepscale;
@@ -85,55 +89,54 @@ void ResampleSfx(sfx_t * sfx, int inrate, int inwidth, byte * data)
                 ((signed char *)sc->data)[i] = sample >> 8;
         }
     }
+
+    LTrace_Stage("wav", sfx->name, outcount * sc->width, trace_start);
 }
 
 //=============================================================================
 
 /*
 ==============
-S_LoadSound
+S_SoundFileName
+
+LAMPERT: Split from S_LoadSound, so that S_EndRegistration can queue
+the file on the async loader. Returns false for sounds with no file.
 ==============
 */
-sfxcache_t * S_LoadSound(sfx_t * s)
+qboolean S_SoundFileName(sfx_t * s, char * namebuffer, int size)
 {
-    char namebuffer[MAX_QPATH];
-    byte * data;
-    wavinfo_t info;
-    int len;
-    float stepscale;
-    sfxcache_t * sc;
-    int size;
     char * name;
 
     if (s->name[0] == '*')
-        return NULL;
-
-    // see if still in memory
-    sc = s->cache;
-    if (sc)
-        return sc;
+        return false;
 
-    //Com_Printf ("S_LoadSound: %x\n", (int)stackbuf);
-    // load it in
     if (s->truename)
         name = s->truename;
     else
         name = s->name;
 
     if (name[0] == '#')
-        strcpy(namebuffer, &name[1]);
+        Com_sprintf(namebuffer, size, "%s", &name[1]);
     else
-        Com_sprintf(namebuffer, sizeof(namebuffer), "sound/%s", name);
+        Com_sprintf(namebuffer, size, "sound/%s", name);
 
-    //	Com_Printf ("loading %s\n",namebuffer);
+    return true;
+}
 
-    size = FS_LoadFile(namebuffer, (void **)&data);
+/*
+==============
+S_DecodeSound
 
-    if (!data)
-    {
-        Com_DPrintf("Couldn't load %s\n", namebuffer);
-        return NULL;
-    }
+LAMPERT: Second half of S_LoadSound. Resamples the WAV file
+into the sound cache and frees the file buffer.
+==============
+*/
+sfxcache_t * S_DecodeSound(sfx_t * s, byte * data, int size)
+{
+    wavinfo_t info;
+    int len;
+    float stepscale;
+    sfxcache_t * sc;
 
     info = GetWavinfo(s->name, data, size);
     if (info.channels != 1)
@@ -168,6 +171,63 @@ sfxcache_t * S_LoadSound(sfx_t * s)
     return sc;
 }
 
+/*
+==============
+S_SoundLoaded
+
+LAMPERT: Async loader callback for S_EndRegistration.
+==============
+*/
+void S_SoundLoaded(const char * path, void * buffer, int length, void * user)
+{
+    sfx_t * s = (sfx_t *)user;
+
+    if (!buffer)
+    {
+        Com_DPrintf("Couldn't load %s\n", path);
+        return;
+    }
+    if (!s->cache)
+    {
+        S_DecodeSound(s, (byte *)buffer, length);
+    }
+    else
+    {
+        FS_FreeFile(buffer);
+    }
+}
+
+/*
+==============
+S_LoadSound
+==============
+*/
+sfxcache_t * S_LoadSound(sfx_t * s)
+{
+    char namebuffer[MAX_QPATH];
+    byte * data;
+    int size;
+
+    // see if still in memory
+    if (s->cache)
+        return s->cache;
+
+    if (!S_SoundFileName(s, namebuffer, sizeof(namebuffer)))
+        return NULL;
+
+    //	Com_Printf ("loading %s\n",namebuffer);
+
+    size = FS_LoadFile(namebuffer, (void **)&data);
+
+    if (!data)
+    {
+        Com_DPrintf("Couldn't load %s\n", namebuffer);
+        return NULL;
+    }
+
+    return S_DecodeSound(s, data, size);
+}
+
 /*
 ===============================================================================
 
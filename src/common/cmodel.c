@@ -73,6 +73,7 @@ mapsurface_t map_surfaces[MAX_MAP_TEXINFO];
 
 static int checkcount;
 static char map_name[MAX_QPATH];
+static unsigned map_checksum;
 
 static int numbrushsides;
 static cbrushside_t map_brushsides[MAX_MAP_BRUSHSIDES];
@@ -567,13 +568,12 @@ cmodel_t * CM_LoadMap(char * name, qboolean clientload, unsigned * checksum)
     int i;
     dheader_t header;
     int length;
-    static unsigned last_checksum;
 
     map_noareas = Cvar_Get("map_noareas", "0", 0);
 
     if (!strcmp(map_name, name) && (clientload || !Cvar_VariableValue("flushmap")))
     {
-        *checksum = last_checksum;
+        *checksum = map_checksum;
         if (!clientload)
         {
             memset(portalopen, 0, sizeof(portalopen));
@@ -608,8 +608,8 @@ cmodel_t * CM_LoadMap(char * name, qboolean clientload, unsigned * checksum)
     if (!buf)
         Com_Error(ERR_DROP, "Couldn't load %s", name);
 
-    last_checksum = LittleLong(Com_BlockChecksum(buf, length));
-    *checksum = last_checksum;
+    map_checksum = LittleLong(Com_BlockChecksum(buf, length));
+    *checksum = map_checksum;
 
     header = *(dheader_t *)buf;
     for (i = 0; i < sizeof(dheader_t) / 4; i++)
@@ -649,6 +649,24 @@ cmodel_t * CM_LoadMap(char * name, qboolean clientload, unsigned * checksum)
     return &map_cmodels[0];
 }
 
+/*
+==================
+CM_MapChecksum
+
+LAMPERT: Checksum of the loaded map, without reading it again.
+Returns false if 'name' isn't the map currently loaded.
+==================
+*/
+qboolean CM_MapChecksum(const char * name, unsigned * checksum)
+{
+    if (!map_name[0] || strcmp(map_name, name) != 0)
+    {
+        return false;
+    }
+    *checksum = map_checksum;
+    return true;
+}
+
 /*
 ==================
 CM_InlineModel
@@ -19,6 +19,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "common/q_common.h"
+#include "common/q_prof.h"
+#include "common/q_ltrace.h"
 #include <setjmp.h>
 
 //
@@ -1108,7 +1110,7 @@ enum
 
 typedef struct zhead_s
 {
-    struct zhead_s * prev;
+    struct zhead_s * prev; // both NULL if the block lives in a tag arena
     struct zhead_s * next;
     short magic;
     short tag; // for group free
@@ -1119,6 +1121,149 @@ static zhead_t z_chain;
 static int z_count;
 static int z_bytes;
 
+//
+// LAMPERT: Tag arenas.
+//
+// Tagged allocations (the game's TAG_GAME/TAG_LEVEL) are bump allocated
+// from per-tag chunks, so Z_FreeTags can drop a whole level by freeing a
+// handful of chunks instead of walking every block in z_chain. Z_Free
+// still works on arena blocks, but the memory is only reused if it was
+// the last block allocated; everything else is reclaimed by Z_FreeTags.
+// Blocks too big for a chunk are allocated individually and linked into
+// the arena's own chain. Tag 0 (Z_Malloc) stays in the global chain.
+//
+enum
+{
+    Z_MAX_ARENAS     = 4,
+    Z_ARENA_ALIGN    = 16,
+    Z_ARENA_CHUNK    = 32 * 1024,
+    Z_ARENA_BIG      = Z_ARENA_CHUNK / 4,
+    Z_ARENA_HDR_SIZE = 16 // sizeof(zchunk_t) rounded to Z_ARENA_ALIGN
+};
+
+typedef struct zchunk_s
+{
+    struct zchunk_s * next;
+    int size; // usable bytes after the header
+    int used;
+} zchunk_t;
+
+typedef struct
+{
+    int tag;
+    zchunk_t * chunks; // current chunk first
+    zhead_t big_chain; // blocks bigger than Z_ARENA_BIG
+    int num_chunks;
+    int count; // live blocks and bytes, including big ones
+    int bytes;
+} zarena_t;
+
+static zarena_t z_arenas[Z_MAX_ARENAS];
+static int z_num_arenas;
+
+static void Z_LinkBlock(zhead_t * chain, zhead_t * z)
+{
+    z->next = chain->next;
+    z->prev = chain;
+    chain->next->prev = z;
+    chain->next = z;
+}
+
+static zarena_t * Z_FindArena(int tag)
+{
+    int i;
+    for (i = 0; i < z_num_arenas; ++i)
+    {
+        if (z_arenas[i].tag == tag)
+        {
+            return &z_arenas[i];
+        }
+    }
+    return NULL;
+}
+
+static zarena_t * Z_FindOrCreateArena(int tag)
+{
+    zarena_t * arena = Z_FindArena(tag);
+    if (arena != NULL || tag == 0 || z_num_arenas == Z_MAX_ARENAS)
+    {
+        return arena;
+    }
+
+    arena = &z_arenas[z_num_arenas++];
+    memset(arena, 0, sizeof(*arena));
+    arena->tag = tag;
+    arena->big_chain.next = arena->big_chain.prev = &arena->big_chain;
+    return arena;
+}
+
+/*
+========================
+Z_ArenaAlloc
+
+Size already includes the zhead_t and is a multiple of Z_ARENA_ALIGN.
+Chunks are cleared when allocated, so the blocks come out zeroed.
+========================
+*/
+static zhead_t * Z_ArenaAlloc(zarena_t * arena, int size)
+{
+    zhead_t * z;
+    zchunk_t * chunk = arena->chunks;
+
+    if (chunk == NULL || chunk->used + size > chunk->size)
+    {
+        chunk = PS2_MemAllocAligned(Z_ARENA_ALIGN, Z_ARENA_HDR_SIZE + Z_ARENA_CHUNK, MEMTAG_QUAKE);
+        if (chunk == NULL)
+        {
+            Sys_Error("Z_Malloc: Failed to allocate a chunk for tag %i!", arena->tag);
+        }
+
+        memset(chunk, 0, Z_ARENA_HDR_SIZE + Z_ARENA_CHUNK);
+        chunk->size = Z_ARENA_CHUNK;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->num_chunks++;
+    }
+
+    z = (zhead_t *)((byte *)chunk + Z_ARENA_HDR_SIZE + chunk->used);
+    chunk->used += size;
+    return z;
+}
+
+/*
+========================
+Z_ArenaFree
+========================
+*/
+static void Z_ArenaFree(zhead_t * z)
+{
+    zarena_t * arena = Z_FindArena(z->tag);
+    zchunk_t * chunk;
+    const int size = z->size;
+
+    if (arena == NULL)
+    {
+        Sys_Error("Z_Free: No arena for tag %i", z->tag);
+    }
+
+    arena->count--;
+    arena->bytes -= size;
+    z_count--;
+    z_bytes -= size;
+
+    // Roll back the current chunk if this was the last block handed out.
+    chunk = arena->chunks;
+    if ((byte *)z + size == (byte *)chunk + Z_ARENA_HDR_SIZE + chunk->used)
+    {
+        chunk->used -= size;
+        memset(z, 0, size);
+    }
+    else
+    {
+        z->magic = 0; // catch double frees
+    }
+}
+
 /*
 ========================
 Z_Free
@@ -1133,12 +1278,28 @@ void Z_Free(void * ptr)
         Sys_Error("Z_Free: Bad magic 0x%X", z->magic);
     }
 
+    if (z->next == NULL)
+    {
+        Z_ArenaFree(z);
+        return;
+    }
+
     z->prev->next = z->next;
     z->next->prev = z->prev;
 
     z_count--;
     z_bytes -= z->size;
 
+    if (z->tag != 0)
+    {
+        zarena_t * arena = Z_FindArena(z->tag);
+        if (arena != NULL)
+        {
+            arena->count--;
+            arena->bytes -= z->size;
+        }
+    }
+
     PS2_MemFree(z, z->size, MEMTAG_QUAKE);
 }
 
@@ -1151,6 +1312,34 @@ void Z_FreeTags(int tag)
 {
     zhead_t * z;
     zhead_t * next;
+    zchunk_t * chunk;
+    zarena_t * arena = Z_FindArena(tag);
+
+    if (arena != NULL)
+    {
+        z_count -= arena->count;
+        z_bytes -= arena->bytes;
+
+        while ((chunk = arena->chunks) != NULL)
+        {
+            arena->chunks = chunk->next;
+            PS2_MemFree(chunk, Z_ARENA_HDR_SIZE + chunk->size, MEMTAG_QUAKE);
+        }
+
+        // Big blocks were already subtracted above with the rest.
+        for (z = arena->big_chain.next; z != &arena->big_chain; z = next)
+        {
+            next = z->next;
+            PS2_MemFree(z, z->size, MEMTAG_QUAKE);
+        }
+
+        arena->big_chain.next = arena->big_chain.prev = &arena->big_chain;
+        arena->num_chunks = 0;
+        arena->count = 0;
+        arena->bytes = 0;
+        return;
+    }
+
     for (z = z_chain.next; z != &z_chain; z = next)
     {
         next = z->next;
@@ -1169,27 +1358,41 @@ Z_TagMalloc
 void * Z_TagMalloc(int size, int tag)
 {
     zhead_t * z;
+    zarena_t * arena;
 
     size = size + sizeof(zhead_t);
-    z = PS2_MemAlloc(size, MEMTAG_QUAKE);
+    arena = Z_FindOrCreateArena(tag);
 
-    if (z == NULL)
+    if (arena != NULL && size <= Z_ARENA_BIG)
     {
-        Sys_Error("Z_Malloc: Failed on allocation of %i bytes!", size);
+        size = (size + Z_ARENA_ALIGN - 1) & ~(Z_ARENA_ALIGN - 1);
+        z = Z_ArenaAlloc(arena, size);
+        z->prev = z->next = NULL;
+    }
+    else
+    {
+        z = PS2_MemAlloc(size, MEMTAG_QUAKE);
+        if (z == NULL)
+        {
+            Sys_Error("Z_Malloc: Failed on allocation of %i bytes!", size);
+        }
+
+        memset(z, 0, size);
+        Z_LinkBlock((arena != NULL) ? &arena->big_chain : &z_chain, z);
+    }
+
+    if (arena != NULL)
+    {
+        arena->count++;
+        arena->bytes += size;
     }
 
-    memset(z, 0, size);
     z_count++;
     z_bytes += size;
     z->magic = Z_MAGIC;
     z->tag   = tag;
     z->size  = size;
 
-    z->next = z_chain.next;
-    z->prev = &z_chain;
-    z_chain.next->prev = z;
-    z_chain.next = z;
-
     return (void *)(z + 1);
 }
 
@@ -1203,6 +1406,23 @@ void * Z_Malloc(int size)
     return Z_TagMalloc(size, 0);
 }
 
+// LAMPERT: Slab allocator benchmark, from ps2/tests/test_mem_alloc.c
+void Test_PS2_MemAlloc(void);
+// LAMPERT: Compressed pak benchmark, from ps2/tests/test_pak_load.c
+void Test_PS2_PakLoad(void);
+// LAMPERT: 8bits texture conversion checks, from ps2/tests/test_tex_palette.c
+void Test_PS2_TexPalette(void);
+// LAMPERT: VRam texture cache checks, from ps2/tests/test_tex_vram.c
+void Test_PS2_TexVRam(void);
+// LAMPERT: Mipmap VRam layout checks, from ps2/tests/test_tex_mipmap.c
+void Test_PS2_TexMipmap(void);
+// LAMPERT: Packed VU1 vertex format checks, from ps2/tests/test_vert_pack.c
+void Test_PS2_VertPack(void);
+// LAMPERT: Bulk VU1 list writing benchmark, from ps2/tests/test_vu1_list.c
+void Test_PS2_VU1ListBench(void);
+// LAMPERT: Cached world visible sets checks, from ps2/tests/test_world_vis.c
+void Test_PS2_WorldVis(void);
+
 /*
 ========================
 Z_Stats_f
@@ -1210,7 +1430,17 @@ Z_Stats_f
 */
 void Z_Stats_f(void)
 {
+    int i;
+    const zarena_t * arena;
+
     Com_Printf("%i bytes in %i blocks\n", z_bytes, z_count);
+
+    for (i = 0; i < z_num_arenas; ++i)
+    {
+        arena = &z_arenas[i];
+        Com_Printf("  tag %i: %i bytes in %i blocks, %i chunks\n",
+                   arena->tag, arena->bytes, arena->count, arena->num_chunks);
+    }
 }
 
 //============================================================================
@@ -1458,7 +1688,17 @@ void Qcommon_Init(int argc, char ** argv)
     // init commands and vars
     //
     Cmd_AddCommand("z_stats", Z_Stats_f);
+    Cmd_AddCommand("mem_bench", Test_PS2_MemAlloc); // LAMPERT: See ps2/tests/test_mem_alloc.c
+    Cmd_AddCommand("pak_bench", Test_PS2_PakLoad);  // LAMPERT: See ps2/tests/test_pak_load.c
+    Cmd_AddCommand("texpal_test", Test_PS2_TexPalette); // LAMPERT: See ps2/tests/test_tex_palette.c
+    Cmd_AddCommand("texvram_test", Test_PS2_TexVRam);   // LAMPERT: See ps2/tests/test_tex_vram.c
+    Cmd_AddCommand("texmip_test", Test_PS2_TexMipmap);  // LAMPERT: See ps2/tests/test_tex_mipmap.c
+    Cmd_AddCommand("vertpack_test", Test_PS2_VertPack); // LAMPERT: See ps2/tests/test_vert_pack.c
+    Cmd_AddCommand("vu1list_bench", Test_PS2_VU1ListBench); // LAMPERT: See ps2/tests/test_vu1_list.c
+    Cmd_AddCommand("worldvis_test", Test_PS2_WorldVis);     // LAMPERT: See ps2/tests/test_world_vis.c
     Cmd_AddCommand("error", Com_Error_f);
+    Prof_Init();
+    LTrace_Init();
 
     host_speeds = Cvar_Get("host_speeds", "0", 0);
     log_stats = Cvar_Get("log_stats", "0", 0);
@@ -1489,7 +1729,9 @@ void Qcommon_Init(int argc, char ** argv)
     SV_Init();
     CL_Init();
 
-    /*
+    // LAMPERT: The host builds (see 'make host-bench') take the startup
+    // map/demo from the command line, like the original PC code did.
+    #ifndef PS2_QUAKE
     // add + commands from command line
     if (!Cbuf_AddLateCommands())
     {
@@ -1510,10 +1752,11 @@ void Qcommon_Init(int argc, char ** argv)
         // so drop the loading plaque
         SCR_EndLoadingPlaque();
     }
-    */
+    #else // PS2_QUAKE
     //FIXME this is for temporary testing only! Restore the above once done!
     Cbuf_AddText("killserver ; maxclients 1 ; deathmatch 0 ; map fact3\n");
     Cbuf_Execute();
+    #endif // PS2_QUAKE
 
     Com_Printf("---- Quake II Initialized! ----\n");
 }
@@ -1533,6 +1776,9 @@ void Qcommon_Frame(int msec)
         return; // an ERR_DROP was thrown
     }
 
+    Prof_BeginFrame();
+    Prof_Begin("Qcommon_Frame");
+
     if (log_stats->modified)
     {
         log_stats->modified = false;
@@ -1601,14 +1847,18 @@ void Qcommon_Frame(int msec)
         time_before = Sys_Milliseconds();
     }
 
+    Prof_Begin("SV_Frame");
     SV_Frame(msec);
+    Prof_End();
 
     if (host_speeds->value)
     {
         time_between = Sys_Milliseconds();
     }
 
+    Prof_Begin("CL_Frame");
     CL_Frame(msec);
+    Prof_End();
 
     if (host_speeds->value)
     {
@@ -1628,6 +1878,9 @@ void Qcommon_Frame(int msec)
         Com_Printf("all:%3i sv:%3i gm:%3i cl:%3i rf:%3i\n",
                    all, sv, gm, cl, rf);
     }
+
+    Prof_End();
+    Prof_EndFrame();
 }
 
 /*
@@ -19,6 +19,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "common/q_common.h"
+#include "common/pak_lz.h"
+#include "common/q_ltrace.h"
+
+#ifndef _EE
+#include <unistd.h>   // pread()
+#include <sys/mman.h> // mmap()
+#define FS_USE_MMAP   // See FS_MapView()
+#endif // _EE
 
 //===========================================================================
 
@@ -47,14 +55,19 @@ typedef struct
     char name[MAX_QPATH];
     int filepos;
     int filelen;
+    int hash_next; // LAMPERT: next file in the same hash bucket, or -1
+    int complen;   // LAMPERT: bytes in the pak if compressed, 0 if stored
 } packfile_t;
 
 typedef struct pack_s
 {
     char filename[MAX_OSPATH];
-    FILE * handle;
+    FILE * handle;    // LAMPERT: kept open, all pak reads go through it
+    int handle_pos;   // LAMPERT: current offset of handle, to skip redundant seeks
     int numfiles;
     packfile_t * files;
+    int hash_size;    // LAMPERT: power of two
+    int * hash_table; // first file index for each bucket, or -1
 } pack_t;
 
 typedef struct filelink_s
@@ -88,6 +101,42 @@ static char fs_default_base_path[MAX_OSPATH] = "."; // Added for QPS2
 int file_from_pak = 0;
 cvar_t * fs_gamedirvar = NULL;
 
+// LAMPERT: Pak directory lookups go through a hash index unless
+// fs_pakhash is 0 (for comparing against the original linear search).
+// The counters are printed and reset by the 'fs_stats' command.
+static cvar_t * fs_pakhash;
+static int fs_pak_lookups;
+static int fs_pak_compares;
+static unsigned int fs_pak_lookup_usec;
+
+// LAMPERT: Bytes loaded from paks vs bytes actually read from
+// them, which differ for compressed entries. Also for 'fs_stats'.
+static unsigned int fs_pak_bytes_loaded;
+static unsigned int fs_pak_bytes_read;
+
+// Staging buffer for one compressed block, main thread only.
+static byte fs_pakz_stage[PAKZ_BLOCK_SIZE];
+
+#ifdef FS_USE_MMAP
+// LAMPERT: Pak entries returned by FS_LoadFile as private file
+// mappings instead of Z_Malloc copies, while fs_mmap is set.
+enum
+{
+    FS_MAX_MAPPED     = 64,       // Mapped loads alive at the same time; more are copied.
+    FS_MMAP_MIN_SIZE  = 16 * 1024 // Smaller files are cheaper to copy than to map.
+};
+typedef struct
+{
+    void * data; // What FS_LoadFile returned, or NULL if the slot is free
+    void * base; // Page aligned start of the mapping
+    size_t size;
+} fs_mapped_t;
+static fs_mapped_t fs_mapped[FS_MAX_MAPPED];
+static cvar_t * fs_mmap;
+static int fs_mapped_files;
+static unsigned int fs_mapped_bytes;
+#endif // FS_USE_MMAP
+
 /* ===========================================================================
 
 All of Quake's data access is through a hierarchical file system, but the contents of
@@ -195,26 +244,167 @@ int Developer_searchpath(int who)
     return 0;
 }
 
+/*
+================
+FS_HashPackName
+
+Case-insensitive, to match the Q_strcasecmp used for the lookup.
+================
+*/
+static unsigned int FS_HashPackName(const char * name)
+{
+    unsigned int hash = 0;
+    int c;
+
+    while ((c = *name++) != '\0')
+    {
+        if (c >= 'A' && c <= 'Z')
+        {
+            c += 'a' - 'A';
+        }
+        hash += c;
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+
+    hash += (hash << 3);
+    hash ^= (hash >> 11);
+    hash += (hash << 15);
+
+    return hash;
+}
+
+/*
+================
+FS_FindInPack
+
+Returns the first directory entry with the given name, or NULL.
+================
+*/
+static packfile_t * FS_FindInPack(pack_t * pak, const char * filename)
+{
+    int i;
+    packfile_t * found = NULL;
+    const unsigned int start = Sys_Microseconds();
+
+    fs_pak_lookups++;
+
+    if (fs_pakhash->value && pak->hash_table)
+    {
+        i = pak->hash_table[FS_HashPackName(filename) & (pak->hash_size - 1)];
+        for (; i != -1; i = pak->files[i].hash_next)
+        {
+            fs_pak_compares++;
+            if (!Q_strcasecmp(pak->files[i].name, filename))
+            {
+                found = &pak->files[i];
+                break;
+            }
+        }
+    }
+    else
+    {
+        for (i = 0; i < pak->numfiles; i++)
+        {
+            fs_pak_compares++;
+            if (!Q_strcasecmp(pak->files[i].name, filename))
+            {
+                found = &pak->files[i];
+                break;
+            }
+        }
+    }
+
+    fs_pak_lookup_usec += Sys_Microseconds() - start;
+    return found;
+}
+
+/*
+================
+FS_SetPakView
+================
+*/
+static int FS_SetPakView(fs_view_t * view, pack_t * pak, const packfile_t * pakfile)
+{
+    view->pak    = pak;
+    view->file   = NULL;
+    view->dir    = NULL;
+    view->offset = pakfile->filepos;
+    view->length = pakfile->filelen;
+    view->complen = pakfile->complen;
+    view->pos    = 0;
+    return view->length;
+}
+
+/*
+================
+FS_SetLooseView
+================
+*/
+static int FS_SetLooseView(fs_view_t * view, FILE * file, const char * dir)
+{
+    view->pak    = NULL;
+    view->file   = file;
+    view->dir    = dir;
+    view->offset = 0;
+    view->length = FS_filelength(file);
+    view->complen = 0;
+    view->pos    = 0;
+    return view->length;
+}
+
+/*
+================
+FS_SetNullView
+================
+*/
+static int FS_SetNullView(fs_view_t * view)
+{
+    memset(view, 0, sizeof(*view));
+    view->length = -1;
+    return -1;
+}
+
 /*
 ===========
-FS_FOpenFile
+FS_OpenPakView
 
-Finds the file in the search path.
-returns filesize and an open FILE *
-Used for streaming data out of either a pak file or
-a separate file.
+LAMPERT: Like FS_OpenView, but only looks in the given pak.
+===========
+*/
+int FS_OpenPakView(struct pack_s * pak, const char * filename, fs_view_t * view)
+{
+    const packfile_t * pakfile = FS_FindInPack(pak, filename);
+    if (!pakfile)
+    {
+        return FS_SetNullView(view);
+    }
+    return FS_SetPakView(view, pak, pakfile);
+}
+
+/*
+===========
+FS_OpenView
+
+LAMPERT: Finds the file in the search path. Files inside a pak are
+not opened again; the view just records where they are in the pak,
+and FS_ReadView reads them through the pak's own handle. Loose files
+get a FILE. Either way, release the view with FS_CloseView.
+
+Returns the file length, or -1 if not found.
 ===========
 */
 
 #ifndef NO_ADDONS
 
-int FS_FOpenFile(const char * filename, FILE ** file)
+int FS_OpenView(const char * filename, fs_view_t * view)
 {
     searchpath_t * search;
     char netpath[MAX_OSPATH];
     pack_t * pak;
+    packfile_t * pakfile;
     filelink_t * link;
-    int i;
+    FILE * file;
 
     file_from_pak = 0;
 
@@ -224,13 +414,13 @@ int FS_FOpenFile(const char * filename, FILE ** file)
         if (!strncmp(filename, link->from, link->fromlength))
         {
             Com_sprintf(netpath, sizeof(netpath), "%s%s", link->to, filename + link->fromlength);
-            *file = fopen(netpath, "rb");
-            if (*file)
+            file = fopen(netpath, "rb");
+            if (file)
             {
                 Com_DPrintf("Link file: %s\n", netpath);
-                return FS_filelength(*file);
+                return FS_SetLooseView(view, file, link->to);
             }
-            return -1;
+            return FS_SetNullView(view);
         }
     }
 
@@ -244,57 +434,46 @@ int FS_FOpenFile(const char * filename, FILE ** file)
         {
             // look through all the pak file elements
             pak = search->pack;
-            for (i = 0; i < pak->numfiles; i++)
+            pakfile = FS_FindInPack(pak, filename);
+            if (pakfile)
             {
-                if (!Q_strcasecmp(pak->files[i].name, filename))
-                {
-                    // found it!
-                    file_from_pak = 1;
-                    Com_DPrintf("PackFile: %s : %s\n", pak->filename, filename);
-
-                    // open a new file on the pakfile
-                    *file = fopen(pak->filename, "rb");
-                    if (!*file)
-                    {
-                        Com_Error(ERR_FATAL, "Couldn't reopen %s", pak->filename);
-                    }
-
-                    fseek(*file, pak->files[i].filepos, SEEK_SET);
-                    return pak->files[i].filelen;
-                }
+                // found it!
+                file_from_pak = 1;
+                Com_DPrintf("PackFile: %s : %s\n", pak->filename, filename);
+                return FS_SetPakView(view, pak, pakfile);
             }
         }
         else // check a file in the directory tree:
         {
             Com_sprintf(netpath, sizeof(netpath), "%s/%s", search->filename, filename);
 
-            *file = fopen(netpath, "rb");
-            if (!*file)
+            file = fopen(netpath, "rb");
+            if (!file)
             {
                 continue;
             }
 
             Com_DPrintf("FS_FOpenFile: %s\n", netpath);
 
-            return FS_filelength(*file);
+            return FS_SetLooseView(view, file, search->filename);
         }
     }
 
     Com_DPrintf("FS_FOpenFile: can't find %s\n", filename);
 
-    *file = NULL;
-    return -1;
+    return FS_SetNullView(view);
 }
 
 #else // NO_ADDONS
 
 // this is just for demos to prevent add on hacking
-int FS_FOpenFile(const char * filename, FILE ** file)
+int FS_OpenView(const char * filename, fs_view_t * view)
 {
     searchpath_t * search;
     char netpath[MAX_OSPATH];
     pack_t * pak;
-    int i;
+    packfile_t * pakfile;
+    FILE * file;
 
     file_from_pak = 0;
 
@@ -303,15 +482,15 @@ int FS_FOpenFile(const char * filename, FILE ** file)
     {
         Com_sprintf(netpath, sizeof(netpath), "%s/%s", FS_Gamedir(), filename);
 
-        *file = fopen(netpath, "rb");
-        if (!*file)
+        file = fopen(netpath, "rb");
+        if (!file)
         {
-            return -1;
+            return FS_SetNullView(view);
         }
 
         Com_DPrintf("FS_FOpenFile (NO_ADDONS): %s\n", netpath);
 
-        return FS_filelength(*file);
+        return FS_SetLooseView(view, file, FS_Gamedir());
     }
 
     for (search = fs_searchpaths; search; search = search->next)
@@ -324,39 +503,72 @@ int FS_FOpenFile(const char * filename, FILE ** file)
 
     if (!search)
     {
-        *file = NULL;
-        return -1;
+        return FS_SetNullView(view);
     }
 
     pak = search->pack;
-    for (i = 0; i < pak->numfiles; i++)
+    pakfile = FS_FindInPack(pak, filename);
+    if (pakfile)
     {
-        if (!Q_strcasecmp(pak->files[i].name, filename))
-        {
-            // found it!
-            file_from_pak = 1;
-            Com_DPrintf("PackFile: %s : %s\n", pak->filename, filename);
-
-            // open a new file on the pakfile
-            *file = fopen(pak->filename, "rb");
-            if (!*file)
-            {
-                Com_Error(ERR_FATAL, "Couldn't reopen %s", pak->filename);
-            }
-
-            fseek(*file, pak->files[i].filepos, SEEK_SET);
-            return pak->files[i].filelen;
-        }
+        // found it!
+        file_from_pak = 1;
+        Com_DPrintf("PackFile: %s : %s\n", pak->filename, filename);
+        return FS_SetPakView(view, pak, pakfile);
     }
 
     Com_DPrintf("FS_FOpenFile (NO_ADDONS): can't find %s\n", filename);
 
-    *file = NULL;
-    return -1;
+    return FS_SetNullView(view);
 }
 
 #endif // NO_ADDONS
 
+/*
+===========
+FS_FOpenFile
+
+Finds the file in the search path.
+returns filesize and an open FILE *
+Used for streaming data out of either a pak file or
+a separate file.
+===========
+*/
+int FS_FOpenFile(const char * filename, FILE ** file)
+{
+    fs_view_t view;
+
+    if (FS_OpenView(filename, &view) < 0)
+    {
+        *file = NULL;
+        return -1;
+    }
+
+    if (view.file)
+    {
+        *file = view.file;
+        return view.length;
+    }
+
+    // LAMPERT: the FILE would see the compressed blocks.
+    if (view.complen)
+    {
+        Com_Printf("FS_FOpenFile: %s is compressed in %s and can't be streamed\n",
+                   filename, view.pak->filename);
+        *file = NULL;
+        return -1;
+    }
+
+    // Streaming callers need a FILE of their own, positioned at the entry.
+    *file = fopen(view.pak->filename, "rb");
+    if (!*file)
+    {
+        Com_Error(ERR_FATAL, "Couldn't reopen %s", view.pak->filename);
+    }
+
+    fseek(*file, view.offset, SEEK_SET);
+    return view.length;
+}
+
 /*
 =================
 FS_Read
@@ -417,7 +629,7 @@ void FS_Read(void * buffer, int len, FILE * fp)
             Com_Error(ERR_FATAL, "FS_Read: -1 bytes read");
         }
 
-        // do some progress bar thing here...
+        FS_LoadProgress(read, 0); // LAMPERT: for the loading plaque
         remaining -= read;
         buf += read;
     }
@@ -430,10 +642,398 @@ void FS_Read(void * buffer, int len, FILE * fp)
         Com_Error(ERR_FATAL, "FS_Read: Unable to read requested size! Asked %u, got %u",
                   (unsigned)len, (unsigned)num_read);
     }
+    FS_LoadProgress(len, 0);
 
 #endif // FS_CHUNKED_FILE_READ
 }
 
+/*
+=================
+FS_TryReadPak
+
+LAMPERT: Reads from an absolute offset in the pak, using the
+handle opened by FS_LoadPackFile. The host build uses pread(),
+so this is safe to call from the async loader thread. The PS2
+libc has no positional reads, so seek only when the read doesn't
+continue from where the last one stopped. Returns false on errors.
+=================
+*/
+static qboolean FS_TryReadPak(pack_t * pak, int offset, void * buffer, int len)
+{
+#ifdef _EE
+    if (pak->handle_pos != offset)
+    {
+        fseek(pak->handle, offset, SEEK_SET);
+    }
+    if (fread(buffer, 1, len, pak->handle) != (size_t)len)
+    {
+        pak->handle_pos = -1;
+        return false;
+    }
+    pak->handle_pos = offset + len;
+    return true;
+#else // !_EE
+    byte * buf = (byte *)buffer;
+    const int fd = fileno(pak->handle);
+
+    while (len > 0)
+    {
+        const ssize_t num_read = pread(fd, buf, len, offset);
+        if (num_read <= 0)
+        {
+            return false;
+        }
+        buf += num_read;
+        offset += num_read;
+        len -= num_read;
+    }
+    return true;
+#endif // _EE
+}
+
+/*
+=================
+FS_ReadPak
+=================
+*/
+static void FS_ReadPak(pack_t * pak, int offset, void * buffer, int len)
+{
+    if (!FS_TryReadPak(pak, offset, buffer, len))
+    {
+        Com_Error(ERR_FATAL, "FS_ReadPak: Read error in %s at offset %i", pak->filename, offset);
+    }
+    FS_LoadProgress(len, 0);
+}
+
+/*
+=================
+FS_FetchCompressed
+
+LAMPERT: Gets 'len' bytes at 'offset' of a compressed pak entry,
+either from 'raw' if the whole entry was already read into memory,
+or from the pak into 'dst'. Returns NULL on read errors.
+=================
+*/
+static const byte * FS_FetchCompressed(const fs_view_t * view, const byte * raw, int offset, byte * dst, int len)
+{
+    if (raw)
+    {
+        return raw + (offset - view->offset);
+    }
+    return FS_TryReadPak(view->pak, offset, dst, len) ? dst : NULL;
+}
+
+/*
+=================
+FS_ReadCompressed
+
+LAMPERT: Decodes a compressed pak entry straight into 'buffer', one
+block at a time, so only a single compressed block is ever staged
+in 'stage' (PAKZ_BLOCK_SIZE bytes). If 'raw' is not NULL, it holds
+the whole compressed entry and nothing is read from the pak.
+Returns false on read errors or corrupt data.
+=================
+*/
+static qboolean FS_ReadCompressed(const fs_view_t * view, const byte * raw, byte * buffer, byte * stage, qboolean report_progress)
+{
+    byte header[4];
+    const byte * src;
+    unsigned int block_header;
+    int block_len, out_len;
+    int offset = view->offset;
+    const int end = view->offset + view->complen;
+    int remaining = view->length;
+
+    while (remaining > 0)
+    {
+        if (offset + 4 > end || !(src = FS_FetchCompressed(view, raw, offset, header, 4)))
+        {
+            return false;
+        }
+        block_header = src[0] | (src[1] << 8) | (src[2] << 16) | ((unsigned int)src[3] << 24);
+        block_len = block_header & ~PAKZ_BLOCK_STORED;
+        out_len = (remaining < PAKZ_BLOCK_SIZE) ? remaining : PAKZ_BLOCK_SIZE;
+        offset += 4;
+
+        if (offset + block_len > end)
+        {
+            return false;
+        }
+
+        if (block_header & PAKZ_BLOCK_STORED)
+        {
+            // Stored blocks go straight to the output.
+            if (block_len != out_len || !(src = FS_FetchCompressed(view, raw, offset, buffer, out_len)))
+            {
+                return false;
+            }
+            if (src != buffer)
+            {
+                memcpy(buffer, src, out_len);
+            }
+        }
+        else
+        {
+            if (block_len > PAKZ_BLOCK_SIZE || !(src = FS_FetchCompressed(view, raw, offset, stage, block_len)))
+            {
+                return false;
+            }
+            if (PakLZ_DecompressBlock(src, block_len, buffer, out_len) != out_len)
+            {
+                return false;
+            }
+        }
+
+        offset += block_len;
+        buffer += out_len;
+        remaining -= out_len;
+
+        if (report_progress)
+        {
+            FS_LoadProgress(out_len, 0);
+        }
+    }
+    return true;
+}
+
+/*
+=================
+FS_ReadView
+
+Reads the next 'len' bytes of the file.
+=================
+*/
+void FS_ReadView(fs_view_t * view, void * buffer, int len)
+{
+    if (len > view->length - view->pos)
+    {
+        Com_Error(ERR_FATAL, "FS_ReadView: Read past the end of the file");
+    }
+
+    if (view->complen)
+    {
+        // LAMPERT: compressed entries can only be read whole.
+        if (view->pos != 0 || len != view->length)
+        {
+            Com_Error(ERR_FATAL, "FS_ReadView: Partial read of compressed file in %s", view->pak->filename);
+        }
+        if (!FS_ReadCompressed(view, NULL, buffer, fs_pakz_stage, true))
+        {
+            Com_Error(ERR_FATAL, "FS_ReadView: Corrupt compressed file in %s at offset %i",
+                      view->pak->filename, view->offset);
+        }
+    }
+    else if (view->pak)
+    {
+        FS_ReadPak(view->pak, view->offset + view->pos, buffer, len);
+    }
+    else
+    {
+        FS_Read(buffer, len, view->file);
+    }
+    view->pos += len;
+}
+
+/*
+=================
+FS_TryReadView
+
+LAMPERT: Reads the whole file into 'buffer' for the async loader.
+Unlike FS_ReadView, it returns false on errors instead of calling
+Com_Error and touches no shared state, so on the host it is safe
+to call from the loader thread. 'stage' is a PAKZ_BLOCK_SIZE buffer
+for compressed entries, private to the calling thread, or NULL to
+use the main thread's.
+=================
+*/
+qboolean FS_TryReadView(const fs_view_t * view, void * buffer, void * stage)
+{
+    if (view->length <= 0)
+    {
+        return view->length == 0;
+    }
+
+    if (view->complen)
+    {
+        return FS_ReadCompressed(view, NULL, buffer, stage ? stage : fs_pakz_stage, false);
+    }
+    if (view->pak)
+    {
+        return FS_TryReadPak(view->pak, view->offset, buffer, view->length);
+    }
+    return view->file && fread(buffer, 1, view->length, view->file) == (size_t)view->length;
+}
+
+/*
+=================
+FS_DecodeView
+
+LAMPERT: Decodes a compressed pak entry whose 'complen' bytes were
+read into 'raw' by other means (the PS2 async loader reads them on
+the IOP). Returns false on corrupt data.
+=================
+*/
+qboolean FS_DecodeView(const fs_view_t * view, const void * raw, void * buffer)
+{
+    return FS_ReadCompressed(view, raw, buffer, NULL, false);
+}
+
+/*
+=================
+FS_ViewLocation
+
+LAMPERT: Writes the OS path of the file holding the view's data
+and returns the offset its data starts at in that file, for reading
+it through other means. 'filename' is the name the view was opened
+with. Returns -1 for views of files that weren't found.
+=================
+*/
+int FS_ViewLocation(const fs_view_t * view, const char * filename, char * path, int path_size)
+{
+    const filelink_t * link;
+
+    if (view->pak)
+    {
+        Com_sprintf(path, path_size, "%s", view->pak->filename);
+        return view->offset;
+    }
+    if (!view->dir)
+    {
+        return -1;
+    }
+
+    // Same paths FS_OpenView opens loose files with.
+    for (link = fs_links; link; link = link->next)
+    {
+        if (view->dir == link->to)
+        {
+            Com_sprintf(path, path_size, "%s%s", link->to, filename + link->fromlength);
+            return 0;
+        }
+    }
+    Com_sprintf(path, path_size, "%s/%s", view->dir, filename);
+    return 0;
+}
+
+/*
+=================
+FS_CountPakRead
+
+LAMPERT: Adds a load from a pak to the 'fs_stats' byte counts.
+=================
+*/
+void FS_CountPakRead(const fs_view_t * view)
+{
+    if (view->pak)
+    {
+        fs_pak_bytes_loaded += view->length;
+        fs_pak_bytes_read += view->complen ? view->complen : view->length;
+    }
+}
+
+/*
+=================
+FS_CloseView
+=================
+*/
+void FS_CloseView(fs_view_t * view)
+{
+    if (view->file)
+    {
+        fclose(view->file);
+    }
+    memset(view, 0, sizeof(*view));
+}
+
+#ifdef FS_USE_MMAP
+/*
+=================
+FS_MapView
+
+LAMPERT: Maps a pak entry into memory. Each load gets its own private
+(copy-on-write) mapping, so the pages are shared with the OS file cache
+and nothing is copied, yet callers that write into the buffer (e.g. to
+terminate lines) still only change their own copy, as with Z_Malloc.
+Returns NULL if the entry should be loaded the normal way.
+=================
+*/
+static void * FS_MapView(const fs_view_t * view)
+{
+    int i;
+    long page_size;
+    long page_offset;
+    byte * base;
+
+    for (i = 0; i < FS_MAX_MAPPED; i++)
+    {
+        if (!fs_mapped[i].data)
+        {
+            break;
+        }
+    }
+    if (i == FS_MAX_MAPPED)
+    {
+        return NULL;
+    }
+
+    page_size = sysconf(_SC_PAGESIZE);
+    page_offset = view->offset % page_size;
+
+    base = mmap(NULL, view->length + page_offset, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                fileno(view->pak->handle), view->offset - page_offset);
+    if (base == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    fs_mapped[i].base = base;
+    fs_mapped[i].size = view->length + page_offset;
+    fs_mapped[i].data = base + page_offset;
+
+    fs_mapped_files++;
+    fs_mapped_bytes += view->length;
+    return fs_mapped[i].data;
+}
+
+/*
+=================
+FS_UnmapFile
+
+Returns false if the buffer wasn't mapped by FS_MapView.
+=================
+*/
+static qboolean FS_UnmapFile(void * buffer)
+{
+    int i;
+    for (i = 0; i < FS_MAX_MAPPED; i++)
+    {
+        if (fs_mapped[i].data == buffer)
+        {
+            munmap(fs_mapped[i].base, fs_mapped[i].size);
+            fs_mapped[i].data = NULL;
+            return true;
+        }
+    }
+    return false;
+}
+#endif // FS_USE_MMAP
+
+/*
+============
+FS_ViewSource
+
+LAMPERT: Name of the pak or directory a view reads from, for the load trace.
+============
+*/
+static const char * FS_ViewSource(const fs_view_t * view)
+{
+    if (view->pak)
+    {
+        return COM_SkipPath(view->pak->filename);
+    }
+    return view->dir ? COM_SkipPath((char *)view->dir) : "?";
+}
+
 /*
 ============
 FS_LoadFile
@@ -445,6 +1045,7 @@ a null buffer will just return the file length without loading
 int FS_LoadFile(const char * path, void ** buffer)
 {
     //FIXME TEMP, just for development/testing
+    #ifdef PS2_QUAKE
     if (strcmp(path, "maps/fact3.bsp") == 0)
     {
         extern unsigned int size_fact3_data;
@@ -455,36 +1056,66 @@ int FS_LoadFile(const char * path, void ** buffer)
         }
         return size_fact3_data;
     }
+    #endif // PS2_QUAKE
     //END TEMP
 
-    FILE * h;
+    fs_view_t view;
     byte * buf;
     int len;
+    unsigned int trace_start;
 
     buf = NULL; // quiet compiler warning
+    trace_start = LTrace_Start();
+
+    // LAMPERT: already read by the async loader?
+    if (buffer && FS_AsyncTake(path, buffer, &len))
+    {
+        LTrace_File(path, "async", len, trace_start);
+        return len;
+    }
 
     // look for it in the filesystem or pack files
-    len = FS_FOpenFile(path, &h);
-    if (!h)
+    len = FS_OpenView(path, &view);
+    if (len < 0)
     {
         if (buffer)
         {
             *buffer = NULL;
+            LTrace_File(path, NULL, -1, trace_start);
         }
         return -1;
     }
 
     if (!buffer)
     {
-        fclose(h);
+        FS_CloseView(&view);
         return len;
     }
 
+    FS_LoadProgress(0, len);
+    FS_CountPakRead(&view);
+
+#ifdef FS_USE_MMAP
+    if (view.pak && !view.complen && fs_mmap->value && len >= FS_MMAP_MIN_SIZE)
+    {
+        buf = FS_MapView(&view);
+        if (buf)
+        {
+            FS_LoadProgress(len, 0);
+            *buffer = buf;
+            LTrace_File(path, FS_ViewSource(&view), len, trace_start);
+            FS_CloseView(&view);
+            return len;
+        }
+    }
+#endif // FS_USE_MMAP
+
     buf = Z_Malloc(len);
     *buffer = buf;
 
-    FS_Read(buf, len, h);
-    fclose(h);
+    FS_ReadView(&view, buf, len);
+    LTrace_File(path, FS_ViewSource(&view), len, trace_start);
+    FS_CloseView(&view);
     return len;
 }
 
@@ -496,16 +1127,108 @@ FS_FreeFile
 void FS_FreeFile(void * buffer)
 {
     //FIXME TEMP, just for development/testing
+    #ifdef PS2_QUAKE
     extern unsigned char fact3_data[];
     if (buffer == fact3_data)
     {
         return;
     }
+    #endif // PS2_QUAKE
     //END TEMP
 
+    #ifdef FS_USE_MMAP
+    if (FS_UnmapFile(buffer))
+    {
+        return;
+    }
+    #endif // FS_USE_MMAP
+
     Z_Free(buffer);
 }
 
+/*
+=================
+FS_NewPack
+
+LAMPERT: Allocates the pack_t for a parsed directory and builds the
+hash index. Inserting backwards keeps each bucket in directory order,
+so duplicates resolve like before.
+=================
+*/
+static pack_t * FS_NewPack(const char * packfile, FILE * packhandle, packfile_t * files, int numpackfiles)
+{
+    int i;
+    pack_t * pack;
+
+    pack = Z_Malloc(sizeof(pack_t));
+    strcpy(pack->filename, packfile);
+    pack->handle = packhandle;
+    pack->handle_pos = -1; // unknown, seek on the first read
+    pack->numfiles = numpackfiles;
+    pack->files = files;
+
+    pack->hash_size = 16;
+    while (pack->hash_size < numpackfiles)
+    {
+        pack->hash_size <<= 1;
+    }
+    pack->hash_table = Z_Malloc(pack->hash_size * sizeof(int));
+    memset(pack->hash_table, 0xFF, pack->hash_size * sizeof(int));
+
+    for (i = numpackfiles - 1; i >= 0; i--)
+    {
+        const int bucket = FS_HashPackName(files[i].name) & (pack->hash_size - 1);
+        files[i].hash_next = pack->hash_table[bucket];
+        pack->hash_table[bucket] = i;
+    }
+
+    return pack;
+}
+
+/*
+=================
+FS_LoadCompressedPackFile
+
+LAMPERT: Directory of an IDPAKZHEADER pak. The entries are bigger than
+dpackfile_t, so they are read one by one instead of into a stack array.
+=================
+*/
+static pack_t * FS_LoadCompressedPackFile(const char * packfile, FILE * packhandle, dpackheader_t * header)
+{
+    int i;
+    int numpackfiles;
+    packfile_t * newfiles;
+    dpackzfile_t info;
+
+    header->dirofs = LittleLong(header->dirofs);
+    header->dirlen = LittleLong(header->dirlen);
+    numpackfiles = header->dirlen / sizeof(dpackzfile_t);
+
+    if (numpackfiles > MAX_FILES_IN_PACK)
+    {
+        Com_Error(ERR_FATAL, "%s has %i files", packfile, numpackfiles);
+    }
+
+    newfiles = Z_Malloc(numpackfiles * sizeof(packfile_t));
+    fseek(packhandle, header->dirofs, SEEK_SET);
+
+    for (i = 0; i < numpackfiles; i++)
+    {
+        if (fread(&info, 1, sizeof(info), packhandle) != sizeof(info))
+        {
+            Com_Error(ERR_FATAL, "%s has a truncated directory", packfile);
+        }
+        info.name[sizeof(info.name) - 1] = '\0';
+        strcpy(newfiles[i].name, info.name);
+        newfiles[i].filepos = LittleLong(info.filepos);
+        newfiles[i].filelen = LittleLong(info.filelen);
+        newfiles[i].complen = (LittleLong(info.flags) & PAKZ_COMPRESSED) ? LittleLong(info.complen) : 0;
+    }
+
+    Com_Printf("Added compressed packfile %s (%i files)\n", packfile, numpackfiles);
+    return FS_NewPack(packfile, packhandle, newfiles, numpackfiles);
+}
+
 /*
 =================
 FS_LoadPackFile
@@ -534,6 +1257,10 @@ pack_t * FS_LoadPackFile(char * packfile)
     }
 
     fread(&header, 1, sizeof(header), packhandle);
+    if (LittleLong(header.ident) == IDPAKZHEADER)
+    {
+        return FS_LoadCompressedPackFile(packfile, packhandle, &header);
+    }
     if (LittleLong(header.ident) != IDPAKHEADER)
     {
         Com_Error(ERR_FATAL, "%s is not a packfile", packfile);
@@ -571,16 +1298,25 @@ pack_t * FS_LoadPackFile(char * packfile)
         newfiles[i].filelen = LittleLong(info[i].filelen);
     }
 
-    pack = Z_Malloc(sizeof(pack_t));
-    strcpy(pack->filename, packfile);
-    pack->handle = packhandle;
-    pack->numfiles = numpackfiles;
-    pack->files = newfiles;
+    pack = FS_NewPack(packfile, packhandle, newfiles, numpackfiles);
 
     Com_Printf("Added packfile %s (%i files)\n", packfile, numpackfiles);
     return pack;
 }
 
+/*
+=================
+FS_FreePackFile
+=================
+*/
+void FS_FreePackFile(pack_t * pak)
+{
+    fclose(pak->handle);
+    Z_Free(pak->files);
+    Z_Free(pak->hash_table);
+    Z_Free(pak);
+}
+
 /*
 ================
 FS_AddGameDirectory
@@ -685,6 +1421,9 @@ void FS_SetGamedir(const char * dir)
         return;
     }
 
+    // LAMPERT: queued reads point into the paks about to be closed
+    FS_AsyncFlush();
+
     //
     // free up any current game dir info
     //
@@ -692,9 +1431,7 @@ void FS_SetGamedir(const char * dir)
     {
         if (fs_searchpaths->pack)
         {
-            fclose(fs_searchpaths->pack->handle);
-            Z_Free(fs_searchpaths->pack->files);
-            Z_Free(fs_searchpaths->pack);
+            FS_FreePackFile(fs_searchpaths->pack);
         }
         next = fs_searchpaths->next;
         Z_Free(fs_searchpaths);
@@ -912,6 +1649,38 @@ void FS_Path_f(void)
     }
 }
 
+/*
+============
+FS_Stats_f
+
+fs_stats [reset]
+============
+*/
+void FS_Stats_f(void)
+{
+    Com_Printf("%i pak lookups (%s), %i name compares, %.3f ms\n",
+               fs_pak_lookups, fs_pakhash->value ? "hashed" : "linear",
+               fs_pak_compares, fs_pak_lookup_usec / 1000.0);
+    Com_Printf("%u KB loaded from paks, %u KB read\n", fs_pak_bytes_loaded / 1024, fs_pak_bytes_read / 1024);
+#ifdef FS_USE_MMAP
+    Com_Printf("%i files mapped (%i KB)\n", fs_mapped_files, fs_mapped_bytes / 1024);
+#endif // FS_USE_MMAP
+    FS_AsyncPrintStats(Cmd_Argc() > 1 && !strcmp(Cmd_Argv(1), "reset"));
+
+    if (Cmd_Argc() > 1 && !strcmp(Cmd_Argv(1), "reset"))
+    {
+        fs_pak_lookups = 0;
+        fs_pak_compares = 0;
+        fs_pak_lookup_usec = 0;
+        fs_pak_bytes_loaded = 0;
+        fs_pak_bytes_read = 0;
+#ifdef FS_USE_MMAP
+        fs_mapped_files = 0;
+        fs_mapped_bytes = 0;
+#endif // FS_USE_MMAP
+    }
+}
+
 /*
 ================
 FS_NextPath
@@ -975,6 +1744,13 @@ void FS_InitFilesystem(void)
     Cmd_AddCommand("path", FS_Path_f);
     Cmd_AddCommand("link", FS_Link_f);
     Cmd_AddCommand("dir", FS_Dir_f);
+    Cmd_AddCommand("fs_stats", FS_Stats_f);
+
+    fs_pakhash = Cvar_Get("fs_pakhash", "1", 0);
+#ifdef FS_USE_MMAP
+    fs_mmap = Cvar_Get("fs_mmap", "1", 0);
+#endif // FS_USE_MMAP
+    FS_AsyncInit();
 
     //
     // basedir <path>
@@ -0,0 +1,933 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: fs_async.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Asynchronous file loading queue for the level registration phase,
+ *        plus the byte counters behind the loading plaque progress bar.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/q_common.h"
+#include "common/q_ltrace.h"
+#include "ps2/mem_alloc.h"
+
+//
+// Requests are queued with the file path, a priority and an optional
+// completion callback. The loader thread reads them into Z_Malloc'd buffers
+// in priority order while the main thread decodes whatever it loaded before.
+// Requests without a callback are prefetches: the buffer is held until
+// FS_LoadFile asks for that path, so the registration code doesn't need to
+// change at all to benefit from them.
+//
+// Only the reading happens in the loader thread. Path lookups, allocations
+// and callbacks all run on the main thread, since neither the search path
+// nor the zone allocator are thread safe. The amount of memory held by read
+// but unclaimed buffers is capped by 'fs_async_budget', and by what is left
+// in the zone's memory tag (see FS_AsyncBudget).
+//
+// The PS2 build reads ahead on the IOP instead, through the fileXio async
+// calls: a single read is in flight at a time, started and polled by
+// FS_AsyncDispatch from the main thread, so the EE keeps decoding while the
+// IOP reads. Compressed pak entries are read whole and decoded when the
+// read completes. With 'fs_async 0', requests are read on demand by the
+// main thread when they are claimed.
+//
+#ifdef _EE
+#include <fileXio_rpc.h>
+#include <fcntl.h>
+#define FS_ASYNC_IOP
+#else // !_EE
+#include <pthread.h>
+#define FS_ASYNC_THREADED
+#endif // _EE
+
+enum
+{
+    // Enough for every sound, model and image configstring of a level.
+    FS_ASYNC_MAX_REQUESTS = MAX_SOUNDS + MAX_MODELS + MAX_IMAGES
+};
+
+typedef enum
+{
+    FS_REQ_FREE,
+    FS_REQ_PENDING,    // Waiting to be handed to the loader thread.
+    FS_REQ_DISPATCHED, // Buffer allocated, in the loader thread's FIFO.
+    FS_REQ_READING,    // Being read by the loader thread, or by the IOP.
+    FS_REQ_DONE,
+    FS_REQ_FAILED
+} fs_req_state_t;
+
+typedef struct
+{
+    char path[MAX_QPATH];
+    fs_view_t view;
+    int length;
+    byte * buffer;
+    fs_priority_t priority;
+    unsigned int sequence; // Queue order, FIFO within the same priority.
+    fs_async_callback_t callback;
+    void * user;
+    fs_req_state_t state;
+} fs_request_t;
+
+static fs_request_t fs_requests[FS_ASYNC_MAX_REQUESTS];
+static int fs_num_requests; // Non-free entries, to skip the scan when idle.
+static unsigned int fs_request_sequence;
+static int fs_inflight_bytes; // Dispatched or read, but not claimed yet.
+
+static cvar_t * fs_async;
+static cvar_t * fs_async_budget; // In kilobytes.
+
+// Stats printed by 'fs_stats'.
+static int fs_async_queued;
+static int fs_async_hits;   // FS_LoadFile found the file already read.
+static int fs_async_waits;  // FS_LoadFile had to wait for the loader thread.
+static int fs_async_misses; // Queued, but loaded before the loader got to it.
+static int fs_async_wasted; // Prefetched but never asked for.
+static unsigned int fs_async_wait_usec;
+
+// Loading plaque progress, in bytes.
+static qboolean fs_progress_active;
+static int fs_progress_done;
+static int fs_progress_total;
+
+#ifdef FS_ASYNC_THREADED
+static pthread_t fs_loader_thread;
+static pthread_mutex_t fs_loader_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fs_loader_work  = PTHREAD_COND_INITIALIZER; // Signaled on dispatch.
+static pthread_cond_t fs_loader_done  = PTHREAD_COND_INITIALIZER; // Signaled when a read finishes.
+static qboolean fs_loader_started;
+
+// FIFO of dispatched request indexes, consumed by the loader thread.
+static int fs_loader_fifo[FS_ASYNC_MAX_REQUESTS];
+static int fs_loader_head;
+static int fs_loader_tail;
+
+// For compressed pak entries read by the loader thread.
+static byte fs_loader_stage[PAKZ_BLOCK_SIZE];
+#endif // FS_ASYNC_THREADED
+
+#ifdef FS_ASYNC_IOP
+static fs_request_t * fs_iop_request; // The read in flight on the IOP, if any.
+static byte * fs_iop_raw;             // Its compressed bytes, for compressed pak entries.
+static int fs_iop_fd = -1;            // File of the read in flight, or of fs_iop_pak.
+static const struct pack_s * fs_iop_pak; // Pak kept open between reads, if any.
+#endif // FS_ASYNC_IOP
+
+/*
+================
+FS_AsyncBudget
+
+Bytes that read but unclaimed buffers may hold. The buffers are
+Z_Malloc'd, so besides fs_async_budget, they get at most half of
+what MEMTAG_QUAKE has left (counting themselves), leaving the rest
+to the game and to the code decoding them.
+================
+*/
+static int FS_AsyncBudget(void)
+{
+    unsigned int footprint, in_use, tag_budget;
+    const int budget = (int)fs_async_budget->value * 1024;
+
+    PS2_MemGetSpaceUsage(MEMTAG_QUAKE, &footprint, &in_use, &tag_budget);
+    const int tag_share = ((int)(tag_budget - in_use) + fs_inflight_bytes) / 2;
+
+    return (tag_share < budget) ? tag_share : budget;
+}
+
+/*
+================
+FS_AsyncNextPending
+
+The pending request to read next, highest priority first, or NULL
+if there's none or the in-flight buffers wouldn't fit in 'budget'.
+At least one request is always let in flight, however big.
+================
+*/
+static fs_request_t * FS_AsyncNextPending(int budget)
+{
+    int i;
+    fs_request_t * req;
+    fs_request_t * best = NULL;
+
+    for (i = 0, req = fs_requests; i < FS_ASYNC_MAX_REQUESTS; ++i, ++req)
+    {
+        if (req->state != FS_REQ_PENDING)
+        {
+            continue;
+        }
+        if (!best || req->priority > best->priority ||
+            (req->priority == best->priority && req->sequence < best->sequence))
+        {
+            best = req;
+        }
+    }
+
+    if (!best || (fs_inflight_bytes > 0 && fs_inflight_bytes + best->length > budget))
+    {
+        return NULL;
+    }
+    return best;
+}
+
+/*
+================
+FS_AsyncPrepare
+
+Gets a pending request ready to be read: reopens loose files,
+which don't hold on to their FILE while queued, and allocates
+the buffer. Returns false, failing the request, if the file
+changed since it was queued.
+================
+*/
+static qboolean FS_AsyncPrepare(fs_request_t * req)
+{
+    if (req->length > 0 && !req->view.pak && FS_OpenView(req->path, &req->view) != req->length)
+    {
+        FS_CloseView(&req->view);
+        req->state = FS_REQ_FAILED;
+        return false;
+    }
+
+    req->buffer = Z_Malloc(req->length + 1);
+    fs_inflight_bytes += req->length;
+    return true;
+}
+
+/*
+================
+FS_AsyncReadRequest
+
+Reads a request on the calling thread. Returns the new state,
+which the loader thread sets while holding the lock. 'stage' is
+passed to FS_TryReadView.
+================
+*/
+static fs_req_state_t FS_AsyncReadRequest(fs_request_t * req, void * stage)
+{
+    return FS_TryReadView(&req->view, req->buffer, stage) ? FS_REQ_DONE : FS_REQ_FAILED;
+}
+
+#ifdef FS_ASYNC_THREADED
+
+/*
+================
+FS_LoaderThread
+================
+*/
+static void * FS_LoaderThread(void * arg)
+{
+    fs_request_t * req;
+    fs_req_state_t state;
+
+    (void)arg;
+    pthread_mutex_lock(&fs_loader_lock);
+    for (;;)
+    {
+        while (fs_loader_head == fs_loader_tail)
+        {
+            pthread_cond_wait(&fs_loader_work, &fs_loader_lock);
+        }
+
+        req = &fs_requests[fs_loader_fifo[fs_loader_head]];
+        fs_loader_head = (fs_loader_head + 1) % FS_ASYNC_MAX_REQUESTS;
+        req->state = FS_REQ_READING;
+        pthread_mutex_unlock(&fs_loader_lock);
+
+        state = FS_AsyncReadRequest(req, fs_loader_stage);
+
+        pthread_mutex_lock(&fs_loader_lock);
+        req->state = state;
+        pthread_cond_broadcast(&fs_loader_done);
+    }
+    return NULL;
+}
+
+/*
+================
+FS_AsyncDispatch
+
+Hands pending requests to the loader thread, highest priority
+first, as long as the in-flight buffers fit in the budget.
+At least one request is always in flight, however big.
+================
+*/
+static void FS_AsyncDispatch(void)
+{
+    fs_request_t * best;
+    int budget;
+
+    if (!fs_async->value)
+    {
+        return;
+    }
+
+    if (!fs_loader_started)
+    {
+        if (pthread_create(&fs_loader_thread, NULL, FS_LoaderThread, NULL) != 0)
+        {
+            Com_Printf("FS_AsyncDispatch: Failed to start the loader thread.\n");
+            Cvar_Set("fs_async", "0");
+            return;
+        }
+        pthread_detach(fs_loader_thread);
+        fs_loader_started = true;
+    }
+
+    budget = FS_AsyncBudget();
+    while ((best = FS_AsyncNextPending(budget)) != NULL)
+    {
+        if (!FS_AsyncPrepare(best))
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&fs_loader_lock);
+        best->state = FS_REQ_DISPATCHED;
+        fs_loader_fifo[fs_loader_tail] = best - fs_requests;
+        fs_loader_tail = (fs_loader_tail + 1) % FS_ASYNC_MAX_REQUESTS;
+        pthread_cond_signal(&fs_loader_work);
+        pthread_mutex_unlock(&fs_loader_lock);
+    }
+}
+
+/*
+================
+FS_AsyncWaitRequest
+
+Blocks until the loader thread is done with the request.
+Returns true if the read wasn't finished yet.
+================
+*/
+static qboolean FS_AsyncWaitRequest(fs_request_t * req)
+{
+    qboolean waited = false;
+
+    pthread_mutex_lock(&fs_loader_lock);
+    while (req->state == FS_REQ_DISPATCHED || req->state == FS_REQ_READING)
+    {
+        pthread_cond_wait(&fs_loader_done, &fs_loader_lock);
+        waited = true;
+    }
+    pthread_mutex_unlock(&fs_loader_lock);
+    return waited;
+}
+
+#define FS_AsyncLock()   pthread_mutex_lock(&fs_loader_lock)
+#define FS_AsyncUnlock() pthread_mutex_unlock(&fs_loader_lock)
+
+#elif defined(FS_ASYNC_IOP)
+
+/*
+================
+FS_AsyncIopClose
+
+Closes the file of the last read, unless it is
+the pak kept open for the next one.
+================
+*/
+static void FS_AsyncIopClose(qboolean keep_pak)
+{
+    if (fs_iop_fd >= 0 && !(keep_pak && fs_iop_pak))
+    {
+        fileXioClose(fs_iop_fd);
+        fs_iop_fd  = -1;
+        fs_iop_pak = NULL;
+    }
+}
+
+/*
+================
+FS_AsyncIopStart
+
+Starts reading the request on the IOP. The file is opened and
+seeked in blocking mode, which is quick, and only the read itself
+runs asynchronously. Returns false if the file couldn't be opened,
+so the request should be read on the main thread instead.
+================
+*/
+static qboolean FS_AsyncIopStart(fs_request_t * req)
+{
+    char path[MAX_OSPATH];
+    int offset;
+    int raw_len;
+
+    offset = FS_ViewLocation(&req->view, req->path, path, sizeof(path));
+    if (offset < 0)
+    {
+        return false;
+    }
+
+    if (!req->view.pak || req->view.pak != fs_iop_pak)
+    {
+        FS_AsyncIopClose(false);
+        fs_iop_fd = fileXioOpen(path, O_RDONLY, 0);
+        if (fs_iop_fd < 0)
+        {
+            fs_iop_fd = -1;
+            return false;
+        }
+        fs_iop_pak = req->view.pak;
+    }
+
+    if (fileXioLseek(fs_iop_fd, offset, SEEK_SET) != offset)
+    {
+        FS_AsyncIopClose(false);
+        return false;
+    }
+
+    raw_len = req->view.complen;
+    if (raw_len)
+    {
+        fs_iop_raw = Z_Malloc(raw_len);
+    }
+    else
+    {
+        raw_len = req->length;
+    }
+
+    fileXioSetBlockMode(FXIO_NOWAIT);
+    fileXioRead(fs_iop_fd, fs_iop_raw ? fs_iop_raw : req->buffer, raw_len);
+
+    req->state = FS_REQ_READING;
+    fs_iop_request = req;
+    return true;
+}
+
+/*
+================
+FS_AsyncIopFinish
+
+Completes the read in flight, given the result
+of fileXioRead, decoding compressed entries.
+================
+*/
+static void FS_AsyncIopFinish(int result)
+{
+    fs_request_t * req = fs_iop_request;
+    const int raw_len = req->view.complen ? req->view.complen : req->length;
+
+    fileXioSetBlockMode(FXIO_WAIT);
+    fs_iop_request = NULL;
+
+    if (result != raw_len)
+    {
+        req->state = FS_REQ_FAILED;
+    }
+    else if (fs_iop_raw)
+    {
+        req->state = FS_DecodeView(&req->view, fs_iop_raw, req->buffer) ? FS_REQ_DONE : FS_REQ_FAILED;
+    }
+    else
+    {
+        req->state = FS_REQ_DONE;
+    }
+
+    if (fs_iop_raw)
+    {
+        Z_Free(fs_iop_raw);
+        fs_iop_raw = NULL;
+    }
+    FS_AsyncIopClose(result == raw_len);
+}
+
+/*
+================
+FS_AsyncDispatch
+
+Completes the IOP read if it is done, then starts reading
+the next pending request that fits in the budget.
+================
+*/
+static void FS_AsyncDispatch(void)
+{
+    fs_request_t * best;
+    int result;
+
+    if (fs_iop_request)
+    {
+        if (fileXioWaitAsync(FXIO_NOWAIT, &result) != FXIO_COMPLETE)
+        {
+            return;
+        }
+        FS_AsyncIopFinish(result);
+    }
+
+    if (!fs_async->value)
+    {
+        return;
+    }
+
+    while ((best = FS_AsyncNextPending(FS_AsyncBudget())) != NULL)
+    {
+        if (!FS_AsyncPrepare(best))
+        {
+            continue;
+        }
+        if (!FS_AsyncIopStart(best))
+        {
+            // Read it now rather than stall the queue behind it.
+            best->state = FS_AsyncReadRequest(best, NULL);
+            fs_async_misses++;
+            continue;
+        }
+        break;
+    }
+}
+
+/*
+================
+FS_AsyncWaitRequest
+
+Blocks until the IOP is done with the request.
+Returns true if the read wasn't finished yet.
+================
+*/
+static qboolean FS_AsyncWaitRequest(fs_request_t * req)
+{
+    int result;
+
+    if (req != fs_iop_request)
+    {
+        return false;
+    }
+
+    fileXioWaitAsync(FXIO_WAIT, &result);
+    FS_AsyncIopFinish(result);
+    return true;
+}
+
+#define FS_AsyncLock()
+#define FS_AsyncUnlock()
+
+#endif // FS_ASYNC_THREADED
+
+/*
+================
+FS_AsyncFind
+================
+*/
+static fs_request_t * FS_AsyncFind(const char * path)
+{
+    int i;
+    fs_request_t * req;
+
+    for (i = 0, req = fs_requests; i < FS_ASYNC_MAX_REQUESTS; ++i, ++req)
+    {
+        if (req->state != FS_REQ_FREE && !Q_stricmp(req->path, path))
+        {
+            return req;
+        }
+    }
+    return NULL;
+}
+
+/*
+================
+FS_AsyncComplete
+
+Makes sure the request has been read, reading it on the main
+thread if the loader didn't get to it. Returns false if it
+couldn't be read. Only the main thread touches pending requests,
+so that state can be tested without the lock.
+================
+*/
+static qboolean FS_AsyncComplete(fs_request_t * req)
+{
+    unsigned int start;
+
+    if (req->state == FS_REQ_PENDING)
+    {
+        if (!FS_AsyncPrepare(req))
+        {
+            return false;
+        }
+        req->state = FS_AsyncReadRequest(req, NULL);
+        fs_async_misses++;
+    }
+    else
+    {
+        start = Sys_Microseconds();
+        if (FS_AsyncWaitRequest(req))
+        {
+            fs_async_wait_usec += Sys_Microseconds() - start;
+            fs_async_waits++;
+        }
+        else if (!req->callback)
+        {
+            fs_async_hits++;
+        }
+    }
+
+    return req->state == FS_REQ_DONE;
+}
+
+/*
+================
+FS_AsyncRelease
+
+Frees the request slot. The buffer is kept
+if 'keep_buffer' is set, otherwise freed.
+================
+*/
+static void FS_AsyncRelease(fs_request_t * req, qboolean keep_buffer)
+{
+    if (keep_buffer)
+    {
+        FS_CountPakRead(&req->view);
+    }
+    FS_CloseView(&req->view);
+
+    if (req->buffer)
+    {
+        fs_inflight_bytes -= req->length;
+        if (!keep_buffer)
+        {
+            Z_Free(req->buffer);
+        }
+    }
+
+    memset(req, 0, sizeof(*req));
+    fs_num_requests--;
+}
+
+/*
+================
+FS_AsyncQueue
+
+Returns false if the file doesn't exist, it is already
+queued or the queue is full. Callbacks run from FS_AsyncPump
+and take ownership of the buffer (free it with FS_FreeFile);
+a failed read calls back with a NULL buffer and -1 length.
+================
+*/
+qboolean FS_AsyncQueue(const char * path, fs_priority_t priority, fs_async_callback_t callback, void * user)
+{
+    int i;
+    int length;
+    fs_request_t * req;
+
+    if (strlen(path) >= MAX_QPATH || FS_AsyncFind(path))
+    {
+        return false;
+    }
+
+    for (i = 0, req = fs_requests; i < FS_ASYNC_MAX_REQUESTS; ++i, ++req)
+    {
+        if (req->state == FS_REQ_FREE)
+        {
+            break;
+        }
+    }
+    if (i == FS_ASYNC_MAX_REQUESTS)
+    {
+        return false;
+    }
+
+    length = FS_OpenView(path, &req->view);
+    if (length < 0)
+    {
+        return false;
+    }
+
+    // Don't hold on to a FILE for every queued loose file. Pak views
+    // have no handle of their own and stay valid until the gamedir changes.
+    if (req->view.file)
+    {
+        FS_CloseView(&req->view);
+    }
+
+    strcpy(req->path, path);
+    req->length   = length;
+    req->buffer   = NULL;
+    req->priority = priority;
+    req->sequence = fs_request_sequence++;
+    req->callback = callback;
+    req->user     = user;
+    req->state    = FS_REQ_PENDING;
+
+    fs_num_requests++;
+    fs_async_queued++;
+    FS_LoadProgress(0, length);
+
+    FS_AsyncDispatch();
+    return true;
+}
+
+/*
+================
+FS_AsyncPump
+
+Runs the callbacks of finished requests and keeps the loader
+thread busy. Call it from the main thread.
+================
+*/
+void FS_AsyncPump(void)
+{
+    int i, n;
+    int num_finished;
+    fs_request_t * req;
+    fs_async_callback_t callback;
+    void * user;
+    byte * buffer;
+    int length;
+    char path[MAX_QPATH];
+    static int finished[FS_ASYNC_MAX_REQUESTS];
+
+    if (fs_num_requests == 0)
+    {
+        return;
+    }
+
+    num_finished = 0;
+    FS_AsyncLock();
+    for (i = 0, req = fs_requests; i < FS_ASYNC_MAX_REQUESTS; ++i, ++req)
+    {
+        if (req->callback && (req->state == FS_REQ_DONE || req->state == FS_REQ_FAILED))
+        {
+            finished[num_finished++] = i;
+        }
+    }
+    FS_AsyncUnlock();
+
+    for (n = 0; n < num_finished; ++n)
+    {
+        req = &fs_requests[finished[n]];
+
+        // The callback may queue more requests, so release the slot first.
+        strcpy(path, req->path);
+        callback = req->callback;
+        user     = req->user;
+        length   = (req->state == FS_REQ_DONE) ? req->length : -1;
+        buffer   = (req->state == FS_REQ_DONE) ? req->buffer : NULL;
+        FS_AsyncRelease(req, buffer != NULL);
+
+        if (buffer)
+        {
+            FS_LoadProgress(length, 0);
+        }
+
+        // Read by the loader thread, so no time is charged here.
+        LTrace_File(path, "async", length, LTrace_Start());
+        callback(path, buffer, length, user);
+    }
+
+    FS_AsyncDispatch();
+}
+
+/*
+================
+FS_AsyncWait
+
+Runs until every request with a callback has completed.
+Prefetches are left for FS_LoadFile to pick up.
+================
+*/
+void FS_AsyncWait(void)
+{
+    int i;
+    fs_request_t * req;
+    fs_request_t * next;
+
+    for (;;)
+    {
+        FS_AsyncPump();
+
+        // Oldest outstanding callback request first, since
+        // that is the order the loader thread reads them in.
+        next = NULL;
+        for (i = 0, req = fs_requests; i < FS_ASYNC_MAX_REQUESTS; ++i, ++req)
+        {
+            if (req->state != FS_REQ_FREE && req->callback &&
+                (!next || req->sequence < next->sequence))
+            {
+                next = req;
+            }
+        }
+        if (!next)
+        {
+            break;
+        }
+
+        FS_AsyncComplete(next);
+    }
+}
+
+/*
+================
+FS_AsyncTake
+
+Called by FS_LoadFile. If the path was prefetched, hands over the
+buffer, waiting for the read to finish if needed. Returns false if
+the path isn't queued or the read failed, in which case the caller
+should load the file the normal way.
+================
+*/
+qboolean FS_AsyncTake(const char * path, void ** buffer, int * length)
+{
+    fs_request_t * req;
+    qboolean ok;
+
+    if (fs_num_requests == 0)
+    {
+        return false;
+    }
+
+    req = FS_AsyncFind(path);
+    if (!req || req->callback)
+    {
+        return false;
+    }
+
+    ok = FS_AsyncComplete(req);
+    if (ok)
+    {
+        *buffer = req->buffer;
+        *length = req->length;
+        FS_LoadProgress(req->length, 0);
+    }
+    FS_AsyncRelease(req, ok);
+
+    // The released budget can go to the next prefetches right away,
+    // so they are read while the caller decodes this one.
+    FS_AsyncDispatch();
+    return ok;
+}
+
+/*
+================
+FS_AsyncFlush
+
+Waits for the loader thread and drops every request,
+without running callbacks. Called once registration is
+over, and before the search path changes.
+================
+*/
+void FS_AsyncFlush(void)
+{
+    int i;
+    fs_request_t * req;
+
+    for (i = 0, req = fs_requests; i < FS_ASYNC_MAX_REQUESTS && fs_num_requests > 0; ++i, ++req)
+    {
+        if (req->state == FS_REQ_FREE)
+        {
+            continue;
+        }
+
+        FS_AsyncWaitRequest(req);
+        if (req->state == FS_REQ_DONE && !req->callback)
+        {
+            fs_async_wasted++;
+        }
+        FS_AsyncRelease(req, false);
+    }
+
+#ifdef FS_ASYNC_IOP
+    // The search path may change next, so don't keep the pak open.
+    FS_AsyncIopClose(false);
+#endif // FS_ASYNC_IOP
+}
+
+/*
+================
+FS_AsyncPrintStats
+
+For 'fs_stats [reset]'.
+================
+*/
+void FS_AsyncPrintStats(qboolean reset)
+{
+#ifdef FS_ASYNC_IOP
+    const char * mode = fs_async->value ? "IOP" : "on demand";
+#else // !FS_ASYNC_IOP
+    const char * mode = fs_async->value ? "threaded" : "on demand";
+#endif // FS_ASYNC_IOP
+
+    Com_Printf("%i async requests (%s): %i ready, %i waited for (%.3f ms), %i read on demand, %i unused\n",
+               fs_async_queued, mode,
+               fs_async_hits, fs_async_waits, fs_async_wait_usec / 1000.0,
+               fs_async_misses, fs_async_wasted);
+
+    if (reset)
+    {
+        fs_async_queued    = 0;
+        fs_async_hits      = 0;
+        fs_async_waits     = 0;
+        fs_async_misses    = 0;
+        fs_async_wasted    = 0;
+        fs_async_wait_usec = 0;
+    }
+}
+
+/*
+================
+FS_AsyncInit
+================
+*/
+void FS_AsyncInit(void)
+{
+    fs_async = Cvar_Get("fs_async", "1", 0);
+    fs_async_budget = Cvar_Get("fs_async_budget", "4096", 0);
+}
+
+/*
+================
+FS_BeginLoadProgress
+
+Starts counting the bytes loaded for the loading plaque.
+================
+*/
+void FS_BeginLoadProgress(void)
+{
+    fs_progress_active = true;
+    fs_progress_done   = 0;
+    fs_progress_total  = 0;
+}
+
+/*
+================
+FS_EndLoadProgress
+================
+*/
+void FS_EndLoadProgress(void)
+{
+    fs_progress_active = false;
+}
+
+/*
+================
+FS_LoadProgress
+
+Called by the file system as files are opened ('total' bytes)
+and read ('done' bytes), and by the queue as prefetched files
+are queued and claimed. Only counts: the loading plaque draws
+the bar between registration steps (SCR_UpdateScreen), never
+from inside the file system, while the renderer or the sound
+system may be halfway through loading something.
+================
+*/
+void FS_LoadProgress(int done, int total)
+{
+    if (!fs_progress_active)
+    {
+        return;
+    }
+
+    fs_progress_done  += done;
+    fs_progress_total += total;
+}
+
+/*
+================
+FS_GetLoadProgress
+================
+*/
+void FS_GetLoadProgress(int * done, int * total)
+{
+    *done  = fs_progress_done;
+    *total = fs_progress_total;
+}
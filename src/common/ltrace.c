@@ -0,0 +1,407 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: ltrace.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Level load trace. See q_ltrace.h.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/q_common.h"
+#include "common/q_ltrace.h"
+
+typedef enum
+{
+    LTRACE_FILE,
+    LTRACE_STAGE,
+    LTRACE_HIT,
+    LTRACE_MISS
+} ltrace_kind_t;
+
+typedef struct
+{
+    ltrace_kind_t kind;
+    const char * what;  // Stage or cache name. NULL for files.
+    char source[16];    // Pak or directory, files only.
+    char name[MAX_QPATH];
+    int bytes;
+    unsigned int usec;
+} ltrace_event_t;
+
+// Totals per source, stage or cache for the summary.
+typedef struct
+{
+    const char * name;
+    int count;
+    int misses; // Caches only.
+    unsigned int bytes;
+    unsigned int usec;
+} ltrace_total_t;
+
+enum
+{
+    LTRACE_MAX_TOTALS = 32
+};
+
+static cvar_t * ltrace_enable = NULL;
+static cvar_t * ltrace_csv    = NULL;
+static cvar_t * ltrace_top    = NULL;
+
+static ltrace_event_t ltrace_events[LTRACE_MAX_EVENTS];
+static int ltrace_num_events = 0;
+static int ltrace_dropped    = 0;
+
+// Time spent in traced file loads, taken out of the LTrace_Start clock.
+static unsigned int ltrace_file_usec = 0;
+
+/*
+================
+LTrace_NewEvent
+================
+*/
+static ltrace_event_t * LTrace_NewEvent(ltrace_kind_t kind, const char * what, const char * name)
+{
+    ltrace_event_t * ev;
+
+    if (ltrace_num_events == LTRACE_MAX_EVENTS)
+    {
+        ltrace_dropped++;
+        return NULL;
+    }
+
+    ev = &ltrace_events[ltrace_num_events++];
+    memset(ev, 0, sizeof(*ev));
+    ev->kind = kind;
+    ev->what = what;
+    strncpy(ev->name, name, sizeof(ev->name) - 1);
+    return ev;
+}
+
+/*
+================
+LTrace_Start
+================
+*/
+unsigned int LTrace_Start(void)
+{
+    if (ltrace_enable == NULL || !ltrace_enable->value)
+    {
+        return 0;
+    }
+    return Sys_Microseconds() - ltrace_file_usec;
+}
+
+/*
+================
+LTrace_File
+================
+*/
+void LTrace_File(const char * path, const char * source, int bytes, unsigned int start)
+{
+    ltrace_event_t * ev;
+    unsigned int usec;
+
+    if (ltrace_enable == NULL || !ltrace_enable->value)
+    {
+        return;
+    }
+
+    usec = Sys_Microseconds() - ltrace_file_usec - start;
+    ltrace_file_usec += usec;
+
+    ev = LTrace_NewEvent(LTRACE_FILE, NULL, path);
+    if (ev)
+    {
+        strncpy(ev->source, (bytes >= 0) ? source : "-", sizeof(ev->source) - 1);
+        ev->bytes = bytes;
+        ev->usec  = usec;
+    }
+}
+
+/*
+================
+LTrace_Stage
+================
+*/
+void LTrace_Stage(const char * stage, const char * name, int bytes, unsigned int start)
+{
+    ltrace_event_t * ev;
+
+    if (ltrace_enable == NULL || !ltrace_enable->value)
+    {
+        return;
+    }
+
+    ev = LTrace_NewEvent(LTRACE_STAGE, stage, name);
+    if (ev)
+    {
+        ev->bytes = bytes;
+        ev->usec  = Sys_Microseconds() - ltrace_file_usec - start;
+    }
+}
+
+/*
+================
+LTrace_Cache
+================
+*/
+void LTrace_Cache(const char * cache, const char * name, qboolean hit)
+{
+    if (ltrace_enable == NULL || !ltrace_enable->value)
+    {
+        return;
+    }
+    LTrace_NewEvent(hit ? LTRACE_HIT : LTRACE_MISS, cache, name);
+}
+
+/*
+================
+LTrace_AddTotal
+================
+*/
+static ltrace_total_t * LTrace_AddTotal(ltrace_total_t * totals, int * num_totals, const char * name)
+{
+    int i;
+    for (i = 0; i < *num_totals; ++i)
+    {
+        if (!strcmp(totals[i].name, name))
+        {
+            return &totals[i];
+        }
+    }
+    if (*num_totals == LTRACE_MAX_TOTALS)
+    {
+        return NULL;
+    }
+
+    memset(&totals[i], 0, sizeof(ltrace_total_t));
+    totals[i].name = name;
+    (*num_totals)++;
+    return &totals[i];
+}
+
+/*
+================
+LTrace_CompareTime
+
+qsort callback, slowest first.
+================
+*/
+static int LTrace_CompareTime(const void * a, const void * b)
+{
+    const ltrace_event_t * ea = *(const ltrace_event_t * const *)a;
+    const ltrace_event_t * eb = *(const ltrace_event_t * const *)b;
+
+    if (ea->usec != eb->usec)
+    {
+        return (ea->usec < eb->usec) ? 1 : -1;
+    }
+    return 0;
+}
+
+/*
+================
+LTrace_PrintSlowest
+
+Prints the 'ltrace_top' slowest events of the given kind.
+================
+*/
+static void LTrace_PrintSlowest(ltrace_kind_t kind, const char * label)
+{
+    int i, n, top;
+    static const ltrace_event_t * sorted[LTRACE_MAX_EVENTS];
+
+    for (i = 0, n = 0; i < ltrace_num_events; ++i)
+    {
+        if (ltrace_events[i].kind == kind)
+        {
+            sorted[n++] = &ltrace_events[i];
+        }
+    }
+    if (n == 0)
+    {
+        return;
+    }
+
+    qsort(sorted, n, sizeof(sorted[0]), LTrace_CompareTime);
+
+    top = (int)ltrace_top->value;
+    if (top > n)
+    {
+        top = n;
+    }
+
+    Com_Printf("slowest %s:\n", label);
+    for (i = 0; i < top; ++i)
+    {
+        const ltrace_event_t * ev = sorted[i];
+        Com_Printf("%9.2f %7d  %-12s %s\n", ev->usec / 1000.0, ev->bytes / 1024,
+                   (kind == LTRACE_FILE) ? ev->source : ev->what, ev->name);
+    }
+}
+
+/*
+================
+LTrace_WriteCsv
+================
+*/
+static void LTrace_WriteCsv(const char * title)
+{
+    int i;
+    FILE * f;
+    char name[MAX_OSPATH];
+    static const char * kind_names[] = { "file", "stage", "hit", "miss" };
+
+    Com_sprintf(name, sizeof(name), "%s/ltrace_%s.csv", FS_Gamedir(), title);
+    f = fopen(name, "w");
+    if (!f)
+    {
+        Com_Printf("Couldn't open %s\n", name);
+        return;
+    }
+
+    fprintf(f, "kind,what,name,bytes,ms\n");
+    for (i = 0; i < ltrace_num_events; ++i)
+    {
+        const ltrace_event_t * ev = &ltrace_events[i];
+        fprintf(f, "%s,%s,%s,%d,%.3f\n", kind_names[ev->kind],
+                (ev->kind == LTRACE_FILE) ? ev->source : ev->what,
+                ev->name, ev->bytes, ev->usec / 1000.0);
+    }
+
+    fclose(f);
+    Com_Printf("Wrote %d load events to %s\n", ltrace_num_events, name);
+}
+
+/*
+================
+LTrace_Report
+================
+*/
+void LTrace_Report(const char * title)
+{
+    int i;
+    int num_sources = 0;
+    int num_stages  = 0;
+    int num_caches  = 0;
+    ltrace_total_t sources[LTRACE_MAX_TOTALS];
+    ltrace_total_t stages[LTRACE_MAX_TOTALS];
+    ltrace_total_t caches[LTRACE_MAX_TOTALS];
+    ltrace_total_t * t;
+
+    if (ltrace_num_events == 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < ltrace_num_events; ++i)
+    {
+        const ltrace_event_t * ev = &ltrace_events[i];
+        switch (ev->kind)
+        {
+        case LTRACE_FILE :
+            t = LTrace_AddTotal(sources, &num_sources, ev->source);
+            break;
+        case LTRACE_STAGE :
+            t = LTrace_AddTotal(stages, &num_stages, ev->what);
+            break;
+        default :
+            t = LTrace_AddTotal(caches, &num_caches, ev->what);
+            if (t && ev->kind == LTRACE_MISS)
+            {
+                t->misses++;
+            }
+            break;
+        } // switch (ev->kind)
+
+        if (t)
+        {
+            t->count++;
+            t->bytes += (ev->bytes > 0) ? ev->bytes : 0;
+            t->usec  += ev->usec;
+        }
+    }
+
+    Com_Printf("====== load trace: %s ======\n", title);
+    if (ltrace_dropped)
+    {
+        Com_Printf("WARNING: %d events dropped, trace is full\n", ltrace_dropped);
+    }
+
+    if (num_sources > 0)
+    {
+        Com_Printf("source         files       KB        ms\n");
+    }
+    for (i = 0; i < num_sources; ++i)
+    {
+        Com_Printf("%-12s %7d %8u %9.2f\n", sources[i].name, sources[i].count,
+                   sources[i].bytes / 1024, sources[i].usec / 1000.0);
+    }
+
+    if (num_stages > 0)
+    {
+        Com_Printf("stage          calls       KB        ms\n");
+    }
+    for (i = 0; i < num_stages; ++i)
+    {
+        Com_Printf("%-12s %7d %8u %9.2f\n", stages[i].name, stages[i].count,
+                   stages[i].bytes / 1024, stages[i].usec / 1000.0);
+    }
+
+    if (num_caches > 0)
+    {
+        Com_Printf("cache           hits   misses\n");
+    }
+    for (i = 0; i < num_caches; ++i)
+    {
+        Com_Printf("%-12s %7d %8d\n", caches[i].name,
+                   caches[i].count - caches[i].misses, caches[i].misses);
+    }
+
+    LTrace_PrintSlowest(LTRACE_FILE, "files");
+    LTrace_PrintSlowest(LTRACE_STAGE, "stages");
+
+    if (ltrace_csv->value)
+    {
+        LTrace_WriteCsv(title);
+    }
+
+    ltrace_num_events = 0;
+    ltrace_dropped    = 0;
+}
+
+/*
+================
+LTrace_Report_f
+
+ltrace_report [title]
+
+Prints what was recorded since the last report,
+e.g. for the server side of a dedicated server.
+================
+*/
+static void LTrace_Report_f(void)
+{
+    if (ltrace_num_events == 0)
+    {
+        Com_Printf("No load events recorded. Set ltrace_enable to 1.\n");
+        return;
+    }
+    LTrace_Report((Cmd_Argc() > 1) ? Cmd_Argv(1) : "manual");
+}
+
+/*
+================
+LTrace_Init
+================
+*/
+void LTrace_Init(void)
+{
+    ltrace_enable = Cvar_Get("ltrace_enable", "0", 0);
+    ltrace_csv    = Cvar_Get("ltrace_csv", "0", 0);
+    ltrace_top    = Cvar_Get("ltrace_top", "10", 0);
+
+    Cmd_AddCommand("ltrace_report", LTrace_Report_f);
+}
@@ -0,0 +1,261 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: pak_lz.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Small LZ77 block codec used by compressed pak entries. See pak_lz.h.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/pak_lz.h"
+#include <string.h>
+
+//
+// Block layout, a sequence of:
+//
+//  token:    1 byte, literal count in the high nibble, match length - 4 in the low one.
+//            A nibble of 15 means more length bytes follow, added until one is < 255.
+//  literals: the literal bytes.
+//  offset:   2 bytes, little endian, distance back to the match (1..65535).
+//
+// The last sequence only has literals; the block ends right after them.
+// Matches never reach before the start of the block.
+//
+enum
+{
+    LZ_MIN_MATCH  = 4,
+    LZ_MAX_OFFSET = 65535,
+    LZ_HASH_BITS  = 14,
+    LZ_HASH_SIZE  = 1 << LZ_HASH_BITS,
+    LZ_LAST_LITERALS = 5 // The tail of the block is always literals; keeps the match search in bounds.
+};
+
+static unsigned int PakLZ_Read32(const unsigned char * p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static unsigned int PakLZ_Hash(unsigned int v)
+{
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Writes the 255-run continuation of a length that didn't fit in a nibble.
+static unsigned char * PakLZ_WriteLength(unsigned char * op, int len)
+{
+    while (len >= 255)
+    {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+/*
+================
+PakLZ_CompressBlock
+
+Greedy parse with a single hash table entry per bucket. It isn't
+trying to win on ratio, only to be cheap to decode on the EE.
+================
+*/
+int PakLZ_CompressBlock(const unsigned char * src, int src_len, unsigned char * dst, int dst_size)
+{
+    static int table[LZ_HASH_SIZE];
+
+    const unsigned char * ip     = src;
+    const unsigned char * anchor = src;
+    const unsigned char * iend   = src + src_len;
+    const unsigned char * mlimit = iend - LZ_LAST_LITERALS;
+    unsigned char * op   = dst;
+    unsigned char * oend = dst + dst_size;
+    unsigned char * token;
+    int lit_len, match_len;
+    int i;
+
+    for (i = 0; i < LZ_HASH_SIZE; ++i)
+    {
+        table[i] = -1;
+    }
+
+    while (ip + LZ_MIN_MATCH <= mlimit)
+    {
+        const unsigned int seq = PakLZ_Read32(ip);
+        const unsigned int h = PakLZ_Hash(seq);
+        const int candidate = table[h];
+        const unsigned char * match;
+
+        table[h] = (int)(ip - src);
+
+        if (candidate < 0 || (ip - src) - candidate > LZ_MAX_OFFSET ||
+            PakLZ_Read32(src + candidate) != seq)
+        {
+            ++ip;
+            continue;
+        }
+
+        match = src + candidate;
+        match_len = LZ_MIN_MATCH;
+        while (ip + match_len < mlimit && match[match_len] == ip[match_len])
+        {
+            ++match_len;
+        }
+
+        // Worst case for this sequence: token, length runs, literals, offset.
+        lit_len = (int)(ip - anchor);
+        if (op + 1 + lit_len + lit_len / 255 + 2 + match_len / 255 + 2 > oend)
+        {
+            return 0;
+        }
+
+        token = op++;
+        if (lit_len >= 15)
+        {
+            *token = 15 << 4;
+            op = PakLZ_WriteLength(op, lit_len - 15);
+        }
+        else
+        {
+            *token = (unsigned char)(lit_len << 4);
+        }
+        memcpy(op, anchor, lit_len);
+        op += lit_len;
+
+        op[0] = (unsigned char)((ip - match) & 0xFF);
+        op[1] = (unsigned char)((ip - match) >> 8);
+        op += 2;
+
+        if (match_len - LZ_MIN_MATCH >= 15)
+        {
+            *token |= 15;
+            op = PakLZ_WriteLength(op, match_len - LZ_MIN_MATCH - 15);
+        }
+        else
+        {
+            *token |= (unsigned char)(match_len - LZ_MIN_MATCH);
+        }
+
+        ip += match_len;
+        anchor = ip;
+    }
+
+    // Trailing literals.
+    lit_len = (int)(iend - anchor);
+    if (op + 1 + lit_len + lit_len / 255 + 1 > oend)
+    {
+        return 0;
+    }
+
+    token = op++;
+    if (lit_len >= 15)
+    {
+        *token = 15 << 4;
+        op = PakLZ_WriteLength(op, lit_len - 15);
+    }
+    else
+    {
+        *token = (unsigned char)(lit_len << 4);
+    }
+    memcpy(op, anchor, lit_len);
+    op += lit_len;
+
+    return (op - dst < src_len) ? (int)(op - dst) : 0;
+}
+
+/*
+================
+PakLZ_DecompressBlock
+================
+*/
+int PakLZ_DecompressBlock(const unsigned char * src, int src_len, unsigned char * dst, int dst_len)
+{
+    const unsigned char * ip   = src;
+    const unsigned char * iend = src + src_len;
+    unsigned char * op   = dst;
+    unsigned char * oend = dst + dst_len;
+    const unsigned char * match;
+    unsigned int token;
+    int len, offset;
+
+    while (ip < iend)
+    {
+        token = *ip++;
+
+        // Literals:
+        len = token >> 4;
+        if (len == 15)
+        {
+            int s;
+            do
+            {
+                if (ip >= iend)
+                {
+                    return -1;
+                }
+                s = *ip++;
+                len += s;
+            } while (s == 255);
+        }
+        if (len > iend - ip || len > oend - op)
+        {
+            return -1;
+        }
+        memcpy(op, ip, len);
+        ip += len;
+        op += len;
+
+        if (ip == iend)
+        {
+            break; // Last sequence has no match.
+        }
+
+        // Match:
+        if (iend - ip < 2)
+        {
+            return -1;
+        }
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        len = token & 15;
+        if (len == 15)
+        {
+            int s;
+            do
+            {
+                if (ip >= iend)
+                {
+                    return -1;
+                }
+                s = *ip++;
+                len += s;
+            } while (s == 255);
+        }
+        len += LZ_MIN_MATCH;
+
+        if (offset == 0 || offset > op - dst || len > oend - op)
+        {
+            return -1;
+        }
+
+        // Byte copy, since the match may overlap the bytes it produces.
+        match = op - offset;
+        if (offset >= len)
+        {
+            memcpy(op, match, len);
+            op += len;
+        }
+        else
+        {
+            while (len-- > 0)
+            {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return (int)(op - dst);
+}
@@ -0,0 +1,33 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: pak_lz.h
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Small LZ77 block codec used by compressed pak entries (see IDPAKZHEADER).
+ *
+ * Entries are split into PAKZ_BLOCK_SIZE blocks that are compressed
+ * independently, so a block can be decoded straight into the final
+ * buffer with only one compressed block staged in memory. The format
+ * is LZ4-like: a token byte with the literal and match lengths in each
+ * nibble, the literals, then a 16 bits match offset. No entropy coding,
+ * so decoding is little more than memcpy.
+ *
+ * This file has no engine dependencies, so the tools can build it too.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#ifndef PAK_LZ_H
+#define PAK_LZ_H
+
+// Compresses one block. Returns the compressed size, or 0 if the
+// block doesn't get smaller than 'dst_size', in which case it
+// should be stored as is.
+int PakLZ_CompressBlock(const unsigned char * src, int src_len, unsigned char * dst, int dst_size);
+
+// Decodes one block. Returns the number of bytes written, which should
+// be 'dst_len', or -1 if the data is corrupt. Never writes past 'dst_len'.
+int PakLZ_DecompressBlock(const unsigned char * src, int src_len, unsigned char * dst, int dst_len);
+
+#endif // PAK_LZ_H
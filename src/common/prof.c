@@ -0,0 +1,421 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: prof.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Lightweight hierarchical frame profiler. See q_prof.h.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/q_common.h"
+#include "common/q_prof.h"
+#include "ps2/defs_ps2.h"
+
+#ifndef _EE
+#include <time.h>
+#endif
+
+//
+// Timer source:
+// The EE COP0 Count register ticks once per CPU cycle (294.912 MHz).
+// It is only 32 bits wide, so it wraps every ~14 seconds; we extend it
+// to 64 bits by watching for the wrap on each read. Host builds use
+// the monotonic clock, in nanoseconds.
+//
+#ifdef _EE
+
+#define PROF_TICKS_PER_USEC 294.912
+
+static u32 prof_last_count = 0;
+static u64 prof_count_hi   = 0;
+
+static inline u64 Prof_ReadTicks(void)
+{
+    u32 count;
+    __asm__ volatile ("mfc0 %0, $9\n" : "=r"(count));
+
+    if (count < prof_last_count)
+    {
+        prof_count_hi += (u64)1 << 32;
+    }
+    prof_last_count = count;
+    return prof_count_hi | count;
+}
+
+#else // !_EE
+
+#define PROF_TICKS_PER_USEC 1000.0
+
+static inline u64 Prof_ReadTicks(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+#endif // _EE
+
+#define PROF_TICKS_TO_MS(t) ((float)((double)(t) / (PROF_TICKS_PER_USEC * 1000.0)))
+#define PROF_TICKS_TO_US(t) ((double)(t) / PROF_TICKS_PER_USEC)
+
+typedef struct
+{
+    const char * name;
+    u32 start; // Ticks relative to the frame start.
+    u32 end;
+    int depth;
+} prof_scope_t;
+
+typedef struct
+{
+    u64 start;
+    int num_scopes;
+    prof_scope_t scopes[PROF_MAX_SCOPES];
+} prof_frame_t;
+
+static cvar_t * prof_enable = NULL;
+
+// One extra slot for the frame being recorded, so it never
+// overwrites the oldest completed frame in the history.
+#define PROF_RING_SIZE (PROF_MAX_FRAMES + 1)
+
+static prof_frame_t prof_frames[PROF_RING_SIZE];
+static int prof_frame_head  = 0; // Frame being recorded.
+static int prof_frame_count = 0; // Completed frames in the history.
+static qboolean prof_recording = false;
+
+// Scope index for each open level, or -1 if the scope was dropped.
+static int prof_stack[PROF_MAX_DEPTH];
+static int prof_depth = 0;
+
+/*
+================
+Prof_BeginFrame
+
+Starts recording a new frame. Any scopes left open by the
+previous frame (e.g. by a longjmp out of Com_Error) are discarded.
+================
+*/
+void Prof_BeginFrame(void)
+{
+    prof_frame_t * frame;
+
+    prof_recording = (prof_enable != NULL && prof_enable->value);
+    prof_depth = 0;
+
+    if (!prof_recording)
+    {
+        return;
+    }
+
+    frame = &prof_frames[prof_frame_head];
+    frame->start = Prof_ReadTicks();
+    frame->num_scopes = 0;
+}
+
+/*
+================
+Prof_EndFrame
+================
+*/
+void Prof_EndFrame(void)
+{
+    if (!prof_recording)
+    {
+        return;
+    }
+
+    while (prof_depth > 0)
+    {
+        Prof_End();
+    }
+
+    prof_frame_head = (prof_frame_head + 1) % PROF_RING_SIZE;
+    if (prof_frame_count < PROF_MAX_FRAMES)
+    {
+        prof_frame_count++;
+    }
+    prof_recording = false;
+}
+
+/*
+================
+Prof_Begin
+================
+*/
+void Prof_Begin(const char * name)
+{
+    prof_frame_t * frame;
+    prof_scope_t * scope;
+
+    if (!prof_recording)
+    {
+        return;
+    }
+    if (prof_depth >= PROF_MAX_DEPTH)
+    {
+        // Not recorded, but still counted, so the matching
+        // Prof_End pops this level and not its parent's.
+        if (prof_depth == PROF_MAX_DEPTH)
+        {
+            Com_DPrintf("Prof_Begin: '%s' is too deeply nested\n", name);
+        }
+        prof_depth++;
+        return;
+    }
+
+    frame = &prof_frames[prof_frame_head];
+    if (frame->num_scopes == PROF_MAX_SCOPES)
+    {
+        prof_stack[prof_depth++] = -1;
+        return;
+    }
+
+    scope = &frame->scopes[frame->num_scopes];
+    scope->name  = name;
+    scope->depth = prof_depth;
+    scope->start = (u32)(Prof_ReadTicks() - frame->start);
+    scope->end   = scope->start;
+
+    prof_stack[prof_depth++] = frame->num_scopes++;
+}
+
+/*
+================
+Prof_End
+================
+*/
+void Prof_End(void)
+{
+    int index;
+    prof_frame_t * frame;
+
+    if (!prof_recording || prof_depth == 0)
+    {
+        return;
+    }
+
+    if (--prof_depth >= PROF_MAX_DEPTH)
+    {
+        return;
+    }
+
+    index = prof_stack[prof_depth];
+    if (index < 0)
+    {
+        return;
+    }
+
+    frame = &prof_frames[prof_frame_head];
+    frame->scopes[index].end = (u32)(Prof_ReadTicks() - frame->start);
+}
+
+/*
+================
+Prof_GetStats
+================
+*/
+int Prof_GetStats(prof_stats_t * stats, int max_stats)
+{
+    int f, i, s;
+    int num_stats;
+    int first;
+    const prof_frame_t * frame;
+    u32 frame_ticks[PROF_MAX_SCOPES];
+    int frame_calls[PROF_MAX_SCOPES];
+
+    if (prof_frame_count == 0 || max_stats <= 0)
+    {
+        return 0;
+    }
+
+    num_stats = 0;
+    first = (prof_frame_head - prof_frame_count + PROF_RING_SIZE) % PROF_RING_SIZE;
+
+    // Oldest to newest, so first-seen order follows the call order.
+    for (f = 0; f < prof_frame_count; ++f)
+    {
+        frame = &prof_frames[(first + f) % PROF_RING_SIZE];
+        memset(frame_ticks, 0, sizeof(frame_ticks));
+        memset(frame_calls, 0, sizeof(frame_calls));
+
+        // Sum the calls to each named scope in this frame.
+        for (i = 0; i < frame->num_scopes; ++i)
+        {
+            const prof_scope_t * scope = &frame->scopes[i];
+
+            for (s = 0; s < num_stats; ++s)
+            {
+                if (stats[s].name == scope->name)
+                {
+                    break;
+                }
+            }
+            if (s == num_stats)
+            {
+                if (num_stats == max_stats || num_stats == PROF_MAX_SCOPES)
+                {
+                    continue;
+                }
+                memset(&stats[s], 0, sizeof(prof_stats_t));
+                stats[s].name   = scope->name;
+                stats[s].depth  = scope->depth;
+                stats[s].min_ms = 1e9f;
+                num_stats++;
+            }
+
+            frame_ticks[s] += scope->end - scope->start;
+            frame_calls[s]++;
+        }
+
+        for (s = 0; s < num_stats; ++s)
+        {
+            float ms;
+            if (frame_calls[s] == 0)
+            {
+                continue;
+            }
+
+            ms = PROF_TICKS_TO_MS(frame_ticks[s]);
+            stats[s].frames++;
+            stats[s].calls  += frame_calls[s];
+            stats[s].avg_ms += ms;
+            if (ms < stats[s].min_ms)
+            {
+                stats[s].min_ms = ms;
+            }
+            if (ms > stats[s].max_ms)
+            {
+                stats[s].max_ms = ms;
+            }
+        }
+    }
+
+    for (s = 0; s < num_stats; ++s)
+    {
+        stats[s].avg_ms /= stats[s].frames;
+    }
+
+    return num_stats;
+}
+
+/*
+================
+Prof_Stats_f
+
+Prints min/avg/max for every scope in the history.
+================
+*/
+static void Prof_Stats_f(void)
+{
+    int i, n;
+    prof_stats_t stats[PROF_MAX_SCOPES];
+
+    n = Prof_GetStats(stats, PROF_MAX_SCOPES);
+    if (n == 0)
+    {
+        Com_Printf("No profiler frames recorded. Set prof_enable to 1.\n");
+        return;
+    }
+
+    Com_Printf("%d frames\n", prof_frame_count);
+    Com_Printf("scope                       min ms   avg ms   max ms  calls\n");
+    for (i = 0; i < n; ++i)
+    {
+        Com_Printf("%*s%-*s %8.3f %8.3f %8.3f %6d\n",
+                   stats[i].depth * 2, "", 24 - stats[i].depth * 2, stats[i].name,
+                   stats[i].min_ms, stats[i].avg_ms, stats[i].max_ms, stats[i].calls);
+    }
+}
+
+/*
+================
+Prof_Dump_f
+
+prof_dump [basename]
+
+Writes every scope in the history to <gamedir>/<basename>.csv and
+a Chrome trace (chrome://tracing) to <gamedir>/<basename>.json.
+================
+*/
+static void Prof_Dump_f(void)
+{
+    int f, i;
+    int first;
+    FILE * csv;
+    FILE * json;
+    u64 base;
+    const char * basename;
+    const prof_frame_t * frame;
+    char name[MAX_OSPATH];
+
+    if (prof_frame_count == 0)
+    {
+        Com_Printf("No profiler frames recorded. Set prof_enable to 1.\n");
+        return;
+    }
+
+    basename = (Cmd_Argc() > 1) ? Cmd_Argv(1) : "prof";
+
+    Com_sprintf(name, sizeof(name), "%s/%s.csv", FS_Gamedir(), basename);
+    csv = fopen(name, "w");
+    if (!csv)
+    {
+        Com_Printf("Couldn't open %s\n", name);
+        return;
+    }
+
+    Com_sprintf(name, sizeof(name), "%s/%s.json", FS_Gamedir(), basename);
+    json = fopen(name, "w");
+    if (!json)
+    {
+        Com_Printf("Couldn't open %s\n", name);
+        fclose(csv);
+        return;
+    }
+
+    first = (prof_frame_head - prof_frame_count + PROF_RING_SIZE) % PROF_RING_SIZE;
+    base  = prof_frames[first].start;
+
+    fprintf(csv, "frame,scope,depth,start_ms,dur_ms\n");
+    fprintf(json, "{\"traceEvents\":[\n");
+
+    for (f = 0; f < prof_frame_count; ++f)
+    {
+        frame = &prof_frames[(first + f) % PROF_RING_SIZE];
+        for (i = 0; i < frame->num_scopes; ++i)
+        {
+            const prof_scope_t * scope = &frame->scopes[i];
+            const u64 start = frame->start - base + scope->start;
+            const u32 dur = scope->end - scope->start;
+
+            fprintf(csv, "%d,%s,%d,%.4f,%.4f\n", f, scope->name, scope->depth,
+                    PROF_TICKS_TO_US(start) / 1000.0, PROF_TICKS_TO_US(dur) / 1000.0);
+
+            fprintf(json, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}\n",
+                    (f == 0 && i == 0) ? "" : ",", scope->name,
+                    PROF_TICKS_TO_US(start), PROF_TICKS_TO_US(dur));
+        }
+    }
+
+    fprintf(json, "]}\n");
+    fclose(json);
+    fclose(csv);
+
+    Com_Printf("Wrote %d frames to %s/%s.csv/.json\n", prof_frame_count, FS_Gamedir(), basename);
+}
+
+/*
+================
+Prof_Init
+================
+*/
+void Prof_Init(void)
+{
+    prof_enable = Cvar_Get("prof_enable", "0", 0);
+
+    Cmd_AddCommand("prof_stats", Prof_Stats_f);
+    Cmd_AddCommand("prof_dump", Prof_Dump_f);
+}
@@ -635,6 +635,7 @@ CMODEL
 #include "common/q_files.h"
 
 cmodel_t * CM_LoadMap(char * name, qboolean clientload, unsigned * checksum);
+qboolean CM_MapChecksum(const char * name, unsigned * checksum); // LAMPERT: Without reloading the map.
 cmodel_t * CM_InlineModel(char * name); // *1, *2, etc
 
 int CM_NumClusters(void);
@@ -708,6 +709,26 @@ char * FS_Gamedir(void);
 char * FS_NextPath(char * prevpath);
 void FS_ExecAutoexec(void);
 
+// LAMPERT: A file found in the search path. Pak entries are just
+// an offset and length into the pak, read through its open handle,
+// so opening one doesn't cost an fopen/fseek.
+typedef struct
+{
+    struct pack_s * pak; // NULL for loose files
+    FILE * file;         // Loose files only
+    const char * dir;    // Loose files only, the search path dir it was found in
+    int offset;          // Start of the file in the pak
+    int length;
+    int complen;         // Bytes in the pak for compressed entries, else 0
+    int pos;             // Read position, relative to the start of the file
+} fs_view_t;
+
+int FS_OpenView(const char * filename, fs_view_t * view);
+int FS_OpenPakView(struct pack_s * pak, const char * filename, fs_view_t * view);
+void FS_ReadView(fs_view_t * view, void * buffer, int len);
+void FS_CloseView(fs_view_t * view);
+// FS_OpenView returns the file length, or -1 if not found
+
 int FS_FOpenFile(const char * filename, FILE ** file);
 void FS_FCloseFile(FILE * f);
 // note: this can't be called from another DLL, due to MS libc issues
@@ -722,6 +743,45 @@ void FS_Read(void * buffer, int len, FILE * f);
 void FS_FreeFile(void * buffer);
 void FS_CreatePath(char * path);
 
+qboolean FS_TryReadView(const fs_view_t * view, void * buffer, void * stage);
+// reads the whole file, returning false on errors instead of calling Com_Error
+
+void FS_CountPakRead(const fs_view_t * view);
+
+qboolean FS_DecodeView(const fs_view_t * view, const void * raw, void * buffer);
+int FS_ViewLocation(const fs_view_t * view, const char * filename, char * path, int path_size);
+// LAMPERT: for reading views through other means, like the PS2's fileXio
+
+struct pack_s * FS_LoadPackFile(char * packfile);
+void FS_FreePackFile(struct pack_s * pak);
+// LAMPERT: paks outside the search path, for tools and benchmarks
+
+// LAMPERT: Asynchronous loading queue (fs_async.c). Files are read in
+// the background in priority order, then handed to the callback from
+// FS_AsyncPump, or to FS_LoadFile for requests queued without a callback.
+typedef enum
+{
+    FS_PRIO_LOW,
+    FS_PRIO_NORMAL,
+    FS_PRIO_HIGH
+} fs_priority_t;
+
+typedef void (*fs_async_callback_t)(const char * path, void * buffer, int length, void * user);
+
+void FS_AsyncInit(void);
+qboolean FS_AsyncQueue(const char * path, fs_priority_t priority, fs_async_callback_t callback, void * user);
+qboolean FS_AsyncTake(const char * path, void ** buffer, int * length);
+void FS_AsyncPump(void);
+void FS_AsyncWait(void);  // until all requests with callbacks are done
+void FS_AsyncFlush(void); // drops everything still queued
+void FS_AsyncPrintStats(qboolean reset);
+
+// Bytes opened and read between Begin/End, for the loading plaque.
+void FS_BeginLoadProgress(void);
+void FS_EndLoadProgress(void);
+void FS_LoadProgress(int done, int total);
+void FS_GetLoadProgress(int * done, int * total);
+
 /*
 ==============================================================
 
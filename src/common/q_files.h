@@ -46,6 +46,30 @@ typedef struct
     int dirlen;
 } dpackheader_t;
 
+//
+// LAMPERT: Compressed pak variant. Same header, different ident and
+// directory entries. A compressed entry is a run of blocks, each one
+// decoding to PAKZ_BLOCK_SIZE bytes (the last one to the remainder),
+// preceded by a 32 bits little endian header with the size of the
+// block data. Blocks that didn't compress have PAKZ_BLOCK_STORED set
+// in the header and are copied as is. See common/pak_lz.h.
+//
+#define IDPAKZHEADER (('Z' << 24) + ('C' << 16) + ('A' << 8) + 'P')
+
+#define PAKZ_BLOCK_SIZE   (32 * 1024)
+#define PAKZ_BLOCK_STORED 0x80000000
+
+#define PAKZ_COMPRESSED 1 // dpackzfile_t::flags
+
+typedef struct
+{
+    char name[56];
+    int filepos;
+    int filelen;  // Uncompressed size
+    int complen;  // Bytes in the pak, block headers included
+    int flags;
+} dpackzfile_t;
+
 /*
 ========================================================================
 
@@ -0,0 +1,46 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: q_ltrace.h
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Level load trace. Records file loads, loader stages and cache lookups.
+ *
+ * While 'ltrace_enable' is set, every FS_LoadFile, every loader stage (BSP
+ * lumps, models, image decoding, sound resampling) and every renderer cache
+ * lookup is recorded. CL_PrepRefresh prints a summary once registration is
+ * over and clears the trace, so each report covers one level load. With
+ * 'ltrace_csv' set, the events are also written to <gamedir>/ltrace_<map>.csv.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#ifndef Q_LTRACE_H
+#define Q_LTRACE_H
+
+enum
+{
+    LTRACE_MAX_EVENTS = 2048 // Events after this are counted but dropped.
+};
+
+void LTrace_Init(void);
+
+// Returns the start time to pass to LTrace_File/LTrace_Stage. The clock
+// stops while files are loaded, so a stage that loads files itself only
+// gets charged for its own work, not for the I/O already traced apart.
+unsigned int LTrace_Start(void);
+
+// 'source' is the pak or directory the file came from.
+// Negative 'bytes' records a lookup for a file that wasn't found.
+void LTrace_File(const char * path, const char * source, int bytes, unsigned int start);
+
+// 'stage' must be a string with static storage, e.g. "wal" or "bsp:faces".
+void LTrace_Stage(const char * stage, const char * name, int bytes, unsigned int start);
+
+// 'cache' must be a string with static storage, e.g. "image" or "model".
+void LTrace_Cache(const char * cache, const char * name, qboolean hit);
+
+// Prints the summary, writes the CSV if enabled and clears the trace.
+void LTrace_Report(const char * title);
+
+#endif // Q_LTRACE_H
@@ -0,0 +1,52 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: q_prof.h
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Lightweight hierarchical frame profiler.
+ *
+ * Scopes are begin/end pairs with a static name string. They can nest,
+ * and the last PROF_MAX_FRAMES frames are kept in a ring buffer, which
+ * can be queried for per-scope stats or dumped with 'prof_dump'.
+ * Recording is only active while the 'prof_enable' cvar is set.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#ifndef Q_PROF_H
+#define Q_PROF_H
+
+enum
+{
+    PROF_MAX_FRAMES = 256, // Frame history kept in the ring buffer.
+    PROF_MAX_SCOPES = 32,  // Scopes recorded per frame; extra ones are dropped.
+    PROF_MAX_DEPTH  = 16   // Max nesting depth.
+};
+
+// Per-scope stats over the frames in the history.
+// Times are the sum of all calls to the scope in a frame.
+typedef struct
+{
+    const char * name;
+    int depth;  // Nesting depth the first time the scope was seen.
+    int frames; // Number of frames in which the scope appeared.
+    int calls;  // Total calls over those frames.
+    float min_ms;
+    float avg_ms;
+    float max_ms;
+} prof_stats_t;
+
+void Prof_Init(void);
+void Prof_BeginFrame(void);
+void Prof_EndFrame(void);
+
+// 'name' must be a string with static storage, since only the pointer is stored.
+void Prof_Begin(const char * name);
+void Prof_End(void);
+
+// Fills 'stats' in scope first-seen order, which is also the call
+// hierarchy order. Returns the number of entries written.
+int Prof_GetStats(prof_stats_t * stats, int max_stats);
+
+#endif // Q_PROF_H
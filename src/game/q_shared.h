@@ -273,6 +273,30 @@ byte * Hunk_BlockAlloc(mem_hunk_t * hunk, int block_size);
 // Get the offset to the end of the allocated region.
 int Hunk_GetTail(mem_hunk_t * hunk);
 
+//
+// Per-frame scratch allocation API
+//
+// Linear allocators with a fixed budget that are rewound once per frame,
+// for temporaries that would otherwise be big static or stack buffers.
+// Memory is not zero filled and is only valid until the next reset.
+//
+typedef enum
+{
+    FRAME_MEM_REFRESH, // Reset by the renderer's BeginFrame.
+    FRAME_MEM_SERVER,  // Reset at the top of SV_Frame.
+    FRAME_MEM_COUNT
+} frame_mem_arena_t;
+
+void * Frame_MemAlloc(frame_mem_arena_t arena, int size_bytes);
+void Frame_MemReset(frame_mem_arena_t arena);
+
+// Free back to a previous mark, for temporaries in functions called many times per frame.
+int Frame_MemGetMark(frame_mem_arena_t arena);
+void Frame_MemFreeToMark(frame_mem_arena_t arena, int mark);
+
+// Budget and the most bytes ever used in a single frame.
+void Frame_MemGetUsage(frame_mem_arena_t arena, int * high_water, int * budget);
+
 // LAMPERT 2015-10-30:
 // Original Hunk allocator API used by Quake2
 // relied on global data. We provide a cleaner
@@ -292,6 +316,10 @@ extern int curtime;
 int Sys_Milliseconds(void);
 void Sys_Mkdir(const char * path);
 
+// LAMPERT: High resolution timer for benchmarking.
+// Wraps around, so only the difference between two calls is meaningful.
+unsigned int Sys_Microseconds(void);
+
 // directory searching
 #define SFF_ARCH   0x01
 #define SFF_HIDDEN 0x02
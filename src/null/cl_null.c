@@ -43,13 +43,17 @@ void CL_Frame(int msec)
 {
 }
 
+void Con_Init(void)
+{
+}
+
 void Con_Print(char * text)
 {
 }
 
 void Cmd_ForwardToServer(void)
 {
-    char * cmd;
+    const char * cmd;
     cmd = Cmd_Argv(0);
     Com_Printf("Unknown command \"%s\"\n", cmd);
 }
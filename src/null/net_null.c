@@ -114,6 +114,16 @@ NET_AdrToString
 char * NET_AdrToString(netadr_t a)
 {
     static char s[64];
+
+    if (a.type == NA_LOOPBACK)
+    {
+        Com_sprintf(s, sizeof(s), "loopback");
+    }
+    else
+    {
+        s[0] = '\0';
+    }
+
     return s;
 }
 
@@ -124,9 +134,84 @@ NET_StringToAdr
 */
 qboolean NET_StringToAdr(const char * s, netadr_t * a)
 {
+    memset(a, 0, sizeof(*a));
+
+    if (!strcmp(s, "localhost") || !strcmp(s, "loopback"))
+    {
+        a->type = NA_LOOPBACK;
+        return true;
+    }
+
     return false;
 }
 
+/*
+=============================================================================
+
+LOOPBACK BUFFERS FOR LOCAL PLAYER
+
+LAMPERT: Same code from net_wins.c, so that a null
+client can talk to a local server (see 'make host-bench').
+=============================================================================
+*/
+
+#define MAX_LOOPBACK 4
+
+typedef struct
+{
+    byte data[MAX_MSGLEN];
+    int datalen;
+} loopmsg_t;
+
+typedef struct
+{
+    loopmsg_t msgs[MAX_LOOPBACK];
+    int get, send;
+} loopback_t;
+
+static loopback_t loopbacks[2];
+
+static qboolean NET_GetLoopPacket(netsrc_t sock, netadr_t * net_from, sizebuf_t * net_message)
+{
+    int i;
+    loopback_t * loop;
+
+    loop = &loopbacks[sock];
+
+    if (loop->send - loop->get > MAX_LOOPBACK)
+    {
+        loop->get = loop->send - MAX_LOOPBACK;
+    }
+
+    if (loop->get >= loop->send)
+    {
+        return false;
+    }
+
+    i = loop->get & (MAX_LOOPBACK - 1);
+    loop->get++;
+
+    memcpy(net_message->data, loop->msgs[i].data, loop->msgs[i].datalen);
+    net_message->cursize = loop->msgs[i].datalen;
+    memset(net_from, 0, sizeof(*net_from));
+    net_from->type = NA_LOOPBACK;
+    return true;
+}
+
+static void NET_SendLoopPacket(netsrc_t sock, int length, const void * data, netadr_t to)
+{
+    int i;
+    loopback_t * loop;
+
+    loop = &loopbacks[sock ^ 1];
+
+    i = loop->send & (MAX_LOOPBACK - 1);
+    loop->send++;
+
+    memcpy(loop->msgs[i].data, data, length);
+    loop->msgs[i].datalen = length;
+}
+
 /*
 ====================
 NET_GetPacket
@@ -134,7 +219,7 @@ NET_GetPacket
 */
 qboolean NET_GetPacket(netsrc_t sock, netadr_t * net_from, sizebuf_t * net_message)
 {
-    return false;
+    return NET_GetLoopPacket(sock, net_from, net_message);
 }
 
 /*
@@ -144,6 +229,10 @@ NET_SendPacket
 */
 void NET_SendPacket(netsrc_t sock, int length, const void * data, netadr_t to)
 {
+    if (to.type == NA_LOOPBACK)
+    {
+        NET_SendLoopPacket(sock, length, data, to);
+    }
 }
 
 /*
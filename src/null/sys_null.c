@@ -22,6 +22,16 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "common/q_common.h"
 
+#ifndef PS2_QUAKE
+// LAMPERT: Host build support (see 'make host-bench').
+#include <sys/stat.h>
+#include <sys/time.h>
+#endif // PS2_QUAKE
+
+#ifdef GAME_HARD_LINKED
+#include "game/game.h" // For GetGameAPI()
+#endif // GAME_HARD_LINKED
+
 int curtime;
 unsigned sys_frame_time;
 
@@ -55,7 +65,11 @@ void Sys_UnloadGame(void)
 
 void * Sys_GetGameAPI(void * parms)
 {
+#ifdef GAME_HARD_LINKED
+    return GetGameAPI((game_import_t *)parms);
+#else // !GAME_HARD_LINKED
     return NULL;
+#endif // GAME_HARD_LINKED
 }
 
 char * Sys_ConsoleInput(void)
@@ -65,6 +79,9 @@ char * Sys_ConsoleInput(void)
 
 void Sys_ConsoleOutput(const char * string)
 {
+#ifndef PS2_QUAKE
+    fputs(string, stdout);
+#endif // PS2_QUAKE
 }
 
 void Sys_SendKeyEvents(void)
@@ -86,11 +103,40 @@ char * Sys_GetClipboardData(void)
 
 int Sys_Milliseconds(void)
 {
+#ifndef PS2_QUAKE
+    static int secbase = 0;
+    struct timeval tp;
+
+    gettimeofday(&tp, NULL);
+    if (!secbase)
+    {
+        secbase = tp.tv_sec;
+        return tp.tv_usec / 1000;
+    }
+
+    curtime = (tp.tv_sec - secbase) * 1000 + tp.tv_usec / 1000;
+    return curtime;
+#else // PS2_QUAKE
+    return 0;
+#endif // PS2_QUAKE
+}
+
+unsigned int Sys_Microseconds(void)
+{
+#ifndef PS2_QUAKE
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned int)ts.tv_sec * 1000000u + (unsigned int)(ts.tv_nsec / 1000);
+#else // PS2_QUAKE
     return 0;
+#endif // PS2_QUAKE
 }
 
 void Sys_Mkdir(const char * path)
 {
+#ifndef PS2_QUAKE
+    mkdir(path, 0777);
+#endif // PS2_QUAKE
 }
 
 char * Sys_FindFirst(const char * path, unsigned musthave, unsigned canthave)
@@ -152,15 +198,32 @@ int rename(const char * a, const char * b)
 
 //=============================================================================
 
-int main(/*int argc, char ** argv*/)
+int main(int argc, char ** argv)
 {
-    int argc = 1;
-    char * argv[] = { "NULL_SYS" };
+    int time, oldtime, newtime;
+    cvar_t * timedemo;
+
+#ifndef PS2_QUAKE
+    // Keep the console output in order when piped to a log.
+    setvbuf(stdout, NULL, _IOLBF, 0);
+#endif // PS2_QUAKE
+
     Qcommon_Init(argc, argv);
+    timedemo = Cvar_Get("timedemo", "0", 0);
 
+    oldtime = Sys_Milliseconds();
     while (true)
     {
-        Qcommon_Frame(1); // FIXME: use a time delta!
+        // find time spent rendering last frame
+        // (timedemos run as fast as possible)
+        do
+        {
+            newtime = Sys_Milliseconds();
+            time = newtime - oldtime;
+        } while (time < 1 && !timedemo->value);
+
+        Qcommon_Frame(time);
+        oldtime = newtime;
     }
 
     return 0;
@@ -26,9 +26,131 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 viddef_t viddef; // global video state
 refexport_t re;
 
+/*
+==========================================================================
+
+NULL REFRESH
+
+LAMPERT: Minimal refresh that accepts every call and draws nothing,
+so the client can run frames on a host without a renderer (see the
+'host-bench' target in the Makefile). Registration always fails,
+which the client code already handles as missing assets.
+
+==========================================================================
+*/
+
+static qboolean R_Null_Init(void * hinstance, void * wndproc)
+{
+    // Nothing is loaded, so don't have the client read models and pics
+    // ahead only to drop them. Runs before V_Init registers the cvar.
+    Cvar_Get("cl_prefetch", "0", 0);
+    return true;
+}
+
+static void R_Null_Shutdown(void)
+{
+}
+
+static void R_Null_BeginRegistration(const char * map_name)
+{
+}
+
+static struct model_s * R_Null_RegisterModel(const char * name)
+{
+    return NULL;
+}
+
+static struct image_s * R_Null_RegisterImage(const char * name)
+{
+    return NULL;
+}
+
+static void R_Null_SetSky(const char * name, float rotate, vec3_t axis)
+{
+}
+
+static void R_Null_EndRegistration(void)
+{
+}
+
+static void R_Null_RenderFrame(refdef_t * fd)
+{
+}
+
+static void R_Null_DrawGetPicSize(int * w, int * h, const char * name)
+{
+    *w = *h = 0;
+}
+
+static void R_Null_DrawPic(int x, int y, const char * name)
+{
+}
+
+static void R_Null_DrawStretchPic(int x, int y, int w, int h, const char * name)
+{
+}
+
+static void R_Null_DrawChar(int x, int y, int c)
+{
+}
+
+static void R_Null_DrawFill(int x, int y, int w, int h, int c)
+{
+}
+
+static void R_Null_DrawFadeScreen(void)
+{
+}
+
+static void R_Null_DrawStretchRaw(int x, int y, int w, int h, int cols, int rows, const byte * data)
+{
+}
+
+static void R_Null_CinematicSetPalette(const unsigned char * palette)
+{
+}
+
+static void R_Null_BeginFrame(float camera_separation)
+{
+}
+
+static void R_Null_EndFrame(void)
+{
+}
+
+static void R_Null_AppActivate(qboolean activate)
+{
+}
+
 refexport_t GetRefAPI(refimport_t rimp)
 {
-    static refexport_t refexp;
+    refexport_t refexp;
+
+    memset(&refexp, 0, sizeof(refexp));
+
+    refexp.api_version         = REF_API_VERSION;
+    refexp.Init                = R_Null_Init;
+    refexp.Shutdown            = R_Null_Shutdown;
+    refexp.BeginRegistration   = R_Null_BeginRegistration;
+    refexp.RegisterModel       = R_Null_RegisterModel;
+    refexp.RegisterSkin        = R_Null_RegisterImage;
+    refexp.RegisterPic         = R_Null_RegisterImage;
+    refexp.SetSky              = R_Null_SetSky;
+    refexp.EndRegistration     = R_Null_EndRegistration;
+    refexp.RenderFrame         = R_Null_RenderFrame;
+    refexp.DrawGetPicSize      = R_Null_DrawGetPicSize;
+    refexp.DrawPic             = R_Null_DrawPic;
+    refexp.DrawStretchPic      = R_Null_DrawStretchPic;
+    refexp.DrawChar            = R_Null_DrawChar;
+    refexp.DrawTileClear       = R_Null_DrawStretchPic;
+    refexp.DrawFill            = R_Null_DrawFill;
+    refexp.DrawFadeScreen      = R_Null_DrawFadeScreen;
+    refexp.DrawStretchRaw      = R_Null_DrawStretchRaw;
+    refexp.CinematicSetPalette = R_Null_CinematicSetPalette;
+    refexp.BeginFrame          = R_Null_BeginFrame;
+    refexp.EndFrame            = R_Null_EndFrame;
+    refexp.AppActivate         = R_Null_AppActivate;
+
     return refexp;
 }
 
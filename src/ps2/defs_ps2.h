@@ -13,7 +13,21 @@
 #ifndef DEFS_PS2_H
 #define DEFS_PS2_H
 
+#ifdef _EE
 #include <tamtypes.h>
+#else // !_EE
+// Host builds (see 'make host-bench') don't have the PS2DEV SDK types.
+#include <stdint.h>
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef int64_t  s64;
+typedef unsigned __int128 u128;
+#endif // _EE
 
 // Shorthand for the awfully verbose GCC attribute...
 #define PS2_ALIGN(alignment) __attribute__((aligned(alignment)))
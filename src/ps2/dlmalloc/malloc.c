@@ -242,6 +242,14 @@ extern void * ps2_sbrk(size_t increment);
 #define MMAP_CLEARS   0
 #define USE_DL_PREFIX 1
 
+// LAMPERT: Quadword alignment, like the system malloc, since
+// the EE 128-bit loads/stores and DMA transfers expect it.
+#define MALLOC_ALIGNMENT 16
+
+// LAMPERT: Independent malloc states, one per memory tag.
+// See ps2_dl_select() near the end of the file.
+#define PS2_DL_MAX_SPACES 8
+
 // ----------------------------------------------------------------------------
 
 /*
@@ -2516,7 +2524,13 @@ typedef struct malloc_state * mstate;
    all zeroes (as is true of C statics).
 */
 
-static struct malloc_state av_; /* never directly referenced */
+/*
+  LAMPERT: We keep PS2_DL_MAX_SPACES of these, selected with
+  ps2_dl_select() before calling into the allocator. MORECORE
+  grows the region of the currently selected space.
+*/
+static struct malloc_state av_[PS2_DL_MAX_SPACES]; /* never directly referenced */
+static int av_current = 0;
 
 /*
    All uses of av_ are via get_malloc_state().
@@ -2526,7 +2540,7 @@ static struct malloc_state av_; /* never directly referenced */
    Also, it is called in check* routines if DL_DEBUG is set.
 */
 
-#define get_malloc_state() (&(av_))
+#define get_malloc_state() (&(av_[av_current]))
 
 /*
   Initialize a malloc_state struct.
@@ -5665,6 +5679,43 @@ static int cpuinfo(int whole, CHUNK_SIZE_T * kernel, CHUNK_SIZE_T * user)
 
 #endif /* WIN32 */
 
+/*
+  ------------------------- PLAYSTATION 2 SPACES -------------------------
+
+  LAMPERT: Minimal multi-space support for 2.7.2. This version predates
+  mspaces, but since all allocator state lives in struct malloc_state,
+  switching between several of them gives the same effect. The caller
+  (mem_alloc.c) selects a space before each malloc/memalign/free and
+  provides a separate MORECORE region for each one. Not thread-safe.
+*/
+
+void ps2_dl_select(int space)
+{
+    assert(space >= 0 && space < PS2_DL_MAX_SPACES);
+    av_current = space;
+}
+
+/* Forgets every chunk in the space. The caller resets its MORECORE region. */
+void ps2_dl_reset(int space)
+{
+    assert(space >= 0 && space < PS2_DL_MAX_SPACES);
+    MALLOC_ZERO(&av_[space], sizeof(struct malloc_state));
+}
+
+/* Bytes taken from MORECORE and bytes in allocated chunks (incl. headers). */
+void ps2_dl_stats(int space, size_t * footprint, size_t * in_use)
+{
+    const int prev = av_current;
+    struct mallinfo mi;
+
+    av_current = space;
+    mi = mALLINFo();
+    av_current = prev;
+
+    *footprint = (size_t)mi.arena;
+    *in_use = (size_t)mi.uordblks;
+}
+
 /* ------------------------------------------------------------
 History:
     V2.7.2 Sat Aug 17 09:07:30 2002  Doug Lea  (dl at gee)
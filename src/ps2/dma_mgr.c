@@ -122,8 +122,10 @@ void VIFDMA_Shutdown(ps2_vif_dma_obj_t obj)
 
     if (base->mem_pages != NULL)
     {
-        free(base->mem_pages[0].start_ptr); // First page has the start pointer for the block.
-        free(base->mem_pages);              // The array was also heap allocated.
+        // First page has the start pointer for the block. Same size VIFDMA_Initialize allocated.
+        const int total_pages = (base->dma_type == VIF_DYNAMIC_DMA) ? (base->num_pages * 2) : base->num_pages;
+        PS2_MemFree(base->mem_pages[0].start_ptr, total_pages * 4096, MEMTAG_RENDERER);
+        free(base->mem_pages); // The array was also heap allocated.
     }
 
     memset(base, 0, sizeof(*base));
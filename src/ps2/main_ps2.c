@@ -25,6 +25,15 @@ extern void Test_PS2_Cinematics(void);  // ps2_prog = 2
 extern void Test_PS2_QuakeMenus(void);  // ps2_prog = 3
 extern void Test_PS2_VU1Triangle(void); // ps2_prog = 4
 extern void Test_PS2_VU1Cubes(void);    // ps2_prog = 5
+extern void Test_PS2_MemAlloc(void);    // ps2_prog = 6
+extern void Test_PS2_PakLoad(void);     // ps2_prog = 7
+extern void Test_PS2_TexCache(void);    // ps2_prog = 8
+extern void Test_PS2_TexPalette(void);  // ps2_prog = 9
+extern void Test_PS2_TexVRam(void);     // ps2_prog = 10
+extern void Test_PS2_TexMipmap(void);   // ps2_prog = 11
+extern void Test_PS2_VertPack(void);    // ps2_prog = 12
+extern void Test_PS2_VU1ListBench(void); // ps2_prog = 13
+extern void Test_PS2_WorldVis(void);    // ps2_prog = 14
 
 // Default value for ps2_prog CVar:
 #ifndef DEFAULT_PS2_PROG
@@ -60,13 +69,16 @@ int main(void)
         int newtime = 0;
         int oldtime = Sys_Milliseconds();
 
+        // Timedemos run as fast as possible, without frame pacing.
+        cvar_t * timedemo = Cvar_Get("timedemo", "0", 0);
+
         for (;;)
         {
             do
             {
                 newtime = Sys_Milliseconds();
                 time = newtime - oldtime;
-            } while (time < 1);
+            } while (time < 1 && !timedemo->value);
 
             Qcommon_Frame(time);
             oldtime = newtime;
@@ -91,6 +103,33 @@ int main(void)
         case 5 :
             Test_PS2_VU1Cubes();
             break;
+        case 6 :
+            Test_PS2_MemAlloc();
+            break;
+        case 7 :
+            Test_PS2_PakLoad();
+            break;
+        case 8 :
+            Test_PS2_TexCache();
+            break;
+        case 9 :
+            Test_PS2_TexPalette();
+            break;
+        case 10 :
+            Test_PS2_TexVRam();
+            break;
+        case 11 :
+            Test_PS2_TexMipmap();
+            break;
+        case 12 :
+            Test_PS2_VertPack();
+            break;
+        case 13 :
+            Test_PS2_VU1ListBench();
+            break;
+        case 14 :
+            Test_PS2_WorldVis();
+            break;
         default :
             break;
         } // switch (ps2_prog)
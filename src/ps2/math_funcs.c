@@ -13,6 +13,8 @@
 
 #include "ps2/math_funcs.h"
 
+#ifdef _EE
+
 // Asm code originally from Morten "Sparky" Mikkelsen's fast maths routines
 // (From a post on the forums at www.playstation2-linux.com)
 
@@ -156,6 +158,25 @@ float ps2_cosf(float x)
     return r;
 }
 
+#else // !_EE
+
+/*
+=================
+Host fallbacks (see 'make host-bench')
+=================
+*/
+float ps2_asinf(float x)
+{
+    return asinf(x);
+}
+
+float ps2_cosf(float x)
+{
+    return cosf(x);
+}
+
+#endif // _EE
+
 /*
 =================
 fmodf for the PS2
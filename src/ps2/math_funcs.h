@@ -26,6 +26,8 @@ float ps2_asinf(float x);
 float ps2_cosf(float x);
 float ps2_fmodf(float x, float y);
 
+#ifdef _EE
+
 static inline float ps2_fabsf(float x)
 {
 	float r;
@@ -66,6 +68,31 @@ static inline float ps2_sqrtf(float x)
 	return r;
 }
 
+#else // !_EE
+
+// Host builds (see 'make host-bench') use the C library versions.
+static inline float ps2_fabsf(float x)
+{
+	return fabsf(x);
+}
+
+static inline float ps2_minf(float a, float b)
+{
+	return (a < b) ? a : b;
+}
+
+static inline float ps2_maxf(float a, float b)
+{
+	return (a > b) ? a : b;
+}
+
+static inline float ps2_sqrtf(float x)
+{
+	return sqrtf(x);
+}
+
+#endif // _EE
+
 static inline float ps2_rsqrtf(float x)
 {
 	return 1.0f / ps2_sqrtf(x);
@@ -16,6 +16,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef _EE
+#include <malloc.h> // memalign() on host builds
+#endif // _EE
+
 // For debug printing
 const char * ps2_mem_tag_names[MEMTAG_COUNT] =
 {
@@ -31,6 +35,411 @@ const char * ps2_mem_tag_names[MEMTAG_COUNT] =
 // Tags updated on every alloc/free.
 ps2_mem_counters_t ps2_mem_tag_counts[MEMTAG_COUNT] = {0};
 
+//=============================================================================
+//
+// Size-class slab pools for small allocations:
+//
+// The region is split into PS2_SLAB_PAGE_SIZE pages. A page is given
+// to a size class on demand and is handed back to the free page list
+// once all of its objects are freed, so a page never stays stuck with
+// a class it no longer needs. Ownership of a pointer is a range check
+// on the region, so PS2_MemFree doesn't depend on the size passed in.
+//
+// Most of the slab footprint overhead isn't the size rounding but the
+// free objects sitting in partial pages, since each class sizes itself
+// for its own peak. So before a class takes a new page, it borrows an
+// object from a partial page of the next class up.
+//
+//=============================================================================
+
+int ps2_mem_slabs_enabled = 1;
+
+enum
+{
+    PS2_SLAB_NUM_CLASSES = 16,
+    PS2_SLAB_NUM_PAGES   = PS2_SLAB_REGION_SIZE / PS2_SLAB_PAGE_SIZE
+};
+
+// All multiples of 16, so every object is 16 bytes aligned.
+// Spaced so that rounding up wastes at most ~20% of a block.
+static const unsigned short ps2_slab_class_sizes[PS2_SLAB_NUM_CLASSES] =
+{
+    16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512
+};
+
+typedef struct ps2_slab_page_s
+{
+    struct ps2_slab_page_s * next; // Next page in the class partial list or in the free page list.
+    struct ps2_slab_page_s * prev;
+    void * free_objs;              // Singly linked list threaded through the free objects.
+    unsigned short used;           // Live objects in this page.
+    unsigned char size_class;
+} ps2_slab_page_t;
+
+static byte * ps2_slab_region = NULL;
+static ps2_slab_page_t ps2_slab_pages[PS2_SLAB_NUM_PAGES];
+static ps2_slab_page_t * ps2_slab_free_pages = NULL;
+static ps2_slab_page_t * ps2_slab_partial[PS2_SLAB_NUM_CLASSES]; // Pages with at least one free object.
+static unsigned int ps2_slab_pages_used = 0;
+
+// Maps (size - 1) / 16 to the smallest class that fits.
+static unsigned char ps2_slab_class_lut[PS2_SLAB_MAX_SIZE / 16];
+
+/*
+================
+PS2_SlabInit
+================
+*/
+static int PS2_SlabInit(void)
+{
+    int i, c;
+
+    ps2_slab_region = memalign(PS2_SLAB_PAGE_SIZE, PS2_SLAB_REGION_SIZE);
+    if (ps2_slab_region == NULL)
+    {
+        ps2_mem_slabs_enabled = 0;
+        return 0;
+    }
+
+    for (i = PS2_SLAB_NUM_PAGES - 1; i >= 0; --i)
+    {
+        ps2_slab_pages[i].next = ps2_slab_free_pages;
+        ps2_slab_free_pages = &ps2_slab_pages[i];
+    }
+
+    for (i = 0, c = 0; i < PS2_SLAB_MAX_SIZE / 16; ++i)
+    {
+        while (ps2_slab_class_sizes[c] < (i + 1) * 16)
+        {
+            ++c;
+        }
+        ps2_slab_class_lut[i] = (unsigned char)c;
+    }
+
+    // The region is accounted for per object, in each tag's slab_bytes.
+    return 1;
+}
+
+static inline byte * PS2_SlabPageBase(const ps2_slab_page_t * page)
+{
+    return ps2_slab_region + (page - ps2_slab_pages) * PS2_SLAB_PAGE_SIZE;
+}
+
+static inline void PS2_SlabUnlinkPartial(ps2_slab_page_t * page)
+{
+    if (page->prev != NULL)
+    {
+        page->prev->next = page->next;
+    }
+    else
+    {
+        ps2_slab_partial[page->size_class] = page->next;
+    }
+    if (page->next != NULL)
+    {
+        page->next->prev = page->prev;
+    }
+    page->next = page->prev = NULL;
+}
+
+static inline void PS2_SlabLinkPartial(ps2_slab_page_t * page)
+{
+    page->prev = NULL;
+    page->next = ps2_slab_partial[page->size_class];
+    if (page->next != NULL)
+    {
+        page->next->prev = page;
+    }
+    ps2_slab_partial[page->size_class] = page;
+}
+
+/*
+================
+PS2_SlabAlloc
+
+Returns NULL if the request must go to malloc instead.
+================
+*/
+static void * PS2_SlabAlloc(int size_bytes, ps2_mem_tag_t tag)
+{
+    int c, i, obj_size, num_objs;
+    ps2_slab_page_t * page;
+    byte * base;
+    void * obj;
+
+    if (!ps2_mem_slabs_enabled || size_bytes > PS2_SLAB_MAX_SIZE)
+    {
+        return NULL;
+    }
+    if (ps2_slab_region == NULL && !PS2_SlabInit())
+    {
+        return NULL;
+    }
+
+    c = ps2_slab_class_lut[(size_bytes - 1) >> 4];
+    obj_size = ps2_slab_class_sizes[c];
+
+    page = ps2_slab_partial[c];
+    if (page == NULL && c + 1 < PS2_SLAB_NUM_CLASSES && ps2_slab_partial[c + 1] != NULL)
+    {
+        // Borrow from the next class rather than take a new page.
+        page = ps2_slab_partial[++c];
+        obj_size = ps2_slab_class_sizes[c];
+    }
+    if (page == NULL)
+    {
+        // Grab an empty page and thread a free list through it.
+        page = ps2_slab_free_pages;
+        if (page == NULL)
+        {
+            return NULL; // Region is full.
+        }
+        ps2_slab_free_pages = page->next;
+        ps2_slab_pages_used++;
+
+        base = PS2_SlabPageBase(page);
+        num_objs = PS2_SLAB_PAGE_SIZE / obj_size;
+        for (i = 0; i < num_objs - 1; ++i)
+        {
+            *(void **)(base + i * obj_size) = base + (i + 1) * obj_size;
+        }
+        *(void **)(base + i * obj_size) = NULL;
+
+        page->free_objs  = base;
+        page->used       = 0;
+        page->size_class = (unsigned char)c;
+        PS2_SlabLinkPartial(page);
+    }
+
+    obj = page->free_objs;
+    page->free_objs = *(void **)obj;
+    page->used++;
+
+    if (page->free_objs == NULL)
+    {
+        PS2_SlabUnlinkPartial(page); // Now full.
+    }
+
+    ps2_mem_tag_counts[tag].slab_bytes += obj_size;
+    ps2_mem_tag_counts[tag].slab_allocs++;
+    return obj;
+}
+
+/*
+================
+PS2_SlabFree
+
+Returns 0 if the pointer doesn't belong to the slab region.
+================
+*/
+static int PS2_SlabFree(void * ptr, ps2_mem_tag_t tag)
+{
+    ps2_slab_page_t * page;
+    const byte * p = (const byte *)ptr;
+
+    if (ps2_slab_region == NULL)
+    {
+        return 0;
+    }
+    if (p < ps2_slab_region || p >= ps2_slab_region + PS2_SLAB_REGION_SIZE)
+    {
+        return 0;
+    }
+
+    page = &ps2_slab_pages[(p - ps2_slab_region) / PS2_SLAB_PAGE_SIZE];
+    if (page->free_objs == NULL)
+    {
+        PS2_SlabLinkPartial(page); // Was full.
+    }
+
+    *(void **)ptr = page->free_objs;
+    page->free_objs = ptr;
+    page->used--;
+
+    ps2_mem_tag_counts[tag].slab_bytes -= ps2_slab_class_sizes[page->size_class];
+
+    if (page->used == 0)
+    {
+        // Give the page back so any size class can use it.
+        PS2_SlabUnlinkPartial(page);
+        page->next = ps2_slab_free_pages;
+        ps2_slab_free_pages = page;
+        ps2_slab_pages_used--;
+    }
+
+    return 1;
+}
+
+/*
+================
+PS2_SlabGetUsage
+================
+*/
+void PS2_SlabGetUsage(unsigned int * pages_used, unsigned int * pages_total)
+{
+    *pages_used  = ps2_slab_pages_used;
+    *pages_total = (ps2_slab_region != NULL) ? PS2_SLAB_NUM_PAGES : 0;
+}
+
+//=============================================================================
+//
+// Per-tag dlmalloc spaces:
+//
+// The bundled dlmalloc (ps2/dlmalloc/malloc.c) keeps one malloc state
+// for each memory tag. A space grows through ps2_sbrk() inside its own
+// region, reserved on first use with the size of the tag's budget, so a
+// tag can't take more than its budget, its footprint is known exactly,
+// and all of its memory can be dropped at once with PS2_MemResetTag().
+//
+//=============================================================================
+
+// dlmalloc entry points (compiled with USE_DL_PREFIX):
+extern void * dlmalloc(size_t size);
+extern void * dlmemalign(size_t alignment, size_t size);
+extern void dlfree(void * ptr);
+extern void ps2_dl_select(int space);
+extern void ps2_dl_reset(int space);
+extern void ps2_dl_stats(int space, size_t * footprint, size_t * in_use);
+
+// Must match PS2_DL_MAX_SPACES in malloc.c.
+enum { PS2_MEM_MAX_SPACES = 8 };
+
+// Hard limits for each tag, sized to fit in the 32MB of EE RAM
+// together with the executable and the slab region.
+static const unsigned int ps2_mem_tag_budgets[MEMTAG_COUNT] =
+{
+    2  * 1024 * 1024, // MEMTAG_MISC
+    5  * 1024 * 1024, // MEMTAG_QUAKE
+    3  * 1024 * 1024, // MEMTAG_RENDERER
+    7  * 1024 * 1024, // MEMTAG_TEXIMAGE
+    3  * 1024 * 1024, // MEMTAG_MDL_ALIAS
+    512 * 1024,       // MEMTAG_MDL_SPRITE
+    6  * 1024 * 1024  // MEMTAG_MDL_WORLD
+};
+
+typedef struct
+{
+    byte * base; // Start of the region. NULL until the tag's first allocation.
+    byte * brk;  // Current break, as returned by ps2_sbrk().
+    byte * end;
+} ps2_mem_space_t;
+
+static ps2_mem_space_t ps2_mem_spaces[MEMTAG_COUNT];
+static ps2_mem_space_t * ps2_mem_curr_space = NULL;
+
+/*
+================
+ps2_sbrk
+
+dlmalloc's MORECORE. Moves the break of the selected space.
+================
+*/
+void * ps2_sbrk(size_t increment)
+{
+    const ptrdiff_t delta = (ptrdiff_t)increment;
+    ps2_mem_space_t * space = ps2_mem_curr_space;
+    byte * old_brk = space->brk;
+
+    if (delta > space->end - old_brk || delta < space->base - old_brk)
+    {
+        return (void *)(-1); // MORECORE_FAILURE
+    }
+
+    space->brk += delta;
+    return old_brk;
+}
+
+/*
+================
+PS2_MemSelectSpace
+
+Returns 0 if the tag's region couldn't be reserved.
+================
+*/
+static int PS2_MemSelectSpace(ps2_mem_tag_t tag)
+{
+    ps2_mem_space_t * space = &ps2_mem_spaces[tag];
+
+    if (space->base == NULL)
+    {
+        space->base = memalign(16, ps2_mem_tag_budgets[tag]);
+        if (space->base == NULL)
+        {
+            return 0;
+        }
+        space->brk = space->base;
+        space->end = space->base + ps2_mem_tag_budgets[tag];
+    }
+
+    ps2_mem_curr_space = space;
+    ps2_dl_select(tag);
+    return 1;
+}
+
+/*
+================
+PS2_MemSpaceOf
+
+Tag whose region holds the pointer, or -1.
+================
+*/
+static int PS2_MemSpaceOf(const void * ptr)
+{
+    int i;
+    const byte * p = (const byte *)ptr;
+
+    for (i = 0; i < MEMTAG_COUNT; ++i)
+    {
+        if (p >= ps2_mem_spaces[i].base && p < ps2_mem_spaces[i].brk)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+================
+PS2_MemGetSpaceUsage
+================
+*/
+void PS2_MemGetSpaceUsage(ps2_mem_tag_t tag, unsigned int * footprint,
+                          unsigned int * in_use, unsigned int * budget)
+{
+    size_t fp = 0, used = 0;
+
+    if (ps2_mem_spaces[tag].base != NULL)
+    {
+        ps2_dl_stats(tag, &fp, &used);
+    }
+
+    *footprint = (unsigned int)fp;
+    *in_use    = (unsigned int)used;
+    *budget    = ps2_mem_tag_budgets[tag];
+}
+
+/*
+================
+PS2_MemResetTag
+================
+*/
+void PS2_MemResetTag(ps2_mem_tag_t tag)
+{
+    ps2_mem_space_t * space = &ps2_mem_spaces[tag];
+
+    if (space->base == NULL)
+    {
+        return;
+    }
+
+    ps2_dl_reset(tag);
+    space->brk = space->base;
+
+    ps2_mem_tag_counts[tag].total_frees += ps2_mem_tag_counts[tag].total_allocs -
+                                           ps2_mem_tag_counts[tag].total_frees;
+    ps2_mem_tag_counts[tag].total_bytes = 0;
+}
+
 //=============================================================================
 //
 // malloc/free hooks:
@@ -51,15 +460,20 @@ static void PS2_OutOfMemoryError(int alloc_attempt_size, ps2_mem_tag_t tag)
     char * ptr = tags_dump_str;
     unsigned int i, mem_total = 0;
 
-    ptr += sprintf(ptr, "Tag Name   Bytes      Allocs  Frees   Small   Large\n");
+    ptr += sprintf(ptr, "Tag Name   Bytes      Space      Budget     Allocs  Frees   Small   Large\n");
 
     for (i = 0; i < MEMTAG_COUNT; ++i)
     {
+        unsigned int footprint, in_use, budget;
+        PS2_MemGetSpaceUsage(i, &footprint, &in_use, &budget);
+
         mem_total += ps2_mem_tag_counts[i].total_bytes;
-        const char * total_str = PS2_FormatMemoryUnit(ps2_mem_tag_counts[i].total_bytes, true);
+        const char * total_str  = PS2_FormatMemoryUnit(ps2_mem_tag_counts[i].total_bytes, true);
+        const char * space_str  = PS2_FormatMemoryUnit(footprint, true);
+        const char * budget_str = PS2_FormatMemoryUnit(budget, true);
 
-        ptr += sprintf(ptr, "%-10s %-10s %-7d %-7d %-7d %-7d\n",
-                ps2_mem_tag_names[i], total_str,
+        ptr += sprintf(ptr, "%-10s %-10s %-10s %-10s %-7d %-7d %-7d %-7d\n",
+                ps2_mem_tag_names[i], total_str, space_str, budget_str,
                 ps2_mem_tag_counts[i].total_allocs,
                 ps2_mem_tag_counts[i].total_frees,
                 ps2_mem_tag_counts[i].smallest_alloc,
@@ -88,7 +502,11 @@ void * PS2_MemAlloc(int size_bytes, ps2_mem_tag_t tag)
         Sys_Error("Trying to allocate zero or negative size (%d)!", size_bytes);
     }
 
-    void * ptr = malloc(size_bytes);
+    void * ptr = PS2_SlabAlloc(size_bytes, tag);
+    if (ptr == NULL && PS2_MemSelectSpace(tag))
+    {
+        ptr = dlmalloc(size_bytes);
+    }
     if (ptr == NULL)
     {
         PS2_OutOfMemoryError(size_bytes, tag);
@@ -127,7 +545,12 @@ void * PS2_MemAllocAligned(int alignment, int size_bytes, ps2_mem_tag_t tag)
         Sys_Error("PS2_MemAllocAligned: Bad alignment: %d!", alignment);
     }
 
-    void * ptr = memalign(alignment, size_bytes);
+    // Slab objects are always 16 bytes aligned.
+    void * ptr = (alignment <= 16) ? PS2_SlabAlloc(size_bytes, tag) : NULL;
+    if (ptr == NULL && PS2_MemSelectSpace(tag))
+    {
+        ptr = dlmemalign(alignment, size_bytes);
+    }
     if (ptr == NULL)
     {
         PS2_OutOfMemoryError(size_bytes, tag);
@@ -165,8 +588,22 @@ void PS2_MemFree(void * ptr, int size_bytes, ps2_mem_tag_t tag)
     ps2_mem_tag_counts[tag].total_bytes -= size_bytes;
     ps2_mem_tag_counts[tag].total_frees++;
 
-    // Good for both malloc() and memalign().
-    free(ptr);
+    if (PS2_SlabFree(ptr, tag))
+    {
+        return;
+    }
+
+    // Look up the space by address rather than trusting 'tag'.
+    const int space = PS2_MemSpaceOf(ptr);
+    if (space < 0)
+    {
+        Sys_Error("PS2_MemFree: %p was not allocated by PS2_MemAlloc!", ptr);
+    }
+
+    // Good for both dlmalloc() and dlmemalign().
+    ps2_mem_curr_space = &ps2_mem_spaces[space];
+    ps2_dl_select(space);
+    dlfree(ptr);
 }
 
 /*
@@ -350,3 +787,94 @@ int Hunk_GetTail(mem_hunk_t * hunk)
 {
     return hunk->curr_size;
 }
+
+//=============================================================================
+//
+// Per-frame scratch allocators:
+//
+// Each arena is a hunk that gets rewound on Frame_MemReset. The hunk
+// is only allocated the first time the arena is used, so builds that
+// never touch one of them (e.g. the dedicated server) don't pay for it.
+//
+//=============================================================================
+
+typedef struct
+{
+    mem_hunk_t hunk;
+    int budget;
+    int mem_tag;
+    int high_water;
+} frame_mem_t;
+
+static frame_mem_t ps2_frame_mem[FRAME_MEM_COUNT] =
+{
+    { {0}, 64 * 1024, MEMTAG_RENDERER, 0 }, // FRAME_MEM_REFRESH
+    { {0}, 16 * 1024, MEMTAG_QUAKE,    0 }  // FRAME_MEM_SERVER
+};
+
+/*
+================
+Frame_MemAlloc
+================
+*/
+void * Frame_MemAlloc(frame_mem_arena_t arena, int size_bytes)
+{
+    frame_mem_t * fm = &ps2_frame_mem[arena];
+
+    if (fm->hunk.base_ptr == NULL)
+    {
+        Hunk_New(&fm->hunk, fm->budget, fm->mem_tag);
+    }
+
+    byte * ptr = Hunk_BlockAlloc(&fm->hunk, size_bytes);
+    if (fm->hunk.curr_size > fm->high_water)
+    {
+        fm->high_water = fm->hunk.curr_size;
+    }
+    return ptr;
+}
+
+/*
+================
+Frame_MemReset
+================
+*/
+void Frame_MemReset(frame_mem_arena_t arena)
+{
+    ps2_frame_mem[arena].hunk.curr_size = 0;
+}
+
+/*
+================
+Frame_MemGetMark
+================
+*/
+int Frame_MemGetMark(frame_mem_arena_t arena)
+{
+    return ps2_frame_mem[arena].hunk.curr_size;
+}
+
+/*
+================
+Frame_MemFreeToMark
+================
+*/
+void Frame_MemFreeToMark(frame_mem_arena_t arena, int mark)
+{
+    if (mark < 0 || mark > ps2_frame_mem[arena].hunk.curr_size)
+    {
+        Sys_Error("Frame_MemFreeToMark: Bad mark %d!", mark);
+    }
+    ps2_frame_mem[arena].hunk.curr_size = mark;
+}
+
+/*
+================
+Frame_MemGetUsage
+================
+*/
+void Frame_MemGetUsage(frame_mem_arena_t arena, int * high_water, int * budget)
+{
+    *high_water = ps2_frame_mem[arena].high_water;
+    *budget     = ps2_frame_mem[arena].budget;
+}
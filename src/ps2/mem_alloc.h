@@ -34,6 +34,8 @@ typedef struct
     unsigned int total_frees;
     unsigned int smallest_alloc;
     unsigned int largest_alloc;
+    unsigned int slab_bytes;  // Bytes currently held in slab objects (rounded up to the size class).
+    unsigned int slab_allocs; // Allocations served by the slab pools so far.
 } ps2_mem_counters_t;
 
 extern const char * ps2_mem_tag_names[MEMTAG_COUNT];        // Printable strings for the above enum.
@@ -45,6 +47,33 @@ void * PS2_MemAllocAligned(int alignment, int size_bytes, ps2_mem_tag_t tag);
 void PS2_MemFree(void * ptr, int size_bytes, ps2_mem_tag_t tag);
 void PS2_TagsAddMem(ps2_mem_tag_t tag, unsigned int size_bytes);
 
+// Everything else comes from dlmalloc, with a separate space for each tag.
+// A space lives in a fixed region the size of the tag's budget, so running
+// over the budget fails right away with the out-of-memory report.
+// 'footprint' is what the space took from its region, 'in_use' the part of
+// it in live blocks (including dlmalloc headers), so their difference is
+// the space's free/fragmented memory.
+void PS2_MemGetSpaceUsage(ps2_mem_tag_t tag, unsigned int * footprint,
+                          unsigned int * in_use, unsigned int * budget);
+
+// Drops every dlmalloc block of the tag at once (slab objects are not affected).
+// Any pointer still held into that tag becomes invalid.
+void PS2_MemResetTag(ps2_mem_tag_t tag);
+
+// Small allocations (up to PS2_SLAB_MAX_SIZE) are served from size-class
+// slab pools carved out of one fixed region, falling back to malloc when the
+// region is full. Set ps2_mem_slabs_enabled to 0 to bypass them (benchmarks).
+// Pages are kept small, since every class holds on to the free objects of its
+// partial pages (see 'mem_bench' for the footprint against plain dlmalloc).
+enum
+{
+    PS2_SLAB_MAX_SIZE    = 512,
+    PS2_SLAB_PAGE_SIZE   = 2048,
+    PS2_SLAB_REGION_SIZE = 1024 * 1024
+};
+extern int ps2_mem_slabs_enabled;
+void PS2_SlabGetUsage(unsigned int * pages_used, unsigned int * pages_total);
+
 // Formatter for printing the memory tags.
 const char * PS2_FormatMemoryUnit(unsigned int memorySizeInBytes, int abbreviated);
 
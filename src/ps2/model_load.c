@@ -13,7 +13,9 @@
 #include "ps2/model_load.h"
 #include "ps2/ref_ps2.h"
 #include "ps2/mem_alloc.h"
+#include "ps2/name_index.h"
 #include "common/q_files.h"
+#include "common/q_ltrace.h"
 
 // d*_t structures are on-disk representation
 // m*_t structures are in-memory representation
@@ -45,6 +47,9 @@ static cvar_t * r_ps2_flush_map = NULL;
 // If set we don't load the MD2 and sprite models, making them render as null models.
 static cvar_t * r_ps2_force_null_entity_models = NULL;
 
+// If set, maps/<name>.pcw is loaded instead of the .bsp when there is one (see src/tools/worldcook.c).
+static cvar_t * r_ps2_cooked_world = NULL;
+
 // World instance. Usually a reference to ps2_model_pool[0].
 static ps2_model_t * ps2_world_model = NULL;
 
@@ -55,11 +60,16 @@ static ps2_model_t ps2_model_pool[PS2_MDL_POOL_SIZE];
 // These are only referenced by the world geometry.
 static ps2_model_t ps2_inline_models[PS2_MDL_POOL_SIZE];
 
+// Name lookups into ps2_model_pool[]. Models are added once loaded
+// (their type is only known then) and removed by PS2_ModelFree.
+static ps2_name_slot_t ps2_model_slots[PS2_NAME_INDEX_SLOTS(PS2_MDL_POOL_SIZE)];
+static ps2_name_index_t ps2_model_index;
+
 // Used to hash the model filenames.
 extern u32 Sys_HashString(const char * str);
 
-// For the fixed-size world chunk.
-#define MEGABYTES(n) ((n) * 1024 * 1024)
+// Size of a Hunk_BlockAlloc() request after rounding.
+#define HUNK_BLOCK_SIZE(n) (((n) + 31) & ~31)
 
 //=============================================================================
 
@@ -77,6 +87,9 @@ void PS2_ModelInit(void)
 
     r_ps2_force_null_entity_models = Cvar_Get("r_ps2_force_null_entity_models", "1", 0);
     r_ps2_flush_map = Cvar_Get("r_ps2_flush_map", "0", 0);
+    r_ps2_cooked_world = Cvar_Get("r_ps2_cooked_world", "1", 0);
+
+    PS2_NameIndexInit(&ps2_model_index, ps2_model_slots, PS2_NAME_INDEX_SLOTS(PS2_MDL_POOL_SIZE));
 }
 
 /*
@@ -98,6 +111,7 @@ void PS2_ModelShutdown(void)
 
     memset(ps2_model_pool,    0, sizeof(ps2_model_pool));
     memset(ps2_inline_models, 0, sizeof(ps2_inline_models));
+    PS2_NameIndexClear(&ps2_model_index);
 
     ps2_model_pool_used    = 0;
     ps2_inline_models_used = 0;
@@ -146,6 +160,7 @@ void PS2_ModelFree(ps2_model_t * mdl)
     }
 
     Hunk_Free(&mdl->hunk);
+    PS2_NameIndexRemove(&ps2_model_index, mdl->hash, mdl - ps2_model_pool);
     PS2_MemClearObj(mdl);
     --ps2_model_pool_used;
 }
@@ -171,6 +186,19 @@ void PS2_ModelFreeUnused(void)
             ++ps2_unused_models_freed;
         }
     }
+
+    // Get rid of the tombstones left by the models just freed.
+    if (PS2_NameIndexNeedsRebuild(&ps2_model_index))
+    {
+        PS2_NameIndexClear(&ps2_model_index);
+        for (i = 0, model_iter = ps2_model_pool; i < PS2_MDL_POOL_SIZE; ++i, ++model_iter)
+        {
+            if (model_iter->type != MDL_NULL)
+            {
+                PS2_NameIndexInsert(&ps2_model_index, model_iter->hash, i);
+            }
+        }
+    }
 }
 
 //=============================================================================
@@ -558,9 +586,11 @@ static void BMod_LoadTexInfo(ps2_model_t * mdl, const byte * mdl_data, const lum
     int i, j;
     for (i = 0; i < count; ++i, ++in, ++out)
     {
+        // Both rows. Indexing past vecs[0] is undefined, and the host GCC
+        // build used by the world cooker does drop the second row for it.
         for (j = 0; j < 8; ++j)
         {
-            out->vecs[0][j] = LittleFloat(in->vecs[0][j]);
+            out->vecs[j / 4][j % 4] = LittleFloat(in->vecs[j / 4][j % 4]);
         }
 
         out->flags = LittleLong(in->flags);
@@ -1388,49 +1418,85 @@ static void BMod_LoadSubmodels(ps2_model_t * mdl, const byte * mdl_data, const l
 
 /*
 ==============
-PS2_LoadBrushModel
+PS2_BrushModelHunkSize
 
 Remarks: Local function.
-Fails with a Sys_Error if the data is invalid.
-Adapted from ref_gl.
+Pre-pass over the BSP lumps that computes the exact hunk size
+the BMod_Load* functions will need, so the whole world fits in
+a single allocation with no slack. Must mirror the allocations
+made by the loaders. Header is not byte-swapped yet.
 ==============
 */
-static void PS2_LoadBrushModel(ps2_model_t * mdl, void * mdl_data)
+static int PS2_BrushModelHunkSize(const byte * mdl_data)
 {
-    if (mdl != &ps2_model_pool[0])
-    {
-        Sys_Error("Loaded a brush model after the world!");
-    }
+    int i, size;
+    const dheader_t * header = (const dheader_t *)mdl_data;
 
-    int i;
-    dheader_t * header = (dheader_t *)mdl_data;
-    const int version  = LittleLong(header->version);
+    #define LUMP_LEN(l)   LittleLong(header->lumps[(l)].filelen)
+    #define LUMP_COUNT(l, t) (LUMP_LEN(l) / (int)sizeof(t))
 
-    if (version != BSPVERSION)
+    size  = HUNK_BLOCK_SIZE(LUMP_COUNT(LUMP_VERTEXES, dvertex_t) * sizeof(ps2_mdl_vertex_t));
+    size += HUNK_BLOCK_SIZE((LUMP_COUNT(LUMP_EDGES, dedge_t) + 1) * sizeof(ps2_mdl_edge_t));
+    size += HUNK_BLOCK_SIZE(LUMP_COUNT(LUMP_SURFEDGES, int) * sizeof(int));
+    size += HUNK_BLOCK_SIZE(LUMP_COUNT(LUMP_PLANES, dplane_t) * 2 * sizeof(cplane_t));
+    size += HUNK_BLOCK_SIZE(LUMP_COUNT(LUMP_TEXINFO, textureinfo_t) * sizeof(ps2_mdl_texinfo_t));
+    size += HUNK_BLOCK_SIZE(LUMP_COUNT(LUMP_FACES, dface_t) * sizeof(ps2_mdl_surface_t));
+    size += HUNK_BLOCK_SIZE(LUMP_COUNT(LUMP_LEAFFACES, s16) * sizeof(ps2_mdl_surface_t *));
+    size += HUNK_BLOCK_SIZE(LUMP_COUNT(LUMP_LEAFS, dleaf_t) * sizeof(ps2_mdl_leaf_t));
+    size += HUNK_BLOCK_SIZE(LUMP_COUNT(LUMP_NODES, dnode_t) * sizeof(ps2_mdl_node_t));
+    size += HUNK_BLOCK_SIZE(LUMP_COUNT(LUMP_MODELS, dmodel_t) * sizeof(ps2_mdl_submod_t));
+
+    // Raw copies:
+    if (LUMP_LEN(LUMP_LIGHTING) > 0)
     {
-        Sys_Error("PS2_LoadBrushModel: '%s' has wrong version number (%i should be %i)",
-                  mdl->name, version, BSPVERSION);
+        size += HUNK_BLOCK_SIZE(LUMP_LEN(LUMP_LIGHTING));
+    }
+    if (LUMP_LEN(LUMP_VISIBILITY) > 0)
+    {
+        size += HUNK_BLOCK_SIZE(LUMP_LEN(LUMP_VISIBILITY));
     }
 
-    // Byte-swap the header fields:
-    for (i = 0; i < sizeof(dheader_t) / 4; ++i)
+    // One polygon per non-warped face (see BMod_BuildPolygonFromSurface).
+    const textureinfo_t * texinfos = (const textureinfo_t *)(mdl_data + LittleLong(header->lumps[LUMP_TEXINFO].fileofs));
+    const int num_texinfos = LUMP_COUNT(LUMP_TEXINFO, textureinfo_t);
+    const dface_t * face = (const dface_t *)(mdl_data + LittleLong(header->lumps[LUMP_FACES].fileofs));
+    const int num_faces = LUMP_COUNT(LUMP_FACES, dface_t);
+
+    for (i = 0; i < num_faces; ++i, ++face)
     {
-        ((int *)header)[i] = LittleLong(((int *)header)[i]);
+        const int tex_num = LittleShort(face->texinfo);
+        if (tex_num >= 0 && tex_num < num_texinfos && (LittleLong(texinfos[tex_num].flags) & SURF_WARP))
+        {
+            continue;
+        }
+
+        const int num_verts = LittleShort(face->numedges);
+        size += HUNK_BLOCK_SIZE(sizeof(ps2_mdl_poly_t));
+        size += HUNK_BLOCK_SIZE(num_verts * sizeof(ps2_poly_vertex_t));
+        if (num_verts > 2)
+        {
+            size += HUNK_BLOCK_SIZE((num_verts - 2) * sizeof(ps2_mdl_triangle_t));
+        }
     }
 
-    // Load file contents into the in-memory model structure:
-    BMod_LoadVertexes(mdl, mdl_data, &header->lumps[LUMP_VERTEXES]);
-    BMod_LoadEdges(mdl, mdl_data, &header->lumps[LUMP_EDGES]);
-    BMod_LoadSurfEdges(mdl, mdl_data, &header->lumps[LUMP_SURFEDGES]);
-    BMod_LoadLighting(mdl, mdl_data, &header->lumps[LUMP_LIGHTING]);
-    BMod_LoadPlanes(mdl, mdl_data, &header->lumps[LUMP_PLANES]);
-    BMod_LoadTexInfo(mdl, mdl_data, &header->lumps[LUMP_TEXINFO]);
-    BMod_LoadFaces(mdl, mdl_data, &header->lumps[LUMP_FACES]);
-    BMod_LoadMarkSurfaces(mdl, mdl_data, &header->lumps[LUMP_LEAFFACES]);
-    BMod_LoadVisibility(mdl, mdl_data, &header->lumps[LUMP_VISIBILITY]);
-    BMod_LoadLeafs(mdl, mdl_data, &header->lumps[LUMP_LEAFS]);
-    BMod_LoadNodes(mdl, mdl_data, &header->lumps[LUMP_NODES]);
-    BMod_LoadSubmodels(mdl, mdl_data, &header->lumps[LUMP_MODELS]);
+    #undef LUMP_LEN
+    #undef LUMP_COUNT
+
+    return size;
+}
+
+/*
+==============
+PS2_SetupBrushModel
+
+Remarks: Local function.
+Sets up the inline models and references the textures once
+the arrays are loaded. Shared by the .bsp and cooked loaders.
+==============
+*/
+static void PS2_SetupBrushModel(ps2_model_t * mdl)
+{
+    int i;
 
     mdl->num_frames = 2; // regular and alternate animation
     mdl->type = MDL_BRUSH;
@@ -1472,12 +1538,519 @@ static void PS2_LoadBrushModel(ps2_model_t * mdl, void * mdl_data)
         }
         mdl->texinfos[i].teximage->registration_sequence = ps2ref.registration_sequence;
     }
+}
+
+/*
+==============
+PS2_LoadBrushModel
+
+Remarks: Local function.
+Fails with a Sys_Error if the data is invalid.
+Adapted from ref_gl.
+==============
+*/
+static void PS2_LoadBrushModel(ps2_model_t * mdl, void * mdl_data)
+{
+    if (mdl != &ps2_model_pool[0])
+    {
+        Sys_Error("Loaded a brush model after the world!");
+    }
+
+    int i;
+    dheader_t * header = (dheader_t *)mdl_data;
+    const int version  = LittleLong(header->version);
+
+    if (version != BSPVERSION)
+    {
+        Sys_Error("PS2_LoadBrushModel: '%s' has wrong version number (%i should be %i)",
+                  mdl->name, version, BSPVERSION);
+    }
+
+    // Byte-swap the header fields:
+    for (i = 0; i < sizeof(dheader_t) / 4; ++i)
+    {
+        ((int *)header)[i] = LittleLong(((int *)header)[i]);
+    }
+
+    // Load file contents into the in-memory model structure.
+    // In this order, since the later lumps reference the earlier ones.
+    static const struct
+    {
+        const char * stage; // For the load trace.
+        int lump;
+        void (*load)(ps2_model_t *, const byte *, const lump_t *);
+    } loaders[] = {
+        { "bsp:vertexes",  LUMP_VERTEXES,   &BMod_LoadVertexes     },
+        { "bsp:edges",     LUMP_EDGES,      &BMod_LoadEdges        },
+        { "bsp:surfedges", LUMP_SURFEDGES,  &BMod_LoadSurfEdges    },
+        { "bsp:lighting",  LUMP_LIGHTING,   &BMod_LoadLighting     },
+        { "bsp:planes",    LUMP_PLANES,     &BMod_LoadPlanes       },
+        { "bsp:texinfo",   LUMP_TEXINFO,    &BMod_LoadTexInfo      },
+        { "bsp:faces",     LUMP_FACES,      &BMod_LoadFaces        },
+        { "bsp:leaffaces", LUMP_LEAFFACES,  &BMod_LoadMarkSurfaces },
+        { "bsp:vis",       LUMP_VISIBILITY, &BMod_LoadVisibility   },
+        { "bsp:leafs",     LUMP_LEAFS,      &BMod_LoadLeafs        },
+        { "bsp:nodes",     LUMP_NODES,      &BMod_LoadNodes        },
+        { "bsp:models",    LUMP_MODELS,     &BMod_LoadSubmodels    }
+    };
+
+    for (i = 0; i < sizeof(loaders) / sizeof(loaders[0]); ++i)
+    {
+        const lump_t * lump = &header->lumps[loaders[i].lump];
+        const unsigned int trace_start = LTrace_Start();
+
+        loaders[i].load(mdl, mdl_data, lump);
+        LTrace_Stage(loaders[i].stage, mdl->name, lump->filelen, trace_start);
+    }
+
+    PS2_SetupBrushModel(mdl);
 
     #ifdef PS2_VERBOSE_MODEL_LOADER
     Com_DPrintf("New Brush model '%s' loaded!\n", mdl->name);
     #endif // PS2_VERBOSE_MODEL_LOADER
 }
 
+//=============================================================================
+//
+// Cooked world loading (see model_load.h and src/tools/worldcook.c):
+//
+//=============================================================================
+
+/*
+==============
+CWorld_LumpCount
+
+Remarks: Local function.
+==============
+*/
+static int CWorld_LumpCount(const ps2_model_t * mdl, const dcookedworld_t * header, int lump, int elem_size)
+{
+    const lump_t * l = &header->lumps[lump];
+    if (l->filelen % elem_size)
+    {
+        Sys_Error("PS2_LoadCookedWorld: Funny size for lump %i in '%s'", lump, mdl->name);
+    }
+    return l->filelen / elem_size;
+}
+
+/*
+==============
+CWorld_CopyLump
+
+Remarks: Local function.
+Lumps that are stored as they are in memory are just copied into the hunk.
+==============
+*/
+static void * CWorld_CopyLump(ps2_model_t * mdl, const byte * data, const dcookedworld_t * header, int lump, int alloc_size)
+{
+    const lump_t * l = &header->lumps[lump];
+    byte * out = Hunk_BlockAlloc(&mdl->hunk, alloc_size);
+    memcpy(out, data + l->fileofs, l->filelen);
+    return out;
+}
+
+/*
+==============
+PS2_CookedWorldHunkSize
+
+Remarks: Local function.
+Exact hunk size for PS2_LoadCookedWorld. Must mirror its allocations.
+==============
+*/
+static int PS2_CookedWorldHunkSize(const dcookedworld_t * header)
+{
+    int size;
+
+    #define CW_LEN(l) (header->lumps[(l)].filelen)
+    #define CW_COUNT(l, t) (CW_LEN(l) / (int)sizeof(t))
+
+    // Raw copies:
+    size  = HUNK_BLOCK_SIZE(CW_LEN(CW_LUMP_VERTEXES));
+    size += HUNK_BLOCK_SIZE(CW_LEN(CW_LUMP_EDGES) + sizeof(ps2_mdl_edge_t));
+    size += HUNK_BLOCK_SIZE(CW_LEN(CW_LUMP_SURFEDGES));
+    size += HUNK_BLOCK_SIZE(CW_LEN(CW_LUMP_PLANES) * 2);
+    size += HUNK_BLOCK_SIZE(CW_LEN(CW_LUMP_LIGHTING));
+    size += HUNK_BLOCK_SIZE(CW_LEN(CW_LUMP_VISIBILITY));
+    size += HUNK_BLOCK_SIZE(CW_LEN(CW_LUMP_POLYVERTS));
+    size += HUNK_BLOCK_SIZE(CW_LEN(CW_LUMP_TRIANGLES));
+    size += HUNK_BLOCK_SIZE(CW_LEN(CW_LUMP_SUBMODELS));
+
+    // Arrays with pointers:
+    size += HUNK_BLOCK_SIZE(CW_COUNT(CW_LUMP_TEXINFO, dcw_texinfo_t) * sizeof(ps2_mdl_texinfo_t));
+    size += HUNK_BLOCK_SIZE(CW_COUNT(CW_LUMP_POLYS, dcw_poly_t) * sizeof(ps2_mdl_poly_t));
+    size += HUNK_BLOCK_SIZE(CW_COUNT(CW_LUMP_SURFACES, dcw_surface_t) * sizeof(ps2_mdl_surface_t));
+    size += HUNK_BLOCK_SIZE(CW_COUNT(CW_LUMP_MARKSURFACES, int) * sizeof(ps2_mdl_surface_t *));
+    size += HUNK_BLOCK_SIZE(CW_COUNT(CW_LUMP_LEAFS, dcw_leaf_t) * sizeof(ps2_mdl_leaf_t));
+    size += HUNK_BLOCK_SIZE(CW_COUNT(CW_LUMP_NODES, dcw_node_t) * sizeof(ps2_mdl_node_t));
+
+    #undef CW_LEN
+    #undef CW_COUNT
+
+    return size;
+}
+
+/*
+==============
+PS2_LoadCookedWorld
+
+Remarks: Local function.
+Everything the .bsp loader computes is already in the file,
+so this is just copies plus turning the indexes back into pointers.
+==============
+*/
+static void PS2_LoadCookedWorld(ps2_model_t * mdl, const byte * data)
+{
+    // Set as the fall-back texture if loading fails.
+    extern ps2_teximage_t * ps2_builtin_tex_debug;
+    extern int Dbg_GetDebugColorIndex(void);
+
+    int i, j;
+    const dcookedworld_t * header = (const dcookedworld_t *)data;
+
+    #define CW_COUNT(l, t) CWorld_LumpCount(mdl, header, (l), sizeof(t))
+    #define CW_DATA(l, t)  ((const t *)(data + header->lumps[(l)].fileofs))
+
+    //
+    // Arrays stored as they are in memory:
+    //
+    mdl->num_vertexes = CW_COUNT(CW_LUMP_VERTEXES, ps2_mdl_vertex_t);
+    mdl->vertexes = CWorld_CopyLump(mdl, data, header, CW_LUMP_VERTEXES, mdl->num_vertexes * sizeof(ps2_mdl_vertex_t));
+
+    mdl->num_edges = CW_COUNT(CW_LUMP_EDGES, ps2_mdl_edge_t);
+    mdl->edges = CWorld_CopyLump(mdl, data, header, CW_LUMP_EDGES, (mdl->num_edges + 1) * sizeof(ps2_mdl_edge_t));
+
+    mdl->num_surf_edges = CW_COUNT(CW_LUMP_SURFEDGES, int);
+    mdl->surf_edges = CWorld_CopyLump(mdl, data, header, CW_LUMP_SURFEDGES, mdl->num_surf_edges * sizeof(int));
+
+    mdl->num_planes = CW_COUNT(CW_LUMP_PLANES, cplane_t);
+    mdl->planes = CWorld_CopyLump(mdl, data, header, CW_LUMP_PLANES, mdl->num_planes * 2 * sizeof(cplane_t));
+
+    mdl->num_submodels = CW_COUNT(CW_LUMP_SUBMODELS, ps2_mdl_submod_t);
+    mdl->submodels = CWorld_CopyLump(mdl, data, header, CW_LUMP_SUBMODELS, mdl->num_submodels * sizeof(ps2_mdl_submod_t));
+
+    const int light_len = header->lumps[CW_LUMP_LIGHTING].filelen;
+    mdl->light_data = (light_len > 0) ? CWorld_CopyLump(mdl, data, header, CW_LUMP_LIGHTING, light_len) : NULL;
+
+    const int vis_len = header->lumps[CW_LUMP_VISIBILITY].filelen;
+    mdl->vis = (vis_len > 0) ? CWorld_CopyLump(mdl, data, header, CW_LUMP_VISIBILITY, vis_len) : NULL;
+
+    const int num_poly_verts = CW_COUNT(CW_LUMP_POLYVERTS, ps2_poly_vertex_t);
+    ps2_poly_vertex_t * poly_verts = CWorld_CopyLump(mdl, data, header, CW_LUMP_POLYVERTS, num_poly_verts * sizeof(ps2_poly_vertex_t));
+
+    const int num_triangles = CW_COUNT(CW_LUMP_TRIANGLES, ps2_mdl_triangle_t);
+    ps2_mdl_triangle_t * triangles = CWorld_CopyLump(mdl, data, header, CW_LUMP_TRIANGLES, num_triangles * sizeof(ps2_mdl_triangle_t));
+
+    //
+    // Texinfos (the images are looked up by name):
+    //
+    const dcw_texinfo_t * texinfo_in = CW_DATA(CW_LUMP_TEXINFO, dcw_texinfo_t);
+    mdl->num_texinfos = CW_COUNT(CW_LUMP_TEXINFO, dcw_texinfo_t);
+    mdl->texinfos = (ps2_mdl_texinfo_t *)Hunk_BlockAlloc(&mdl->hunk, mdl->num_texinfos * sizeof(ps2_mdl_texinfo_t));
+
+    for (i = 0; i < mdl->num_texinfos; ++i)
+    {
+        const dcw_texinfo_t * in = &texinfo_in[i];
+        ps2_mdl_texinfo_t * out  = &mdl->texinfos[i];
+
+        memcpy(out->vecs, in->vecs, sizeof(out->vecs));
+        out->flags      = in->flags;
+        out->num_frames = in->num_frames;
+        out->next       = (in->next >= 0 && in->next < mdl->num_texinfos) ? mdl->texinfos + in->next : NULL;
+
+        out->teximage = PS2_TexImageFindOrLoad(in->texture, IT_WALL);
+        if (out->teximage == NULL)
+        {
+            out->teximage = ps2_builtin_tex_debug;
+        }
+    }
+
+    //
+    // Polygons:
+    //
+    const dcw_poly_t * poly_in = CW_DATA(CW_LUMP_POLYS, dcw_poly_t);
+    const int num_polys = CW_COUNT(CW_LUMP_POLYS, dcw_poly_t);
+    ps2_mdl_poly_t * polys = (ps2_mdl_poly_t *)Hunk_BlockAlloc(&mdl->hunk, num_polys * sizeof(ps2_mdl_poly_t));
+
+    for (i = 0; i < num_polys; ++i, ++poly_in)
+    {
+        const int num_tris = (poly_in->num_verts > 2) ? (poly_in->num_verts - 2) : 0;
+        if (poly_in->num_verts < 0 ||
+            poly_in->first_vert < 0 || poly_in->first_vert + poly_in->num_verts > num_poly_verts ||
+            poly_in->first_triangle < 0 || poly_in->first_triangle + num_tris > num_triangles)
+        {
+            Sys_Error("PS2_LoadCookedWorld: Bad polygon %i in '%s'", i, mdl->name);
+        }
+
+        // The triangles index into the polygon's own vertexes.
+        const ps2_mdl_triangle_t * tri = triangles + poly_in->first_triangle;
+        for (j = 0; j < num_tris; ++j, ++tri)
+        {
+            if (tri->vertexes[0] >= poly_in->num_verts ||
+                tri->vertexes[1] >= poly_in->num_verts ||
+                tri->vertexes[2] >= poly_in->num_verts)
+            {
+                Sys_Error("PS2_LoadCookedWorld: Bad triangle %i in polygon %i of '%s'", j, i, mdl->name);
+            }
+        }
+
+        polys[i].num_verts = poly_in->num_verts;
+        polys[i].vertexes  = poly_verts + poly_in->first_vert;
+        polys[i].triangles = triangles  + poly_in->first_triangle;
+    }
+
+    //
+    // Surfaces:
+    //
+    const dcw_surface_t * surf_in = CW_DATA(CW_LUMP_SURFACES, dcw_surface_t);
+    mdl->num_surfaces = CW_COUNT(CW_LUMP_SURFACES, dcw_surface_t);
+    mdl->surfaces = (ps2_mdl_surface_t *)Hunk_BlockAlloc(&mdl->hunk, mdl->num_surfaces * sizeof(ps2_mdl_surface_t));
+
+    for (i = 0; i < mdl->num_surfaces; ++i, ++surf_in)
+    {
+        ps2_mdl_surface_t * out = &mdl->surfaces[i];
+
+        if (surf_in->plane   < 0 || surf_in->plane   >= mdl->num_planes   ||
+            surf_in->texinfo < 0 || surf_in->texinfo >= mdl->num_texinfos ||
+            surf_in->poly    >= num_polys)
+        {
+            Sys_Error("PS2_LoadCookedWorld: Bad surface %i in '%s'", i, mdl->name);
+        }
+
+        out->plane           = mdl->planes + surf_in->plane;
+        out->flags           = surf_in->flags;
+        out->debug_color     = Dbg_GetDebugColorIndex();
+        out->first_edge      = surf_in->first_edge;
+        out->num_edges       = surf_in->num_edges;
+        out->texture_mins[0] = surf_in->texture_mins[0];
+        out->texture_mins[1] = surf_in->texture_mins[1];
+        out->extents[0]      = surf_in->extents[0];
+        out->extents[1]      = surf_in->extents[1];
+        out->light_s         = surf_in->light_s;
+        out->light_t         = surf_in->light_t;
+        out->texinfo         = mdl->texinfos + surf_in->texinfo;
+        out->polys           = (surf_in->poly >= 0) ? polys + surf_in->poly : NULL;
+
+        if (surf_in->light_ofs >= 0 && surf_in->light_ofs < light_len)
+        {
+            out->samples = mdl->light_data + surf_in->light_ofs;
+        }
+        else
+        {
+            out->samples = NULL;
+        }
+
+        for (j = 0; j < MAXLIGHTMAPS; ++j)
+        {
+            out->styles[j] = surf_in->styles[j];
+        }
+
+        // The tex coords were computed with the texture size the cooker saw.
+        // If we got a different image (e.g. the debug texture), rescale them.
+        const dcw_texinfo_t * tex_in = &texinfo_in[surf_in->texinfo];
+        const ps2_teximage_t * teximage = out->texinfo->teximage;
+        if (out->polys != NULL && (teximage->width != tex_in->width || teximage->height != tex_in->height))
+        {
+            const float scale_s = (float)tex_in->width  / (float)teximage->width;
+            const float scale_t = (float)tex_in->height / (float)teximage->height;
+            for (j = 0; j < out->polys->num_verts; ++j)
+            {
+                out->polys->vertexes[j].texture_s *= scale_s;
+                out->polys->vertexes[j].texture_t *= scale_t;
+            }
+        }
+    }
+
+    //
+    // Mark surfaces:
+    //
+    const int * mark_in = CW_DATA(CW_LUMP_MARKSURFACES, int);
+    mdl->num_mark_surfaces = CW_COUNT(CW_LUMP_MARKSURFACES, int);
+    mdl->mark_surfaces = (ps2_mdl_surface_t **)Hunk_BlockAlloc(&mdl->hunk, mdl->num_mark_surfaces * sizeof(ps2_mdl_surface_t *));
+
+    for (i = 0; i < mdl->num_mark_surfaces; ++i)
+    {
+        if (mark_in[i] < 0 || mark_in[i] >= mdl->num_surfaces)
+        {
+            Sys_Error("PS2_LoadCookedWorld: Bad surface number: %i", mark_in[i]);
+        }
+        mdl->mark_surfaces[i] = mdl->surfaces + mark_in[i];
+    }
+
+    //
+    // Leafs and nodes, parent links included:
+    //
+    const dcw_leaf_t * leaf_in = CW_DATA(CW_LUMP_LEAFS, dcw_leaf_t);
+    const dcw_node_t * node_in = CW_DATA(CW_LUMP_NODES, dcw_node_t);
+
+    mdl->num_leafs = CW_COUNT(CW_LUMP_LEAFS, dcw_leaf_t);
+    mdl->leafs = (ps2_mdl_leaf_t *)Hunk_BlockAlloc(&mdl->hunk, mdl->num_leafs * sizeof(ps2_mdl_leaf_t));
+
+    mdl->num_nodes = CW_COUNT(CW_LUMP_NODES, dcw_node_t);
+    mdl->nodes = (ps2_mdl_node_t *)Hunk_BlockAlloc(&mdl->hunk, mdl->num_nodes * sizeof(ps2_mdl_node_t));
+
+    for (i = 0; i < mdl->num_leafs; ++i, ++leaf_in)
+    {
+        ps2_mdl_leaf_t * out = &mdl->leafs[i];
+
+        if (leaf_in->parent >= mdl->num_nodes || leaf_in->first_mark_surface < 0 || leaf_in->num_mark_surfaces < 0 ||
+            leaf_in->first_mark_surface + leaf_in->num_mark_surfaces > mdl->num_mark_surfaces)
+        {
+            Sys_Error("PS2_LoadCookedWorld: Bad leaf %i in '%s'", i, mdl->name);
+        }
+
+        memcpy(out->minmaxs, leaf_in->minmaxs, sizeof(out->minmaxs));
+        out->contents           = leaf_in->contents;
+        out->cluster            = leaf_in->cluster;
+        out->area               = leaf_in->area;
+        out->parent             = (leaf_in->parent >= 0) ? mdl->nodes + leaf_in->parent : NULL;
+        out->first_mark_surface = mdl->mark_surfaces + leaf_in->first_mark_surface;
+        out->num_mark_surfaces  = leaf_in->num_mark_surfaces;
+    }
+
+    for (i = 0; i < mdl->num_nodes; ++i, ++node_in)
+    {
+        ps2_mdl_node_t * out = &mdl->nodes[i];
+
+        if (node_in->parent >= mdl->num_nodes || node_in->plane < 0 || node_in->plane >= mdl->num_planes ||
+            node_in->first_surface + node_in->num_surfaces > mdl->num_surfaces)
+        {
+            Sys_Error("PS2_LoadCookedWorld: Bad node %i in '%s'", i, mdl->name);
+        }
+
+        memcpy(out->minmaxs, node_in->minmaxs, sizeof(out->minmaxs));
+        out->contents      = -1; // differentiate from leafs
+        out->parent        = (node_in->parent >= 0) ? mdl->nodes + node_in->parent : NULL;
+        out->plane         = mdl->planes + node_in->plane;
+        out->first_surface = node_in->first_surface;
+        out->num_surfaces  = node_in->num_surfaces;
+
+        for (j = 0; j < 2; ++j)
+        {
+            const int p = node_in->children[j];
+            if (p >= mdl->num_nodes || (-1 - p) >= mdl->num_leafs)
+            {
+                Sys_Error("PS2_LoadCookedWorld: Bad child for node %i in '%s'", i, mdl->name);
+            }
+
+            if (p >= 0)
+            {
+                out->children[j] = mdl->nodes + p;
+            }
+            else
+            {
+                out->children[j] = (ps2_mdl_node_t *)(mdl->leafs + (-1 - p));
+            }
+        }
+    }
+
+    #undef CW_COUNT
+    #undef CW_DATA
+
+    PS2_SetupBrushModel(mdl);
+
+    #ifdef PS2_VERBOSE_MODEL_LOADER
+    Com_DPrintf("Cooked world '%s' loaded!\n", mdl->name);
+    #endif // PS2_VERBOSE_MODEL_LOADER
+}
+
+/*
+==============
+PS2_TryLoadCookedWorld
+
+Remarks: Local function.
+Loads maps/<name>.pcw in place of the .bsp. Returns false if there
+is no cooked file or it can't be used, so the .bsp gets loaded instead.
+==============
+*/
+static qboolean PS2_TryLoadCookedWorld(ps2_model_t * mdl)
+{
+    int i;
+    int start_time;
+    int end_time;
+    int file_len;
+    int bsp_len;
+    unsigned int bsp_checksum = 0;
+    void * file_data = NULL;
+    void * bsp_data = NULL;
+    char base_name[MAX_QPATH];
+    char cooked_name[MAX_QPATH];
+
+    if (!r_ps2_cooked_world->value || mdl != &ps2_model_pool[0])
+    {
+        return false;
+    }
+
+    COM_StripExtension(mdl->name, base_name);
+    Com_sprintf(cooked_name, sizeof(cooked_name), "%s.pcw", base_name);
+
+    start_time = Sys_Milliseconds();
+    {
+        file_len = FS_LoadFile(cooked_name, &file_data);
+        if (file_data == NULL || file_len <= 0)
+        {
+            return false;
+        }
+    }
+    end_time = Sys_Milliseconds();
+    ps2_model_load_fs_time += end_time - start_time;
+
+    const dcookedworld_t * header = (const dcookedworld_t *)file_data;
+    qboolean valid = (file_len >= (int)sizeof(*header) &&
+                      header->ident == IDCOOKEDWORLDHEADER &&
+                      header->version == COOKED_WORLD_VERSION);
+
+    for (i = 0; valid && i < CW_NUM_LUMPS; ++i)
+    {
+        const lump_t * l = &header->lumps[i];
+        valid = (l->fileofs >= (int)sizeof(*header) && (l->fileofs % COOKED_WORLD_LUMP_ALIGN) == 0 &&
+                 l->filelen >= 0 && l->filelen <= file_len - l->fileofs);
+    }
+
+    if (!valid)
+    {
+        Com_DPrintf("WARNING: '%s' is not a valid cooked world! Loading the BSP.\n", cooked_name);
+        FS_FreeFile(file_data);
+        return false;
+    }
+
+    // If the .bsp is around, make sure it is still the one this was cooked from.
+    // The client has normally loaded it for collision already, so CM_LoadMap has
+    // its checksum. Otherwise it has to be read, which is still cheaper than
+    // building the polygons.
+    if (CM_MapChecksum(mdl->name, &bsp_checksum))
+    {
+        bsp_len = header->bsp_len;
+    }
+    else
+    {
+        bsp_len = FS_LoadFile(mdl->name, &bsp_data);
+        if (bsp_data != NULL)
+        {
+            bsp_checksum = LittleLong(Com_BlockChecksum(bsp_data, bsp_len));
+            FS_FreeFile(bsp_data);
+        }
+    }
+    if (bsp_len >= 0 && (bsp_len != header->bsp_len || bsp_checksum != header->bsp_checksum))
+    {
+        Com_DPrintf("WARNING: '%s' is out of date! Loading the BSP.\n", cooked_name);
+        FS_FreeFile(file_data);
+        return false;
+    }
+
+    const unsigned int trace_start = LTrace_Start();
+    start_time = Sys_Milliseconds();
+    {
+        Hunk_New(&mdl->hunk, PS2_CookedWorldHunkSize(header), MEMTAG_MDL_WORLD);
+        PS2_LoadCookedWorld(mdl, file_data);
+    }
+    end_time = Sys_Milliseconds();
+    ps2_model_load_world_time += end_time - start_time;
+    LTrace_Stage("pcw", cooked_name, file_len, trace_start);
+
+    FS_FreeFile(file_data);
+    return true;
+}
+
 /*
 ==============
 PS2_FindInlineModel
@@ -1577,15 +2150,12 @@ ps2_model_t * PS2_ModelFindOrLoad(const char * name, int flags)
     // Search the currently loaded models first:
     //
     int i;
-    const u32 name_hash = Sys_HashString(name); // Compare by hash code, much cheaper.
-    ps2_model_t * model_iter = ps2_model_pool;
-    for (i = 0; i < PS2_MDL_POOL_SIZE; ++i, ++model_iter)
+    int cursor = 0;
+    const u32 name_hash = Sys_HashString(name);
+    while ((i = PS2_NameIndexNext(&ps2_model_index, name_hash, &cursor)) >= 0)
     {
-        if (model_iter->type == MDL_NULL)
-        {
-            continue;
-        }
-        if ((name_hash == model_iter->hash) && (flags & model_iter->type))
+        ps2_model_t * model_iter = &ps2_model_pool[i];
+        if ((flags & model_iter->type) && strncmp(model_iter->name, name, MAX_QPATH) == 0)
         {
             if (ps2ref.registration_started)
             {
@@ -1596,6 +2166,8 @@ ps2_model_t * PS2_ModelFindOrLoad(const char * name, int flags)
             Com_DPrintf("Model '%s' already in cache.\n", name);
             #endif // PS2_VERBOSE_MODEL_LOADER
 
+            LTrace_Cache("model", name, true);
+
             model_iter->registration_sequence = ps2ref.registration_sequence;
             PS2_ReferenceAllTextures(model_iter); // Ensures they are not discarded by EndRegistration.
             return model_iter;
@@ -1605,6 +2177,8 @@ ps2_model_t * PS2_ModelFindOrLoad(const char * name, int flags)
     //
     // Else, load from file for the first time:
     //
+    LTrace_Cache("model", name, false);
+
     ps2_model_t * new_model = PS2_ModelAlloc();
     strncpy(new_model->name, name, MAX_QPATH); // Save the name string for console printing
     new_model->hash = name_hash;               // We've already computed the name hash above!
@@ -1623,6 +2197,16 @@ ps2_model_t * PS2_ModelFindOrLoad(const char * name, int flags)
         }
     }
 
+    //
+    // Maps prefer the cooked version, if there is an up to date one:
+    //
+    if (strcmp(name + strlen(name) - 4, ".bsp") == 0 && PS2_TryLoadCookedWorld(new_model))
+    {
+        PS2_NameIndexInsert(&ps2_model_index, name_hash, new_model - ps2_model_pool);
+        new_model->registration_sequence = ps2ref.registration_sequence;
+        return new_model;
+    }
+
     int start_time;
     int end_time;
     int file_len;
@@ -1651,6 +2235,7 @@ ps2_model_t * PS2_ModelFindOrLoad(const char * name, int flags)
     // Call the appropriate loader:
     //
     const u32 id = LittleLong(*(u32 *)file_data);
+    const unsigned int trace_start = LTrace_Start();
     switch (id)
     {
     case IDALIASHEADER :
@@ -1661,6 +2246,7 @@ ps2_model_t * PS2_ModelFindOrLoad(const char * name, int flags)
         }
         end_time = Sys_Milliseconds();
         ps2_model_load_ents_time += end_time - start_time;
+        LTrace_Stage("md2", name, file_len, trace_start);
         break;
 
     case IDSPRITEHEADER :
@@ -1671,13 +2257,22 @@ ps2_model_t * PS2_ModelFindOrLoad(const char * name, int flags)
         }
         end_time = Sys_Milliseconds();
         ps2_model_load_ents_time += end_time - start_time;
+        LTrace_Stage("sprite", name, file_len, trace_start);
         break;
 
     case IDBSPHEADER :
         start_time = Sys_Milliseconds();
         {
-            Hunk_New(&new_model->hunk, MEGABYTES(5), MEMTAG_MDL_WORLD); // Fixed size for the largest map in the game
+            // Sized by a pre-pass over the lumps; everything the world needs
+            // lives in this one hunk and is released by PS2_ModelFree.
+            Hunk_New(&new_model->hunk, PS2_BrushModelHunkSize(file_data), MEMTAG_MDL_WORLD);
             PS2_LoadBrushModel(new_model, file_data);
+
+            #ifdef PS2_VERBOSE_MODEL_LOADER
+            Com_DPrintf("World hunk: %s used of %s\n",
+                        PS2_FormatMemoryUnit(Hunk_GetTail(&new_model->hunk), true),
+                        PS2_FormatMemoryUnit(new_model->hunk.max_size, true));
+            #endif // PS2_VERBOSE_MODEL_LOADER
         }
         end_time = Sys_Milliseconds();
         ps2_model_load_world_time += end_time - start_time;
@@ -1691,6 +2286,7 @@ ps2_model_t * PS2_ModelFindOrLoad(const char * name, int flags)
     FS_FreeFile(file_data);
 
     // Reference it:
+    PS2_NameIndexInsert(&ps2_model_index, name_hash, new_model - ps2_model_pool);
     new_model->registration_sequence = ps2ref.registration_sequence;
     return new_model;
 }
@@ -1727,6 +2323,10 @@ void PS2_ModelLoadWorld(const char * name)
     if (strcmp(ps2_model_pool[0].name, fullname) != 0 || r_ps2_flush_map->value)
     {
         PS2_ModelFree(&ps2_model_pool[0]);
+
+        // Nothing else lives in the world space, so start the new level
+        // with an empty one instead of whatever the old map left behind.
+        PS2_MemResetTag(MEMTAG_MDL_WORLD);
     }
 
     ps2_world_model = PS2_ModelFindOrLoad(fullname, MDL_BRUSH);
@@ -157,6 +157,10 @@ typedef struct ps2_mdl_surface_s
 
     ps2_mdl_texinfo_t * texinfo;
 
+    // VIF DMA block with the VU1 batches of the first poly, built once per
+    // world by PS2_WorldStaticDMASetup(). Replayed with a CALL tag. 0 if none.
+    u32 static_dma_addr;
+
     // dynamic lighting info:
     int dlight_frame;
     int dlight_bits;
@@ -304,6 +308,110 @@ typedef struct ps2_model_s
 /*
 ==============================================================
 
+Cooked world format (maps/<name>.pcw):
+
+Written offline by src/tools/worldcook.c from the arrays that
+PS2_LoadBrushModel builds, so loading it skips the polygon
+building and triangulation. Arrays without pointers are stored
+exactly as they are in memory. Pointers are stored as 32bits
+indexes and patched in a single pass by the loader, so the file
+doesn't depend on the pointer size of the machine that cooked it.
+Little-endian. Bump the version when any of the structures change.
+
+==============================================================
+*/
+
+#define IDCOOKEDWORLDHEADER  (('D' << 24) + ('W' << 16) + ('C' << 8) + 'P') // "PCWD"
+#define COOKED_WORLD_VERSION 2
+
+// Lumps are padded to this, so the records can be read in place.
+#define COOKED_WORLD_LUMP_ALIGN 16
+
+enum
+{
+    CW_LUMP_VERTEXES,     // ps2_mdl_vertex_t
+    CW_LUMP_EDGES,        // ps2_mdl_edge_t
+    CW_LUMP_SURFEDGES,    // int
+    CW_LUMP_LIGHTING,     // byte
+    CW_LUMP_PLANES,       // cplane_t
+    CW_LUMP_TEXINFO,      // dcw_texinfo_t
+    CW_LUMP_SURFACES,     // dcw_surface_t
+    CW_LUMP_POLYS,        // dcw_poly_t
+    CW_LUMP_POLYVERTS,    // ps2_poly_vertex_t
+    CW_LUMP_TRIANGLES,    // ps2_mdl_triangle_t
+    CW_LUMP_MARKSURFACES, // int, index into surfaces
+    CW_LUMP_VISIBILITY,   // dvis_t, already byte-swapped
+    CW_LUMP_LEAFS,        // dcw_leaf_t
+    CW_LUMP_NODES,        // dcw_node_t
+    CW_LUMP_SUBMODELS,    // ps2_mdl_submod_t
+    CW_NUM_LUMPS
+};
+
+typedef struct
+{
+    float vecs[2][4];
+    int flags;
+    int num_frames;
+    int next;                // Index of the next animation frame, -1 if none.
+    int width, height;       // Texture size the tex coords were computed with.
+    char texture[MAX_QPATH]; // "textures/<name>.wal"
+} dcw_texinfo_t;
+
+typedef struct
+{
+    int plane;
+    int flags;
+    int first_edge;
+    int num_edges;
+    s16 texture_mins[2];
+    s16 extents[2];
+    int light_s, light_t;
+    int texinfo;
+    int poly;      // -1 for warped surfaces.
+    int light_ofs; // Offset into the lighting lump, -1 if none.
+    byte styles[MAXLIGHTMAPS];
+} dcw_surface_t;
+
+typedef struct
+{
+    int num_verts;
+    int first_vert;     // Into the polyverts lump.
+    int first_triangle; // Into the triangles lump, (num_verts - 2) of them.
+} dcw_poly_t;
+
+typedef struct
+{
+    float minmaxs[6];
+    int contents;
+    int cluster;
+    int area;
+    int parent; // Node index.
+    int first_mark_surface;
+    int num_mark_surfaces;
+} dcw_leaf_t;
+
+typedef struct
+{
+    float minmaxs[6];
+    int parent;      // Node index, -1 for the root.
+    int plane;
+    int children[2]; // Same as the BSP: negative numbers are -(leaf + 1).
+    u16 first_surface;
+    u16 num_surfaces;
+} dcw_node_t;
+
+typedef struct
+{
+    int ident;
+    int version;
+    int bsp_len;               // Size of the .bsp it was cooked from.
+    unsigned int bsp_checksum; // Com_BlockChecksum of that .bsp, like CM_LoadMap's. If it changes, the cooked file is ignored.
+    lump_t lumps[CW_NUM_LUMPS];
+} dcookedworld_t;
+
+/*
+==============================================================
+
 Public model loading/management functions:
 
 ==============================================================
@@ -333,4 +441,70 @@ void PS2_ModelFree(ps2_model_t * mdl);
 // Called by EndRegistration() to free models not referenced by the new level.
 void PS2_ModelFreeUnused(void);
 
+/*
+==============================================================
+
+Cached visible surface lists of the world (see world_vis.c):
+
+==============================================================
+*/
+
+// Leaf of a visible set. Just what the per-frame frustum test needs.
+typedef struct
+{
+    float minmaxs[6];
+    ps2_mdl_surface_t ** first_mark_surface;
+    int num_mark_surfaces;
+} ps2_world_vis_leaf_t;
+
+// The leafs that pass the PVS of (cluster, cluster2) and the areabits,
+// and the opaque surfaces they mark, sorted by texture.
+typedef struct
+{
+    const ps2_model_t * world_mdl; // NULL if the cache slot is free.
+    int cluster;
+    int cluster2;
+    qboolean all_areas; // Built without areabits.
+    byte areabits[MAX_MAP_AREAS / 8];
+    u32 last_used;
+    int mem_bytes;
+
+    int num_leafs;
+    ps2_world_vis_leaf_t * leafs;
+
+    int num_surfaces;
+    ps2_mdl_surface_t ** surfaces;
+} ps2_world_vis_t;
+
+typedef struct
+{
+    int hits;      // Lookups that found their set, since the last reset.
+    int misses;    // Lookups that had to build it.
+    int num_sets;  // Sets in the cache.
+    int mem_bytes; // Taken by them.
+} ps2_world_vis_stats_t;
+
+// Bytes in a PVS row of the world, rounded to whole ints.
+int PS2_WorldVisRowSize(const ps2_model_t * world_mdl);
+
+// PVS of 'cluster', merged with the one of 'cluster2' if different. NULL when
+// everything is visible (no vis data or cluster -1). Frame scratch memory.
+byte * PS2_WorldVisClusterPVS(const ps2_model_t * world_mdl, int cluster, int cluster2);
+
+// Looks up the visible set of the view clusters and areabits (NULL for all areas),
+// building it if not cached. Stays valid until the next lookup or reset.
+const ps2_world_vis_t * PS2_WorldVisFind(const ps2_model_t * world_mdl, int cluster, int cluster2, const byte * areabits);
+
+// Per frame: frustum culls the leafs of the set, then writes the surfaces they mark that face
+// 'vieworg' to 'out_surfaces', in texture order. Sets vis_frame = 'frame_num' on the surfaces
+// of the leafs that are in. 'out_surfaces' must hold vis->num_surfaces. Returns the count.
+int PS2_WorldVisGather(const ps2_world_vis_t * vis, const cplane_t * frustum, int num_planes,
+                       const vec3_t vieworg, int frame_num, ps2_mdl_surface_t ** out_surfaces);
+
+// Frees all the cached sets. Must be called when the world model changes.
+void PS2_WorldVisReset(void);
+
+// Cache counters for the render stats.
+void PS2_WorldVisGetStats(ps2_world_vis_stats_t * stats);
+
 #endif // PS2_MODEL_H
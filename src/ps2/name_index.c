@@ -0,0 +1,154 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: name_index.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Open-addressing hash index over the fixed pools of named renderer objects.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/q_common.h"
+#include "ps2/name_index.h"
+
+enum
+{
+    NAME_INDEX_EMPTY   = -1, // Never used, ends a probe sequence.
+    NAME_INDEX_DELETED = -2  // Tombstone, probes continue past it.
+};
+
+/*
+==============
+PS2_NameIndexInit
+==============
+*/
+void PS2_NameIndexInit(ps2_name_index_t * index, ps2_name_slot_t * slots, int num_slots)
+{
+    if (num_slots <= 0 || (num_slots & (num_slots - 1)) != 0)
+    {
+        Sys_Error("PS2_NameIndexInit: Slot count must be a power of two!");
+    }
+
+    index->slots = slots;
+    index->size  = num_slots;
+    PS2_NameIndexClear(index);
+}
+
+/*
+==============
+PS2_NameIndexClear
+==============
+*/
+void PS2_NameIndexClear(ps2_name_index_t * index)
+{
+    int i;
+    for (i = 0; i < index->size; ++i)
+    {
+        index->slots[i].hash  = 0;
+        index->slots[i].entry = NAME_INDEX_EMPTY;
+    }
+
+    index->used    = 0;
+    index->deleted = 0;
+}
+
+/*
+==============
+PS2_NameIndexInsert
+==============
+*/
+void PS2_NameIndexInsert(ps2_name_index_t * index, u32 hash, int entry)
+{
+    int i;
+    ps2_name_slot_t * slot;
+    const int mask = index->size - 1;
+
+    // Always leave an empty slot, so that probes terminate.
+    if (index->used + index->deleted >= mask)
+    {
+        Sys_Error("PS2_NameIndexInsert: Index is full!");
+    }
+
+    for (i = hash & mask;; i = (i + 1) & mask)
+    {
+        slot = &index->slots[i];
+        if (slot->entry == NAME_INDEX_EMPTY || slot->entry == NAME_INDEX_DELETED)
+        {
+            break;
+        }
+    }
+
+    if (slot->entry == NAME_INDEX_DELETED)
+    {
+        --index->deleted;
+    }
+
+    slot->hash  = hash;
+    slot->entry = (s16)entry;
+    ++index->used;
+}
+
+/*
+==============
+PS2_NameIndexRemove
+
+Does nothing if the entry is not in the index.
+==============
+*/
+void PS2_NameIndexRemove(ps2_name_index_t * index, u32 hash, int entry)
+{
+    int i;
+    ps2_name_slot_t * slot;
+    const int mask = index->size - 1;
+
+    for (i = hash & mask;; i = (i + 1) & mask)
+    {
+        slot = &index->slots[i];
+        if (slot->entry == NAME_INDEX_EMPTY)
+        {
+            return;
+        }
+        if (slot->entry == entry && slot->hash == hash)
+        {
+            break;
+        }
+    }
+
+    slot->entry = NAME_INDEX_DELETED;
+    --index->used;
+    ++index->deleted;
+}
+
+/*
+==============
+PS2_NameIndexNext
+
+Returns the next pool entry with the given hash, or -1 when there
+are no more. 'cursor' must be zero for the first call of a lookup.
+==============
+*/
+int PS2_NameIndexNext(const ps2_name_index_t * index, u32 hash, int * cursor)
+{
+    int i;
+    const ps2_name_slot_t * slot;
+    const int mask = index->size - 1;
+
+    for (; *cursor < index->size; ++(*cursor))
+    {
+        i = (hash + *cursor) & mask;
+        slot = &index->slots[i];
+
+        if (slot->entry == NAME_INDEX_EMPTY)
+        {
+            break;
+        }
+        if (slot->entry >= 0 && slot->hash == hash)
+        {
+            ++(*cursor);
+            return slot->entry;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,62 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: name_index.h
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Open-addressing hash index over the fixed pools of named renderer
+ *        objects (textures and models), so lookups by name don't scan the pools.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#ifndef PS2_NAME_INDEX_H
+#define PS2_NAME_INDEX_H
+
+#include "ps2/defs_ps2.h"
+
+// The index only maps a name hash to pool entry numbers. Since different
+// names can have the same hash, and the same name can be in the pool more
+// than once with different type flags, lookups go through every entry with
+// a matching hash and the owner compares the full name and the type:
+//
+//   int cursor = 0, i;
+//   while ((i = PS2_NameIndexNext(&index, hash, &cursor)) >= 0)
+//   {
+//       if ((flags & pool[i].type) && strcmp(pool[i].name, name) == 0) { found }
+//   }
+//
+// Linear probing. Removed entries leave a tombstone behind, so after freeing
+// a batch of entries the owner should PS2_NameIndexClear and re-insert what's
+// left once PS2_NameIndexNeedsRebuild says so.
+
+typedef struct
+{
+    u32 hash;
+    s16 entry; // Pool entry number, or negative for an empty slot or a tombstone (NAME_INDEX_* in name_index.c).
+} ps2_name_slot_t;
+
+typedef struct
+{
+    ps2_name_slot_t * slots; // Owned by the caller. Power of two count.
+    int size;
+    int used;
+    int deleted;
+} ps2_name_index_t;
+
+// Slot count for a pool of 'n' entries. Keeps the load under 50%.
+// 'n' must be a power of two, like all the pool sizes currently are.
+#define PS2_NAME_INDEX_SLOTS(n) ((n) * 2)
+
+void PS2_NameIndexInit(ps2_name_index_t * index, ps2_name_slot_t * slots, int num_slots);
+void PS2_NameIndexClear(ps2_name_index_t * index);
+void PS2_NameIndexInsert(ps2_name_index_t * index, u32 hash, int entry);
+void PS2_NameIndexRemove(ps2_name_index_t * index, u32 hash, int entry);
+int  PS2_NameIndexNext(const ps2_name_index_t * index, u32 hash, int * cursor);
+
+static inline int PS2_NameIndexNeedsRebuild(const ps2_name_index_t * index)
+{
+    return index->deleted > 0;
+}
+
+#endif // PS2_NAME_INDEX_H
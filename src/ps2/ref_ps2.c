@@ -11,6 +11,7 @@
  * ================================================================================================ */
 
 #include "common/q_common.h"
+#include "common/q_prof.h"
 #include "ps2/ref_ps2.h"
 #include "ps2/mem_alloc.h"
 #include "ps2/model_load.h"
@@ -20,6 +21,7 @@
 #include <kernel.h>
 #include <dma_tags.h>
 #include <gif_tags.h>
+#include <gs_gp.h>
 #include <gs_psm.h>
 #include <dma.h>
 #include <graph.h>
@@ -49,7 +51,9 @@ static cvar_t * r_ps2_fade_scr_alpha    = NULL; // Fade screen opacity from 0 to
 static cvar_t * r_ps2_show_fps          = NULL; // Show FPS counter and frame times on screen; "1" by default.
 static cvar_t * r_ps2_show_mem_tags     = NULL; // Show memory usage on screen; "1" by default.
 static cvar_t * r_ps2_show_render_stats = NULL; // Show renderer statistics, like models/textures loaded; "1" by default.
+static cvar_t * r_ps2_show_profiler     = NULL; // Show per-scope frame profiler times; "0" by default. Also sets prof_enable.
 static cvar_t * r_ps2_skip_render_frame = NULL; // Skips PS2_RenderFrame() entirely; "0" by default.
+static cvar_t * r_ps2_mip_lod_bias      = NULL; // Added to the mipmap level picked by the GS. Negative is sharper; "0" by default.
 
 // Average multiple frames together to smooth changes out a bit.
 enum { MAX_FPS_HIST = 4 };
@@ -149,6 +153,19 @@ extern ps2_teximage_t * ps2_builtin_tex_debug;
         }                                                              \
     } while (0)
 
+//
+// Frame packet sizes, in qwords:
+//
+//FIXME Temp: will settle on a definite size later, but we
+// don't need a lot since now the 3D drawing happens on the VU1.
+// this is for the 2D drawing and a few render-states only...
+enum
+{
+    FRAME_PACKET_SIZE       = 65535/2,
+    //FRAME_PACKET_SIZE     = 65535,
+    FRAME_PACKET_FLUSH_SIZE = FRAME_PACKET_SIZE / 2 // Texture switches flush past this.
+};
+
 //
 // DMA GIF tag helpers:
 //
@@ -302,12 +319,6 @@ static void PS2_AllocRenderPackets(void)
     // very big mesh could potentially crash the renderer!
     //
 
-    //FIXME Temp: will settle on a definite size later, but we
-    // don't need a lot since now the 3D drawing happens on the VU1.
-    // this is for the 2D drawing and a few render-states only...
-    enum { FRAME_PACKET_SIZE = 65535/2 };
-    //enum { FRAME_PACKET_SIZE = 65535 };
-
     PS2_PacketAlloc(&ps2ref.frame_packets[0], FRAME_PACKET_SIZE, GS_PACKET_NORMAL);
     PS2_PacketAlloc(&ps2ref.frame_packets[1], FRAME_PACKET_SIZE, GS_PACKET_NORMAL);
 
@@ -362,13 +373,23 @@ static void PS2_InitGSBuffers(int vidMode, int fbPsm, int zPsm, qboolean interla
                                             ps2ref.z_buffer.zsm,
                                             GRAPH_ALIGN_PAGE);
 
-    // User textures start after the z-buffer.
-    // Allocate space for a single 256x256 large texture
-    // (pretty much all the space we have left):
-    ps2ref.vram_texture_start = PS2_VRamAlloc(MAX_TEXIMAGE_SIZE,
-                                              MAX_TEXIMAGE_SIZE,
-                                              GS_PSM_32,
-                                              GRAPH_ALIGN_BLOCK);
+    // The CLUT for the 8bits palettized textures goes after the z-buffer.
+    // Every GS_PSM_8 texture shares it (see PS2_ClutVRamUpload).
+    ps2ref.vram_clut_start = PS2_VRamAlloc(16, 16, GS_PSM_32, GRAPH_ALIGN_BLOCK);
+
+    // All the remaining pages are the texture cache (see tex_vram.c).
+    // A page is 64x32 pixels in PSM_32, so this takes exactly that many.
+    const u32 clut_end   = ps2ref.vram_clut_start + graph_vram_size(16, 16, GS_PSM_32, GRAPH_ALIGN_BLOCK);
+    const u32 tex_start  = (clut_end + PS2_VRAM_PAGE_WORDS - 1) & ~(PS2_VRAM_PAGE_WORDS - 1);
+    const int tex_pages  = (PS2_VRAM_SIZE_WORDS - tex_start) / PS2_VRAM_PAGE_WORDS;
+    const int max_tex_pages = (MAX_TEXIMAGE_SIZE * MAX_TEXIMAGE_SIZE) / PS2_VRAM_PAGE_WORDS; // Largest RGBA texture.
+    if (tex_pages < max_tex_pages)
+    {
+        Sys_Error("Not enough VRam left for textures! %d pages, need %d\n", tex_pages, max_tex_pages);
+    }
+
+    ps2ref.vram_texture_start = PS2_VRamAlloc(64, 32 * tex_pages, GS_PSM_32, GRAPH_ALIGN_PAGE);
+    PS2_TexVRamInit(ps2ref.vram_texture_start, tex_pages);
 
     //
     // Initialize the screen and tie the first framebuffer to the read circuits:
@@ -640,10 +661,15 @@ static void PS2_Draw2DTexChange(u32 tex_index)
 
         if (need_tex_switch)
         {
-            // Need to close the current 2D tag, flush, then reopen it.
+            // Need to close the current 2D tag for the upload, then reopen it.
+            // Uploads are chained into the frame packet, so the draws so far
+            // only need to be sent once the packet starts to get full.
             END_DMA_TAG_NAMED(ps2ref.dmatag_draw2d, ps2ref.current_frame_qwptr);
 
-            PS2_FlushPipeline();
+            if ((ps2ref.current_frame_qwptr - ps2ref.current_frame_packet->data) > FRAME_PACKET_FLUSH_SIZE)
+            {
+                PS2_FlushPipeline();
+            }
             PS2_TexImageVRamUpload(teximage);
 
             BEGIN_DMA_TAG_NAMED(ps2ref.dmatag_draw2d, ps2ref.current_frame_qwptr);
@@ -828,18 +854,15 @@ static void PS2_DrawFullScreenCinematic(void)
     texrect.color.a = (byte)ps2ref.ui_brightness;
     texrect.color.q = 1.0f;
 
+    // The upload goes in between 2D tags.
+    END_DMA_TAG_NAMED(ps2ref.dmatag_draw2d, ps2ref.current_frame_qwptr);
     PS2_TexImageVRamUpload(ps2_cinematic_frame.teximage);
-    PS2_TexImageBindCurrent();
+    BEGIN_DMA_TAG_NAMED(ps2ref.dmatag_draw2d, ps2ref.current_frame_qwptr);
 
+    PS2_TexImageBindCurrent();
     ps2ref.current_frame_qwptr = draw_rect_textured(
                     ps2ref.current_frame_qwptr, 0, &texrect);
 
-    // Since the cinematic uses a special texture buffer, we need to flush
-    // immediately after the thing is drawn. Disable and re-enable 2D mode for that.
-    END_DMA_TAG_NAMED(ps2ref.dmatag_draw2d, ps2ref.current_frame_qwptr);
-    PS2_FlushPipeline();
-    BEGIN_DMA_TAG_NAMED(ps2ref.dmatag_draw2d, ps2ref.current_frame_qwptr);
-
     ps2_cinematic_frame.draw_pending = false;
 }
 
@@ -929,6 +952,32 @@ static void PS2_DrawMemTags(void)
     draw_stats_curr_y += 5;
     Stats_Print(va("TOTAL: %s", PS2_FormatMemoryUnit(total, true)));
 
+    // dlmalloc spaces, footprint out of the budgets:
+    unsigned int space_footprint = 0, space_budget = 0;
+    for (i = 0; i < MEMTAG_COUNT; ++i)
+    {
+        unsigned int footprint, in_use, budget;
+        PS2_MemGetSpaceUsage(i, &footprint, &in_use, &budget);
+        space_footprint += footprint;
+        space_budget    += budget;
+    }
+    Stats_Print(va("SPACES: %s/%s", PS2_FormatMemoryUnit(space_footprint, true),
+                   PS2_FormatMemoryUnit(space_budget, true)));
+
+    // Small-object pool pages in use:
+    unsigned int slab_pages_used, slab_pages_total;
+    PS2_SlabGetUsage(&slab_pages_used, &slab_pages_total);
+    Stats_Print(va("SLABS: %u/%u pages", slab_pages_used, slab_pages_total));
+
+    // Peak per-frame scratch memory use (renderer and server):
+    int frame_mem_peak, frame_mem_budget;
+    Frame_MemGetUsage(FRAME_MEM_REFRESH, &frame_mem_peak, &frame_mem_budget);
+    Stats_Print(va("FRAME R: %s/%s", PS2_FormatMemoryUnit(frame_mem_peak, true),
+                   PS2_FormatMemoryUnit(frame_mem_budget, true)));
+    Frame_MemGetUsage(FRAME_MEM_SERVER, &frame_mem_peak, &frame_mem_budget);
+    Stats_Print(va("FRAME S: %s/%s", PS2_FormatMemoryUnit(frame_mem_peak, true),
+                   PS2_FormatMemoryUnit(frame_mem_budget, true)));
+
     // A darker background to give the text more contrast.
     Stats_DrawBackground();
 }
@@ -958,6 +1007,13 @@ static void PS2_DrawRenderStats(void)
     extern int ps2_unused_teximages_freed;
     extern int ps2_teximages_failed;
     extern int ps2_teximage_load_time;
+    extern int ps2_teximage_mip_bytes;
+    extern int ps2_world_static_dma_bytes;
+    extern int ps2_world_static_dma_needed;
+    extern int ps2_world_dma_frame_bytes;
+    extern int ps2_num_vu_batches;
+    extern int ps2_vu_stall_usec;
+    extern int ps2_vu_drain_usec;
 
     draw_stats_old_y = draw_stats_curr_y;
 
@@ -971,6 +1027,34 @@ static void PS2_DrawRenderStats(void)
     Stats_Print(va("TEX cache hits %d", ps2_teximage_cache_hits));
     Stats_Print(va("TEX freed      %d", ps2_unused_teximages_freed));
     Stats_Print(va("TEX failed     %d", ps2_teximages_failed));
+    Stats_Print(va("TEX mips KB    %d", ps2_teximage_mip_bytes / 1024));
+    if (ps2_world_static_dma_needed > 0)
+    {
+        Stats_Print(va("WLD DMA KB     off, needs %d", ps2_world_static_dma_needed / 1024));
+    }
+    else
+    {
+        Stats_Print(va("WLD DMA KB     %d", ps2_world_static_dma_bytes / 1024));
+    }
+    Stats_Print(va("WLD DMA KB/frm %d", ps2_world_dma_frame_bytes / 1024));
+    Stats_Print(va("VU1 batches    %d", ps2_num_vu_batches));
+    Stats_Print(va("VU1 stall ms   %.2f", ps2_vu_stall_usec / 1000.0f));
+    Stats_Print(va("VU1 drain ms   %.2f", ps2_vu_drain_usec / 1000.0f));
+    Stats_Print("--------------------");
+    ps2_tex_vram_stats_t vram_stats;
+    PS2_TexVRamGetStats(&vram_stats);
+    const int vram_binds = vram_stats.hits + vram_stats.misses;
+    Stats_Print(va("VRAM hit rate  %d%%", (vram_binds > 0) ? (vram_stats.hits * 100 / vram_binds) : 100));
+    Stats_Print(va("VRAM uploads   %d", vram_stats.misses));
+    Stats_Print(va("VRAM upload KB %u", vram_stats.upload_bytes / 1024));
+    Stats_Print(va("VRAM evictions %d", vram_stats.evictions));
+    Stats_Print(va("VRAM pages     %d/%d", vram_stats.pages_used, vram_stats.pages_total));
+    Stats_Print("--------------------");
+    ps2_world_vis_stats_t vis_stats;
+    PS2_WorldVisGetStats(&vis_stats);
+    Stats_Print(va("VIS sets       %d", vis_stats.num_sets));
+    Stats_Print(va("VIS sets KB    %d", vis_stats.mem_bytes / 1024));
+    Stats_Print(va("VIS misses     %d/%d", vis_stats.misses, vis_stats.hits + vis_stats.misses));
     Stats_Print("--------------------");
     Stats_Print(va("Load MDL FS %.2f s", ps2_msec_to_sec(ps2_model_load_fs_time)));
     Stats_Print(va("Load WORLD  %.2f s", ps2_msec_to_sec(ps2_model_load_world_time)));
@@ -982,6 +1066,39 @@ static void PS2_DrawRenderStats(void)
     Stats_DrawBackground();
 }
 
+/*
+================
+PS2_DrawProfiler
+
+Average times of the profiler scopes over the frame history.
+Remarks: Local function.
+================
+*/
+static void PS2_DrawProfiler(void)
+{
+    int i, indent, num_stats;
+    prof_stats_t stats[PROF_MAX_SCOPES];
+
+    num_stats = Prof_GetStats(stats, PROF_MAX_SCOPES);
+    if (num_stats == 0)
+    {
+        return;
+    }
+
+    draw_stats_old_y = draw_stats_curr_y;
+
+    Stats_Print("PROF          avg ms");
+    for (i = 0; i < num_stats; ++i)
+    {
+        indent = (stats[i].depth < 4) ? stats[i].depth : 4;
+        Stats_Print(va("%*s%-*.*s %5.2f", indent, "", 14 - indent, 14 - indent,
+                       stats[i].name, stats[i].avg_ms));
+    }
+
+    // A darker background to give the text more contrast.
+    Stats_DrawBackground();
+}
+
 //=============================================================================
 //
 // Rendering methods exported to the game and engine (refresh exports):
@@ -1010,7 +1127,9 @@ qboolean PS2_RendererInit(void * unused1, void * unused2)
     r_ps2_show_fps           = Cvar_Get("r_ps2_show_fps",          "1",   0);
     r_ps2_show_mem_tags      = Cvar_Get("r_ps2_show_mem_tags",     "1",   0);
     r_ps2_show_render_stats  = Cvar_Get("r_ps2_show_render_stats", "1",   0);
+    r_ps2_show_profiler      = Cvar_Get("r_ps2_show_profiler",     "0",   0);
     r_ps2_skip_render_frame  = Cvar_Get("r_ps2_skip_render_frame", "0",   0);
+    r_ps2_mip_lod_bias       = Cvar_Get("r_ps2_mip_lod_bias",      "0",   0);
 
     // Cache these, since on the PS2 we don't have a way of interacting with the console.
     viddef.width             = (int)r_ps2_vid_width->value;
@@ -1020,6 +1139,13 @@ qboolean PS2_RendererInit(void * unused1, void * unused2)
     ps2ref.show_fps_count    = (qboolean)r_ps2_show_fps->value;
     ps2ref.show_mem_tags     = (qboolean)r_ps2_show_mem_tags->value;
     ps2ref.show_render_stats = (qboolean)r_ps2_show_render_stats->value;
+    ps2ref.show_profiler     = (qboolean)r_ps2_show_profiler->value;
+
+    // The overlay needs the profiler to be recording.
+    if (ps2ref.show_profiler)
+    {
+        Cvar_Set("prof_enable", "1");
+    }
 
     // Renderer id. Used in a couple places by the game.
     vidref_val = VIDREF_OTHER;
@@ -1057,6 +1183,9 @@ qboolean PS2_RendererInit(void * unused1, void * unused2)
     // Gen the default images.
     PS2_TexImageInit();
 
+    // CLUT used by all the 8bits textures, only uploaded once.
+    PS2_ClutVRamUpload();
+
     // Make sure it's initially set to a valid palette (ps2_global_palette).
     PS2_CinematicSetPalette(NULL);
 
@@ -1117,6 +1246,8 @@ void PS2_RendererShutdown(void)
     PS2_PacketFree(&ps2ref.flip_fb_packet);
 
     VU1_Shutdown();
+    PS2_WorldVisReset();
+    PS2_WorldDrawShutdown();
     PS2_ModelShutdown();
     PS2_TexImageShutdown();
     PS2_MemClearObj(&ps2ref);
@@ -1198,6 +1329,9 @@ void PS2_EndRegistration(void)
     PS2_ModelFreeUnused();
     PS2_TexImageFreeUnused();
 
+    // World geometry never changes, so its VU1 batches are built once here.
+    PS2_WorldStaticDMASetup(PS2_ModelGetWorld());
+
     ps2ref.registration_started = false;
 }
 
@@ -1267,6 +1401,10 @@ void PS2_BeginFrame(float camera_separation)
     ps2_draws2d      = 0;
     ps2_tex_uploads  = 0;
     ps2_pipe_flushes = 0;
+    PS2_TexVRamBeginFrame();
+
+    // Scratch memory from the previous frame can be reused.
+    Frame_MemReset(FRAME_MEM_REFRESH);
 
     ps2ref.current_frame_packet = &ps2ref.frame_packets[ps2ref.frame_index];
     ps2ref.current_frame_qwptr  = ps2ref.current_frame_packet->data;
@@ -1313,6 +1451,10 @@ void PS2_EndFrame(void)
     {
         PS2_DrawRenderStats();
     }
+    if (ps2ref.show_profiler)
+    {
+        PS2_DrawProfiler();
+    }
 
     PS2_Flush2DBatch();
     PS2_Draw2DEnd();
@@ -1385,9 +1527,11 @@ void PS2_RenderFrame(refdef_t * view_def)
     // (probably in account of the software renderer).
     //
 
+    Prof_Begin("PS2_RenderFrame");
     PS2_DrawFrameSetup(view_def);
     PS2_DrawWorldModel(view_def);
     PS2_DrawViewEntities(view_def);
+    Prof_End();
 }
 
 /*
@@ -1400,9 +1544,34 @@ qboolean PS2_IsFrameStarted(void)
     return ps2ref.frame_started;
 }
 
+/*
+================
+PS2_TexChainedFlush
+
+Remarks: Local function.
+Like libdraw's draw_texture_flush, but continues the DMA chain
+instead of ending it, so more data can follow in the packet.
+================
+*/
+static qword_t * PS2_TexChainedFlush(qword_t * q)
+{
+    DMATAG_CNT(q, 2, 0, 0, 0);
+    q++;
+    PACK_GIFTAG(q, GIF_SET_TAG(1, 1, 0, 0, GIF_FLG_PACKED, 1), GIF_REG_AD);
+    q++;
+    PACK_GIFTAG(q, 1, GS_REG_TEXFLUSH);
+    q++;
+    return q;
+}
+
 /*
 ================
 PS2_TexImageVRamUpload
+
+Makes the texture resident in VRam, uploading it if it isn't
+there already. Inside a frame, the upload is chained into the
+frame packet at the current position, so the caller must not
+have a DMA tag open. Outside a frame it's sent right away.
 ================
 */
 void PS2_TexImageVRamUpload(ps2_teximage_t * teximage)
@@ -1419,37 +1588,194 @@ void PS2_TexImageVRamUpload(ps2_teximage_t * teximage)
         return;
     }
 
-    //
-    // Upload the texture to GS VRam.
-    // Since we are using almost all of our video memory with framebuffers
-    // and z-buffer, the rest of it can only fit a single large RGBA texture.
-    //
-
     int width;
     int height;
+    int buffer_width;
     if (!TEXIMAGE_IS_SCRAP(teximage))
     {
         width  = teximage->width;
         height = teximage->height;
+        buffer_width = teximage->texbuf.width; // GS_PSM_8 textures may have a wider buffer.
     }
     else
     {
         width  = MAX_TEXIMAGE_SIZE;
         height = MAX_TEXIMAGE_SIZE;
+        buffer_width = MAX_TEXIMAGE_SIZE;
     }
 
+    const int psm = teximage->texbuf.psm;
+    const int bytes_per_pixel = (psm == GS_PSM_32) ? 4 : (psm == GS_PSM_16) ? 2 : 1;
+
+    // Mipmaps are packed in VRam as laid out by Img_MipLayout. A single
+    // level takes the pages of the buffer, like any other GS image.
+    ps2_mip_layout_t mips;
+    if (teximage->mip_levels > 1)
+    {
+        Img_MipLayout(width, height, bytes_per_pixel * 8, teximage->mip_levels, &mips);
+    }
+    else
+    {
+        mips.num_levels      = 1;
+        mips.num_pages       = graph_vram_size(buffer_width, height, psm, GRAPH_ALIGN_PAGE) / PS2_VRAM_PAGE_WORDS;
+        mips.offset[0]       = 0;
+        mips.buffer_width[0] = buffer_width;
+    }
+
+    u32 address;
+    const qboolean resident = PS2_TexVRamAcquire(teximage->pic, mips.num_pages,
+                                                 Img_MipChainBytes(width, height, mips.num_levels, bytes_per_pixel),
+                                                 &address);
+
+    teximage->texbuf.address = address;
+    ps2ref.current_tex = teximage;
+
+    if (resident)
+    {
+        return;
+    }
+
+    int level;
+    const byte * level_pic = teximage->pic;
+
+    if (ps2ref.frame_started)
+    {
+        // The GS runs the packet in order, so the draws queued before
+        // are done sampling whatever was in these pages before the
+        // transfer overwrites them. No need to wait for anything.
+        for (level = 0; level < mips.num_levels; ++level)
+        {
+            ps2ref.current_frame_qwptr = draw_texture_transfer(ps2ref.current_frame_qwptr, (void *)level_pic,
+                                                               width >> level, height >> level, psm,
+                                                               address + mips.offset[level], mips.buffer_width[level]);
+            level_pic += (width >> level) * (height >> level) * bytes_per_pixel;
+        }
+        ps2ref.current_frame_qwptr = PS2_TexChainedFlush(ps2ref.current_frame_qwptr);
+    }
+    else
+    {
+        ps2_gs_packet_t * packet = &ps2ref.tex_upload_packet[ps2ref.frame_index];
+        qword_t * q = packet->data;
+
+        for (level = 0; level < mips.num_levels; ++level)
+        {
+            q = draw_texture_transfer(q, (void *)level_pic, width >> level, height >> level, psm,
+                                      address + mips.offset[level], mips.buffer_width[level]);
+            level_pic += (width >> level) * (height >> level) * bytes_per_pixel;
+        }
+        q = draw_texture_flush(q);
+
+        dma_channel_send_chain(DMA_CHANNEL_GIF, packet->data, (q - packet->data), 0, 0);
+        dma_wait_fast();
+    }
+
+    ps2_tex_uploads++;
+}
+
+/*
+================
+PS2_TexImageVRamRelease
+
+Called when the pixels change or are freed.
+================
+*/
+void PS2_TexImageVRamRelease(const byte * pic)
+{
+    if (pic == NULL)
+    {
+        return;
+    }
+
+    PS2_TexVRamRelease(pic);
+
+    if (ps2ref.current_tex != NULL && ps2ref.current_tex->pic == pic)
+    {
+        ps2ref.current_tex = NULL;
+    }
+}
+
+/*
+================
+PS2_ClutVRamUpload
+
+Copies ps2_global_palette to the CLUT area of VRam.
+Can be called outside Begin/End frame.
+================
+*/
+void PS2_ClutVRamUpload(void)
+{
+    static u32 clut[256] PS2_ALIGN(16);
+    Img_SwizzleClut32(ps2_global_palette, clut);
+
     ps2_gs_packet_t * packet = &ps2ref.tex_upload_packet[ps2ref.frame_index];
     qword_t * q = packet->data;
 
-    q = draw_texture_transfer(q, teximage->pic, width, height,
-                              teximage->texbuf.psm, teximage->texbuf.address, width);
+    // 16x16 block of 32bits colors, with the minimum buffer width of 64.
+    q = draw_texture_transfer(q, clut, 16, 16, GS_PSM_32, ps2ref.vram_clut_start, 64);
     q = draw_texture_flush(q);
 
     dma_channel_send_chain(DMA_CHANNEL_GIF, packet->data, (q - packet->data), 0, 0);
     dma_wait_fast();
+}
 
-    ps2ref.current_tex = teximage;
-    ps2_tex_uploads++;
+/*
+================
+PS2_TexMipmapSetup
+
+Remarks: Local function.
+Points the GS at the smaller levels of the texture and
+picks the LOD parameters for it. Goes in the frame packet.
+================
+*/
+static void PS2_TexMipmapSetup(const ps2_teximage_t * teximage, lod_t * lod)
+{
+    ps2_mip_layout_t mips;
+    u32 level_address[PS2_MAX_MIP_LEVELS] = { 0 };
+    int level_width[PS2_MAX_MIP_LEVELS]   = { 0 };
+    int level;
+
+    const int bits_per_pixel = (teximage->texbuf.psm == GS_PSM_32) ? 32 :
+                               (teximage->texbuf.psm == GS_PSM_16) ? 16 : 8;
+
+    Img_MipLayout(teximage->width, teximage->height, bits_per_pixel, teximage->mip_levels, &mips);
+    for (level = 1; level < mips.num_levels; ++level)
+    {
+        level_address[level] = teximage->texbuf.address + mips.offset[level];
+        level_width[level]    = mips.buffer_width[level];
+    }
+
+    // Bilinear inside a level, nearest between levels. Trilinear would double
+    // the texture reads, and the point is to save GS texture cache bandwidth.
+    lod->min_filter = (lod->min_filter == LOD_MIN_NEAREST) ? LOD_MIN_NEAREST_MIPMAP_NEAREST :
+                                                             LOD_MIN_LINEAR_MIPMAP_NEAREST;
+
+    // With LCM=0 the GS picks LOD = log2(1/Q) + K. Q is 1/w, so that is the
+    // log2 of the view distance. A WAL texel is a world unit, and it takes a
+    // pixel at the distance where it is as wide as the focal length in pixels
+    // (half the screen width at 90 degrees FOV), so that is where level 0
+    // must end. The smaller the texture, the fewer levels it has to go down
+    // to, which is the per texture part, MXL. Unmipmapped UV draws (2D) are
+    // sampled with Q=1, so they still get level 0. The log2 is rounded
+    // down, which keeps level 0 a bit further away.
+    int focal_log2 = 0;
+    while (((viddef.width / 2) >> (focal_log2 + 1)) > 0)
+    {
+        ++focal_log2;
+    }
+
+    lod->calculation = LOD_USE_FORMULA;
+    lod->max_level   = mips.num_levels - 1;
+    lod->l           = 0;
+    lod->k           = -focal_log2 + r_ps2_mip_lod_bias->value;
+
+    qword_t * q = ps2ref.current_frame_qwptr;
+    PACK_GIFTAG(q, GIF_SET_TAG(1, 0, 0, 0, GIF_FLG_PACKED, 1), GIF_REG_AD);
+    q++;
+    PACK_GIFTAG(q, GS_SET_MIPTBP1(level_address[1] >> 6, level_width[1] >> 6,
+                                  level_address[2] >> 6, level_width[2] >> 6,
+                                  level_address[3] >> 6, level_width[3] >> 6), GS_REG_MIPTBP1_1);
+    q++;
+    ps2ref.current_frame_qwptr = q;
 }
 
 /*
@@ -1478,6 +1804,7 @@ void PS2_TexImageBindCurrent(void)
     lod.min_filter    = ps2ref.current_tex->min_filter;
     lod.calculation   = LOD_USE_K;
     lod.max_level     = 0;
+    lod.mipmap_select = LOD_MIPMAP_REGISTER;
     lod.l             = 0;
     lod.k             = 0;
     clut.address      = 0;
@@ -1486,6 +1813,16 @@ void PS2_TexImageBindCurrent(void)
     clut.storage_mode = CLUT_STORAGE_MODE1;
     clut.load_method  = CLUT_NO_LOAD;
 
+    // Palettized textures sample the shared CLUT. Loading it into the
+    // GS CLUT buffer on every bind is only 1KB of local VRam copy, much
+    // less than the texture upload that precedes the bind.
+    if (ps2ref.current_tex->texbuf.psm == GS_PSM_8)
+    {
+        clut.address     = ps2ref.vram_clut_start;
+        clut.psm         = GS_PSM_32;
+        clut.load_method = CLUT_LOAD;
+    }
+
     if (!TEXIMAGE_IS_SCRAP(ps2ref.current_tex))
     {
         p_texbuf = &ps2ref.current_tex->texbuf;
@@ -1496,7 +1833,7 @@ void PS2_TexImageBindCurrent(void)
         // the size of the backing atlas texture, but the size of the tile.
         byte size_log2 = draw_log2(MAX_TEXIMAGE_SIZE);
 
-        tmp_texbuf.address         = ps2ref.vram_texture_start;
+        tmp_texbuf.address         = ps2ref.current_tex->texbuf.address;
         tmp_texbuf.width           = MAX_TEXIMAGE_SIZE;
         tmp_texbuf.psm             = GS_PSM_32;
         tmp_texbuf.info.width      = size_log2;
@@ -1507,6 +1844,11 @@ void PS2_TexImageBindCurrent(void)
         p_texbuf = &tmp_texbuf;
     }
 
+    if (ps2ref.current_tex->mip_levels > 1)
+    {
+        PS2_TexMipmapSetup(ps2ref.current_tex, &lod);
+    }
+
     ps2ref.current_frame_qwptr = draw_texture_sampling(ps2ref.current_frame_qwptr, 0, &lod);
     ps2ref.current_frame_qwptr = draw_texturebuffer(ps2ref.current_frame_qwptr, 0, p_texbuf, &clut);
 }
@@ -16,10 +16,20 @@
 #include "client/client.h"
 #include "ps2/defs_ps2.h"
 
+#ifdef _EE
 // PS2DEV SDK:
 #include <tamtypes.h>
 #include <draw_buffers.h>
 #include <draw_types.h>
+#else // !_EE
+// The world cooker builds model_load.c on the host (see src/tools/worldcook.c).
+// It never talks to the GS, so the libdraw types only need to be complete.
+typedef struct { u64 dw[2]; } qword_t;
+typedef struct { u8 r, g, b, a; float q; } color_t;
+typedef struct { int width, psm, address; } texbuffer_t;
+typedef struct { int width, height, mask, psm, address; } framebuffer_t;
+typedef struct { int enable, method, address, mask, zsm; } zbuffer_t;
+#endif // _EE
 
 /*
 ==============================================================
@@ -43,6 +53,14 @@ enum
     MAX_TEXIMAGES      = 1024,
     MAX_TEXIMAGE_SIZE  = 256,
 
+    // GS local memory, in 32bits words. Textures are cached in whole pages.
+    PS2_VRAM_SIZE_WORDS = 1024 * 1024,
+    PS2_VRAM_PAGE_WORDS = 2048,
+    PS2_VRAM_BLOCK_WORDS = 64,
+
+    // WAL files store 4 levels, and that's all we keep.
+    PS2_MAX_MIP_LEVELS = 4,
+
     // ps2_gs_packet_t constants:
     GS_PACKET_QWC_MAX  = 65535, // Maximum number of qwords allowed, but each channel has its own limitations.
     GS_PACKET_NORMAL   = 0x00,  // Normal EE RAM.
@@ -80,7 +98,8 @@ typedef struct
     u16                 width;                   // Width in pixels;  Must be > 0 && <= MAX_TEXIMAGE_SIZE.
     u16                 height;                  // Height in pixels; Must be > 0 && <= MAX_TEXIMAGE_SIZE.
     u16                 mag_filter;              // One of the LOD_MAG_* from libdraw.
-    u16                 min_filter;              // One of the LOD_MIN_* from libdraw.
+    u16                 min_filter;              // One of the LOD_MIN_* from libdraw. Used for the top level of a mipmapped image.
+    u16                 mip_levels;              // Levels stored in pic, one after the other. 1 if not mipmapped.
     u16                 u0, v0;                  // Offsets into the scrap if this is allocate from the scrap, zero otherwise.
     u16                 u1, v1;                  // If not zero, this is a scrap image. In such case, use these instead of w&h.
     texbuffer_t         texbuf;                  // GS texture buffer info from libdraw.
@@ -97,6 +116,7 @@ typedef struct
     qboolean          show_fps_count;            // Draws a frames per sec counter in the top-right corner of the screen.
     qboolean          show_mem_tags;             // Draws a debug overlay with the current values of the memory tags.
     qboolean          show_render_stats;         // Display a debug overlay with other miscellaneous renderer stats.
+    qboolean          show_profiler;             // Display a debug overlay with the frame profiler scope times.
     qboolean          frame_started;             // Set by BeginFrame, cleared at EndFrame. Some calls must be in between.
     qboolean          registration_started;      // Set when between BeginRegistration/EndRegistration.
     u32               registration_sequence;     // Bumped each BeginRegistration. Any loaded model/image not matching it is freed on EndRegistration.
@@ -113,7 +133,8 @@ typedef struct
     u32               fade_scr_alpha;            // How dark to fade the screen: 255=totally black, 0=no fade.
     u32               frame_index;               // Index of the current frame buffer.
     u32               vram_used_bytes;           // Bytes of VRam currently committed.
-    u32               vram_texture_start;        // Start of VRam after screen buffers where we can alloc textures.
+    u32               vram_texture_start;        // Start of VRam after screen buffers where we can alloc textures (see tex_vram.c).
+    u32               vram_clut_start;           // VRam address of the CLUT shared by all the GS_PSM_8 textures (ps2_global_palette).
     ps2_teximage_t *  current_tex;               // Pointer to the current game texture in VRam (points to teximages[]).
     ps2_teximage_t    teximages[MAX_TEXIMAGES];  // All the textures used by a game level + UI must fit in here!
 } ps2_refresh_t;
@@ -158,6 +179,8 @@ struct image_s * PS2_RegisterPic(const char * name);
  * Frame rendering (3D stuff):
  */
 
+struct ps2_model_s;
+
 qboolean PS2_IsFrameStarted(void);
 void PS2_BeginFrame(float camera_separation);
 void PS2_EndFrame(void);
@@ -165,6 +188,8 @@ void PS2_RenderFrame(refdef_t * view_def);
 void PS2_DrawFrameSetup(const refdef_t * view_def);
 void PS2_DrawWorldModel(refdef_t * view_def);
 void PS2_DrawViewEntities(refdef_t * view_def);
+void PS2_WorldStaticDMASetup(struct ps2_model_s * world_mdl);
+void PS2_WorldDrawShutdown(void);
 void PS2_SetClearColor(byte r, byte g, byte b);
 
 /*
@@ -224,6 +249,8 @@ ps2_teximage_t * PS2_TexImageFindOrLoad(const char * name, int flags);
 
 void PS2_TexImageVRamUpload(ps2_teximage_t * teximage);
 void PS2_TexImageBindCurrent(void);
+void PS2_ClutVRamUpload(void);
+void PS2_TexImageVRamRelease(const byte * pic);
 
 void PS2_TexImageSetup(ps2_teximage_t * teximage, const char * name, int w, int h, int components,
                        int func, int psm, int mag_filter, int min_filter, ps2_imagetype_t type, byte * pic);
@@ -256,6 +283,89 @@ void Img_UnPalettize24(int width, int height, const byte * restrict pic8in,
 void Img_UnPalettize16(int width, int height, const byte * restrict pic8in,
                        const u32 * restrict palette, byte * restrict pic16out);
 
+/*
+ * VRam texture cache (see tex_vram.c):
+ */
+
+typedef struct
+{
+    int hits;         // Binds of images that were still in VRam.
+    int misses;       // Binds that had to upload the image.
+    int evictions;    // Images dropped to make room for others.
+    u32 upload_bytes; // Texel bytes sent to VRam.
+    int pages_used;   // VRam pages currently holding images.
+    int pages_total;  // Size of the texture area in pages.
+} ps2_tex_vram_stats_t;
+
+// The area of 'num_pages' VRam pages starting at word address 'start'.
+void PS2_TexVRamInit(u32 start, int num_pages);
+
+// Forgets every image, e.g. when the VRam contents are lost.
+void PS2_TexVRamReset(void);
+
+// Advances the LRU clock and starts a new set of frame stats.
+void PS2_TexVRamBeginFrame(void);
+
+// Looks up the image with the given pixels. Returns true if it is still
+// in VRam. Otherwise, places it in 'num_pages' pages, evicting the least
+// recently used images as needed, and returns false: the caller must then
+// upload 'upload_bytes' of texels to '*address' before the image is used.
+qboolean PS2_TexVRamAcquire(const void * pic, int num_pages, u32 upload_bytes, u32 * address);
+
+// Drops the image from VRam, if there. For when the pixels change or are freed.
+void PS2_TexVRamRelease(const void * pic);
+
+// Stats of the last complete frame, plus the current page use.
+void PS2_TexVRamGetStats(ps2_tex_vram_stats_t * stats);
+
+/*
+ * 8bits palettized textures (see tex_palette.c):
+ */
+
+// How Common8BitTexSetup stores an image loaded from a PCX or WAL.
+typedef enum
+{
+    IMG_8BIT_INDEXED8, // GS_PSM_8, sampled through the shared CLUT.
+    IMG_8BIT_RGB16,    // GS_PSM_16, when r_ps2_paletted_tex is off.
+    IMG_8BIT_RGBA32    // GS_PSM_32, resampled or with filtered transparency.
+} img_8bit_format_t;
+
+// True if any pixel uses the transparent palette index (255).
+qboolean Img_HasTransparency(const byte * pic8in, int pixel_count);
+
+// Picks the storage format for a palettized image.
+img_8bit_format_t Img_Choose8BitFormat(const byte * pic8in, int width, int height,
+                                       qboolean allow_indexed, qboolean nearest_filter);
+
+// Bytes per pixel of the above formats.
+int Img_8BitFormatBytes(img_8bit_format_t format);
+
+// Reorders a 256 colors palette into the CSM1 layout the GS expects for a CLUT.
+void Img_SwizzleClut32(const u32 * restrict palette, u32 * restrict clut_out);
+
+/*
+ * Mipmaps (see tex_mipmap.c):
+ */
+
+// Where each level of a mipmapped image goes in VRam.
+typedef struct
+{
+    int num_levels;
+    int num_pages;                           // VRam pages taken by all levels.
+    u32 offset[PS2_MAX_MIP_LEVELS];          // Word offset of each level from the first page.
+    int buffer_width[PS2_MAX_MIP_LEVELS];    // Buffer width of each level in pixels (TBW * 64).
+} ps2_mip_layout_t;
+
+// Levels to keep for an image of that size, including the top one, at most 'max_levels'.
+int Img_NumMipLevels(int width, int height, int max_levels);
+
+// Size in bytes of the first 'num_levels' levels, stored one after the other.
+int Img_MipChainBytes(int width, int height, int num_levels, int bytes_per_pixel);
+
+// Packs the levels of a power-of-two image into VRam pages.
+// 'bits_per_pixel' is 32, 16 or 8 (GS_PSM_32, GS_PSM_16 or GS_PSM_8).
+void Img_MipLayout(int width, int height, int bits_per_pixel, int num_levels, ps2_mip_layout_t * mips);
+
 /*
  * Other image utilities:
  */
@@ -268,4 +378,81 @@ ps2_teximage_t * Img_ScrapAlloc(const byte * pic8in, int w, int h, const char *
 void Img_Resample32(const u32 * restrict in_img, int in_width, int in_height,
                     u32 * restrict out_img, int out_width, int out_height);
 
+/*
+ * Packed VU1 vertex streams (see vert_pack.c):
+ */
+
+// VU1 data memory layout of the world programs, in quadwords. The constants
+// are sent once per chain. The batches are double buffered by the VIF (BASE and
+// OFFSET codes): a batch unpacks to the half the running program isn't reading,
+// the program finds it with XTOP and the vertex count is passed in ITOP.
+enum
+{
+    PS2_VU_MVP_MATRIX      = 0,   // 4 qwords, sent once per chain.
+    PS2_VU_SCALES          = 4,   // GS scales in XYZ, sent once per chain.
+    PS2_VU_KICK_FENCE      = 5,   // Empty GIF tag the programs kick to wait for their batch to go out.
+    PS2_VU_DBUF_BASE       = 8,   // First half of the batch double buffer.
+    PS2_VU_DBUF_SIZE       = 508, // Qwords in each half, up to the end of VU1 memory.
+    PS2_VU_MAX_BATCH_VERTS = 252  // 84 triangles, what fits in a half (2 qwords per vertex).
+};
+
+// Batch of VU1Prog_Color_Triangles_Packed, relative to its half of the double buffer.
+// Batches are unpacked with a skipping write cycle (STCYCL WL=1, CL=2),
+// so everything they send lands on every other qword.
+enum
+{
+    PS2_VU_PACKED_POS_ORIGIN   = 0, // Batch origin in XYZ, position step in W.
+    PS2_VU_PACKED_GIFTAG       = 2, // GIF tag + register list.
+    PS2_VU_PACKED_START_COLOR  = 3, // Color (V4_8) of the first vertex.
+    PS2_VU_PACKED_START_VERT   = 4, // Position (V3_16) of the first vertex.
+    PS2_VU_PACKED_MAX_VERTS    = PS2_VU_MAX_BATCH_VERTS
+};
+
+// Positions go as 16 bits integers from a per-batch origin,
+// in steps no finer than 1/PS2_VERT_POS_MIN_STEP_INV units.
+#define PS2_VERT_POS_MIN_STEP_INV 16
+
+// Texture coordinates go as 4:12 fixed point from a per-batch whole repeat.
+#define PS2_VERT_ST_FRAC_BITS 12
+
+// Where the 16 bits positions of a batch are relative to.
+typedef struct
+{
+    float origin[3]; // Added back to every position by the VU program.
+    float step;      // World units per integer step. Always a power of two.
+} ps2_vert_pos_frame_t;
+
+// Picks the origin and the finest step that still covers every point.
+void Vert_PosFrameFromPoints(const float * positions, int num_verts, ps2_vert_pos_frame_t * frame);
+
+// Position <=> V3_16 encoding. Decoding is the same math the VU program does.
+void Vert_PackPosition(const ps2_vert_pos_frame_t * frame, const float * position, s16 * out_xyz);
+void Vert_UnpackPosition(const ps2_vert_pos_frame_t * frame, const s16 * in_xyz, float * out_position);
+
+// RGBA <=> V4_8 encoding (one word, bytes in memory order).
+u32 Vert_PackColor(const byte * rgba);
+void Vert_UnpackColor(u32 packed, byte * out_rgba);
+
+// Texture coordinates <=> V2_16 encoding. 'base' is the
+// whole repeat subtracted, floor() of the batch minimum.
+void Vert_PackTexCoords(const float * st, const float * base, s16 * out_st);
+void Vert_UnpackTexCoords(const s16 * in_st, const float * base, float * out_st);
+
+// Words Vert_PackBatch writes for a batch of 'num_verts', VIF codes included,
+// and the same batch with every vertex sent as two V4_32 qwords, for comparison.
+int Vert_PackedBatchWords(int num_verts);
+int Vert_UnpackedBatchWords(int num_verts);
+
+// Writes what goes once before the batches: the MVP matrix, GS scales and kick
+// fence, the double buffer setup and the write cycle the batches expect.
+// Returns the words written.
+#define PS2_VERT_FRAME_HEADER_WORDS 30
+int Vert_PackFrameHeader(u32 * out, const float * mvp_matrix);
+
+// Writes a whole VU1 batch as VIF codes and packed data: the vertex count as ITOP,
+// origin, GIF tag, the colors and positions, all to the free half of the double
+// buffer, then a MSCAL of 'vu_prog_addr'. Returns the words written.
+int Vert_PackBatch(u32 * out, const float * positions, const u32 * colors, int num_verts,
+                   u64 giftag, u64 giftag_regs, int vu_prog_addr);
+
 #endif // PS2_REFRESH_H
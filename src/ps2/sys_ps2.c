@@ -21,6 +21,7 @@
 #include <smod.h>
 #include <sifrpc.h>
 #include <loadfile.h>
+#include <fileXio_rpc.h>
 
 // ref_ps2.c
 extern void PS2_RendererShutdown(void);
@@ -65,6 +66,23 @@ void Sys_LoadIOPModules(void)
         Sys_Error("Failed to load IOP module usbd! %d", result);
     }
 
+    // iomanX.irx + fileXio.irx, for the async file loading (common/fs_async.c):
+    extern void iomanX_irx;
+    extern int size_iomanX_irx;
+    result = SifExecModuleBuffer(&iomanX_irx, size_iomanX_irx, 0, NULL, NULL);
+    if (result <= 0)
+    {
+        Sys_Error("Failed to load IOP module iomanX! %d", result);
+    }
+
+    extern void fileXio_irx;
+    extern int size_fileXio_irx;
+    result = SifExecModuleBuffer(&fileXio_irx, size_fileXio_irx, 0, NULL, NULL);
+    if (result <= 0)
+    {
+        Sys_Error("Failed to load IOP module fileXio! %d", result);
+    }
+
     // Give the IOP a moment to be sure the modules are ready.
     nopdelay();
 }
@@ -86,6 +104,12 @@ void Sys_Init(void)
     // Load the built-in IOP modules we need for the game.
     Sys_LoadIOPModules();
 
+    // Binds the fileXio RPC server, now that the module is running.
+    if (fileXioInit() < 0)
+    {
+        Sys_Error("Failed to initialize fileXio!");
+    }
+
     // Add our estimate of the amount of memory used to allocate
     // the program executable and all the prog data:
     PS2_TagsAddMem(MEMTAG_MISC, PROG_MEGABYTES * 1024 * 1024);
@@ -269,6 +293,16 @@ int Sys_Milliseconds(void)
 	return curtime;
 }
 
+/*
+================
+Sys_Microseconds
+================
+*/
+unsigned int Sys_Microseconds(void)
+{
+    return (unsigned int)(((u64)clock() * 1000000) / CLOCKS_PER_SEC);
+}
+
 /*
 ================
 Sys_ConsoleInput
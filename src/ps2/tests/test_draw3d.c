@@ -45,8 +45,8 @@ static const int NUM_VERTEX_ELEMENTS = 2;
 // to send per draw list info to the Vector Unit 1.
 typedef struct
 {
-    // We send one matrix and 1 quadword (vec4) for each draw list.
-    byte buffer[sizeof(m_mat4_t) + sizeof(m_vec4_t)] PS2_ALIGN(16);
+    // We send one matrix and 2 quadwords (scales and kick fence) for each draw list.
+    byte buffer[sizeof(m_mat4_t) + sizeof(m_vec4_t) * 2] PS2_ALIGN(16);
     byte * ptr;
 } draw_data_t;
 
@@ -71,19 +71,21 @@ static void DrawDataAddMatrix(draw_data_t * dd, const m_mat4_t * m)
     dd->ptr += sizeof(*m);
 }
 
-static void DrawDataAddScaleFactorsAndVertCount(draw_data_t * dd, u32 vert_count)
+static void DrawDataAddScaleFactorsAndKickFence(draw_data_t * dd)
 {
     // GS rasterizer scale factors follow the MVP matrix:
     float * scale_vec = (float *)dd->ptr;
     scale_vec[0] = 2048.0f;
     scale_vec[1] = 2048.0f;
     scale_vec[2] = ((float)0xFFFFFF) / 32.0f;
-    dd->ptr += sizeof(float) * 3;
-
-    // And lastly the vertex count in the W component of the quadword.
-    u32 * count = (u32 *)dd->ptr;
-    *count = vert_count;
-    dd->ptr += sizeof(u32);
+    scale_vec[3] = 0.0f;
+    dd->ptr += sizeof(float) * 4;
+
+    // And the empty GIF tag the program kicks to wait for the triangles to go out.
+    u64 * fence = (u64 *)dd->ptr;
+    fence[0] = GS_GIFTAG(0, 1, 0, 0, GS_GIFTAG_PACKED, 1);
+    fence[1] = 0;
+    dd->ptr += sizeof(u64) * 2;
 }
 
 static int CountVertexLoops(float vertex_qwords, float num_regs)
@@ -103,16 +105,17 @@ static void DrawVU1Triangle(draw_data_t * dd, const m_mat4_t * mvp)
 {
     DrawDataReset(dd);
     DrawDataAddMatrix(dd, mvp);
-    DrawDataAddScaleFactorsAndVertCount(dd, 3); // 1 triangle = 3 verts
+    DrawDataAddScaleFactorsAndKickFence(dd);
 
     VU1_Begin();
 
-    // Matrix/scales will be uploaded at address 0 in VU memory.
+    // Matrix/scales/fence will be uploaded at address 0 in VU memory.
     const int draw_data_qwsize = DrawDataGetQWordSize(dd);
-    VU1_ListData(0, dd->buffer, draw_data_qwsize);
+    VU1_ListData(PS2_VU_MVP_MATRIX, dd->buffer, draw_data_qwsize);
 
-    // Data added from here will begin at address 6, right after the MVP, fScales and vert count:
-    VU1_ListAddBegin(draw_data_qwsize);
+    // Data added from here goes to the first half of the VU memory double buffer.
+    VU1_ListDoubleBuffer(PS2_VU_DBUF_BASE, PS2_VU_DBUF_SIZE);
+    VU1_ListAddBegin(0);
 
     // The GIF Tag and primitive description:
     const int vert_loops = CountVertexLoops(/* vertex_qwords = */ 6, NUM_VERTEX_ELEMENTS);
@@ -156,11 +159,12 @@ static void DrawVU1Triangle(draw_data_t * dd, const m_mat4_t * mvp)
     VU1_ListAddFloat(3.0f);
     VU1_ListAddFloat(1.0f);
 
-    // 13 qwords total so far (verts + matrix/scales draw data)
+    // 7 qwords total so far (GIF tag + verts)
     VU1_ListAddEnd();
 
     // End the list and start the VU program (located in micromem address 0)
-    VU1_End(0);
+    // 1 triangle = 3 verts, passed in ITOP.
+    VU1_End(0, 3);
 }
 
 #define XYZ2 ((u64)0x05)
@@ -458,16 +462,17 @@ static void DrawVU1Cube(draw_data_t * dd, const m_mat4_t * mvp, const cube_t * c
 {
     DrawDataReset(dd);
     DrawDataAddMatrix(dd, mvp);
-    DrawDataAddScaleFactorsAndVertCount(dd, CUBE_INDEX_COUNT); // 1 vertex per index
+    DrawDataAddScaleFactorsAndKickFence(dd);
 
     VU1_Begin();
 
-    // Matrix/scales will be uploaded at address 0 in VU memory.
+    // Matrix/scales/fence will be uploaded at address 0 in VU memory.
     const int draw_data_qwsize = DrawDataGetQWordSize(dd);
-    VU1_ListData(0, dd->buffer, draw_data_qwsize);
+    VU1_ListData(PS2_VU_MVP_MATRIX, dd->buffer, draw_data_qwsize);
 
-    // Data added from here will begin at address 6, right after the MVP, fScales and vert count:
-    VU1_ListAddBegin(draw_data_qwsize);
+    // Data added from here goes to the first half of the VU memory double buffer.
+    VU1_ListDoubleBuffer(PS2_VU_DBUF_BASE, PS2_VU_DBUF_SIZE);
+    VU1_ListAddBegin(0);
 
     // The GIF Tag and primitive description:
     const int vertex_qws = CUBE_INDEX_COUNT * 2; // 2 qwords per vertex (color + position)
@@ -507,12 +512,13 @@ static void DrawVU1Cube(draw_data_t * dd, const m_mat4_t * mvp, const cube_t * c
         VU1_ListAddFloat(vert->z);
         VU1_ListAddFloat(vert->w);
     }
-    // We have (6 + 36*2 = 78) qwords of draw data for a cube
+    // We have (1 + 36*2 = 73) qwords of draw data for a cube
 
     VU1_ListAddEnd();
 
     // End the list and start the VU program (located in micromem address 0)
-    VU1_End(0);
+    // 1 vertex per index, passed in ITOP.
+    VU1_End(0, CUBE_INDEX_COUNT);
 
     // Since we are going to draw multiple cubes, we need to synchronize before
     // writing to the same VU1 memory address. Waiting for the GS to finish draw does the job.
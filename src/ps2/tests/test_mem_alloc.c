@@ -0,0 +1,135 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: test_mem_alloc.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Throughput and fragmentation benchmark for the slab pools in mem_alloc.c.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/q_common.h"
+#include "ps2/mem_alloc.h"
+
+// Functions exported from this file:
+void Test_PS2_MemAlloc(void);
+
+//=============================================================================
+//
+// Test_PS2_MemAlloc -- Runs the same random alloc/free workload through
+// PS2_MemAlloc/PS2_MemFree with the slab pools disabled (dlmalloc only) and
+// then enabled, printing time per operation and the peak footprint.
+//
+// Also available from the console as 'mem_bench'.
+//
+//=============================================================================
+
+enum
+{
+    MEMBENCH_SLOTS = 4096,   // Live allocations kept around.
+    MEMBENCH_OPS   = 200000, // Free+alloc pairs after the initial fill.
+    MEMBENCH_SAMPLE_INTERVAL = 1024
+};
+
+static void * membench_ptrs[MEMBENCH_SLOTS];
+static int membench_sizes[MEMBENCH_SLOTS];
+
+static unsigned int MemBench_Rand(unsigned int * seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7FFF;
+}
+
+// Roughly the mix of small sizes Z_Malloc sees from game code (strings,
+// spawn temps). Only sizes the slab pools handle, so that in the slab run
+// dlmalloc stays out of the picture and the footprints are comparable.
+static int MemBench_RandSize(unsigned int * seed)
+{
+    const unsigned int r = MemBench_Rand(seed) % 100;
+    if (r < 50) return 8   + MemBench_Rand(seed) % 57;
+    if (r < 85) return 65  + MemBench_Rand(seed) % 128;
+    return 193 + MemBench_Rand(seed) % (PS2_SLAB_MAX_SIZE - 192);
+}
+
+// Bytes taken by the MISC dlmalloc space plus the slab pages in use.
+static unsigned int MemBench_Footprint(void)
+{
+    unsigned int pages_used, pages_total;
+    unsigned int footprint, in_use, budget;
+    PS2_SlabGetUsage(&pages_used, &pages_total);
+    PS2_MemGetSpaceUsage(MEMTAG_MISC, &footprint, &in_use, &budget);
+    return footprint + pages_used * PS2_SLAB_PAGE_SIZE;
+}
+
+static void MemBench_Run(const char * label, int use_slabs)
+{
+    int i, op, slot;
+    unsigned int seed = 1234;
+    unsigned int live_bytes = 0;
+    unsigned int footprint, base_footprint;
+    unsigned int peak_footprint = 0, live_at_peak = 0;
+    unsigned int start_time, elapsed;
+
+    ps2_mem_slabs_enabled = use_slabs;
+
+    base_footprint = MemBench_Footprint();
+    start_time = Sys_Microseconds();
+
+    for (i = 0; i < MEMBENCH_SLOTS; ++i)
+    {
+        membench_sizes[i] = MemBench_RandSize(&seed);
+        membench_ptrs[i]  = PS2_MemAlloc(membench_sizes[i], MEMTAG_MISC);
+        live_bytes += membench_sizes[i];
+    }
+
+    for (op = 0; op < MEMBENCH_OPS; ++op)
+    {
+        slot = (int)(MemBench_Rand(&seed) % MEMBENCH_SLOTS);
+
+        PS2_MemFree(membench_ptrs[slot], membench_sizes[slot], MEMTAG_MISC);
+        live_bytes -= membench_sizes[slot];
+
+        membench_sizes[slot] = MemBench_RandSize(&seed);
+        membench_ptrs[slot]  = PS2_MemAlloc(membench_sizes[slot], MEMTAG_MISC);
+        live_bytes += membench_sizes[slot];
+
+        if ((op % MEMBENCH_SAMPLE_INTERVAL) == 0)
+        {
+            footprint = MemBench_Footprint() - base_footprint;
+            if (footprint > peak_footprint)
+            {
+                peak_footprint = footprint;
+                live_at_peak   = live_bytes;
+            }
+        }
+    }
+
+    for (i = 0; i < MEMBENCH_SLOTS; ++i)
+    {
+        PS2_MemFree(membench_ptrs[i], membench_sizes[i], MEMTAG_MISC);
+        membench_ptrs[i] = NULL;
+    }
+
+    elapsed = Sys_Microseconds() - start_time;
+
+    Com_Printf("%-8s %8.1f ns/op  peak %s, live %s, overhead %.1f%%\n", label,
+               elapsed * 1000.0 / (MEMBENCH_SLOTS * 2 + MEMBENCH_OPS * 2),
+               PS2_FormatMemoryUnit(peak_footprint, true),
+               PS2_FormatMemoryUnit(live_at_peak, true),
+               (peak_footprint > live_at_peak) ?
+                   100.0 * (peak_footprint - live_at_peak) / peak_footprint : 0.0);
+}
+
+void Test_PS2_MemAlloc(void)
+{
+    const int slabs_were_enabled = ps2_mem_slabs_enabled;
+
+    Com_Printf("====== QPS2 - Test_PS2_MemAlloc ======\n");
+    Com_Printf("%d live blocks, %d free/alloc pairs\n", MEMBENCH_SLOTS, MEMBENCH_OPS);
+
+    MemBench_Run("dlmalloc", 0);
+    MemBench_Run("slabs", 1);
+
+    ps2_mem_slabs_enabled = slabs_were_enabled;
+}
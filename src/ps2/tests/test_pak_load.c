@@ -0,0 +1,167 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: test_pak_load.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Load time benchmark for plain vs. compressed paks (see src/tools/mkpak.c).
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/q_common.h"
+
+// Functions exported from this file:
+void Test_PS2_PakLoad(void);
+
+//=============================================================================
+//
+// Test_PS2_PakLoad -- Loads the first map and the default sounds from a
+// plain pak and from the same data packed with 'mkpak', printing the time
+// and the bytes read from disc for each, and checking that both decode to
+// the same contents. The paks are opened on their own, outside the search
+// path. Build the pair with 'mkpak -s dir pak0.pak' and 'mkpak dir pak0z.pak'.
+//
+// Also available from the console as 'pak_bench [plain.pak packed.pak] [runs]',
+// with pak names relative to the game directory.
+//
+//=============================================================================
+
+static const char * pakbench_files[] =
+{
+    "maps/base1.bsp",
+    // Registered by CL_RegisterTEntSounds for every level:
+    "sound/world/ric1.wav",
+    "sound/world/ric2.wav",
+    "sound/world/ric3.wav",
+    "sound/weapons/lashit.wav",
+    "sound/world/spark5.wav",
+    "sound/world/spark6.wav",
+    "sound/world/spark7.wav",
+    "sound/weapons/railgf1a.wav",
+    "sound/weapons/rocklx1a.wav",
+    "sound/weapons/grenlx1a.wav",
+    "sound/weapons/xpld_wat.wav",
+    "sound/player/land1.wav",
+    "sound/player/fall2.wav",
+    "sound/player/fall1.wav",
+    "sound/player/step1.wav",
+    "sound/player/step2.wav",
+    "sound/player/step3.wav",
+    "sound/player/step4.wav",
+    NULL
+};
+
+typedef struct
+{
+    int files;
+    unsigned int bytes_loaded;
+    unsigned int bytes_read;
+    unsigned int usec;
+} pakbench_result_t;
+
+// Loads every file in the list that the pak has. If 'reference' is
+// given, the contents are checked against the same file in it.
+static void PakBench_Run(struct pack_s * pak, struct pack_s * reference, int runs, pakbench_result_t * result)
+{
+    int i, run;
+    int len;
+    unsigned int start;
+    fs_view_t view;
+    fs_view_t ref_view;
+    byte * data;
+    byte * ref_data;
+
+    memset(result, 0, sizeof(*result));
+
+    for (i = 0; pakbench_files[i] != NULL; ++i)
+    {
+        len = FS_OpenPakView(pak, pakbench_files[i], &view);
+        if (len < 0)
+        {
+            continue;
+        }
+
+        for (run = 0; run < runs; ++run)
+        {
+            FS_OpenPakView(pak, pakbench_files[i], &view);
+            data = Z_Malloc(len + 1);
+
+            start = Sys_Microseconds();
+            FS_ReadView(&view, data, len);
+            result->usec += Sys_Microseconds() - start;
+
+            if (run == 0 && reference && FS_OpenPakView(reference, pakbench_files[i], &ref_view) == len)
+            {
+                ref_data = Z_Malloc(len + 1);
+                FS_ReadView(&ref_view, ref_data, len);
+                if (memcmp(data, ref_data, len) != 0)
+                {
+                    Com_Printf("%s differs between the paks!\n", pakbench_files[i]);
+                }
+                Z_Free(ref_data);
+            }
+
+            Z_Free(data);
+        }
+
+        result->files++;
+        result->bytes_loaded += len;
+        result->bytes_read   += view.complen ? view.complen : len;
+    }
+}
+
+static void PakBench_Print(const char * label, const pakbench_result_t * result, int runs)
+{
+    Com_Printf("%-8s %3d files %7u KB, read %7u KB, %8.3f ms/run\n", label, result->files,
+               result->bytes_loaded / 1024, result->bytes_read / 1024,
+               result->usec / 1000.0 / runs);
+}
+
+void Test_PS2_PakLoad(void)
+{
+    int runs;
+    char plain_name[MAX_OSPATH];
+    char packed_name[MAX_OSPATH];
+    struct pack_s * plain;
+    struct pack_s * packed;
+    pakbench_result_t plain_result;
+    pakbench_result_t packed_result;
+
+    Com_sprintf(plain_name, sizeof(plain_name), "%s/%s", FS_Gamedir(),
+                (Cmd_Argc() > 2) ? Cmd_Argv(1) : "pak0.pak");
+    Com_sprintf(packed_name, sizeof(packed_name), "%s/%s", FS_Gamedir(),
+                (Cmd_Argc() > 2) ? Cmd_Argv(2) : "pak0z.pak");
+    runs = (Cmd_Argc() > 3) ? atoi(Cmd_Argv(3)) : 10;
+    if (runs < 1)
+    {
+        runs = 1;
+    }
+
+    Com_Printf("====== QPS2 - Test_PS2_PakLoad ======\n");
+
+    plain = FS_LoadPackFile(plain_name);
+    if (!plain)
+    {
+        Com_Printf("Can't open %s\n", plain_name);
+        return;
+    }
+    packed = FS_LoadPackFile(packed_name);
+    if (!packed)
+    {
+        Com_Printf("Can't open %s\n", packed_name);
+        FS_FreePackFile(plain);
+        return;
+    }
+
+    Com_Printf("%d runs\n", runs);
+
+    PakBench_Run(plain, NULL, runs, &plain_result);
+    PakBench_Run(packed, plain, runs, &packed_result);
+
+    PakBench_Print("plain", &plain_result, runs);
+    PakBench_Print("packed", &packed_result, runs);
+
+    FS_FreePackFile(packed);
+    FS_FreePackFile(plain);
+}
@@ -0,0 +1,182 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: test_tex_cache.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Lookup benchmark for the texture cache name index (see ps2/name_index.h).
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "client/client.h"
+#include "ps2/ref_ps2.h"
+#include "common/q_files.h"
+
+// Functions exported from this file:
+void Test_PS2_TexCache(void);
+
+//=============================================================================
+//
+// Test_PS2_TexCache -- Loads every wall texture referenced by base1.bsp with
+// PS2_TexImageFindOrLoad, then looks the same names up again many times, both
+// through the renderer (hashed index) and through a linear scan of all the
+// ps2ref.teximages[] slots like FindImageImpl used to do, printing the time
+// per lookup for each and checking that both find the images first loaded.
+//
+//=============================================================================
+
+enum
+{
+    TEXBENCH_MAX_NAMES = 512,
+    TEXBENCH_RUNS      = 100
+};
+
+static char texbench_names[TEXBENCH_MAX_NAMES][MAX_QPATH];
+static ps2_teximage_t * texbench_images[TEXBENCH_MAX_NAMES];
+
+extern u32 Sys_HashString(const char * str);
+extern ps2_teximage_t * ps2_builtin_tex_debug;
+
+// Unique "textures/<name>.wal" paths from the map's texinfo lump.
+static int TexBench_GatherNames(const char * map_name)
+{
+    int i, j;
+    int num_names = 0;
+    byte * data = NULL;
+    char name[MAX_QPATH];
+
+    if (FS_LoadFile(map_name, (void **)&data) <= 0 || data == NULL)
+    {
+        Com_Printf("Can't load %s\n", map_name);
+        return 0;
+    }
+
+    const dheader_t * header = (const dheader_t *)data;
+    const lump_t * lump = &header->lumps[LUMP_TEXINFO];
+    const textureinfo_t * texinfo = (const textureinfo_t *)(data + LittleLong(lump->fileofs));
+    const int count = LittleLong(lump->filelen) / sizeof(textureinfo_t);
+
+    for (i = 0; i < count && num_names < TEXBENCH_MAX_NAMES; ++i)
+    {
+        Com_sprintf(name, sizeof(name), "textures/%s.wal", texinfo[i].texture);
+        for (j = 0; j < num_names; ++j)
+        {
+            if (strcmp(texbench_names[j], name) == 0)
+            {
+                break;
+            }
+        }
+        if (j == num_names)
+        {
+            strcpy(texbench_names[num_names++], name);
+        }
+    }
+
+    FS_FreeFile(data);
+    return num_names;
+}
+
+// The lookup FindImageImpl did before the name index, plus the name compare.
+static ps2_teximage_t * TexBench_LinearFind(const char * name, int flags)
+{
+    int i;
+    const u32 name_hash = Sys_HashString(name);
+    ps2_teximage_t * teximage_iter = ps2ref.teximages;
+
+    for (i = 0; i < MAX_TEXIMAGES; ++i, ++teximage_iter)
+    {
+        if (teximage_iter->type == IT_NULL)
+        {
+            continue;
+        }
+        if ((name_hash == teximage_iter->hash) && (flags & teximage_iter->type) &&
+            strcmp(teximage_iter->name, name) == 0)
+        {
+            return teximage_iter;
+        }
+    }
+    return NULL;
+}
+
+void Test_PS2_TexCache(void)
+{
+    int i, run;
+    int num_names;
+    int num_failed;
+    int hashed_mismatches;
+    int linear_mismatches;
+    unsigned int start;
+    unsigned int load_usec;
+    unsigned int hashed_usec;
+    unsigned int linear_usec;
+    char skip_walls[16];
+
+    Com_Printf("====== QPS2 - Test_PS2_TexCache ======\n");
+
+    num_names = TexBench_GatherNames("maps/base1.bsp");
+    if (num_names == 0)
+    {
+        return;
+    }
+
+    // Walls are skipped by default during development.
+    strncpy(skip_walls, Cvar_VariableString("r_ps2_skip_wall_tex_load"), sizeof(skip_walls) - 1);
+    skip_walls[sizeof(skip_walls) - 1] = '\0';
+    Cvar_Set("r_ps2_skip_wall_tex_load", "0");
+
+    // First time, loads the images:
+    num_failed = 0;
+    start = Sys_Microseconds();
+    for (i = 0; i < num_names; ++i)
+    {
+        texbench_images[i] = PS2_TexImageFindOrLoad(texbench_names[i], IT_WALL);
+    }
+    load_usec = Sys_Microseconds() - start;
+
+    for (i = 0; i < num_names; ++i)
+    {
+        if (texbench_images[i] == NULL || texbench_images[i] == ps2_builtin_tex_debug)
+        {
+            Com_Printf("Failed to load %s\n", texbench_names[i]);
+            ++num_failed;
+        }
+    }
+
+    // Then only cache hits:
+    hashed_mismatches = 0;
+    start = Sys_Microseconds();
+    for (run = 0; run < TEXBENCH_RUNS; ++run)
+    {
+        for (i = 0; i < num_names; ++i)
+        {
+            if (PS2_TexImageFindOrLoad(texbench_names[i], IT_WALL) != texbench_images[i])
+            {
+                ++hashed_mismatches;
+            }
+        }
+    }
+    hashed_usec = Sys_Microseconds() - start;
+
+    linear_mismatches = 0;
+    start = Sys_Microseconds();
+    for (run = 0; run < TEXBENCH_RUNS; ++run)
+    {
+        for (i = 0; i < num_names; ++i)
+        {
+            if (TexBench_LinearFind(texbench_names[i], IT_WALL) != texbench_images[i])
+            {
+                ++linear_mismatches;
+            }
+        }
+    }
+    linear_usec = Sys_Microseconds() - start;
+
+    Cvar_Set("r_ps2_skip_wall_tex_load", skip_walls);
+
+    Com_Printf("%d textures, %d failed, loaded in %.3f ms\n", num_names, num_failed, load_usec / 1000.0);
+    Com_Printf("hashed: %8.3f us/lookup, %d mismatches\n",
+               (float)hashed_usec / (TEXBENCH_RUNS * num_names), hashed_mismatches);
+    Com_Printf("linear: %8.3f us/lookup, %d mismatches\n",
+               (float)linear_usec / (TEXBENCH_RUNS * num_names), linear_mismatches);
+}
@@ -0,0 +1,210 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: test_tex_mipmap.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Checks for the mipmap VRam layout (see ps2/tex_mipmap.c).
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/q_common.h"
+#include "ps2/ref_ps2.h"
+
+// Functions exported from this file:
+void Test_PS2_TexMipmap(void);
+
+//=============================================================================
+//
+// Test_PS2_TexMipmap -- Lays out the mipmaps of every power-of-two size from
+// 8 to 256 in each of the texture formats, then walks every texel of every
+// level through the GS addressing (pages, then the block arrangement tables
+// from the GS manual) checking that no two texels land on the same spot and
+// that all of them are inside the pages given. Also prints the VRam pages
+// taken by some square sizes with and without the extra levels.
+//
+// Doesn't need the GS, so it also runs on the host as 'texmip_test'.
+//
+//=============================================================================
+
+enum
+{
+    TEXMIP_MAX_PAGES   = 64,
+    TEXMIP_PAGE_BLOCKS = 32,
+    TEXMIP_BLOCK_BYTES = 256
+};
+
+// Block arrangement inside a page, [row][column], from the GS manual.
+static const byte texmip_blocks_32[4][8] =
+{
+    { 0,  1,  4,  5,  16, 17, 20, 21 },
+    { 2,  3,  6,  7,  18, 19, 22, 23 },
+    { 8,  9,  12, 13, 24, 25, 28, 29 },
+    { 10, 11, 14, 15, 26, 27, 30, 31 }
+};
+static const byte texmip_blocks_16[8][4] =
+{
+    { 0,  2,  8,  10 },
+    { 1,  3,  9,  11 },
+    { 4,  6,  12, 14 },
+    { 5,  7,  13, 15 },
+    { 16, 18, 24, 26 },
+    { 17, 19, 25, 27 },
+    { 20, 22, 28, 30 },
+    { 21, 23, 29, 31 }
+};
+
+typedef struct
+{
+    int bits_per_pixel;
+    int page_w, page_h;
+    int block_w, block_h;
+} texmip_format_t;
+
+static const texmip_format_t texmip_formats[] =
+{
+    { 32, 64,  32, 8,  8  }, // PSMCT32
+    { 16, 64,  64, 16, 8  }, // PSMCT16
+    { 8,  128, 64, 16, 16 }  // PSMT8 (same block arrangement as PSMCT32)
+};
+
+// Owner level + 1 of each texel in the pages, by block and texel in the block.
+static byte texmip_owner[TEXMIP_MAX_PAGES * TEXMIP_PAGE_BLOCKS * TEXMIP_BLOCK_BYTES];
+
+static int TexMip_BlockNumber(const texmip_format_t * f, int bx, int by)
+{
+    return (f->bits_per_pixel == 16) ? texmip_blocks_16[by][bx] : texmip_blocks_32[by][bx];
+}
+
+static int TexMip_CheckLayout(const texmip_format_t * f, int width, int height)
+{
+    int level, x, y;
+    int errors = 0;
+    ps2_mip_layout_t mips;
+
+    const int num_levels = Img_NumMipLevels(width, height, PS2_MAX_MIP_LEVELS);
+    Img_MipLayout(width, height, f->bits_per_pixel, num_levels, &mips);
+
+    if (mips.num_pages > TEXMIP_MAX_PAGES)
+    {
+        Com_Printf("%dbpp %dx%d: %d pages, more than the test handles\n",
+                   f->bits_per_pixel, width, height, mips.num_pages);
+        return 1;
+    }
+    if (mips.offset[0] != 0)
+    {
+        Com_Printf("%dbpp %dx%d: level 0 not at the start\n", f->bits_per_pixel, width, height);
+        ++errors;
+    }
+
+    memset(texmip_owner, 0, sizeof(texmip_owner));
+    for (level = 0; level < mips.num_levels; ++level)
+    {
+        const int w = width  >> level;
+        const int h = height >> level;
+        const int buffer_w = mips.buffer_width[level];
+        const int base_block = mips.offset[level] / PS2_VRAM_BLOCK_WORDS;
+
+        if ((mips.offset[level] % PS2_VRAM_BLOCK_WORDS) != 0 || (buffer_w % 64) != 0 ||
+            (f->bits_per_pixel == 8 && (buffer_w % 128) != 0) || buffer_w < w)
+        {
+            Com_Printf("%dbpp %dx%d level %d: bad TBP/TBW\n", f->bits_per_pixel, width, height, level);
+            ++errors;
+            continue;
+        }
+
+        for (y = 0; y < h; ++y)
+        {
+            for (x = 0; x < w; ++x)
+            {
+                const int page  = (x / f->page_w) + (y / f->page_h) * (buffer_w / f->page_w);
+                const int block = TexMip_BlockNumber(f, (x % f->page_w) / f->block_w, (y % f->page_h) / f->block_h);
+                const int texel = (y % f->block_h) * f->block_w + (x % f->block_w);
+                const int where = base_block + page * TEXMIP_PAGE_BLOCKS + block;
+
+                if (where >= mips.num_pages * TEXMIP_PAGE_BLOCKS)
+                {
+                    ++errors;
+                    continue;
+                }
+
+                byte * owner = &texmip_owner[where * TEXMIP_BLOCK_BYTES + texel];
+                if (*owner != 0)
+                {
+                    ++errors;
+                }
+                *owner = (byte)(level + 1);
+            }
+        }
+    }
+
+    if (errors != 0)
+    {
+        Com_Printf("%dbpp %dx%d: %d texels overlap or out of range\n",
+                   f->bits_per_pixel, width, height, errors);
+    }
+    return errors;
+}
+
+static int TexMip_CheckSizes(void)
+{
+    int errors = 0;
+
+    // Levels stop when either side would go under 8.
+    errors += Img_NumMipLevels(64,  64,  PS2_MAX_MIP_LEVELS) != 4;
+    errors += Img_NumMipLevels(16,  16,  PS2_MAX_MIP_LEVELS) != 2;
+    errors += Img_NumMipLevels(256, 16,  PS2_MAX_MIP_LEVELS) != 2;
+    errors += Img_NumMipLevels(8,   128, PS2_MAX_MIP_LEVELS) != 1;
+    errors += Img_NumMipLevels(128, 128, 1) != 1;
+
+    // Same sizes as a WAL file.
+    errors += Img_MipChainBytes(64, 64, 4, 1) != (64 * 64 + 32 * 32 + 16 * 16 + 8 * 8);
+    errors += Img_MipChainBytes(64, 32, 1, 4) != (64 * 32 * 4);
+
+    Com_Printf("%-20s %s\n", "level sizes", (errors == 0) ? "ok" : "FAILED");
+    return errors;
+}
+
+void Test_PS2_TexMipmap(void)
+{
+    int i, w, h;
+    int errors;
+    ps2_mip_layout_t single, mips;
+
+    Com_Printf("====== QPS2 - Test_PS2_TexMipmap ======\n");
+
+    errors = TexMip_CheckSizes();
+
+    for (i = 0; i < (int)(sizeof(texmip_formats) / sizeof(texmip_formats[0])); ++i)
+    {
+        const int errors_before = errors;
+        for (w = 8; w <= MAX_TEXIMAGE_SIZE; w *= 2)
+        {
+            for (h = 8; h <= MAX_TEXIMAGE_SIZE; h *= 2)
+            {
+                errors += TexMip_CheckLayout(&texmip_formats[i], w, h);
+            }
+        }
+        Com_Printf("%-20s %s\n", va("%dbpp layouts", texmip_formats[i].bits_per_pixel),
+                   (errors == errors_before) ? "ok" : "FAILED");
+    }
+
+    Com_Printf("%d errors\n", errors);
+
+    // What the extra levels cost in VRam.
+    Com_Printf("%-10s %6s %6s %6s\n", "size", "32bpp", "16bpp", "8bpp");
+    for (w = 32; w <= MAX_TEXIMAGE_SIZE; w *= 2)
+    {
+        char columns[3][16];
+        for (i = 0; i < 3; ++i)
+        {
+            const int bits = texmip_formats[i].bits_per_pixel;
+            Img_MipLayout(w, w, bits, 1, &single);
+            Img_MipLayout(w, w, bits, Img_NumMipLevels(w, w, PS2_MAX_MIP_LEVELS), &mips);
+            Com_sprintf(columns[i], sizeof(columns[i]), "%d/%d", single.num_pages, mips.num_pages);
+        }
+        Com_Printf("%-10s %6s %6s %6s\n", va("%dx%d", w, w), columns[0], columns[1], columns[2]);
+    }
+    Com_Printf("(VRam pages without/with mipmaps)\n");
+}
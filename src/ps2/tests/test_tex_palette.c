@@ -0,0 +1,264 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: test_tex_palette.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Checks for the 8bits palettized texture path (see ps2/tex_palette.c).
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/q_common.h"
+#include "common/q_files.h"
+#include "ps2/ref_ps2.h"
+#include "ps2/mem_alloc.h"
+
+// Functions exported from this file:
+void Test_PS2_TexPalette(void);
+
+//=============================================================================
+//
+// Test_PS2_TexPalette -- Checks the CSM1 CLUT swizzling against the GS index
+// lookup, that images stored as GS_PSM_8 decode to the same colors as the
+// palette, and the format picked for opaque, transparent, non power-of-two
+// and oversized images. Then stores the base1 wall textures the old way
+// (16/32bits), as indexes, and as indexes plus their mipmaps, allocating
+// from MEMTAG_TEXIMAGE like the loader, and prints the tag totals that
+// PS2_DrawMemTags would show for each.
+//
+// Doesn't need the GS, so it also runs on the host as 'texpal_test'.
+//
+//=============================================================================
+
+enum
+{
+    TEXPAL_MAX_WALLS = 512
+};
+
+typedef struct
+{
+    const char * name;
+    int width;
+    int height;
+    int hole; // Pixel set to the transparent index, or -1.
+    qboolean nearest_filter;
+    img_8bit_format_t expected_with_clut;
+    img_8bit_format_t expected_without_clut;
+} texpal_case_t;
+
+static const texpal_case_t texpal_cases[] =
+{
+    { "opaque 64x64",        64,  64,  -1, false, IMG_8BIT_INDEXED8, IMG_8BIT_RGB16  },
+    { "opaque 16x128",       16,  128, -1, false, IMG_8BIT_INDEXED8, IMG_8BIT_RGB16  },
+    { "hole, linear 64x64",  64,  64,  77, false, IMG_8BIT_RGBA32,   IMG_8BIT_RGBA32 },
+    { "hole, nearest 32x32", 32,  32,  0,  true,  IMG_8BIT_INDEXED8, IMG_8BIT_RGBA32 },
+    { "non-PoT 100x50",      100, 50,  -1, true,  IMG_8BIT_RGBA32,   IMG_8BIT_RGBA32 },
+    { "oversized 512x64",    512, 64,  -1, false, IMG_8BIT_RGBA32,   IMG_8BIT_RGBA32 }
+};
+
+static byte texpal_pixels[512 * 64];
+
+// Where the GS fetches index 'i' from in a CSM1 CLUT (bits 3 and 4 swapped).
+static int TexPal_Csm1Index(int i)
+{
+    return (i & ~0x18) | ((i & 0x08) << 1) | ((i & 0x10) >> 1);
+}
+
+static int TexPal_CheckClut(void)
+{
+    int i;
+    int errors = 0;
+    u32 clut[256];
+    u32 unswizzled[256];
+
+    Img_SwizzleClut32(ps2_global_palette, clut);
+    Img_SwizzleClut32(clut, unswizzled);
+
+    for (i = 0; i < 256; ++i)
+    {
+        if (clut[TexPal_Csm1Index(i)] != ps2_global_palette[i])
+        {
+            Com_Printf("CLUT entry %d: 0x%08X, expected 0x%08X\n", i,
+                       clut[TexPal_Csm1Index(i)], ps2_global_palette[i]);
+            ++errors;
+        }
+        if (unswizzled[i] != ps2_global_palette[i])
+        {
+            Com_Printf("CLUT entry %d doesn't swizzle back\n", i);
+            ++errors;
+        }
+    }
+
+    // The transparent index must have zero alpha, everything else opaque.
+    for (i = 0; i < 256; ++i)
+    {
+        const u32 alpha = ps2_global_palette[i] >> 24;
+        if ((i == 255) ? (alpha != 0) : (alpha == 0))
+        {
+            Com_Printf("Palette entry %d has alpha 0x%02X\n", i, alpha);
+            ++errors;
+        }
+    }
+
+    return errors;
+}
+
+static int TexPal_CheckCase(const texpal_case_t * c)
+{
+    int i;
+    int errors = 0;
+    u32 clut[256];
+    const int pixel_count = c->width * c->height;
+
+    for (i = 0; i < pixel_count; ++i)
+    {
+        texpal_pixels[i] = (byte)((i * 7 + i / c->width) % 255); // Never 255.
+    }
+    if (c->hole >= 0)
+    {
+        texpal_pixels[c->hole] = 255;
+    }
+
+    const img_8bit_format_t with_clut    = Img_Choose8BitFormat(texpal_pixels, c->width, c->height, true,  c->nearest_filter);
+    const img_8bit_format_t without_clut = Img_Choose8BitFormat(texpal_pixels, c->width, c->height, false, c->nearest_filter);
+
+    if (with_clut != c->expected_with_clut || without_clut != c->expected_without_clut)
+    {
+        Com_Printf("%s: formats %d/%d, expected %d/%d\n", c->name, with_clut,
+                   without_clut, c->expected_with_clut, c->expected_without_clut);
+        ++errors;
+    }
+
+    // Decode the indexes like the GS would and compare with the palette.
+    if (with_clut == IMG_8BIT_INDEXED8)
+    {
+        Img_SwizzleClut32(ps2_global_palette, clut);
+        for (i = 0; i < pixel_count; ++i)
+        {
+            if (clut[TexPal_Csm1Index(texpal_pixels[i])] != ps2_global_palette[texpal_pixels[i]])
+            {
+                ++errors;
+            }
+        }
+    }
+
+    Com_Printf("%-20s %s\n", c->name, (errors == 0) ? "ok" : "FAILED");
+    return errors;
+}
+
+// Stores every "textures/*.wal" referenced by the map like Common8BitTexSetup
+// would, with and without the CLUT and mipmaps, and prints the MEMTAG_TEXIMAGE totals.
+static void TexPal_MemReport(const char * map_name)
+{
+    int i, j, pass;
+    int num_walls = 0;
+    byte * data = NULL;
+    char name[MAX_QPATH];
+    static char wall_names[TEXPAL_MAX_WALLS][MAX_QPATH];
+    static void * wall_pics[TEXPAL_MAX_WALLS];
+    static int wall_sizes[TEXPAL_MAX_WALLS];
+
+    if (FS_LoadFile(map_name, (void **)&data) <= 0 || data == NULL)
+    {
+        Com_Printf("Can't load %s, skipping the memory report\n", map_name);
+        return;
+    }
+
+    const dheader_t * header = (const dheader_t *)data;
+    const lump_t * lump = &header->lumps[LUMP_TEXINFO];
+    const textureinfo_t * texinfo = (const textureinfo_t *)(data + LittleLong(lump->fileofs));
+    const int count = LittleLong(lump->filelen) / sizeof(textureinfo_t);
+
+    for (i = 0; i < count && num_walls < TEXPAL_MAX_WALLS; ++i)
+    {
+        Com_sprintf(name, sizeof(name), "textures/%s.wal", texinfo[i].texture);
+        for (j = 0; j < num_walls; ++j)
+        {
+            if (strcmp(wall_names[j], name) == 0)
+            {
+                break;
+            }
+        }
+        if (j == num_walls)
+        {
+            strcpy(wall_names[num_walls++], name);
+        }
+    }
+    FS_FreeFile(data);
+
+    // The pics are also what gets DMAed to the GS on each texture change.
+    Com_Printf("%-10s %10s %7s\n", "pass", "TEXIMAGE", "walls");
+    static const char * const pass_names[] = { "16/32bits", "8bits", "8bits+mips" };
+    for (pass = 0; pass < 3; ++pass)
+    {
+        int loaded = 0;
+        const unsigned int tag_before = ps2_mem_tag_counts[MEMTAG_TEXIMAGE].total_bytes;
+
+        for (i = 0; i < num_walls; ++i)
+        {
+            const miptex_t * wall = NULL;
+            wall_pics[i] = NULL;
+
+            if (FS_LoadFile(wall_names[i], (void **)&wall) <= 0 || wall == NULL)
+            {
+                continue;
+            }
+
+            const int width  = LittleLong(wall->width);
+            const int height = LittleLong(wall->height);
+            const byte * pic8 = (const byte *)wall + LittleLong(wall->offsets[0]);
+
+            const img_8bit_format_t format = Img_Choose8BitFormat(pic8, width, height, (qboolean)(pass != 0), false);
+            const int bytes_per_pixel = Img_8BitFormatBytes(format);
+
+            // Resampled images end up at the size limit at most, and lose the mipmaps.
+            if (format == IMG_8BIT_RGBA32 && (width > MAX_TEXIMAGE_SIZE || height > MAX_TEXIMAGE_SIZE))
+            {
+                wall_sizes[i] = MAX_TEXIMAGE_SIZE * MAX_TEXIMAGE_SIZE * bytes_per_pixel;
+            }
+            else
+            {
+                const int levels = (pass == 2) ? Img_NumMipLevels(width, height, PS2_MAX_MIP_LEVELS) : 1;
+                wall_sizes[i] = Img_MipChainBytes(width, height, levels, bytes_per_pixel);
+            }
+
+            wall_pics[i]  = PS2_MemAlloc(wall_sizes[i], MEMTAG_TEXIMAGE);
+
+            FS_FreeFile((void *)wall);
+            ++loaded;
+        }
+
+        const unsigned int tag_total = ps2_mem_tag_counts[MEMTAG_TEXIMAGE].total_bytes - tag_before;
+        Com_Printf("%-10s %10s %7d\n", pass_names[pass],
+                   PS2_FormatMemoryUnit(tag_total, true), loaded);
+
+        for (i = 0; i < num_walls; ++i)
+        {
+            if (wall_pics[i] != NULL)
+            {
+                PS2_MemFree(wall_pics[i], wall_sizes[i], MEMTAG_TEXIMAGE);
+            }
+        }
+    }
+}
+
+void Test_PS2_TexPalette(void)
+{
+    int i;
+    int errors;
+
+    Com_Printf("====== QPS2 - Test_PS2_TexPalette ======\n");
+
+    errors = TexPal_CheckClut();
+    Com_Printf("%-20s %s\n", "CSM1 CLUT", (errors == 0) ? "ok" : "FAILED");
+
+    for (i = 0; i < (int)(sizeof(texpal_cases) / sizeof(texpal_cases[0])); ++i)
+    {
+        errors += TexPal_CheckCase(&texpal_cases[i]);
+    }
+
+    Com_Printf("%d errors\n", errors);
+
+    TexPal_MemReport("maps/base1.bsp");
+}
@@ -0,0 +1,238 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: test_tex_vram.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Checks for the VRam texture cache (see ps2/tex_vram.c).
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/q_common.h"
+#include "ps2/ref_ps2.h"
+
+// Functions exported from this file:
+void Test_PS2_TexVRam(void);
+
+//=============================================================================
+//
+// Test_PS2_TexVRam -- Runs the VRam texture cache over a small pool, checking
+// hits, LRU eviction order and releases, then a long random sequence of binds
+// checked against a model of what VRam should hold, then a frame with more
+// textures than the old single slot could keep, drawn twice, to check that
+// each texture is only uploaded once. Re-initializes the cache to do so, so
+// on the PS2 it is meant to be run as ps2_prog 10, not during a game.
+//
+// Doesn't need the GS, so it also runs on the host as 'texvram_test'.
+//
+//=============================================================================
+
+enum
+{
+    TEXVRAM_POOL_START = 0x10000,
+    TEXVRAM_POOL_PAGES = 16,
+    TEXVRAM_NUM_PICS   = 40,
+    TEXVRAM_RANDOM_OPS = 20000
+};
+
+// What the test expects to be in VRam for each of the fake images.
+typedef struct
+{
+    qboolean resident;
+    u32 address;
+    int num_pages;
+} texvram_model_t;
+
+static byte texvram_pics[TEXVRAM_NUM_PICS]; // Only the addresses are used.
+static texvram_model_t texvram_model[TEXVRAM_NUM_PICS];
+static int texvram_errors = 0;
+
+#define TEXVRAM_CHECK(expr)                                              \
+    do                                                                   \
+    {                                                                    \
+        if (!(expr))                                                     \
+        {                                                                \
+            Com_Printf("%s(%d): check failed: %s\n", __func__, __LINE__, #expr); \
+            ++texvram_errors;                                            \
+        }                                                                \
+    } while (0)
+
+static u32 TexVRam_PageAddress(int page)
+{
+    return TEXVRAM_POOL_START + page * PS2_VRAM_PAGE_WORDS;
+}
+
+// Acquire plus bookkeeping in the model. Returns true for a hit.
+static qboolean TexVRam_Bind(int pic, int num_pages)
+{
+    int i;
+    u32 address = 0;
+    texvram_model_t * m = &texvram_model[pic];
+
+    const qboolean hit = PS2_TexVRamAcquire(&texvram_pics[pic], num_pages,
+                                            num_pages * PS2_VRAM_PAGE_WORDS * 4, &address);
+
+    TEXVRAM_CHECK(address >= TEXVRAM_POOL_START);
+    TEXVRAM_CHECK(address + num_pages * PS2_VRAM_PAGE_WORDS <= TexVRam_PageAddress(TEXVRAM_POOL_PAGES));
+
+    if (hit)
+    {
+        // Must still be where it was uploaded, and nothing uploaded on top of it since.
+        TEXVRAM_CHECK(m->resident);
+        TEXVRAM_CHECK(m->address == address);
+        TEXVRAM_CHECK(m->num_pages == num_pages);
+        return true;
+    }
+
+    // Anything the new upload overlaps is gone.
+    for (i = 0; i < TEXVRAM_NUM_PICS; ++i)
+    {
+        texvram_model_t * other = &texvram_model[i];
+        if (other->resident &&
+            other->address < address + num_pages * PS2_VRAM_PAGE_WORDS &&
+            address < other->address + other->num_pages * PS2_VRAM_PAGE_WORDS)
+        {
+            other->resident = false;
+        }
+    }
+
+    m->resident  = true;
+    m->address   = address;
+    m->num_pages = num_pages;
+    return false;
+}
+
+static void TexVRam_Reset(void)
+{
+    PS2_TexVRamInit(TEXVRAM_POOL_START, TEXVRAM_POOL_PAGES);
+    memset(texvram_model, 0, sizeof(texvram_model));
+}
+
+static void TexVRam_TestLRU(void)
+{
+    ps2_tex_vram_stats_t stats;
+
+    TexVRam_Reset();
+    PS2_TexVRamBeginFrame();
+
+    // Fill the pool: 0 and 1 with 4 pages each, 2 with 8.
+    TEXVRAM_CHECK(!TexVRam_Bind(0, 4));
+    TEXVRAM_CHECK(!TexVRam_Bind(1, 4));
+    TEXVRAM_CHECK(!TexVRam_Bind(2, 8));
+    TEXVRAM_CHECK(TexVRam_Bind(0, 4));
+
+    // Next frame, 1 is the least recently used, so 3 takes its place.
+    PS2_TexVRamBeginFrame();
+    TEXVRAM_CHECK(TexVRam_Bind(0, 4));
+    TEXVRAM_CHECK(TexVRam_Bind(2, 8));
+    TEXVRAM_CHECK(!TexVRam_Bind(3, 4));
+    TEXVRAM_CHECK(texvram_model[3].address == TexVRam_PageAddress(4));
+    TEXVRAM_CHECK(!texvram_model[1].resident);
+
+    PS2_TexVRamGetStats(&stats);
+    TEXVRAM_CHECK(stats.hits == 1 && stats.misses == 3 && stats.evictions == 0);
+    TEXVRAM_CHECK(stats.pages_used == 16 && stats.pages_total == TEXVRAM_POOL_PAGES);
+
+    // Releasing makes the next bind an upload.
+    PS2_TexVRamRelease(&texvram_pics[0]);
+    texvram_model[0].resident = false;
+    TEXVRAM_CHECK(!TexVRam_Bind(0, 4));
+    TEXVRAM_CHECK(texvram_model[0].address == TexVRam_PageAddress(0));
+
+    // Same pixels with a new size are uploaded again.
+    TEXVRAM_CHECK(!TexVRam_Bind(0, 2));
+
+    // The whole pool for one image evicts everything else.
+    PS2_TexVRamBeginFrame();
+    TEXVRAM_CHECK(!TexVRam_Bind(4, TEXVRAM_POOL_PAGES));
+    PS2_TexVRamBeginFrame();
+    PS2_TexVRamGetStats(&stats);
+    TEXVRAM_CHECK(stats.evictions == 3 && stats.pages_used == TEXVRAM_POOL_PAGES);
+
+    Com_Printf("%-20s %s\n", "LRU order", (texvram_errors == 0) ? "ok" : "FAILED");
+}
+
+static void TexVRam_TestRandom(void)
+{
+    int i;
+    int hits = 0;
+    const int errors_before = texvram_errors;
+
+    TexVRam_Reset();
+    srand(1234);
+
+    // Each fake image keeps its size, like a real texture would.
+    int sizes[TEXVRAM_NUM_PICS];
+    for (i = 0; i < TEXVRAM_NUM_PICS; ++i)
+    {
+        sizes[i] = 1 + rand() % 6;
+    }
+
+    for (i = 0; i < TEXVRAM_RANDOM_OPS; ++i)
+    {
+        if ((i % 50) == 0)
+        {
+            PS2_TexVRamBeginFrame();
+        }
+
+        // Favor a few images, like the console font and the HUD.
+        const int pic = ((rand() % 4) == 0) ? (rand() % TEXVRAM_NUM_PICS) : (rand() % 6);
+        if ((rand() % 100) == 0)
+        {
+            PS2_TexVRamRelease(&texvram_pics[pic]);
+            texvram_model[pic].resident = false;
+            continue;
+        }
+        hits += TexVRam_Bind(pic, sizes[pic]);
+    }
+
+    Com_Printf("%-20s %s, %d%% hits\n", "random binds",
+               (texvram_errors == errors_before) ? "ok" : "FAILED",
+               hits * 100 / TEXVRAM_RANDOM_OPS);
+}
+
+static void TexVRam_TestFrame(void)
+{
+    int i, pass;
+    ps2_tex_vram_stats_t stats;
+    const int errors_before = texvram_errors;
+
+    TexVRam_Reset();
+
+    // 8 images of 2 pages: all fit at once, so the second
+    // pass over them in the same frame is all hits.
+    PS2_TexVRamBeginFrame();
+    for (pass = 0; pass < 2; ++pass)
+    {
+        for (i = 0; i < 8; ++i)
+        {
+            TEXVRAM_CHECK(TexVRam_Bind(i, 2) == (pass == 1));
+        }
+    }
+
+    PS2_TexVRamBeginFrame();
+    PS2_TexVRamGetStats(&stats);
+    TEXVRAM_CHECK(stats.misses == 8 && stats.hits == 8);
+    TEXVRAM_CHECK(stats.upload_bytes == 8 * 2 * PS2_VRAM_PAGE_WORDS * 4);
+
+    // And the next frame doesn't upload anything.
+    for (i = 0; i < 8; ++i)
+    {
+        TEXVRAM_CHECK(TexVRam_Bind(i, 2));
+    }
+
+    Com_Printf("%-20s %s\n", "one upload/frame", (texvram_errors == errors_before) ? "ok" : "FAILED");
+}
+
+void Test_PS2_TexVRam(void)
+{
+    Com_Printf("====== QPS2 - Test_PS2_TexVRam ======\n");
+
+    texvram_errors = 0;
+    TexVRam_TestLRU();
+    TexVRam_TestRandom();
+    TexVRam_TestFrame();
+
+    Com_Printf("%d errors\n", texvram_errors);
+}
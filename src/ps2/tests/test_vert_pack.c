@@ -0,0 +1,429 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: test_vert_pack.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Round-trip checks for the packed VU1 vertex formats (see ps2/vert_pack.c).
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/q_common.h"
+#include "ps2/ref_ps2.h"
+
+// Functions exported from this file:
+void Test_PS2_VertPack(void);
+
+//=============================================================================
+//
+// Test_PS2_VertPack -- Encodes colors, positions and texture coordinates and
+// decodes them back, checking the error is inside what each format allows.
+// Then writes whole batches with Vert_PackBatch and runs the words through a
+// small model of the VIF (STCYCL, the double buffer, ITOP and the UNPACK formats
+// we use) into a fake VU memory, and expands that the way VU1Prog_Color_Triangles_Packed
+// does. Consecutive batches must land in alternate halves of the double buffer.
+// Also prints the DMA size of a few batch sizes, packed and as V4_32.
+//
+// Doesn't need the VU, so it also runs on the host as 'vertpack_test'.
+//
+//=============================================================================
+
+enum
+{
+    VERTPACK_RANDOM_BATCHES = 2000,
+    VERTPACK_VU_MEM_QWORDS  = 1024
+};
+
+static int vertpack_errors = 0;
+static u32 vertpack_vu_mem[VERTPACK_VU_MEM_QWORDS][4];
+
+// What the VU program got from each MSCAL: XTOP and XITOP.
+static int vertpack_vu_tops[2];
+static int vertpack_vu_itops[2];
+
+#define VERTPACK_CHECK(expr)                                             \
+    do                                                                   \
+    {                                                                    \
+        if (!(expr))                                                     \
+        {                                                                \
+            Com_Printf("%s(%d): check failed: %s\n", __func__, __LINE__, #expr); \
+            ++vertpack_errors;                                           \
+        }                                                                \
+    } while (0)
+
+static float VertPack_Random(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+static float VertPack_AsFloat(u32 bits)
+{
+    FU32_t i2f;
+    i2f.asU32 = bits;
+    return i2f.asFloat;
+}
+
+static void VertPack_TestColors(void)
+{
+    int i;
+    const int errors_before = vertpack_errors;
+
+    for (i = 0; i < 1024; ++i)
+    {
+        byte in[4], out[4];
+        in[0] = (byte)rand(); in[1] = (byte)rand();
+        in[2] = (byte)rand(); in[3] = (byte)i;
+
+        Vert_UnpackColor(Vert_PackColor(in), out);
+        VERTPACK_CHECK(memcmp(in, out, 4) == 0);
+    }
+
+    Com_Printf("%-20s %s\n", "colors", (vertpack_errors == errors_before) ? "ok" : "FAILED");
+}
+
+static void VertPack_TestPositions(void)
+{
+    int b, i, j;
+    float worst_error = 0.0f;
+    const int errors_before = vertpack_errors;
+    static const float extents[] = { 16.0f, 256.0f, 2048.0f, 4000.0f, 8192.0f, 60000.0f };
+
+    for (b = 0; b < VERTPACK_RANDOM_BATCHES; ++b)
+    {
+        float positions[PS2_VU_PACKED_MAX_VERTS * 3];
+        ps2_vert_pos_frame_t frame;
+
+        const int num_verts = 3 + rand() % (PS2_VU_PACKED_MAX_VERTS - 2);
+        const float extent = extents[b % (sizeof(extents) / sizeof(extents[0]))];
+        const qboolean whole = (b & 1);
+        const float center = VertPack_Random(-4096.0f, 4096.0f);
+
+        for (i = 0; i < num_verts * 3; ++i)
+        {
+            positions[i] = center + VertPack_Random(-extent * 0.5f, extent * 0.5f);
+            if (whole)
+            {
+                positions[i] = floorf(positions[i]);
+            }
+        }
+
+        Vert_PosFrameFromPoints(positions, num_verts, &frame);
+        VERTPACK_CHECK(frame.step >= 1.0f / PS2_VERT_POS_MIN_STEP_INV);
+
+        for (i = 0; i < num_verts; ++i)
+        {
+            s16 packed[3];
+            vec3_t out;
+
+            Vert_PackPosition(&frame, &positions[i * 3], packed);
+            Vert_UnpackPosition(&frame, packed, out);
+
+            for (j = 0; j < 3; ++j)
+            {
+                const float error = fabsf(out[j] - positions[i * 3 + j]);
+                if (error > worst_error)
+                {
+                    worst_error = error;
+                }
+
+                // Half a step of rounding, plus what float has at these magnitudes.
+                VERTPACK_CHECK(error <= frame.step * 0.5f + fabsf(positions[i * 3 + j]) * 1e-6f);
+
+                // Whole numbers in a batch under 4096 units across come back exact.
+                if (whole && extent < 4096.0f)
+                {
+                    VERTPACK_CHECK(out[j] == positions[i * 3 + j]);
+                }
+            }
+        }
+    }
+
+    Com_Printf("%-20s %s, worst error %.4f\n", "positions",
+               (vertpack_errors == errors_before) ? "ok" : "FAILED", worst_error);
+}
+
+static void VertPack_TestTexCoords(void)
+{
+    int i;
+    const float max_error = 0.5f / (1 << PS2_VERT_ST_FRAC_BITS);
+    const int errors_before = vertpack_errors;
+
+    for (i = 0; i < 4096; ++i)
+    {
+        float st[2], base[2], out[2];
+        s16 packed[2];
+
+        base[0] = floorf(VertPack_Random(-64.0f, 64.0f));
+        base[1] = floorf(VertPack_Random(-64.0f, 64.0f));
+        st[0]   = base[0] + VertPack_Random(0.0f, 7.99f);
+        st[1]   = base[1] + VertPack_Random(0.0f, 7.99f);
+
+        Vert_PackTexCoords(st, base, packed);
+        Vert_UnpackTexCoords(packed, base, out);
+
+        VERTPACK_CHECK(fabsf(out[0] - st[0]) <= max_error + 1e-5f);
+        VERTPACK_CHECK(fabsf(out[1] - st[1]) <= max_error + 1e-5f);
+    }
+
+    Com_Printf("%-20s %s\n", "texture coords", (vertpack_errors == errors_before) ? "ok" : "FAILED");
+}
+
+// Model of the VIF: runs the codes Vert_PackBatch writes into vertpack_vu_mem.
+// Returns the last MSCAL address, or -1 if the stream had something unexpected.
+static int VertPack_RunVIF(const u32 * words, int num_words)
+{
+    int cl = 1, wl = 1;
+    int mscal = -1, num_mscals = 0;
+    int base = 0, offset = 0, dbf = 0, itops = 0;
+    const u32 * p = words;
+    const u32 * end = words + num_words;
+
+    while (p < end)
+    {
+        const u32 code = *p++;
+        const int cmd  = code >> 24;
+
+        if (cmd == 0x11) // FLUSH
+        {
+            continue;
+        }
+        if (cmd == 0x01) // STCYCL
+        {
+            cl = code & 0xFF;
+            wl = (code >> 8) & 0xFF;
+            continue;
+        }
+        if (cmd == 0x03) // BASE
+        {
+            base = code & 0x3FF;
+            continue;
+        }
+        if (cmd == 0x02) // OFFSET, also resets to the first half
+        {
+            offset = code & 0x3FF;
+            dbf = 0;
+            continue;
+        }
+        if (cmd == 0x04) // ITOP
+        {
+            itops = code & 0x3FF;
+            continue;
+        }
+        if (cmd == 0x14) // MSCAL: the program gets TOPS and ITOPS, then the halves swap
+        {
+            mscal = code & 0xFFFF;
+            if (num_mscals < 2)
+            {
+                vertpack_vu_tops[num_mscals]  = base + dbf * offset;
+                vertpack_vu_itops[num_mscals] = itops;
+            }
+            ++num_mscals;
+            dbf ^= 1;
+            continue;
+        }
+        if ((cmd & 0x60) != 0x60) // Not an UNPACK
+        {
+            return -1;
+        }
+
+        const int fmt = cmd & 0xF;
+        const int num = ((code >> 16) & 0xFF) ? ((code >> 16) & 0xFF) : 256;
+        const int usn = (code >> 14) & 1;
+        const int tops_flag = (code >> 15) & 1;
+        int addr = (code & 0x3FF) + (tops_flag ? (base + dbf * offset) : 0);
+        int i, written = 0;
+
+        // Skipping write only (CL >= WL), the mode we use.
+        VERTPACK_CHECK(cl >= wl && wl >= 1);
+
+        const byte  * bytes  = (const byte *)p;
+        const s16   * halves = (const s16 *)p;
+        const u16   * uhalves = (const u16 *)p;
+        int bytes_in = 0;
+
+        for (i = 0; i < num; ++i)
+        {
+            if (addr >= VERTPACK_VU_MEM_QWORDS)
+            {
+                return -1;
+            }
+
+            u32 * qw = vertpack_vu_mem[addr];
+            switch (fmt)
+            {
+            case 0xC : // V4_32
+                memcpy(qw, &p[i * 4], 16);
+                bytes_in = num * 16;
+                break;
+            case 0xE : // V4_8
+                qw[0] = usn ? bytes[i * 4 + 0] : (u32)(s32)(s8)bytes[i * 4 + 0];
+                qw[1] = usn ? bytes[i * 4 + 1] : (u32)(s32)(s8)bytes[i * 4 + 1];
+                qw[2] = usn ? bytes[i * 4 + 2] : (u32)(s32)(s8)bytes[i * 4 + 2];
+                qw[3] = usn ? bytes[i * 4 + 3] : (u32)(s32)(s8)bytes[i * 4 + 3];
+                bytes_in = num * 4;
+                break;
+            case 0x9 : // V3_16 (W is left alone)
+                qw[0] = usn ? uhalves[i * 3 + 0] : (u32)(s32)halves[i * 3 + 0];
+                qw[1] = usn ? uhalves[i * 3 + 1] : (u32)(s32)halves[i * 3 + 1];
+                qw[2] = usn ? uhalves[i * 3 + 2] : (u32)(s32)halves[i * 3 + 2];
+                bytes_in = num * 6;
+                break;
+            default :
+                return -1;
+            } // switch (fmt)
+
+            // Write WL qwords, then skip CL - WL.
+            ++addr;
+            if (++written == wl)
+            {
+                addr += cl - wl;
+                written = 0;
+            }
+        }
+
+        p += (bytes_in + 3) / 4; // Data is padded to whole words.
+    }
+
+    return (p == end) ? mscal : -1;
+}
+
+// Checks a batch unpacked at 'top' against what went in.
+static void VertPack_CheckBatch(int top, const float * positions, const u32 * colors, int num_verts,
+                                u64 giftag, u64 regs)
+{
+    int i, j;
+    ps2_vert_pos_frame_t frame;
+
+    // Header, as the VU program reads it.
+    const u32 * origin = vertpack_vu_mem[top + PS2_VU_PACKED_POS_ORIGIN];
+    const u32 * tag    = vertpack_vu_mem[top + PS2_VU_PACKED_GIFTAG];
+    VERTPACK_CHECK(tag[0] == (u32)giftag && tag[1] == (u32)(giftag >> 32));
+    VERTPACK_CHECK(tag[2] == (u32)regs && tag[3] == (u32)(regs >> 32));
+
+    for (j = 0; j < 3; ++j)
+    {
+        frame.origin[j] = VertPack_AsFloat(origin[j]);
+    }
+    frame.step = VertPack_AsFloat(origin[3]);
+
+    // Vertexes: color, position, color, position...
+    for (i = 0; i < num_verts; ++i)
+    {
+        const u32 * color = vertpack_vu_mem[top + PS2_VU_PACKED_START_COLOR + i * 2];
+        const u32 * pos   = vertpack_vu_mem[top + PS2_VU_PACKED_START_VERT  + i * 2];
+        byte rgba[4];
+
+        Vert_UnpackColor(colors[i], rgba);
+        VERTPACK_CHECK(color[0] == rgba[0] && color[1] == rgba[1] && color[2] == rgba[2] && color[3] == rgba[3]);
+
+        for (j = 0; j < 3; ++j)
+        {
+            // ITOF0, then the multiply-add by origin/step.
+            const float out = frame.origin[j] + (float)(s32)pos[j] * frame.step;
+            VERTPACK_CHECK(fabsf(out - positions[i * 3 + j]) <= frame.step * 0.5f + 1e-3f);
+        }
+    }
+
+    // Nothing written to the skipped qword or past the last vertex.
+    VERTPACK_CHECK(vertpack_vu_mem[top + PS2_VU_PACKED_POS_ORIGIN + 1][0] == 0xCDCDCDCD);
+    VERTPACK_CHECK(PS2_VU_PACKED_START_VERT + (num_verts - 1) * 2 < PS2_VU_DBUF_SIZE);
+    if (top + PS2_VU_PACKED_START_COLOR + num_verts * 2 < VERTPACK_VU_MEM_QWORDS)
+    {
+        VERTPACK_CHECK(vertpack_vu_mem[top + PS2_VU_PACKED_START_COLOR + num_verts * 2][0] == 0xCDCDCDCD);
+    }
+}
+
+static void VertPack_TestBatches(void)
+{
+    int b, k, i;
+    const int errors_before = vertpack_errors;
+    const u64 giftag = 0x1122334455667788ULL;
+    const u64 regs   = 0x51;
+    const int prog   = 0x123;
+
+    static float positions[2][PS2_VU_PACKED_MAX_VERTS * 3];
+    static u32 colors[2][PS2_VU_PACKED_MAX_VERTS];
+    static u32 words[PS2_VERT_FRAME_HEADER_WORDS + PS2_VU_PACKED_MAX_VERTS * 3 * 2];
+    int num_verts[2];
+    float mvp[16];
+
+    for (b = 0; b < VERTPACK_RANDOM_BATCHES / 10; ++b)
+    {
+        for (i = 0; i < 16; ++i)
+        {
+            mvp[i] = (float)(i + 1);
+        }
+
+        // Once per chain, then two batches, one for each half of the double buffer.
+        int total_words = Vert_PackFrameHeader(words, mvp);
+        VERTPACK_CHECK(total_words == PS2_VERT_FRAME_HEADER_WORDS);
+
+        for (k = 0; k < 2; ++k)
+        {
+            num_verts[k] = (b == 0) ? PS2_VU_PACKED_MAX_VERTS : 3 * (1 + rand() % (PS2_VU_PACKED_MAX_VERTS / 3));
+            for (i = 0; i < num_verts[k] * 3; ++i)
+            {
+                positions[k][i] = VertPack_Random(-3000.0f, 3000.0f);
+            }
+            for (i = 0; i < num_verts[k]; ++i)
+            {
+                colors[k][i] = (u32)rand() ^ ((u32)rand() << 16);
+            }
+
+            const int batch_words = Vert_PackBatch(words + total_words, positions[k], colors[k],
+                                                   num_verts[k], giftag, regs, prog);
+            VERTPACK_CHECK(batch_words == Vert_PackedBatchWords(num_verts[k]));
+            total_words += batch_words;
+        }
+
+        memset(vertpack_vu_mem, 0xCD, sizeof(vertpack_vu_mem));
+        vertpack_vu_tops[0] = vertpack_vu_tops[1] = -1;
+        VERTPACK_CHECK(VertPack_RunVIF(words, total_words) == prog);
+
+        // Constants, as the VU programs read them.
+        const u32 * scales = vertpack_vu_mem[PS2_VU_SCALES];
+        const u32 * fence  = vertpack_vu_mem[PS2_VU_KICK_FENCE];
+        VERTPACK_CHECK(VertPack_AsFloat(vertpack_vu_mem[PS2_VU_MVP_MATRIX + 3][3]) == 16.0f);
+        VERTPACK_CHECK(VertPack_AsFloat(scales[0]) == 2048.0f && VertPack_AsFloat(scales[1]) == 2048.0f);
+        VERTPACK_CHECK(fence[0] == 0x8000 && fence[1] == 0); // NLOOP 0, EOP
+
+        // Second batch went to the other half, without touching the first.
+        VERTPACK_CHECK(vertpack_vu_tops[0] == PS2_VU_DBUF_BASE);
+        VERTPACK_CHECK(vertpack_vu_tops[1] == PS2_VU_DBUF_BASE + PS2_VU_DBUF_SIZE);
+        for (k = 0; k < 2; ++k)
+        {
+            VERTPACK_CHECK(vertpack_vu_itops[k] == num_verts[k]);
+            VertPack_CheckBatch(vertpack_vu_tops[k], positions[k], colors[k], num_verts[k], giftag, regs);
+        }
+    }
+
+    Com_Printf("%-20s %s\n", "VIF batches", (vertpack_errors == errors_before) ? "ok" : "FAILED");
+}
+
+void Test_PS2_VertPack(void)
+{
+    int i;
+    static const int batch_sizes[] = { 3, 6, 12, 30, 120, 252 };
+
+    Com_Printf("====== QPS2 - Test_PS2_VertPack ======\n");
+
+    vertpack_errors = 0;
+    srand(4321);
+
+    VertPack_TestColors();
+    VertPack_TestPositions();
+    VertPack_TestTexCoords();
+    VertPack_TestBatches();
+
+    Com_Printf("%d errors\n", vertpack_errors);
+
+    // DMA bytes of one batch, VIF codes included.
+    Com_Printf("%-8s %8s %8s %6s\n", "verts", "V4_32", "packed", "saved");
+    for (i = 0; i < (int)(sizeof(batch_sizes) / sizeof(batch_sizes[0])); ++i)
+    {
+        const int unpacked = Vert_UnpackedBatchWords(batch_sizes[i]) * 4;
+        const int packed   = Vert_PackedBatchWords(batch_sizes[i]) * 4;
+        Com_Printf("%-8d %8d %8d %5d%%\n", batch_sizes[i], unpacked, packed, 100 - (packed * 100 / unpacked));
+    }
+}
@@ -0,0 +1,306 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: test_vu1_list.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Benchmark of the bulk VU1 list writing against the per-element VU1_ListAdd calls.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/q_common.h"
+#include "ps2/model_load.h"
+#include "ps2/vu1.h"
+
+// Functions exported from this file:
+void Test_PS2_VU1ListBench(void);
+
+//=============================================================================
+//
+// Test_PS2_VU1ListBench -- Builds the VU1 batches for a set of random polygons
+// the way view_draw.c does, first with a VU1_ListAdd32/VU1_ListAddFloat call per
+// element, then with VU1_ListReserve + VU1_WriteColorPosVerts, and prints the
+// vertexes per second of each. The batches are ended with VU1_ListEndChain
+// instead of VU1_End, so the DMA buffers are the sink and nothing is sent.
+// Both ways must produce the same chains, byte for byte.
+//
+// Doesn't need the VU, so it also runs on the host as 'vu1list_bench'.
+//
+//=============================================================================
+
+enum
+{
+    VU1LIST_NUM_POLYS    = 1024,
+    VU1LIST_MAX_VERTS    = 12,
+    VU1LIST_BATCH_VERTS  = (PS2_VU_MAX_BATCH_VERTS / 3) * 3,
+    VU1LIST_BENCH_PASSES = 50
+};
+
+typedef struct
+{
+    int num_verts;
+    byte color[4];
+    ps2_poly_vertex_t vertexes[VU1LIST_MAX_VERTS];
+    ps2_mdl_triangle_t triangles[VU1LIST_MAX_VERTS - 2];
+} vu1list_poly_t;
+
+static vu1list_poly_t vu1list_polys[VU1LIST_NUM_POLYS];
+static byte vu1list_scratch[VU1LIST_BATCH_VERTS * 32 + 256] PS2_ALIGN(16);
+
+// Batch state, like the one in view_draw.c:
+static int vu1list_batch_vert_count;
+static u64 * vu1list_giftag;
+static qboolean vu1list_compare;
+static int vu1list_num_batches;
+static int vu1list_mismatches;
+static u32 vu1list_sink;
+
+static float VU1List_Random(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+static void VU1List_BuildPolys(void)
+{
+    int p, v;
+    for (p = 0; p < VU1LIST_NUM_POLYS; ++p)
+    {
+        vu1list_poly_t * poly = &vu1list_polys[p];
+        poly->num_verts = 3 + (rand() % (VU1LIST_MAX_VERTS - 2));
+        poly->color[0]  = (byte)rand();
+        poly->color[1]  = (byte)rand();
+        poly->color[2]  = (byte)rand();
+        poly->color[3]  = 255;
+
+        for (v = 0; v < poly->num_verts; ++v)
+        {
+            poly->vertexes[v].position[0] = VU1List_Random(-4096.0f, 4096.0f);
+            poly->vertexes[v].position[1] = VU1List_Random(-4096.0f, 4096.0f);
+            poly->vertexes[v].position[2] = VU1List_Random(-4096.0f, 4096.0f);
+        }
+
+        // Triangle fan, like the BSP loader does.
+        for (v = 0; v < poly->num_verts - 2; ++v)
+        {
+            poly->triangles[v].vertexes[0] = 0;
+            poly->triangles[v].vertexes[1] = v + 1;
+            poly->triangles[v].vertexes[2] = v + 2;
+        }
+    }
+}
+
+static int VU1List_ChainBytes(const void * chain)
+{
+    // CNT tag + its qwords + END tag.
+    const int qwc = (int)(*(const u64 *)chain & 0xFFFF);
+    return (qwc + 2) * 16;
+}
+
+static void VU1List_BeginBatch(void)
+{
+    VU1_Begin();
+    VU1_ListAddBegin(0);
+    vu1list_giftag = VU1_ListAddGIFTag();
+    vu1list_batch_vert_count = 0;
+}
+
+static void VU1List_EndBatch(void)
+{
+    vu1list_giftag[0] = ((u64)vu1list_batch_vert_count << 1) | ((u64)1 << 15);
+    vu1list_giftag[1] = 0x51;
+    VU1_ListAddEnd();
+
+    const byte * chain = VU1_ListEndChain(0, vu1list_batch_vert_count);
+    vu1list_sink += *(const u32 *)(chain + 16);
+    ++vu1list_num_batches;
+
+    // The per-element pass saves its chains, the bulk one compares against them.
+    if (vu1list_compare)
+    {
+        if (memcmp(vu1list_scratch, chain, VU1List_ChainBytes(chain)) != 0)
+        {
+            ++vu1list_mismatches;
+        }
+    }
+}
+
+static int VU1List_DrawPolysPerElement(int first, int count)
+{
+    int p, t, v, num_verts = 0;
+    for (p = first; p < first + count; ++p)
+    {
+        const vu1list_poly_t * poly = &vu1list_polys[p];
+        for (t = 0; t < poly->num_verts - 2; ++t)
+        {
+            if ((vu1list_batch_vert_count + 3) > VU1LIST_BATCH_VERTS)
+            {
+                VU1List_EndBatch();
+                VU1List_BeginBatch();
+            }
+            vu1list_batch_vert_count += 3;
+
+            for (v = 0; v < 3; ++v)
+            {
+                const ps2_poly_vertex_t * vert = &poly->vertexes[poly->triangles[t].vertexes[v]];
+                VU1_ListAdd32(poly->color[0]);
+                VU1_ListAdd32(poly->color[1]);
+                VU1_ListAdd32(poly->color[2]);
+                VU1_ListAdd32(poly->color[3]);
+                VU1_ListAddFloat(vert->position[0]);
+                VU1_ListAddFloat(vert->position[1]);
+                VU1_ListAddFloat(vert->position[2]);
+                VU1_ListAddFloat(1.0f);
+            }
+        }
+        num_verts += (poly->num_verts - 2) * 3;
+    }
+    return num_verts;
+}
+
+static int VU1List_DrawPolysBulk(int first, int count)
+{
+    int p, t, n, num_verts = 0;
+    for (p = first; p < first + count; ++p)
+    {
+        const vu1list_poly_t * poly = &vu1list_polys[p];
+        const int num_triangles = poly->num_verts - 2;
+        for (t = 0; t < num_triangles; t += n)
+        {
+            if ((vu1list_batch_vert_count + 3) > VU1LIST_BATCH_VERTS)
+            {
+                VU1List_EndBatch();
+                VU1List_BeginBatch();
+            }
+
+            n = (VU1LIST_BATCH_VERTS - vu1list_batch_vert_count) / 3;
+            if (n > num_triangles - t)
+            {
+                n = num_triangles - t;
+            }
+
+            u128 * dest = VU1_ListReserve(n * 3 * 2);
+            VU1_WriteColorPosVerts(dest, poly->color, poly->vertexes[0].position, sizeof(ps2_poly_vertex_t),
+                                   &poly->triangles[t].vertexes[0], n * 3);
+            vu1list_batch_vert_count += n * 3;
+        }
+        num_verts += num_triangles * 3;
+    }
+    return num_verts;
+}
+
+static void VU1List_TestSameOutput(void)
+{
+    int p, errors = 0, batches = 0;
+
+    // A polygon at a time: the per-element pass into the scratch, then
+    // the same batch again with the bulk functions, to compare.
+    for (p = 0; p < VU1LIST_NUM_POLYS; ++p)
+    {
+        vu1list_compare = false;
+        VU1List_BeginBatch();
+        VU1List_DrawPolysPerElement(p, 1);
+        VU1List_EndBatch();
+        memcpy(vu1list_scratch, vu1_dma_buffers[vu1_buffer_index],
+               VU1List_ChainBytes(vu1_dma_buffers[vu1_buffer_index]));
+
+        vu1list_compare = true;
+        vu1list_mismatches = 0;
+        VU1List_BeginBatch();
+        VU1List_DrawPolysBulk(p, 1);
+        VU1List_EndBatch();
+
+        errors += vu1list_mismatches;
+        ++batches;
+    }
+
+    // VU1_ListReserve pads a list left in the middle of a qword.
+    static const u32 qwords[8] PS2_ALIGN(16) = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    vu1list_compare = false;
+    VU1_Begin();
+    VU1_ListAddBegin(0);
+    VU1_ListAdd32(0xDEADBEEF);
+    u128 * dest = VU1_ListReserve(2);
+    if (((size_t)dest & 0xF) != 0 || ((const u32 *)dest)[-4] != 0xDEADBEEF || ((const u32 *)dest)[-1] != 0)
+    {
+        ++errors;
+    }
+    VU1_CopyQWords(dest, (const u128 *)qwords, 2);
+    VU1_ListAddEnd();
+    const byte * chain = VU1_ListEndChain(-1, -1);
+    if (VU1List_ChainBytes(chain) != 5 * 16 || memcmp(chain + 32, qwords, sizeof(qwords)) != 0)
+    {
+        ++errors;
+    }
+
+    vu1list_compare = false;
+    Com_Printf("%-20s %s (%d batches)\n", "same output", (errors == 0) ? "ok" : "FAILED", batches);
+}
+
+static void VU1List_Bench(void)
+{
+    int pass, num_verts;
+    u32 start_time, per_element_usec, bulk_usec;
+
+    num_verts = 0;
+    vu1list_num_batches = 0;
+    start_time = Sys_Microseconds();
+    for (pass = 0; pass < VU1LIST_BENCH_PASSES; ++pass)
+    {
+        VU1List_BeginBatch();
+        num_verts += VU1List_DrawPolysPerElement(0, VU1LIST_NUM_POLYS);
+        VU1List_EndBatch();
+    }
+    per_element_usec = Sys_Microseconds() - start_time;
+    if (per_element_usec == 0)
+    {
+        per_element_usec = 1;
+    }
+
+    start_time = Sys_Microseconds();
+    for (pass = 0; pass < VU1LIST_BENCH_PASSES; ++pass)
+    {
+        VU1List_BeginBatch();
+        VU1List_DrawPolysBulk(0, VU1LIST_NUM_POLYS);
+        VU1List_EndBatch();
+    }
+    bulk_usec = Sys_Microseconds() - start_time;
+    if (bulk_usec == 0)
+    {
+        bulk_usec = 1;
+    }
+
+    Com_Printf("%d verts in %d batches per path\n", num_verts, vu1list_num_batches);
+    Com_Printf("%-12s %8.2f Mverts/s (%u usec)\n", "per element",
+               (double)num_verts / (double)per_element_usec, per_element_usec);
+    Com_Printf("%-12s %8.2f Mverts/s (%u usec)\n", "bulk",
+               (double)num_verts / (double)bulk_usec, bulk_usec);
+    Com_Printf("speedup %.2fx (sink %08X)\n", (double)per_element_usec / (double)bulk_usec, vu1list_sink);
+}
+
+/*
+================
+Test_PS2_VU1ListBench
+================
+*/
+void Test_PS2_VU1ListBench(void)
+{
+    // On the host, nothing else has set up the list buffers.
+    const qboolean need_init = (vu1_dma_buffers[0] == NULL);
+    if (need_init)
+    {
+        VU1_ListInit();
+    }
+
+    Com_Printf("====== QPS2 - Test_PS2_VU1ListBench ======\n");
+
+    srand(1234);
+    VU1List_BuildPolys();
+    VU1List_TestSameOutput();
+    VU1List_Bench();
+
+    if (need_init)
+    {
+        VU1_ListShutdown();
+    }
+}
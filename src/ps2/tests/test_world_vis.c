@@ -0,0 +1,576 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: test_world_vis.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Checks the cached world visible sets against a BSP walk (see ps2/world_vis.c).
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "common/q_common.h"
+#include "ps2/model_load.h"
+#include "ps2/mem_alloc.h"
+
+// Functions exported from this file:
+void Test_PS2_WorldVis(void);
+
+//=============================================================================
+//
+// Test_PS2_WorldVis -- Builds a small world: a grid of leafs split by a tree of
+// axial planes, with random clusters, areas, solid leafs, vis rows and surfaces
+// on the node planes marked by leafs below them. Then, for random views, checks
+// that PS2_WorldVisGather() finds the same surfaces that a PS2_MarkLeaves +
+// PS2_RecursiveWorldNode walk would, sorted by texture, and that the sets are
+// found in the cache when the key repeats. Also prints the average time per view
+// of the walk and of the cached gather.
+//
+// Doesn't need the renderer, so it also runs on the host as 'worldvis_test'.
+//
+//=============================================================================
+
+enum
+{
+    WORLDVIS_GRID_BITS  = 5, // 32x32 leafs.
+    WORLDVIS_GRID_SIZE  = 1 << WORLDVIS_GRID_BITS,
+    WORLDVIS_NUM_LEAFS  = WORLDVIS_GRID_SIZE * WORLDVIS_GRID_SIZE,
+    WORLDVIS_NUM_NODES  = WORLDVIS_NUM_LEAFS - 1,
+    WORLDVIS_CELL_SIZE  = 128,
+    WORLDVIS_NUM_AREAS  = 4,
+    WORLDVIS_NUM_IMAGES = 16,
+    WORLDVIS_MAX_SURFS  = WORLDVIS_NUM_NODES * 4,
+    WORLDVIS_MAX_MARKS  = WORLDVIS_MAX_SURFS * 4,
+    WORLDVIS_NUM_VIEWS  = 500
+};
+
+static ps2_model_t        worldvis_mdl;
+static ps2_mdl_node_t     worldvis_nodes[WORLDVIS_NUM_NODES];
+static ps2_mdl_leaf_t     worldvis_leafs[WORLDVIS_NUM_LEAFS];
+static cplane_t           worldvis_planes[WORLDVIS_NUM_NODES];
+static ps2_mdl_surface_t  worldvis_surfs[WORLDVIS_MAX_SURFS];
+static ps2_mdl_texinfo_t  worldvis_texinfos[WORLDVIS_NUM_IMAGES * 2];
+static ps2_teximage_t     worldvis_images[WORLDVIS_NUM_IMAGES];
+static ps2_mdl_surface_t * worldvis_marks[WORLDVIS_MAX_MARKS];
+static ps2_mdl_surface_t * worldvis_leaf_marks[WORLDVIS_NUM_LEAFS][64];
+static int                worldvis_leaf_num_marks[WORLDVIS_NUM_LEAFS];
+static ps2_mdl_surface_t * worldvis_gathered[WORLDVIS_MAX_SURFS];
+static byte               worldvis_expected[WORLDVIS_MAX_SURFS];
+
+static int worldvis_vis_bytes;
+static int worldvis_num_nodes;
+static int worldvis_num_surfs;
+static int worldvis_errors;
+static int worldvis_frame;
+static int worldvis_vis_frame;
+
+// View for the walk:
+static vec3_t   worldvis_vieworg;
+static cplane_t worldvis_frustum[4];
+static byte     worldvis_areabits[MAX_MAP_AREAS / 8];
+
+#define WORLDVIS_CHECK(expr)                                             \
+    do                                                                   \
+    {                                                                    \
+        if (!(expr))                                                     \
+        {                                                                \
+            Com_Printf("%s(%d): check failed: %s\n", __func__, __LINE__, #expr); \
+            ++worldvis_errors;                                           \
+        }                                                                \
+    } while (0)
+
+static float WorldVis_Random(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+static void WorldVis_SetSignBits(cplane_t * plane)
+{
+    int j;
+    plane->signbits = 0;
+    for (j = 0; j < 3; ++j)
+    {
+        if (plane->normal[j] < 0.0f)
+        {
+            plane->signbits |= 1 << j;
+        }
+    }
+}
+
+// Leafs go in the grid by index. Returns the node, or the leaf
+// as a node, covering cells [x0, x0 + w) x [y0, y0 + h).
+static ps2_mdl_node_t * WorldVis_BuildTree(int x0, int y0, int w, int h, ps2_mdl_node_t * parent)
+{
+    if (w == 1 && h == 1)
+    {
+        ps2_mdl_leaf_t * leaf = &worldvis_leafs[y0 * WORLDVIS_GRID_SIZE + x0];
+        leaf->parent = parent;
+        leaf->minmaxs[0] = x0 * WORLDVIS_CELL_SIZE;
+        leaf->minmaxs[1] = y0 * WORLDVIS_CELL_SIZE;
+        leaf->minmaxs[2] = 0.0f;
+        leaf->minmaxs[3] = (x0 + 1) * WORLDVIS_CELL_SIZE;
+        leaf->minmaxs[4] = (y0 + 1) * WORLDVIS_CELL_SIZE;
+        leaf->minmaxs[5] = WORLDVIS_CELL_SIZE;
+        return (ps2_mdl_node_t *)leaf;
+    }
+
+    const int node_index = worldvis_num_nodes++;
+    ps2_mdl_node_t * node = &worldvis_nodes[node_index];
+    cplane_t * plane = &worldvis_planes[node_index];
+
+    node->contents = -1;
+    node->parent   = parent;
+    node->plane    = plane;
+
+    // Split the longest side, front is the positive side.
+    const int axis = (w >= h) ? 0 : 1;
+    VectorClear(plane->normal);
+    plane->normal[axis] = 1.0f;
+    plane->type = (axis == 0) ? PLANE_X : PLANE_Y;
+    WorldVis_SetSignBits(plane);
+
+    if (axis == 0)
+    {
+        plane->dist = (x0 + w / 2) * WORLDVIS_CELL_SIZE;
+        node->children[0] = WorldVis_BuildTree(x0 + w / 2, y0, w - w / 2, h, node);
+        node->children[1] = WorldVis_BuildTree(x0, y0, w / 2, h, node);
+    }
+    else
+    {
+        plane->dist = (y0 + h / 2) * WORLDVIS_CELL_SIZE;
+        node->children[0] = WorldVis_BuildTree(x0, y0 + h / 2, w, h - h / 2, node);
+        node->children[1] = WorldVis_BuildTree(x0, y0, w, h / 2, node);
+    }
+
+    node->minmaxs[0] = x0 * WORLDVIS_CELL_SIZE;
+    node->minmaxs[1] = y0 * WORLDVIS_CELL_SIZE;
+    node->minmaxs[2] = 0.0f;
+    node->minmaxs[3] = (x0 + w) * WORLDVIS_CELL_SIZE;
+    node->minmaxs[4] = (y0 + h) * WORLDVIS_CELL_SIZE;
+    node->minmaxs[5] = WORLDVIS_CELL_SIZE;
+
+    // A few surfaces on the splitting plane, each marked by some leafs below the node.
+    node->first_surface = worldvis_num_surfs;
+    node->num_surfaces  = rand() % 4;
+
+    int s, m;
+    for (s = 0; s < node->num_surfaces; ++s)
+    {
+        ps2_mdl_surface_t * surf = &worldvis_surfs[worldvis_num_surfs++];
+        surf->plane   = plane;
+        surf->flags   = (rand() & 1) ? SURF_PLANEBACK : 0;
+        surf->texinfo = &worldvis_texinfos[rand() % (WORLDVIS_NUM_IMAGES * 2)];
+
+        // Like the BSP, only leafs on the side the surface faces mark it.
+        int sx = x0, sy = y0, sw = w, sh = h;
+        const int front = !(surf->flags & SURF_PLANEBACK);
+        if (axis == 0)
+        {
+            sx = front ? (x0 + w / 2) : x0;
+            sw = front ? (w - w / 2) : (w / 2);
+        }
+        else
+        {
+            sy = front ? (y0 + h / 2) : y0;
+            sh = front ? (h - h / 2) : (h / 2);
+        }
+
+        const int num_marks = 1 + rand() % 3;
+        for (m = 0; m < num_marks; ++m)
+        {
+            const int lx = sx + rand() % sw;
+            const int ly = sy + rand() % sh;
+            const int leaf_index = ly * WORLDVIS_GRID_SIZE + lx;
+            if (worldvis_leaf_num_marks[leaf_index] < 64)
+            {
+                worldvis_leaf_marks[leaf_index][worldvis_leaf_num_marks[leaf_index]++] = surf;
+            }
+        }
+    }
+    return node;
+}
+
+// Random vis rows, one cluster per leaf, run-length compressed like the BSP.
+static dvis_t * WorldVis_BuildVis(int num_clusters)
+{
+    int c, i;
+    const int row_bytes = (num_clusters + 7) / 8;
+    const int header_size = sizeof(int) + num_clusters * sizeof(int) * 2;
+    worldvis_vis_bytes = header_size + num_clusters * row_bytes * 2;
+    byte * data = PS2_MemAlloc(worldvis_vis_bytes, MEMTAG_MISC);
+    dvis_t * vis = (dvis_t *)data;
+    byte * out = data + header_size;
+    byte row[WORLDVIS_NUM_LEAFS / 8];
+
+    vis->numclusters = num_clusters;
+    for (c = 0; c < num_clusters; ++c)
+    {
+        // Sparse rows, so that there are long runs of zeros.
+        memset(row, 0, sizeof(row));
+        row[c >> 3] |= 1 << (c & 7);
+        for (i = 0; i < num_clusters / 8; ++i)
+        {
+            const int other = rand() % num_clusters;
+            row[other >> 3] |= 1 << (other & 7);
+        }
+
+        vis->bitofs[c][DVIS_PVS] = (int)(out - data);
+        vis->bitofs[c][DVIS_PHS] = (int)(out - data);
+        for (i = 0; i < row_bytes; ++i)
+        {
+            *out++ = row[i];
+            if (row[i])
+            {
+                continue;
+            }
+
+            int rep = 1;
+            while (i + 1 < row_bytes && row[i + 1] == 0 && rep < 255)
+            {
+                ++rep;
+                ++i;
+            }
+            *out++ = rep;
+        }
+    }
+    return vis;
+}
+
+static void WorldVis_BuildWorld(void)
+{
+    int i, j, num_marks = 0;
+
+    memset(&worldvis_mdl, 0, sizeof(worldvis_mdl));
+    memset(worldvis_leaf_num_marks, 0, sizeof(worldvis_leaf_num_marks));
+    worldvis_num_nodes = 0;
+    worldvis_num_surfs = 0;
+
+    for (i = 0; i < WORLDVIS_NUM_IMAGES * 2; ++i)
+    {
+        worldvis_texinfos[i].teximage = &worldvis_images[i % WORLDVIS_NUM_IMAGES];
+        worldvis_texinfos[i].flags = 0;
+    }
+    worldvis_texinfos[1].flags = SURF_SKY;
+    worldvis_texinfos[2].flags = SURF_TRANS33;
+    worldvis_texinfos[3].flags = SURF_TRANS66;
+
+    WorldVis_BuildTree(0, 0, WORLDVIS_GRID_SIZE, WORLDVIS_GRID_SIZE, NULL);
+
+    for (i = 0; i < WORLDVIS_NUM_LEAFS; ++i)
+    {
+        ps2_mdl_leaf_t * leaf = &worldvis_leafs[i];
+        leaf->contents = ((rand() % 10) == 0) ? CONTENTS_SOLID : 0;
+        leaf->cluster  = ((rand() % 20) == 0) ? -1 : i;
+        leaf->area     = rand() % WORLDVIS_NUM_AREAS;
+
+        leaf->first_mark_surface = &worldvis_marks[num_marks];
+        leaf->num_mark_surfaces  = worldvis_leaf_num_marks[i];
+        for (j = 0; j < worldvis_leaf_num_marks[i]; ++j)
+        {
+            worldvis_marks[num_marks++] = worldvis_leaf_marks[i][j];
+        }
+    }
+
+    worldvis_mdl.type          = MDL_BRUSH;
+    worldvis_mdl.num_leafs     = WORLDVIS_NUM_LEAFS;
+    worldvis_mdl.leafs         = worldvis_leafs;
+    worldvis_mdl.num_nodes     = worldvis_num_nodes;
+    worldvis_mdl.nodes         = worldvis_nodes;
+    worldvis_mdl.num_surfaces  = worldvis_num_surfs;
+    worldvis_mdl.surfaces      = worldvis_surfs;
+    worldvis_mdl.num_texinfos  = WORLDVIS_NUM_IMAGES * 2;
+    worldvis_mdl.texinfos      = worldvis_texinfos;
+    worldvis_mdl.num_mark_surfaces = num_marks;
+    worldvis_mdl.mark_surfaces = worldvis_marks;
+    worldvis_mdl.vis           = WorldVis_BuildVis(WORLDVIS_NUM_LEAFS);
+}
+
+static void WorldVis_RandomView(qboolean with_areabits)
+{
+    int i;
+    const float extent = WORLDVIS_GRID_SIZE * WORLDVIS_CELL_SIZE;
+
+    worldvis_vieworg[0] = WorldVis_Random(0.0f, extent);
+    worldvis_vieworg[1] = WorldVis_Random(0.0f, extent);
+    worldvis_vieworg[2] = WorldVis_Random(0.0f, WORLDVIS_CELL_SIZE);
+
+    // Four planes through the view origin, around a random direction.
+    const float yaw = WorldVis_Random(0.0f, 2.0f * M_PI);
+    for (i = 0; i < 4; ++i)
+    {
+        const float a = yaw + (i - 1.5f) * 0.5f;
+        cplane_t * plane = &worldvis_frustum[i];
+        plane->normal[0] = cosf(a);
+        plane->normal[1] = sinf(a);
+        plane->normal[2] = (i & 1) ? 0.2f : -0.2f;
+        VectorNormalize(plane->normal);
+        plane->dist = DotProduct(worldvis_vieworg, plane->normal);
+        plane->type = PLANE_ANYZ;
+        WorldVis_SetSignBits(plane);
+    }
+
+    memset(worldvis_areabits, 0, sizeof(worldvis_areabits));
+    for (i = 0; i < WORLDVIS_NUM_AREAS; ++i)
+    {
+        if (!with_areabits || (rand() & 3) != 0)
+        {
+            worldvis_areabits[i >> 3] |= 1 << (i & 7);
+        }
+    }
+}
+
+// Same as PS2_MarkLeaves, minus the early out.
+static void WorldVis_MarkLeaves(int cluster, int cluster2)
+{
+    int i;
+    ++worldvis_vis_frame;
+
+    const int mark = Frame_MemGetMark(FRAME_MEM_REFRESH);
+    const byte * vis = PS2_WorldVisClusterPVS(&worldvis_mdl, cluster, cluster2);
+
+    for (i = 0; i < worldvis_mdl.num_nodes; ++i)
+    {
+        if (vis == NULL)
+        {
+            worldvis_nodes[i].vis_frame = worldvis_vis_frame;
+        }
+    }
+
+    for (i = 0; i < worldvis_mdl.num_leafs; ++i)
+    {
+        ps2_mdl_leaf_t * leaf = &worldvis_leafs[i];
+        if (vis == NULL)
+        {
+            leaf->vis_frame = worldvis_vis_frame;
+            continue;
+        }
+        if (leaf->cluster == -1 || !(vis[leaf->cluster >> 3] & (1 << (leaf->cluster & 7))))
+        {
+            continue;
+        }
+
+        ps2_mdl_node_t * node = (ps2_mdl_node_t *)leaf;
+        for (; node != NULL && node->vis_frame != worldvis_vis_frame; node = node->parent)
+        {
+            node->vis_frame = worldvis_vis_frame;
+        }
+    }
+
+    Frame_MemFreeToMark(FRAME_MEM_REFRESH, mark);
+}
+
+// Same as PS2_RecursiveWorldNode. Sets worldvis_expected[] for the surfaces it would chain.
+static void WorldVis_RecursiveWorldNode(ps2_mdl_node_t * node, const byte * areabits)
+{
+    int i;
+    if (node->contents == CONTENTS_SOLID || node->vis_frame != worldvis_vis_frame)
+    {
+        return;
+    }
+    for (i = 0; i < 4; ++i)
+    {
+        if (BOX_ON_PLANE_SIDE(node->minmaxs, node->minmaxs + 3, &worldvis_frustum[i]) == 2)
+        {
+            return;
+        }
+    }
+
+    if (node->contents != -1)
+    {
+        ps2_mdl_leaf_t * leaf = (ps2_mdl_leaf_t *)node;
+        if (areabits != NULL && !(areabits[leaf->area >> 3] & (1 << (leaf->area & 7))))
+        {
+            return;
+        }
+        for (i = 0; i < leaf->num_mark_surfaces; ++i)
+        {
+            leaf->first_mark_surface[i]->vis_frame = worldvis_frame;
+        }
+        return;
+    }
+
+    const float dot = DotProduct(worldvis_vieworg, node->plane->normal) - node->plane->dist;
+    const int side = (dot >= 0.0f) ? 0 : 1;
+    const int sidebit = (dot >= 0.0f) ? 0 : SURF_PLANEBACK;
+
+    WorldVis_RecursiveWorldNode(node->children[side], areabits);
+
+    ps2_mdl_surface_t * surf = worldvis_surfs + node->first_surface;
+    for (i = node->num_surfaces; i; --i, ++surf)
+    {
+        if (surf->vis_frame != worldvis_frame || (surf->flags & SURF_PLANEBACK) != sidebit)
+        {
+            continue;
+        }
+        if (surf->texinfo->flags & (SURF_SKY | SURF_TRANS33 | SURF_TRANS66))
+        {
+            continue;
+        }
+        worldvis_expected[surf - worldvis_surfs] = 1;
+    }
+
+    WorldVis_RecursiveWorldNode(node->children[!side], areabits);
+}
+
+static void WorldVis_TestSameAsWalk(void)
+{
+    int v, i;
+    const int errors_before = worldvis_errors;
+
+    for (v = 0; v < WORLDVIS_NUM_VIEWS; ++v)
+    {
+        const qboolean with_areabits = (v & 1);
+        WorldVis_RandomView(with_areabits);
+
+        const byte * areabits = with_areabits ? worldvis_areabits : NULL;
+        const int cluster  = ((v % 7) == 0) ? -1 : rand() % WORLDVIS_NUM_LEAFS;
+        const int cluster2 = ((v % 3) == 0) ? rand() % WORLDVIS_NUM_LEAFS : cluster;
+
+        memset(worldvis_expected, 0, sizeof(worldvis_expected));
+        ++worldvis_frame;
+        WorldVis_MarkLeaves(cluster, cluster2);
+        WorldVis_RecursiveWorldNode(worldvis_nodes, areabits);
+
+        ++worldvis_frame;
+        const ps2_world_vis_t * vis = PS2_WorldVisFind(&worldvis_mdl, cluster, cluster2, areabits);
+        const int count = PS2_WorldVisGather(vis, worldvis_frustum, 4, worldvis_vieworg, worldvis_frame, worldvis_gathered);
+
+        int num_expected = 0;
+        for (i = 0; i < worldvis_num_surfs; ++i)
+        {
+            num_expected += worldvis_expected[i];
+        }
+        WORLDVIS_CHECK(count == num_expected);
+
+        for (i = 0; i < count; ++i)
+        {
+            const int surf_index = (int)(worldvis_gathered[i] - worldvis_surfs);
+            WORLDVIS_CHECK(worldvis_expected[surf_index] == 1);
+            worldvis_expected[surf_index] = 2; // Catches duplicates.
+
+            if (i > 0)
+            {
+                WORLDVIS_CHECK(worldvis_gathered[i - 1]->texinfo->teximage <= worldvis_gathered[i]->texinfo->teximage);
+            }
+        }
+
+        if (worldvis_errors - errors_before > 10)
+        {
+            break; // No need to flood the console.
+        }
+    }
+
+    Com_Printf("%-20s %s (%d views)\n", "same as BSP walk", (worldvis_errors == errors_before) ? "ok" : "FAILED", v);
+}
+
+static void WorldVis_TestCache(void)
+{
+    int i;
+    ps2_world_vis_stats_t stats;
+    const int errors_before = worldvis_errors;
+
+    PS2_WorldVisReset();
+    PS2_WorldVisGetStats(&stats);
+    WORLDVIS_CHECK(stats.num_sets == 0 && stats.mem_bytes == 0 && stats.hits == 0 && stats.misses == 0);
+
+    memset(worldvis_areabits, 0xFF, sizeof(worldvis_areabits));
+
+    const ps2_world_vis_t * a = PS2_WorldVisFind(&worldvis_mdl, 10, 10, NULL);
+    const ps2_world_vis_t * b = PS2_WorldVisFind(&worldvis_mdl, 10, 10, NULL);
+    WORLDVIS_CHECK(a == b);
+
+    // Same clusters the other way around, and -1 for cluster2, are the same set.
+    const ps2_world_vis_t * c = PS2_WorldVisFind(&worldvis_mdl, 10, 20, NULL);
+    WORLDVIS_CHECK(c != a);
+    WORLDVIS_CHECK(PS2_WorldVisFind(&worldvis_mdl, 20, 10, NULL) == c);
+    WORLDVIS_CHECK(PS2_WorldVisFind(&worldvis_mdl, 10, -1, NULL) == a);
+
+    // Areabits are part of the key, even when they let everything through.
+    const ps2_world_vis_t * d = PS2_WorldVisFind(&worldvis_mdl, 10, 10, worldvis_areabits);
+    WORLDVIS_CHECK(d != a);
+    worldvis_areabits[0] = 0xFE;
+    WORLDVIS_CHECK(PS2_WorldVisFind(&worldvis_mdl, 10, 10, worldvis_areabits) != d);
+
+    PS2_WorldVisGetStats(&stats);
+    WORLDVIS_CHECK(stats.num_sets == 4 && stats.misses == 4 && stats.hits == 3);
+
+    // Least recently used goes first. Keep 'a' in use while filling the cache.
+    for (i = 0; i < 16; ++i)
+    {
+        PS2_WorldVisFind(&worldvis_mdl, 100 + i, 100 + i, NULL);
+        WORLDVIS_CHECK(PS2_WorldVisFind(&worldvis_mdl, 10, 10, NULL) == a);
+    }
+    PS2_WorldVisGetStats(&stats);
+    WORLDVIS_CHECK(stats.num_sets == 8 && stats.misses == 4 + 16);
+
+    PS2_WorldVisReset();
+    PS2_WorldVisGetStats(&stats);
+    WORLDVIS_CHECK(stats.num_sets == 0 && stats.mem_bytes == 0);
+
+    Com_Printf("%-20s %s\n", "cache", (worldvis_errors == errors_before) ? "ok" : "FAILED");
+}
+
+static void WorldVis_Bench(void)
+{
+    int v, count = 0;
+    u32 start_time, walk_usec, cached_usec;
+
+    // Views move inside a few clusters, like a player would.
+    enum { BENCH_FRAMES = 2000 };
+    const int clusters[4] = { 5, 300, 517, 900 };
+
+    srand(4321);
+    start_time = Sys_Microseconds();
+    for (v = 0; v < BENCH_FRAMES; ++v)
+    {
+        WorldVis_RandomView(false);
+        ++worldvis_frame;
+        if ((v % 50) == 0)
+        {
+            WorldVis_MarkLeaves(clusters[(v / 50) & 3], clusters[(v / 50) & 3]);
+        }
+        WorldVis_RecursiveWorldNode(worldvis_nodes, NULL);
+    }
+    walk_usec = Sys_Microseconds() - start_time;
+
+    srand(4321);
+    start_time = Sys_Microseconds();
+    for (v = 0; v < BENCH_FRAMES; ++v)
+    {
+        WorldVis_RandomView(false);
+        ++worldvis_frame;
+        const int cluster = clusters[(v / 50) & 3];
+        const ps2_world_vis_t * vis = PS2_WorldVisFind(&worldvis_mdl, cluster, cluster, NULL);
+        count += PS2_WorldVisGather(vis, worldvis_frustum, 4, worldvis_vieworg, worldvis_frame, worldvis_gathered);
+    }
+    cached_usec = Sys_Microseconds() - start_time;
+
+    Com_Printf("%d leafs, %d surfaces, %.1f drawn per view\n",
+               WORLDVIS_NUM_LEAFS, worldvis_num_surfs, (float)count / BENCH_FRAMES);
+    Com_Printf("%-12s %8.2f usec/view\n", "BSP walk", (float)walk_usec / BENCH_FRAMES);
+    Com_Printf("%-12s %8.2f usec/view\n", "cached", (float)cached_usec / BENCH_FRAMES);
+}
+
+/*
+================
+Test_PS2_WorldVis
+================
+*/
+void Test_PS2_WorldVis(void)
+{
+    Com_Printf("====== QPS2 - Test_PS2_WorldVis ======\n");
+
+    srand(1234);
+    worldvis_errors = 0;
+    WorldVis_BuildWorld();
+
+    WorldVis_TestSameAsWalk();
+    WorldVis_TestCache();
+    WorldVis_Bench();
+
+    PS2_WorldVisReset();
+    PS2_MemFree(worldvis_mdl.vis, worldvis_vis_bytes, MEMTAG_MISC);
+    worldvis_mdl.vis = NULL;
+
+    Com_Printf("%d errors\n", worldvis_errors);
+}
@@ -12,7 +12,9 @@
 
 #include "ps2/ref_ps2.h"
 #include "ps2/mem_alloc.h"
+#include "ps2/name_index.h"
 #include "common/q_files.h"
+#include "common/q_ltrace.h"
 
 #include <draw.h>
 #include <gs_psm.h>
@@ -77,6 +79,12 @@ int ps2_unused_teximages_freed = 0;
 int ps2_teximages_failed       = 0;
 int ps2_scrap_allocs           = 0;
 int ps2_teximage_load_time     = 0;
+int ps2_teximage_mip_bytes     = 0; // Memory taken by the levels below the first.
+
+// Name lookups into ps2ref.teximages[]. Kept up to date by
+// PS2_TexImageSetup and PS2_TexImageFree.
+static ps2_name_slot_t ps2_teximage_slots[PS2_NAME_INDEX_SLOTS(MAX_TEXIMAGES)];
+static ps2_name_index_t ps2_teximage_index;
 
 // These allow skipping the load of a given texture type.
 // When set, the returned texture will be the built-in debug texture.
@@ -86,6 +94,18 @@ static cvar_t * r_ps2_skip_wall_tex_load   = NULL;
 static cvar_t * r_ps2_skip_sky_tex_load    = NULL;
 static cvar_t * r_ps2_skip_pic_tex_load    = NULL;
 
+// Keep PCX/WAL images as 8bits indexes into the shared CLUT
+// (GS_PSM_8) when possible, instead of expanding them to 16/32bits.
+// Only affects images loaded after it is changed.
+static cvar_t * r_ps2_paletted_tex = NULL;
+
+// Keep the smaller levels of WAL images (see SetupMipmaps).
+// Only affects images loaded after it is changed. Off by default,
+// since the world is still drawn untextured by the VU1 programs, so
+// the levels would take memory and upload time and never be sampled.
+// Turn it on once the world surfaces are texture mapped.
+static cvar_t * r_ps2_mipmaps = NULL;
+
 //=============================================================================
 //
 // Texture image allocations and management:
@@ -152,6 +172,10 @@ void PS2_TexImageInit(void)
     r_ps2_skip_wall_tex_load   = Cvar_Get("r_ps2_skip_wall_tex_load",   "1", 0);
     r_ps2_skip_sky_tex_load    = Cvar_Get("r_ps2_skip_sky_tex_load",    "1", 0);
     r_ps2_skip_pic_tex_load    = Cvar_Get("r_ps2_skip_pic_tex_load",    "0", 0);
+    r_ps2_paletted_tex         = Cvar_Get("r_ps2_paletted_tex",         "1", 0);
+    r_ps2_mipmaps              = Cvar_Get("r_ps2_mipmaps",              "0", 0);
+
+    PS2_NameIndexInit(&ps2_teximage_index, ps2_teximage_slots, PS2_NAME_INDEX_SLOTS(MAX_TEXIMAGES));
 
     //
     // Create the built-in textures:
@@ -254,21 +278,27 @@ void PS2_TexImageFree(ps2_teximage_t * teximage)
     // Built-ins will always be referencing static program data.
     if (teximage->pic != NULL && teximage->type != IT_BUILTIN)
     {
-        int size_bytes;
+        int bytes_per_pixel;
         switch (teximage->texbuf.psm)
         {
         case GS_PSM_32 :
-            size_bytes = (teximage->width * teximage->height * 4);
+            bytes_per_pixel = 4;
             break;
         case GS_PSM_16 :
-            size_bytes = (teximage->width * teximage->height * 2);
+            bytes_per_pixel = 2;
             break;
         default : // Assume 8bits palettized.
-            size_bytes = (teximage->width * teximage->height * 1);
+            bytes_per_pixel = 1;
             break;
         } // switch (teximage->texbuf.psm)
 
+        const int size_bytes = Img_MipChainBytes(teximage->width, teximage->height,
+                                                 teximage->mip_levels, bytes_per_pixel);
+        ps2_teximage_mip_bytes -= size_bytes - (teximage->width * teximage->height * bytes_per_pixel);
+
+        PS2_TexImageVRamRelease(teximage->pic);
         PS2_MemFree(teximage->pic, size_bytes, MEMTAG_TEXIMAGE);
+        PS2_NameIndexRemove(&ps2_teximage_index, teximage->hash, teximage - ps2ref.teximages);
         PS2_MemClearObj(teximage);
         --ps2_teximages_used;
     }
@@ -295,6 +325,19 @@ void PS2_TexImageFreeUnused(void)
             ++ps2_unused_teximages_freed;
         }
     }
+
+    // Get rid of the tombstones left by the images just freed.
+    if (PS2_NameIndexNeedsRebuild(&ps2_teximage_index))
+    {
+        PS2_NameIndexClear(&ps2_teximage_index);
+        for (i = 0, teximage_iter = ps2ref.teximages; i < MAX_TEXIMAGES; ++i, ++teximage_iter)
+        {
+            if (teximage_iter->type != IT_NULL)
+            {
+                PS2_NameIndexInsert(&ps2_teximage_index, teximage_iter->hash, i);
+            }
+        }
+    }
 }
 
 /*
@@ -348,15 +391,43 @@ static inline int RoundToPowerOfTwo(int x)
     */
 }
 
+/*
+==============
+SetupMipmaps
+
+Remarks: Local function.
+Sets the image up to sample from all the levels in its pic.
+==============
+*/
+static void SetupMipmaps(ps2_teximage_t * teximage, int mip_levels)
+{
+    ps2_mip_layout_t mips;
+    const int bits_per_pixel = (teximage->texbuf.psm == GS_PSM_32) ? 32 :
+                               (teximage->texbuf.psm == GS_PSM_16) ? 16 : 8;
+
+    // Level 0 has the buffer width of the layout, which is
+    // different from a single level image when it shares a page.
+    Img_MipLayout(teximage->width, teximage->height, bits_per_pixel, mip_levels, &mips);
+    teximage->texbuf.width = mips.buffer_width[0];
+    teximage->mip_levels   = mip_levels;
+
+    ps2_teximage_mip_bytes += Img_MipChainBytes(teximage->width, teximage->height, mip_levels, bits_per_pixel / 8) -
+                              (teximage->width * teximage->height * (bits_per_pixel / 8));
+}
+
 /*
 ==============
 Common8BitTexSetup
 
 Remarks: Local function.
+'levels' are the mipmaps of a WAL, largest first, each
+half the size of the previous. PCX images only have one.
 ==============
 */
-static ps2_teximage_t * Common8BitTexSetup(const byte * pic8, int width, int height, const char * name, int flags)
+static ps2_teximage_t * Common8BitTexSetup(const byte * const * levels, int num_levels,
+                                           int width, int height, const char * name, int flags)
 {
+    int i;
     byte * expanded_pic;
     byte * scaled_pic;
     ps2_teximage_t * teximage;
@@ -365,6 +436,30 @@ static ps2_teximage_t * Common8BitTexSetup(const byte * pic8, int width, int hei
     int format     = TEXTURE_COMPONENTS_RGB;
     int mag_filter = LOD_MAG_LINEAR;
     int min_filter = LOD_MIN_LINEAR;
+    const byte * pic8 = levels[0];
+
+    // IT_BUILTIN is only used internally as a type.
+    // Can't be present if loaded from file, so mask it off.
+    const int img_type = flags & (~IT_BUILTIN);
+
+    // Sprites can do with a cheaper filtering.
+    // Pics (2D UI elements and such) actually look better with nearest sampling.
+    if (img_type & (IT_PIC | IT_SPRITE))
+    {
+        mag_filter = LOD_MAG_NEAREST;
+        min_filter = LOD_MIN_NEAREST;
+    }
+
+    const img_8bit_format_t img_format = Img_Choose8BitFormat(pic8, width, height,
+                                                              (qboolean)r_ps2_paletted_tex->value,
+                                                              (qboolean)(mag_filter == LOD_MAG_NEAREST));
+
+    // Levels too small to send to the GS are dropped.
+    if (!r_ps2_mipmaps->value)
+    {
+        num_levels = 1;
+    }
+    num_levels = Img_NumMipLevels(width, height, num_levels);
 
     // Clamp down to our size limit or round to PoT. This will also force RGBA32.
     if (width  > MAX_TEXIMAGE_SIZE ||
@@ -386,49 +481,49 @@ static ps2_teximage_t * Common8BitTexSetup(const byte * pic8, int width, int hei
 
         PS2_MemFree(expanded_pic, (width * height * 4), MEMTAG_TEXIMAGE);
 
+        // The smaller levels don't match the resampled image anymore.
         width  = scaled_width;
         height = scaled_height;
+        num_levels = 1;
         expanded_pic = scaled_pic;
     }
-    else
+    else if (img_format == IMG_8BIT_INDEXED8)
     {
-        int i;
-        const int pixel_count = width * height;
-
-        // Check if the image has transparency, if so, we need 32bit color.
-        for (i = 0; i < pixel_count; ++i)
+        // Keep the indexes, colors come from the shared CLUT.
+        // The transparent index has zero alpha in the palette.
+        psm = GS_PSM_8;
+        if (Img_HasTransparency(pic8, width * height))
         {
-            if (pic8[i] == 255) // Transparent color
-            {
-                // Need 32bit RGBA.
-                psm    = GS_PSM_32;
-                format = TEXTURE_COMPONENTS_RGBA;
-                break;
-            }
+            format = TEXTURE_COMPONENTS_RGBA;
         }
 
-        if (format == TEXTURE_COMPONENTS_RGBA)
+        scaled_pic = expanded_pic = PS2_MemAlloc(Img_MipChainBytes(width, height, num_levels, 1), MEMTAG_TEXIMAGE);
+        for (i = 0; i < num_levels; ++i)
         {
-            expanded_pic = PS2_MemAlloc(width * height * 4, MEMTAG_TEXIMAGE);
-            Img_UnPalettize32(width, height, pic8, ps2_global_palette, expanded_pic);
+            memcpy(scaled_pic, levels[i], (width >> i) * (height >> i));
+            scaled_pic += (width >> i) * (height >> i);
         }
-        else // Use more compact 16bit RGB color.
+    }
+    else if (img_format == IMG_8BIT_RGBA32) // Has transparency, need 32bit color.
+    {
+        psm    = GS_PSM_32;
+        format = TEXTURE_COMPONENTS_RGBA;
+
+        scaled_pic = expanded_pic = PS2_MemAlloc(Img_MipChainBytes(width, height, num_levels, 4), MEMTAG_TEXIMAGE);
+        for (i = 0; i < num_levels; ++i)
         {
-            expanded_pic = PS2_MemAlloc(width * height * 2, MEMTAG_TEXIMAGE);
-            Img_UnPalettize16(width, height, pic8, ps2_global_palette, expanded_pic);
+            Img_UnPalettize32(width >> i, height >> i, levels[i], ps2_global_palette, scaled_pic);
+            scaled_pic += (width >> i) * (height >> i) * 4;
         }
     }
-
-    // IT_BUILTIN is only used internally as a type.
-    // Can't be present if loaded from file, so mask it off.
-    const int img_type = flags & (~IT_BUILTIN);
-
-    // Sprites can do with a cheaper filtering.
-    // Pics (2D UI elements and such) actually look better with nearest sampling.
-    if (img_type & (IT_PIC | IT_SPRITE))
+    else // Use more compact 16bit RGB color.
     {
-        mag_filter = LOD_MAG_NEAREST;
-        min_filter = LOD_MIN_NEAREST;
+        scaled_pic = expanded_pic = PS2_MemAlloc(Img_MipChainBytes(width, height, num_levels, 2), MEMTAG_TEXIMAGE);
+        for (i = 0; i < num_levels; ++i)
+        {
+            Img_UnPalettize16(width >> i, height >> i, levels[i], ps2_global_palette, scaled_pic);
+            scaled_pic += (width >> i) * (height >> i) * 2;
+        }
     }
 
     // Finally, allocate and set up the image handle:
@@ -436,6 +531,11 @@ static ps2_teximage_t * Common8BitTexSetup(const byte * pic8, int width, int hei
     PS2_TexImageSetup(teximage, name, width, height, format, TEXTURE_FUNCTION_MODULATE,
                       psm, mag_filter, min_filter, (ps2_imagetype_t)img_type, expanded_pic);
 
+    if (num_levels > 1)
+    {
+        SetupMipmaps(teximage, num_levels);
+    }
+
     return teximage;
 }
 
@@ -474,7 +574,7 @@ static ps2_teximage_t * LoadPcxImpl(const char * name, int flags)
     // Atlas full or image too big, create a standalone texture:
     if (teximage == NULL)
     {
-        teximage = Common8BitTexSetup(pic8, width, height, name, flags);
+        teximage = Common8BitTexSetup(&pic8, 1, width, height, name, flags);
     }
 
     // The palettized image is no longer needed.
@@ -495,7 +595,8 @@ static ps2_teximage_t * LoadWalImpl(const char * name, int flags)
 {
     ps2_teximage_t * teximage;
     const miptex_t * wall;
-    const byte     * pic8;
+    const byte     * levels[MIPLEVELS];
+    int num_levels;
     int width;
     int height;
     int offset;
@@ -510,10 +611,26 @@ static ps2_teximage_t * LoadWalImpl(const char * name, int flags)
 
     width  = LittleLong(wall->width);
     height = LittleLong(wall->height);
-    offset = LittleLong(wall->offsets[0]);
-    pic8   = (const byte *)wall + offset;
 
-    teximage = Common8BitTexSetup(pic8, width, height, name, flags | IT_WALL);
+    // Keep the smaller levels too, as long as they are in the file.
+    // Common8BitTexSetup drops the ones it can't use.
+    for (num_levels = 0; num_levels < MIPLEVELS && num_levels < PS2_MAX_MIP_LEVELS; ++num_levels)
+    {
+        offset = LittleLong(wall->offsets[num_levels]);
+        if (offset <= 0 || offset + (width >> num_levels) * (height >> num_levels) > data_len)
+        {
+            break;
+        }
+        levels[num_levels] = (const byte *)wall + offset;
+    }
+    if (num_levels == 0)
+    {
+        Com_DPrintf("WARNING: Bad WAL texture '%s'\n", name);
+        FS_FreeFile((void *)wall);
+        return NULL;
+    }
+
+    teximage = Common8BitTexSetup(levels, num_levels, width, height, name, flags | IT_WALL);
 
     FS_FreeFile((void *)wall);
 
@@ -589,27 +706,24 @@ static ps2_teximage_t * FindImageImpl(const char * name, int flags)
         return NULL;
     }
 
-    // Compare by hash code, much cheaper.
     const u32 name_hash = Sys_HashString(name);
 
     //
-    // First, lookup our cache:
+    // First, lookup our cache. Hashes can collide, so the names are compared too:
     //
     int i;
-    ps2_teximage_t * teximage_iter = ps2ref.teximages;
-    for (i = 0; i < MAX_TEXIMAGES; ++i, ++teximage_iter)
+    int cursor = 0;
+    while ((i = PS2_NameIndexNext(&ps2_teximage_index, name_hash, &cursor)) >= 0)
     {
-        if (teximage_iter->type == IT_NULL)
-        {
-            continue;
-        }
-        if ((name_hash == teximage_iter->hash) && (flags & teximage_iter->type))
+        ps2_teximage_t * teximage_iter = &ps2ref.teximages[i];
+        if ((flags & teximage_iter->type) && strcmp(teximage_iter->name, name) == 0)
         {
             if (ps2ref.registration_started)
             {
                 ++ps2_teximage_cache_hits;
             }
 
+            LTrace_Cache("image", name, true);
             teximage_iter->registration_sequence = ps2ref.registration_sequence;
             return teximage_iter;
         }
@@ -619,19 +733,26 @@ static ps2_teximage_t * FindImageImpl(const char * name, int flags)
     // Load from file for the first time:
     //
     ps2_teximage_t * new_image;
+    LTrace_Cache("image", name, false);
+
+    // The trace clock leaves out the FS_LoadFile time, which is traced on its own.
+    const unsigned int trace_start = LTrace_Start();
     const int start_time = Sys_Milliseconds();
     {
         if (strcmp(name + name_len - 4, ".pcx") == 0)
         {
             new_image = LoadPcxImpl(name, flags);
+            LTrace_Stage("pcx", name, 0, trace_start);
         }
         else if (strcmp(name + name_len - 4, ".wal") == 0)
         {
             new_image = LoadWalImpl(name, flags);
+            LTrace_Stage("wal", name, 0, trace_start);
         }
         else if (strcmp(name + name_len - 4, ".tga") == 0)
         {
             new_image = LoadTgaImpl(name, flags);
+            LTrace_Stage("tga", name, 0, trace_start);
         }
         else
         {
@@ -722,19 +843,24 @@ void PS2_TexImageSetup(ps2_teximage_t * teximage, const char * name, int w, int
         Sys_Error("Bad texture height (%d) for %s!", h, name);
     }
 
-    // All textures must share the same VRam space.
-    // What this means is that we only have enough VRam
-    // left for a single texture at a time, so every texture
-    // must be copied to VRam on-the-fly, prior to any use.
+    const qboolean was_indexed = (teximage->type != IT_NULL);
+
+    // Textures get a place in VRam when first uploaded (see tex_vram.c).
+    // Whatever copy is there of the old or new pixels is now out of date
+    // (the cinematic frame and the scrap atlas are set up again in place).
+    PS2_TexImageVRamRelease(teximage->pic);
+    PS2_TexImageVRamRelease(pic);
+
     teximage->texbuf.address         = ps2ref.vram_texture_start;
     teximage->pic                    = pic;
     teximage->width                  = w;
     teximage->height                 = h;
     teximage->mag_filter             = mag_filter;
     teximage->min_filter             = min_filter;
+    teximage->mip_levels             = 1; // See SetupMipmaps.
     teximage->type                   = type;
     teximage->texbuf.psm             = psm;
-    teximage->texbuf.width           = w;
+    teximage->texbuf.width           = (psm == GS_PSM_8 && w < 128) ? 128 : w; // PSM_8 needs an even TBW.
     teximage->texbuf.info.width      = draw_log2(w);
     teximage->texbuf.info.height     = draw_log2(h);
     teximage->texbuf.info.components = components;
@@ -744,9 +870,15 @@ void PS2_TexImageSetup(ps2_teximage_t * teximage, const char * name, int w, int
     // These are only used by the scrap atlas:
     teximage->u0 = teximage->u1      = 0;
     teximage->v0 = teximage->v1      = 0;
-    // Finally, copy and hash the name string:
+    // Finally, copy and hash the name string.
+    // Images set up again (e.g. the cinematic frame) are re-indexed under the new name.
+    if (was_indexed)
+    {
+        PS2_NameIndexRemove(&ps2_teximage_index, teximage->hash, teximage - ps2ref.teximages);
+    }
     strncpy(teximage->name, name, MAX_QPATH);
     teximage->hash = Sys_HashString(name);
+    PS2_NameIndexInsert(&ps2_teximage_index, teximage->hash, teximage - ps2ref.teximages);
 }
 
 /*
@@ -0,0 +1,179 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: tex_mipmap.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Mipmap chain sizes and their layout in GS VRam.
+ *
+ * The GS addresses every mip level on its own, with a base pointer (in 256 bytes blocks)
+ * and a buffer width, so the levels can go anywhere, but texels are swizzled in blocks
+ * and pages, so a level placed at an arbitrary block will overlap the others. Levels as
+ * big as a page in either dimension take their own pages. The smaller ones share a page:
+ * blocks inside a page are numbered by interleaving the bits of their x and y, so a level
+ * placed at a block position aligned to its own size in blocks keeps to its rectangle.
+ *
+ * Doesn't touch the GS, so it is also built on the host for ps2/tests/test_tex_mipmap.c.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "ps2/ref_ps2.h"
+
+// Page and block sizes in pixels for the texture formats we use.
+typedef struct
+{
+    int page_w, page_h;
+    int block_w, block_h;
+    qboolean y_first; // Block numbers interleave y before x (PSMCT16).
+} ps2_gs_layout_t;
+
+static const ps2_gs_layout_t ps2_layout_32 = { 64,  32, 8,  8, false };
+static const ps2_gs_layout_t ps2_layout_16 = { 64,  64, 16, 8, true  };
+static const ps2_gs_layout_t ps2_layout_8  = { 128, 64, 16, 16, false };
+
+/*
+==============
+Mip_GetLayout
+
+Remarks: Local function.
+==============
+*/
+static const ps2_gs_layout_t * Mip_GetLayout(int bits_per_pixel)
+{
+    switch (bits_per_pixel)
+    {
+    case 32 : return &ps2_layout_32;
+    case 16 : return &ps2_layout_16;
+    case 8  : return &ps2_layout_8;
+    default :
+        Sys_Error("Mip_GetLayout: Unsupported pixel size %d!", bits_per_pixel);
+        return NULL;
+    } // switch (bits_per_pixel)
+}
+
+/*
+==============
+Mip_BlockNumber
+
+Remarks: Local function.
+Number of the block at (bx, by) inside a page.
+==============
+*/
+static int Mip_BlockNumber(const ps2_gs_layout_t * layout, int bx, int by)
+{
+    int bit, out = 0;
+    int a = layout->y_first ? by : bx;
+    int b = layout->y_first ? bx : by;
+
+    // 32 blocks per page, alternating bits of each coordinate.
+    for (bit = 0; bit < 5; ++bit)
+    {
+        if ((bit & 1) == 0)
+        {
+            out |= (a & 1) << bit;
+            a >>= 1;
+        }
+        else
+        {
+            out |= (b & 1) << bit;
+            b >>= 1;
+        }
+    }
+    return out;
+}
+
+/*
+==============
+Img_NumMipLevels
+
+Levels go down to 8x8, the smallest image we can send in one GS
+transfer at 8bits per pixel (64 bytes, a multiple of a qword).
+==============
+*/
+int Img_NumMipLevels(int width, int height, int max_levels)
+{
+    int levels = 1;
+    while (levels < max_levels && (width >> levels) >= 8 && (height >> levels) >= 8)
+    {
+        ++levels;
+    }
+    return levels;
+}
+
+/*
+==============
+Img_MipChainBytes
+==============
+*/
+int Img_MipChainBytes(int width, int height, int num_levels, int bytes_per_pixel)
+{
+    int i, bytes = 0;
+    for (i = 0; i < num_levels; ++i)
+    {
+        bytes += (width >> i) * (height >> i) * bytes_per_pixel;
+    }
+    return bytes;
+}
+
+/*
+==============
+Img_MipLayout
+==============
+*/
+void Img_MipLayout(int width, int height, int bits_per_pixel, int num_levels, ps2_mip_layout_t * mips)
+{
+    int i;
+    int next_page = 0;  // First page after the ones used so far.
+    int tail_page = -1; // Page shared by the levels smaller than a page.
+    int tail_x    = 0;  // Next free block in the tail page. Levels only
+                        // get smaller, so they always fit in one row.
+
+    const ps2_gs_layout_t * layout = Mip_GetLayout(bits_per_pixel);
+    const int page_blocks_w = layout->page_w / layout->block_w;
+
+    if (num_levels < 1 || num_levels > PS2_MAX_MIP_LEVELS)
+    {
+        Sys_Error("Img_MipLayout: Bad level count %d!", num_levels);
+    }
+
+    mips->num_levels = num_levels;
+    for (i = 0; i < num_levels; ++i)
+    {
+        const int w = width  >> i;
+        const int h = height >> i;
+
+        if (w >= layout->page_w || h >= layout->page_h)
+        {
+            // Whole pages, same as a texture of its own.
+            const int buffer_w = (w + layout->page_w - 1) & ~(layout->page_w - 1);
+            const int pages_h  = (h + layout->page_h - 1) / layout->page_h;
+
+            mips->offset[i]       = next_page * PS2_VRAM_PAGE_WORDS;
+            mips->buffer_width[i] = buffer_w;
+            next_page += (buffer_w / layout->page_w) * pages_h;
+        }
+        else
+        {
+            // Power of two sizes, so these are too, and the running
+            // tail_x is always a multiple of the current level's width.
+            const int blocks_w = (w + layout->block_w - 1) / layout->block_w;
+
+            if (tail_page < 0)
+            {
+                tail_page = next_page++;
+            }
+            if (tail_x + blocks_w > page_blocks_w)
+            {
+                Sys_Error("Img_MipLayout: Levels of %dx%d don't fit a page!", width, height);
+            }
+
+            mips->offset[i] = tail_page * PS2_VRAM_PAGE_WORDS +
+                              Mip_BlockNumber(layout, tail_x, 0) * PS2_VRAM_BLOCK_WORDS;
+            mips->buffer_width[i] = layout->page_w;
+            tail_x += blocks_w;
+        }
+    }
+
+    mips->num_pages = next_page;
+}
@@ -0,0 +1,105 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: tex_palette.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Helpers for the 8bits palettized (PSM_T8 + CLUT) texture path.
+ *
+ * These don't touch the GS, so they are also built on the host (make host-bench)
+ * for the conversion tests in ps2/tests/test_tex_palette.c.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "ps2/ref_ps2.h"
+
+/*
+==============
+Img_HasTransparency
+
+Index 255 is the transparent color of the Quake 2 palette.
+==============
+*/
+qboolean Img_HasTransparency(const byte * pic8in, int pixel_count)
+{
+    int i;
+    for (i = 0; i < pixel_count; ++i)
+    {
+        if (pic8in[i] == 255)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+==============
+Img_Choose8BitFormat
+
+Sizes that are not a power of two or above MAX_TEXIMAGE_SIZE have to be
+resampled, which needs real colors, so they go to RGBA32. Transparent images
+that are sampled with linear filtering also stay in RGBA32, since Img_UnPalettize32
+fills the transparent texels with the color of a neighbor to avoid dark fringes,
+which can't be done with a shared CLUT. Everything else can sample the palette.
+==============
+*/
+img_8bit_format_t Img_Choose8BitFormat(const byte * pic8in, int width, int height,
+                                       qboolean allow_indexed, qboolean nearest_filter)
+{
+    if (width  > MAX_TEXIMAGE_SIZE || (width  & (width  - 1)) != 0 ||
+        height > MAX_TEXIMAGE_SIZE || (height & (height - 1)) != 0)
+    {
+        return IMG_8BIT_RGBA32;
+    }
+
+    if (Img_HasTransparency(pic8in, width * height))
+    {
+        return (allow_indexed && nearest_filter) ? IMG_8BIT_INDEXED8 : IMG_8BIT_RGBA32;
+    }
+
+    return allow_indexed ? IMG_8BIT_INDEXED8 : IMG_8BIT_RGB16;
+}
+
+/*
+==============
+Img_8BitFormatBytes
+==============
+*/
+int Img_8BitFormatBytes(img_8bit_format_t format)
+{
+    switch (format)
+    {
+    case IMG_8BIT_INDEXED8 :
+        return 1;
+    case IMG_8BIT_RGB16 :
+        return 2;
+    default :
+        return 4;
+    } // switch (format)
+}
+
+/*
+==============
+Img_SwizzleClut32
+
+The GS reads a 256 colors CSM1 CLUT with bits 3 and 4 of the
+index swapped, so in every group of 32 entries, entries 8-15
+trade places with 16-23. Swizzling twice restores the input.
+==============
+*/
+void Img_SwizzleClut32(const u32 * restrict palette, u32 * restrict clut_out)
+{
+    int i, j;
+    for (i = 0; i < 256; i += 32)
+    {
+        for (j = 0; j < 8; ++j)
+        {
+            clut_out[i + j]      = palette[i + j];
+            clut_out[i + j + 8]  = palette[i + j + 16];
+            clut_out[i + j + 16] = palette[i + j + 8];
+            clut_out[i + j + 24] = palette[i + j + 24];
+        }
+    }
+}
@@ -0,0 +1,262 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: tex_vram.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Keeps texture images resident in GS VRam between binds, with LRU eviction.
+ *
+ * The VRam after the screen buffers is split in pages (8KB each, the unit the GS
+ * lays textures out in), and each image takes a run of whole pages. Images are
+ * identified by their pixels pointer, so the scrap atlas images, which all share
+ * the same pixels, also share a single copy in VRam.
+ *
+ * Only does the bookkeeping, the uploads are done by PS2_TexImageVRamUpload, so
+ * this is also built on the host for the tests in ps2/tests/test_tex_vram.c.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "ps2/ref_ps2.h"
+
+enum
+{
+    MAX_VRAM_TEX_PAGES = PS2_VRAM_SIZE_WORDS / PS2_VRAM_PAGE_WORDS,
+    MAX_VRAM_TEX_SLOTS = MAX_VRAM_TEX_PAGES // At least one page per image.
+};
+
+typedef struct
+{
+    const void * pic;
+    u32 last_used; // ps2_vram_frame of the last Acquire.
+    u16 first_page;
+    u16 num_pages;
+} ps2_vram_slot_t;
+
+// Resident images. Kept packed, the first ps2_vram_num_slots are in use.
+static ps2_vram_slot_t ps2_vram_slots[MAX_VRAM_TEX_SLOTS];
+static int ps2_vram_num_slots = 0;
+
+// Non-zero for the pages taken by an image.
+static byte ps2_vram_page_used[MAX_VRAM_TEX_PAGES];
+
+static u32 ps2_vram_start      = 0;
+static int ps2_vram_pages      = 0;
+static int ps2_vram_pages_used = 0;
+static u32 ps2_vram_frame      = 0;
+
+static ps2_tex_vram_stats_t ps2_vram_frame_stats; // Being counted.
+static ps2_tex_vram_stats_t ps2_vram_last_stats;  // Last complete frame.
+
+/*
+==============
+PS2_TexVRamInit
+==============
+*/
+void PS2_TexVRamInit(u32 start, int num_pages)
+{
+    if (num_pages <= 0 || num_pages > MAX_VRAM_TEX_PAGES)
+    {
+        Sys_Error("PS2_TexVRamInit: Bad page count %d!", num_pages);
+    }
+
+    ps2_vram_start = start;
+    ps2_vram_pages = num_pages;
+    ps2_vram_frame = 0;
+
+    memset(&ps2_vram_frame_stats, 0, sizeof(ps2_vram_frame_stats));
+    memset(&ps2_vram_last_stats,  0, sizeof(ps2_vram_last_stats));
+    PS2_TexVRamReset();
+}
+
+/*
+==============
+PS2_TexVRamReset
+==============
+*/
+void PS2_TexVRamReset(void)
+{
+    memset(ps2_vram_page_used, 0, sizeof(ps2_vram_page_used));
+    ps2_vram_num_slots  = 0;
+    ps2_vram_pages_used = 0;
+}
+
+/*
+==============
+PS2_TexVRamBeginFrame
+==============
+*/
+void PS2_TexVRamBeginFrame(void)
+{
+    ps2_vram_last_stats = ps2_vram_frame_stats;
+    memset(&ps2_vram_frame_stats, 0, sizeof(ps2_vram_frame_stats));
+    ++ps2_vram_frame;
+}
+
+/*
+==============
+VRam_FreeSlot
+
+Remarks: Local function.
+==============
+*/
+static void VRam_FreeSlot(int index)
+{
+    ps2_vram_slot_t * slot = &ps2_vram_slots[index];
+
+    memset(&ps2_vram_page_used[slot->first_page], 0, slot->num_pages);
+    ps2_vram_pages_used -= slot->num_pages;
+
+    // Keep the array packed.
+    *slot = ps2_vram_slots[--ps2_vram_num_slots];
+}
+
+/*
+==============
+VRam_FindSlot
+
+Remarks: Local function.
+==============
+*/
+static int VRam_FindSlot(const void * pic)
+{
+    int i;
+    for (i = 0; i < ps2_vram_num_slots; ++i)
+    {
+        if (ps2_vram_slots[i].pic == pic)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+==============
+VRam_FindFreePages
+
+Remarks: Local function.
+First fit. Returns the first page of the run or -1.
+==============
+*/
+static int VRam_FindFreePages(int num_pages)
+{
+    int i;
+    int run = 0;
+    for (i = 0; i < ps2_vram_pages; ++i)
+    {
+        run = ps2_vram_page_used[i] ? 0 : run + 1;
+        if (run == num_pages)
+        {
+            return i - num_pages + 1;
+        }
+    }
+    return -1;
+}
+
+/*
+==============
+VRam_EvictLRU
+
+Remarks: Local function.
+==============
+*/
+static void VRam_EvictLRU(void)
+{
+    int i;
+    int oldest = 0;
+    for (i = 1; i < ps2_vram_num_slots; ++i)
+    {
+        if (ps2_vram_slots[i].last_used < ps2_vram_slots[oldest].last_used)
+        {
+            oldest = i;
+        }
+    }
+
+    VRam_FreeSlot(oldest);
+    ps2_vram_frame_stats.evictions++;
+}
+
+/*
+==============
+PS2_TexVRamAcquire
+
+Images used earlier in the current frame can be evicted too. That's
+fine as long as the uploads go down the same GIF stream as the draws,
+since the GS will be done with the old pixels by the time they are
+overwritten. It only means they get uploaded again if used later.
+==============
+*/
+qboolean PS2_TexVRamAcquire(const void * pic, int num_pages, u32 upload_bytes, u32 * address)
+{
+    int first_page;
+    ps2_vram_slot_t * slot;
+
+    int index = VRam_FindSlot(pic);
+    if (index >= 0)
+    {
+        slot = &ps2_vram_slots[index];
+        if (slot->num_pages == num_pages)
+        {
+            slot->last_used = ps2_vram_frame;
+            *address = ps2_vram_start + slot->first_page * PS2_VRAM_PAGE_WORDS;
+            ps2_vram_frame_stats.hits++;
+            return true;
+        }
+
+        // Same pixels with a different layout, e.g. the cinematic frame.
+        VRam_FreeSlot(index);
+    }
+
+    if (num_pages <= 0 || num_pages > ps2_vram_pages)
+    {
+        Sys_Error("PS2_TexVRamAcquire: Image doesn't fit in VRam (%d pages)!", num_pages);
+    }
+
+    // Every image takes at least a page, so there's always a free slot once there's room.
+    while ((first_page = VRam_FindFreePages(num_pages)) < 0)
+    {
+        VRam_EvictLRU();
+    }
+
+    slot = &ps2_vram_slots[ps2_vram_num_slots++];
+    slot->pic        = pic;
+    slot->last_used  = ps2_vram_frame;
+    slot->first_page = (u16)first_page;
+    slot->num_pages  = (u16)num_pages;
+
+    memset(&ps2_vram_page_used[first_page], 1, num_pages);
+    ps2_vram_pages_used += num_pages;
+
+    ps2_vram_frame_stats.misses++;
+    ps2_vram_frame_stats.upload_bytes += upload_bytes;
+
+    *address = ps2_vram_start + first_page * PS2_VRAM_PAGE_WORDS;
+    return false;
+}
+
+/*
+==============
+PS2_TexVRamRelease
+==============
+*/
+void PS2_TexVRamRelease(const void * pic)
+{
+    const int index = VRam_FindSlot(pic);
+    if (index >= 0)
+    {
+        VRam_FreeSlot(index);
+    }
+}
+
+/*
+==============
+PS2_TexVRamGetStats
+==============
+*/
+void PS2_TexVRamGetStats(ps2_tex_vram_stats_t * stats)
+{
+    *stats = ps2_vram_last_stats;
+    stats->pages_used  = ps2_vram_pages_used;
+    stats->pages_total = ps2_vram_pages;
+}
@@ -0,0 +1,316 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: vert_pack.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Packed vertex formats for the VU1 batches and the VIF codes to expand them.
+ *
+ * The VIF widens every UNPACK element to a 32 bits VU memory field on its own, so a vertex
+ * doesn't need to travel as two V4_32 qwords. Colors go as V4_8, which lands in VU memory
+ * exactly as the RGBAQ register wants it in PACKED mode. Positions go as V3_16, integers
+ * in steps of a power of two from a per-batch origin, that the VU program turns back to
+ * floats with ITOF0 and a multiply-add. A skipping write cycle (STCYCL WL=1, CL=2) puts
+ * colors and positions in alternate qwords, the same interleaving the GIF tag reads. It is
+ * set once per chain, so the per-batch header goes on alternate qwords too. The MVP matrix
+ * and the GS scales don't change between batches, so they are only sent with the chain.
+ *
+ * Batches go to the half of the VU1 double buffer that the running program isn't reading
+ * (UNPACK with the TOPS flag), so the VIF fills the next one while the VU transforms the
+ * last. The vertex count goes in ITOP, which the VIF hands to the program with the MSCAL.
+ *
+ * Doesn't touch the hardware, so it is also built on the host for ps2/tests/test_vert_pack.c.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "ps2/ref_ps2.h"
+
+// The VIF codes we need. vu_prog_mgr.h has these too, but only builds with the PS2DEV SDK.
+#define VERT_VIF_FLUSH                0x11000000
+#define VERT_VIF_STCYCL(wl, cl)       ((0x01 << 24) | ((wl) << 8) | (cl))
+#define VERT_VIF_OFFSET(qwords)       ((0x02 << 24) | (qwords))
+#define VERT_VIF_BASE(addr)           ((0x03 << 24) | (addr))
+#define VERT_VIF_ITOP(val)            ((0x04 << 24) | (val))
+#define VERT_VIF_MSCAL(addr)          ((0x14 << 24) | (addr))
+#define VERT_VIF_UNPACK(fmt, num, addr, usn) ((((u32)0x60 | (fmt)) << 24) | (((num) & 0xFF) << 16) | ((usn) << 14) | (addr))
+#define VERT_VIF_UNPACK_TOPS          (1 << 15) // OR'd to an UNPACK: address relative to the free half.
+
+// GIF tag with no data and EOP set, kicked after a batch to wait for it.
+#define VERT_GIFTAG_EMPTY_EOP         0x8000
+
+// UNPACK formats:
+#define VERT_VIF_V3_16 0x9
+#define VERT_VIF_V4_32 0xC
+#define VERT_VIF_V4_8  0xE
+
+// Same GS rasterizer scales the unpacked batches use.
+static const float vert_gs_scale_xy = 2048.0f;
+static const float vert_gs_scale_z  = ((float)0xFFFFFF) / 32.0f;
+
+/*
+==============
+Vert_FloatBits
+
+Remarks: Local function.
+==============
+*/
+static inline u32 Vert_FloatBits(float f)
+{
+    FU32_t f2i;
+    f2i.asFloat = f;
+    return f2i.asU32;
+}
+
+/*
+==============
+Vert_ClampS16
+
+Remarks: Local function.
+==============
+*/
+static inline s16 Vert_ClampS16(float f)
+{
+    const float r = floorf(f + 0.5f);
+    if (r > 32767.0f)
+    {
+        return 32767;
+    }
+    if (r < -32768.0f)
+    {
+        return -32768;
+    }
+    return (s16)r;
+}
+
+/*
+==============
+Vert_PosFrameFromPoints
+==============
+*/
+void Vert_PosFrameFromPoints(const float * positions, int num_verts, ps2_vert_pos_frame_t * frame)
+{
+    int i, j;
+    vec3_t mins, maxs;
+    float max_dist = 0.0f;
+
+    ClearBounds(mins, maxs);
+    for (i = 0; i < num_verts; ++i)
+    {
+        AddPointToBounds((vec_t *)&positions[i * 3], mins, maxs); // Doesn't write to it.
+    }
+
+    // A whole number origin keeps whole number positions exact.
+    for (j = 0; j < 3 && num_verts > 0; ++j)
+    {
+        frame->origin[j] = floorf((mins[j] + maxs[j]) * 0.5f + 0.5f);
+        if (maxs[j] - frame->origin[j] > max_dist)
+        {
+            max_dist = maxs[j] - frame->origin[j];
+        }
+        if (frame->origin[j] - mins[j] > max_dist)
+        {
+            max_dist = frame->origin[j] - mins[j];
+        }
+    }
+    if (num_verts <= 0)
+    {
+        VectorClear(frame->origin);
+    }
+
+    frame->step = 1.0f / PS2_VERT_POS_MIN_STEP_INV;
+    while ((max_dist / frame->step) + 0.5f > 32767.0f)
+    {
+        frame->step *= 2.0f;
+    }
+}
+
+/*
+==============
+Vert_PackPosition
+==============
+*/
+void Vert_PackPosition(const ps2_vert_pos_frame_t * frame, const float * position, s16 * out_xyz)
+{
+    const float inv_step = 1.0f / frame->step; // Exact, since the step is a power of two.
+    out_xyz[0] = Vert_ClampS16((position[0] - frame->origin[0]) * inv_step);
+    out_xyz[1] = Vert_ClampS16((position[1] - frame->origin[1]) * inv_step);
+    out_xyz[2] = Vert_ClampS16((position[2] - frame->origin[2]) * inv_step);
+}
+
+/*
+==============
+Vert_UnpackPosition
+==============
+*/
+void Vert_UnpackPosition(const ps2_vert_pos_frame_t * frame, const s16 * in_xyz, float * out_position)
+{
+    // ITOF0, then origin * 1 + xyz * step, like the VU program.
+    out_position[0] = frame->origin[0] + (float)in_xyz[0] * frame->step;
+    out_position[1] = frame->origin[1] + (float)in_xyz[1] * frame->step;
+    out_position[2] = frame->origin[2] + (float)in_xyz[2] * frame->step;
+}
+
+/*
+==============
+Vert_PackColor
+==============
+*/
+u32 Vert_PackColor(const byte * rgba)
+{
+    // The VIF reads the bytes in memory order, and the EE is little-endian.
+    return ((u32)rgba[0]) | ((u32)rgba[1] << 8) | ((u32)rgba[2] << 16) | ((u32)rgba[3] << 24);
+}
+
+/*
+==============
+Vert_UnpackColor
+==============
+*/
+void Vert_UnpackColor(u32 packed, byte * out_rgba)
+{
+    out_rgba[0] = (byte)(packed);
+    out_rgba[1] = (byte)(packed >> 8);
+    out_rgba[2] = (byte)(packed >> 16);
+    out_rgba[3] = (byte)(packed >> 24);
+}
+
+/*
+==============
+Vert_PackTexCoords
+==============
+*/
+void Vert_PackTexCoords(const float * st, const float * base, s16 * out_st)
+{
+    out_st[0] = Vert_ClampS16((st[0] - base[0]) * (1 << PS2_VERT_ST_FRAC_BITS));
+    out_st[1] = Vert_ClampS16((st[1] - base[1]) * (1 << PS2_VERT_ST_FRAC_BITS));
+}
+
+/*
+==============
+Vert_UnpackTexCoords
+==============
+*/
+void Vert_UnpackTexCoords(const s16 * in_st, const float * base, float * out_st)
+{
+    // ITOF12 on the VU.
+    out_st[0] = base[0] + (float)in_st[0] / (1 << PS2_VERT_ST_FRAC_BITS);
+    out_st[1] = base[1] + (float)in_st[1] / (1 << PS2_VERT_ST_FRAC_BITS);
+}
+
+/*
+==============
+Vert_PackedBatchWords
+==============
+*/
+int Vert_PackedBatchWords(int num_verts)
+{
+    // ITOP, UNPACK + 2 header qwords, UNPACK + a word per color,
+    // UNPACK + 3 halves per position, MSCAL.
+    return 1 + (1 + 2 * 4) + (1 + num_verts) + (1 + (num_verts * 3 + 1) / 2) + 1;
+}
+
+/*
+==============
+Vert_UnpackedBatchWords
+==============
+*/
+int Vert_UnpackedBatchWords(int num_verts)
+{
+    // ITOP, UNPACK + GIF tag qword + 2 qwords per vertex, MSCAL.
+    return 1 + (1 + 4 + num_verts * 8) + 1;
+}
+
+/*
+==============
+Vert_PackFrameHeader
+==============
+*/
+int Vert_PackFrameHeader(u32 * out, const float * mvp_matrix)
+{
+    int i;
+    u32 * p = out;
+
+    // Nothing from a previous chain may still be reading the constants.
+    *p++ = VERT_VIF_FLUSH;
+    *p++ = VERT_VIF_STCYCL(1, 1);
+    *p++ = VERT_VIF_UNPACK(VERT_VIF_V4_32, 6, PS2_VU_MVP_MATRIX, 0);
+    for (i = 0; i < 16; ++i)
+    {
+        *p++ = Vert_FloatBits(mvp_matrix[i]);
+    }
+    *p++ = Vert_FloatBits(vert_gs_scale_xy);
+    *p++ = Vert_FloatBits(vert_gs_scale_xy);
+    *p++ = Vert_FloatBits(vert_gs_scale_z);
+    *p++ = 0;
+    *p++ = VERT_GIFTAG_EMPTY_EOP;
+    *p++ = 0;
+    *p++ = 0;
+    *p++ = 0;
+
+    // Writing OFFSET also resets the VIF to the first half.
+    *p++ = VERT_VIF_BASE(PS2_VU_DBUF_BASE);
+    *p++ = VERT_VIF_OFFSET(PS2_VU_DBUF_SIZE);
+
+    // Write one qword, skip one, for all the batches that follow.
+    *p++ = VERT_VIF_STCYCL(1, 2);
+    return (int)(p - out);
+}
+
+/*
+==============
+Vert_PackBatch
+==============
+*/
+int Vert_PackBatch(u32 * out, const float * positions, const u32 * colors, int num_verts,
+                   u64 giftag, u64 giftag_regs, int vu_prog_addr)
+{
+    int i;
+    u32 * p = out;
+    s16 * halves;
+    ps2_vert_pos_frame_t frame;
+
+    if (num_verts <= 0 || num_verts > PS2_VU_PACKED_MAX_VERTS)
+    {
+        Sys_Error("Vert_PackBatch: Bad vertex count %d!", num_verts);
+    }
+
+    Vert_PosFrameFromPoints(positions, num_verts, &frame);
+
+    // No FLUSH: this goes to the other half while the VU runs the
+    // previous batch, and the MSCAL waits for it to end on its own.
+    *p++ = VERT_VIF_ITOP(num_verts);
+
+    // Header: origin + step, GIF tag + register list.
+    *p++ = VERT_VIF_UNPACK(VERT_VIF_V4_32, 2, PS2_VU_PACKED_POS_ORIGIN, 0) | VERT_VIF_UNPACK_TOPS;
+    *p++ = Vert_FloatBits(frame.origin[0]);
+    *p++ = Vert_FloatBits(frame.origin[1]);
+    *p++ = Vert_FloatBits(frame.origin[2]);
+    *p++ = Vert_FloatBits(frame.step);
+    *p++ = (u32)giftag;
+    *p++ = (u32)(giftag >> 32);
+    *p++ = (u32)giftag_regs;
+    *p++ = (u32)(giftag_regs >> 32);
+
+    // Vertexes: colors and positions interleaved by the write cycle.
+    *p++ = VERT_VIF_UNPACK(VERT_VIF_V4_8, num_verts, PS2_VU_PACKED_START_COLOR, 1) | VERT_VIF_UNPACK_TOPS;
+    for (i = 0; i < num_verts; ++i)
+    {
+        *p++ = colors[i];
+    }
+
+    *p++ = VERT_VIF_UNPACK(VERT_VIF_V3_16, num_verts, PS2_VU_PACKED_START_VERT, 0) | VERT_VIF_UNPACK_TOPS;
+    halves = (s16 *)p;
+    for (i = 0; i < num_verts; ++i)
+    {
+        Vert_PackPosition(&frame, &positions[i * 3], &halves[i * 3]);
+    }
+    if ((num_verts * 3) & 1)
+    {
+        halves[num_verts * 3] = 0; // Pad to a whole word.
+    }
+    p += (num_verts * 3 + 1) / 2;
+
+    *p++ = VERT_VIF_MSCAL(vu_prog_addr);
+    return (int)(p - out);
+}
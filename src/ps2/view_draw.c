@@ -11,14 +11,21 @@
  * ================================================================================================ */
 
 #include "common/q_common.h"
+#include "common/q_prof.h"
 #include "ps2/ref_ps2.h"
 #include "ps2/mem_alloc.h"
 #include "ps2/model_load.h"
 #include "ps2/math_funcs.h"
 #include "ps2/vec_mat.h"
 #include "ps2/vu1.h"
+#include "ps2/vu_prog_mgr.h"
+#include "ps2/dma_mgr.h"
 #include "ps2/gs_defs.h"
 
+// PS2DEV SDK:
+#include <kernel.h>
+#include <dma.h>
+
 //
 // ---------------------------
 // NOTES ON THE VIEW RENDERING
@@ -42,6 +49,7 @@
 // Frame counters used to mark drawable surfaces:
 int ps2_vis_frame_count   = 0; // Bumped when going to a new PVS
 int ps2_frame_count       = 0; // Used for dlight push checking
+static int ps2_marked_frame_count = -1; // Last frame PS2_MarkLeaves ran, since the cached vis path skips it.
 
 // Quake 2 viewcluster stuff:
 // PS2_BeginRegistration() has to reset them to -1.
@@ -67,9 +75,12 @@ static m_mat4_t ps2_mvp_matrix;
 // View frustum for the frame, so we can cull bounding boxes out of view.
 static cplane_t ps2_frustum[4];
 
-// Buffer to decompress a cluster PVS.
-// Alignment not strictly necessary, but might help the compiler since PS2 likes aligned data.
-static byte ps2_dvis_pvs[MAX_MAP_LEAFS / 8] PS2_ALIGN(16);
+// Draw the world from the cached visible sets (see world_vis.c); "1" by default.
+static cvar_t * r_ps2_vis_cache = NULL;
+
+// Surfaces PS2_WorldVisGather() found visible this frame. Grows to the largest visible set.
+static ps2_mdl_surface_t ** ps2_vis_surfaces = NULL;
+static int ps2_vis_surfaces_size = 0;
 
 // Color table used for debug coloring of surfaces.
 static const int NUM_DEBUG_COLORS = 25;
@@ -284,67 +295,6 @@ static const ps2_mdl_leaf_t * PS2_FindLeafNodeForPoint(const vec3_t p, const ps2
     return NULL;
 }
 
-/*
-================
-PS2_DecompressModelVis
-
-Remarks: Local function.
-Returned pointer is a local shared buffer, so don't hold on to it!
-================
-*/
-static byte * PS2_DecompressModelVis(const byte * in, const ps2_model_t * model)
-{
-    int row = (model->vis->numclusters + 7) >> 3;
-    byte * out = ps2_dvis_pvs;
-
-    if (in == NULL)
-    {
-        // No vis info, so make all visible:
-        while (row)
-        {
-            *out++ = 0xFF;
-            row--;
-        }
-        return ps2_dvis_pvs;
-    }
-
-    do
-    {
-        if (*in)
-        {
-            *out++ = *in++;
-            continue;
-        }
-
-        int c = in[1];
-        in += 2;
-        while (c)
-        {
-            *out++ = 0;
-            c--;
-        }
-    } while (out - ps2_dvis_pvs < row);
-
-    return ps2_dvis_pvs;
-}
-
-/*
-================
-PS2_GetClusterPVS
-
-Remarks: Local function.
-================
-*/
-static inline byte * PS2_GetClusterPVS(int cluster, const ps2_model_t * model)
-{
-    if (cluster == -1 || model->vis == NULL)
-    {
-        memset(ps2_dvis_pvs, 0xFF, sizeof(ps2_dvis_pvs)); // All visible.
-        return ps2_dvis_pvs;
-    }
-    return PS2_DecompressModelVis((const byte *)model->vis + model->vis->bitofs[cluster][DVIS_PVS], model);
-}
-
 /*
 ================
 PS2_MarkLeaves
@@ -354,9 +304,12 @@ Mark the leaves and nodes that are in the PVS for the current cluster.
 */
 static void PS2_MarkLeaves(ps2_model_t * world_mdl)
 {
+    const qboolean marked_last_frame = (ps2_marked_frame_count == ps2_frame_count - 1);
+    ps2_marked_frame_count = ps2_frame_count;
+
     if (ps2_old_view_cluster  == ps2_view_cluster  &&
         ps2_old_view_cluster2 == ps2_view_cluster2 &&
-        ps2_view_cluster != -1)
+        ps2_view_cluster != -1 && marked_last_frame)
     {
         return;
     }
@@ -380,22 +333,8 @@ static void PS2_MarkLeaves(ps2_model_t * world_mdl)
         return;
     }
 
-    byte * vis = PS2_GetClusterPVS(ps2_view_cluster, world_mdl);
-    byte fat_vis[MAX_MAP_LEAFS / 8] PS2_ALIGN(16);
-
-    // May have to combine two clusters because of solid water boundaries:
-    if (ps2_view_cluster2 != ps2_view_cluster)
-    {
-        memcpy(fat_vis, vis, (world_mdl->num_leafs + 7) / 8);
-        vis = PS2_GetClusterPVS(ps2_view_cluster2, world_mdl);
-
-        const int c = (world_mdl->num_leafs + 31) / 32;
-        for (i = 0; i < c; ++i)
-        {
-            ((int *)fat_vis)[i] |= ((int *)vis)[i];
-        }
-        vis = fat_vis;
-    }
+    // Merges the two clusters if we are on a solid water boundary.
+    const byte * vis = PS2_WorldVisClusterPVS(world_mdl, ps2_view_cluster, ps2_view_cluster2);
 
     ps2_mdl_leaf_t * leaf;
     for (i = 0, leaf = world_mdl->leafs; i < world_mdl->num_leafs; ++i, ++leaf)
@@ -576,6 +515,48 @@ static void PS2_RecursiveWorldNode(const refdef_t * view_def, ps2_model_t * worl
     PS2_RecursiveWorldNode(view_def, world_mdl, node->children[!side]);
 }
 
+/*
+================
+PS2_AddCachedWorldSurfaces
+
+Remarks: Local function.
+Same as PS2_MarkLeaves + PS2_RecursiveWorldNode, from the cached visible
+set of the view clusters (see world_vis.c). Only the frustum and facing
+tests run every frame, then the surfaces go to their texture chains.
+================
+*/
+static void PS2_AddCachedWorldSurfaces(const refdef_t * view_def, const ps2_model_t * world_mdl)
+{
+    const ps2_world_vis_t * vis = PS2_WorldVisFind(world_mdl, ps2_view_cluster, ps2_view_cluster2, view_def->areabits);
+
+    if (vis->num_surfaces > ps2_vis_surfaces_size)
+    {
+        if (ps2_vis_surfaces != NULL)
+        {
+            PS2_MemFree(ps2_vis_surfaces, ps2_vis_surfaces_size * sizeof(ps2_mdl_surface_t *), MEMTAG_RENDERER);
+        }
+        ps2_vis_surfaces_size = vis->num_surfaces;
+        ps2_vis_surfaces = PS2_MemAlloc(ps2_vis_surfaces_size * sizeof(ps2_mdl_surface_t *), MEMTAG_RENDERER);
+    }
+
+    int i;
+    const int num_surfaces = PS2_WorldVisGather(vis, ps2_frustum, 4, view_def->vieworg, ps2_frame_count, ps2_vis_surfaces);
+
+    // Backwards, so that each chain keeps the cached order.
+    for (i = num_surfaces - 1; i >= 0; --i)
+    {
+        ps2_mdl_surface_t * surf = ps2_vis_surfaces[i];
+        ps2_teximage_t * image = PS2_TextureAnimation(surf->texinfo);
+        if (image == NULL)
+        {
+            Sys_Error("PS2_AddCachedWorldSurfaces: Null tex image!");
+        }
+
+        surf->texture_chain  = image->texture_chain;
+        image->texture_chain = surf;
+    }
+}
+
 /*
 ================
 PS2_DrawBrushModel
@@ -594,11 +575,17 @@ static void PS2_DrawBrushModel(const entity_t * ent)
 extern void VU1Prog_Color_Triangles_CodeStart VU_DATA_SECTION;
 extern void VU1Prog_Color_Triangles_CodeEnd   VU_DATA_SECTION;
 
+extern void VU1Prog_Color_Triangles_Packed_CodeStart VU_DATA_SECTION;
+extern void VU1Prog_Color_Triangles_Packed_CodeEnd   VU_DATA_SECTION;
+
 static qboolean vu_prog_set = false;
+static int vu_packed_prog_addr = 0; // Micromem address of VU1Prog_Color_Triangles_Packed.
 void SetVUProg(void)
 {
     if (vu_prog_set) { return; }
-    VU1_UploadProg(0, &VU1Prog_Color_Triangles_CodeStart, &VU1Prog_Color_Triangles_CodeEnd);
+    // The packed program goes right after the first one.
+    vu_packed_prog_addr = VU1_UploadProg(0, &VU1Prog_Color_Triangles_CodeStart, &VU1Prog_Color_Triangles_CodeEnd);
+    VU1_UploadProg(vu_packed_prog_addr, &VU1Prog_Color_Triangles_Packed_CodeStart, &VU1Prog_Color_Triangles_Packed_CodeEnd);
     vu_prog_set = true;
 }
 
@@ -608,16 +595,17 @@ static const u64 VERTEX_FORMAT = (((u64)GS_REG_RGBAQ) << 0) | (((u64)GS_REG_XYZ2
 // Number of elements in a vertex; (color + position) in our case:
 static const int NUM_VERTEX_ELEMENTS = 2;
 
-// Simple struct to hold the temporary DMA buffer we need
-// to send per draw list info to the Vector Unit 1.
+// Constants the Vector Unit 1 programs share between all the batches of a frame.
+// Sent once, at the start of the frame, to the fixed area below the double buffer.
 typedef struct
 {
     m_mat4_t mvp_matrix;
     float    gs_scale_x;
     float    gs_scale_y;
     float    gs_scale_z;
-    int      vert_count;
-} vu_batch_data_t PS2_ALIGN(16);
+    float    unused;
+    u64      kick_fence[2]; // Empty GIF tag, kicked after each batch (see KickAndWait).
+} vu_frame_data_t PS2_ALIGN(16);
 
 static inline int CountVertexLoops(float vertex_qwords, float num_regs)
 {
@@ -625,21 +613,41 @@ static inline int CountVertexLoops(float vertex_qwords, float num_regs)
     return (int)(vertex_qwords * loops_per_qw);
 }
 
+// As many as fit in one half of the VU1 memory double buffer.
 enum
 {
-// largest value attempted so far
-    MAX_TRIS_PER_VU_BATCH = 40,
+    MAX_TRIS_PER_VU_BATCH = PS2_VU_MAX_BATCH_VERTS / 3,
     MAX_VERTS_PER_VU_BATCH = MAX_TRIS_PER_VU_BATCH * 3
 };
 
-extern u32 vu1_buffer_index;
-static vu_batch_data_t ps2_batch_data_buffers[2];
-
-static vu_batch_data_t * ps2_current_batch_data = NULL;
+static vu_frame_data_t ps2_vu_frame_data;
 static u64 * ps2_current_giftag = NULL;
 
 static int ps2_vu_batch_vert_count = 0;
-static int ps2_num_vu_batches = 0; // for printing
+
+int ps2_num_vu_batches = 0; // VU1 program runs in the last frame, for the render stats.
+int ps2_vu_stall_usec  = 0; // EE time waiting for the VIF1 DMA to take more data.
+int ps2_vu_drain_usec  = 0; // EE time waiting for the last batches to be drawn.
+
+// World surfaces prebuilt as VU1 batches in a static DMA buffer (see PS2_WorldStaticDMASetup).
+// Each frame, the dynamic chain just uploads the MVP and CALLs the blocks of the visible surfaces.
+enum
+{
+    WORLD_DYN_DMA_PAGES       = 8,          // 4K pages per half of the per-frame chain. Each CALL is a qword.
+    WORLD_DMA_CALLS_PER_FIRE  = 1024,       // Send the chain and switch halves after this many CALLs.
+    WORLD_STATIC_DMA_HEADROOM = 512 * 1024  // MEMTAG_RENDERER left for allocations made while playing (the cached visible sets).
+};
+
+static cvar_t * r_ps2_static_world_dma = NULL;
+static ps2_vif_static_dma_t  ps2_world_static_dma;
+static ps2_vif_dynamic_dma_t ps2_world_dynamic_dma;
+static qboolean ps2_world_static_dma_valid = false;
+static qboolean ps2_world_dynamic_dma_valid = false;
+static int ps2_world_dma_calls = 0; // CALLs since the last VIFDMA_Fire.
+
+int ps2_world_static_dma_bytes = 0; // Size of the static buffer, for the render stats.
+int ps2_world_static_dma_needed = 0; // Size it needed when it didn't fit in MEMTAG_RENDERER, for the render stats.
+int ps2_world_dma_frame_bytes  = 0; // Static blocks CALLed in the last frame, for the render stats.
 
 //FIXME END TEMP
 //=============================================================================
@@ -655,29 +663,28 @@ static void PS2_BeginNewVUBatch(void)
 {
     VU1_Begin();
 
-    ++ps2_num_vu_batches;
-    ps2_current_batch_data = &ps2_batch_data_buffers[vu1_buffer_index];
-
-    // Copy the MVP matrix as-is:
-    ps2_current_batch_data->mvp_matrix = ps2_mvp_matrix;
-
-    // GS rasterizer scale factors follow the MVP matrix:
-    ps2_current_batch_data->gs_scale_x = 2048.0f;
-    ps2_current_batch_data->gs_scale_y = 2048.0f;
-    ps2_current_batch_data->gs_scale_z = ((float)0xFFFFFF) / 32.0f;
+    // The constants and the double buffer setup go with the first batch of the frame.
+    // Nothing is running on the VU then, since the previous frame drained it.
+    if (ps2_num_vu_batches == 0)
+    {
+        ps2_vu_frame_data.mvp_matrix = ps2_mvp_matrix;
+        ps2_vu_frame_data.gs_scale_x = 2048.0f;
+        ps2_vu_frame_data.gs_scale_y = 2048.0f;
+        ps2_vu_frame_data.gs_scale_z = ((float)0xFFFFFF) / 32.0f;
+        ps2_vu_frame_data.unused     = 0.0f;
+        ps2_vu_frame_data.kick_fence[0] = GS_GIFTAG(0, 1, 0, 0, GS_GIFTAG_PACKED, 1);
+        ps2_vu_frame_data.kick_fence[1] = 0;
+
+        VU1_ListData(PS2_VU_MVP_MATRIX, &ps2_vu_frame_data, sizeof(ps2_vu_frame_data) >> 4);
+        VU1_ListDoubleBuffer(PS2_VU_DBUF_BASE, PS2_VU_DBUF_SIZE);
+    }
 
-    // The vertex count is in the W component of the previous quadword.
-    // We only actually set the count before the batch is closed, since
-    // we don't know the number of vertexes beforehand.
-    ps2_current_batch_data->vert_count = 0;
+    ++ps2_num_vu_batches;
     ps2_vu_batch_vert_count = 0;
 
-    // Batch/list data will be uploaded at address 0 in VU memory.
-    const int batch_data_qwsize = sizeof(*ps2_current_batch_data) >> 4;
-    VU1_ListData(0, ps2_current_batch_data, batch_data_qwsize);
-
-    // Data added from here will follow the batch/list data (matrix, scales, etc).
-    VU1_ListAddBegin(batch_data_qwsize);
+    // Batch data goes to the free half of the double buffer. The vertex
+    // count is only known when the batch is closed, it goes in ITOP.
+    VU1_ListAddBegin(0);
 
     // Filled before we close the draw list.
     ps2_current_giftag = VU1_ListAddGIFTag();
@@ -692,9 +699,6 @@ Remarks: Local function.
 */
 static void PS2_FlushVUBatch(void)
 {
-    // Now we can set the vertex count.
-    ps2_current_batch_data->vert_count = ps2_vu_batch_vert_count;
-
     // Finish the GIF tag now that we know the vertex count.
     const int vertex_qws = ps2_vu_batch_vert_count * 2; // 2 qwords per vertex (color + position)
     const int vert_loops = CountVertexLoops(vertex_qws, NUM_VERTEX_ELEMENTS);
@@ -707,11 +711,17 @@ static void PS2_FlushVUBatch(void)
     // Close the draw list:
     VU1_ListAddEnd();
 
-    // Send the batch and start the VU program (located in micromem address 0):
-    VU1_End(0);
-
-    //FIXME PROBABLY actually synchronize before VU1_End() call...
-    PS2_WaitGSDrawFinish();
+    // Send the batch and start the VU program (located in micromem address 0).
+    // No waiting for the GS here; the next batch is built while this one is drawn.
+    // The program loops at least once, so an empty batch only sends the list.
+    if (ps2_vu_batch_vert_count > 0)
+    {
+        VU1_End(0, ps2_vu_batch_vert_count);
+    }
+    else
+    {
+        VU1_End(-1, -1);
+    }
 }
 
 /*
@@ -728,39 +738,176 @@ static void PS2_VUBatchAddSurfaceTris(const ps2_mdl_surface_t * surf)
     const int num_triangles = poly->num_verts - 2;
     const byte * color = Dbg_GetDebugColor(surf->debug_color);
 
-    ps2_vu_batch_vert_count += num_triangles * 3;
+    int t, count;
+    for (t = 0; t < num_triangles; t += count)
+    {
+        // Big polygons just carry on in the next batch.
+        if ((ps2_vu_batch_vert_count + 3) > MAX_VERTS_PER_VU_BATCH)
+        {
+            PS2_FlushVUBatch();    // Close current
+            PS2_BeginNewVUBatch(); // Open a new one
+        }
 
-    //TEMP shouldn't need once we stabilize...
-    //if (ps2_vu_batch_vert_count > MAX_VERTS_PER_VU_BATCH)
-    //{
-        //Sys_Error("MAX_VERTS_PER_VU_BATCH overflow!");
-    //}
+        // As many triangles as fit in the batch, written in one go.
+        // The index triplets are contiguous, so they index all the vertexes.
+        count = (MAX_VERTS_PER_VU_BATCH - ps2_vu_batch_vert_count) / 3;
+        if (count > num_triangles - t)
+        {
+            count = num_triangles - t;
+        }
 
-    int t, v;
-    for (t = 0; t < num_triangles; ++t)
+        u128 * dest = VU1_ListReserve(count * 3 * 2);
+        VU1_WriteColorPosVerts(dest, color, poly->vertexes[0].position, sizeof(ps2_poly_vertex_t),
+                               &poly->triangles[t].vertexes[0], count * 3);
+        ps2_vu_batch_vert_count += count * 3;
+    }
+}
+
+/*
+================
+PS2_StaticBatchQWords
+
+Remarks: Local function.
+Qwords a surface takes in the static DMA buffer, counting
+the VIF codes, plus one for the RET tag and its padding.
+================
+*/
+static int PS2_StaticBatchQWords(const ps2_mdl_poly_t * poly)
+{
+    int num_verts, words = 0;
+    for (num_verts = (poly->num_verts - 2) * 3; num_verts > 0; num_verts -= MAX_VERTS_PER_VU_BATCH)
     {
-        const ps2_mdl_triangle_t * tri = &poly->triangles[t];
+        words += Vert_PackedBatchWords((num_verts < MAX_VERTS_PER_VU_BATCH) ? num_verts : MAX_VERTS_PER_VU_BATCH);
+    }
+    return ((words + 3) / 4) + 2;
+}
+
+/*
+================
+PS2_StaticDMAAddSurface
+
+Remarks: Local function.
+Writes the surface triangles to the static DMA buffer as complete VU1 batches
+in the packed vertex formats (see vert_pack.c), each followed by a MSCAL of
+VU1Prog_Color_Triangles_Packed. Returns the address to CALL.
+================
+*/
+static u32 PS2_StaticDMAAddSurface(const ps2_mdl_surface_t * surf)
+{
+    const ps2_mdl_poly_t * poly = surf->polys;
+    const u32 color = Vert_PackColor(Dbg_GetDebugColor(surf->debug_color));
+    const u64 prim_desc = GS_PRIM(GS_PRIM_TRIANGLE, GS_PRIM_SFLAT, GS_PRIM_TOFF, GS_PRIM_FOFF, GS_PRIM_ABOFF, GS_PRIM_AAON, GS_PRIM_FSTQ, GS_PRIM_C1, 0);
+
+    const u32 block_addr = VIFDMA_GetPointer(&ps2_world_static_dma);
+    const int num_triangles = poly->num_verts - 2;
+
+    float positions[MAX_VERTS_PER_VU_BATCH * 3];
+    u32 colors[MAX_VERTS_PER_VU_BATCH];
+    u32 words[MAX_VERTS_PER_VU_BATCH * 3]; // More than Vert_PackedBatchWords() of a full batch.
+
+    int first_tri, t, v, i;
+    for (first_tri = 0; first_tri < num_triangles; first_tri += MAX_TRIS_PER_VU_BATCH)
+    {
+        const int batch_tris  = ((num_triangles - first_tri) < MAX_TRIS_PER_VU_BATCH) ?
+                                (num_triangles - first_tri) : MAX_TRIS_PER_VU_BATCH;
+        const int batch_verts = batch_tris * 3;
+
+        float * pos = positions;
+        for (t = first_tri; t < first_tri + batch_tris; ++t)
+        {
+            const ps2_mdl_triangle_t * tri = &poly->triangles[t];
+            for (v = 0; v < 3; ++v, pos += 3)
+            {
+                VectorCopy(poly->vertexes[tri->vertexes[v]].position, pos);
+            }
+        }
+        for (i = 0; i < batch_verts; ++i)
+        {
+            colors[i] = color;
+        }
 
-        for (v = 0; v < 3; ++v)
+        const u64 giftag = GS_GIFTAG(CountVertexLoops(batch_verts * 2, NUM_VERTEX_ELEMENTS),
+                                     1, 1, prim_desc, GS_GIFTAG_PACKED, NUM_VERTEX_ELEMENTS);
+        const int num_words = Vert_PackBatch(words, positions, colors, batch_verts,
+                                             giftag, VERTEX_FORMAT, vu_packed_prog_addr);
+        for (i = 0; i < num_words; ++i)
         {
-            const ps2_poly_vertex_t * vert = &poly->vertexes[tri->vertexes[v]];
-
-            //TODO probably define a new set of functions that takes a whole
-            //vertex instead of one element at a time. Reduce the number of API calls.
-
-            // Color:
-            VU1_ListAdd32(color[0]); // R
-            VU1_ListAdd32(color[1]); // G
-            VU1_ListAdd32(color[2]); // B
-            VU1_ListAdd32(color[3]); // A
-
-            // Position:
-            VU1_ListAddFloat(vert->position[0]); // X
-            VU1_ListAddFloat(vert->position[1]); // Y
-            VU1_ListAddFloat(vert->position[2]); // Z
-            VU1_ListAddFloat(1.0f);              // W
+            VIFDMA_AddU32(&ps2_world_static_dma, words[i]);
         }
     }
+
+    // Back to the per-frame chain.
+    VIFDMA_DMARet(&ps2_world_static_dma);
+    return block_addr;
+}
+
+/*
+================
+PS2_DrawStaticSurfaces
+
+Remarks: Local function.
+Per-frame path when the world has its static DMA blocks:
+one CALL tag per visible surface and no vertex copying.
+================
+*/
+static void PS2_DrawStaticSurfaces(void)
+{
+    int i;
+    ps2_teximage_t * teximage_iter = ps2ref.teximages;
+
+    // MVP matrix and scales go to VU mem address 0, where every batch
+    // expects them, then the double buffer the batches alternate in.
+    u32 header[PS2_VERT_FRAME_HEADER_WORDS];
+    const int num_words = Vert_PackFrameHeader(header, (const float *)&ps2_mvp_matrix);
+    for (i = 0; i < num_words; ++i)
+    {
+        VIFDMA_AddU32(&ps2_world_dynamic_dma, header[i]);
+    }
+    ps2_world_dma_calls = 0;
+
+    for (i = 0; i < MAX_TEXIMAGES; ++i, ++teximage_iter)
+    {
+        if (teximage_iter->type == IT_NULL)
+        {
+            continue;
+        }
+
+        const ps2_mdl_surface_t * surf = teximage_iter->texture_chain;
+        for (; surf != NULL; surf = surf->texture_chain)
+        {
+            if (surf->static_dma_addr == 0)
+            {
+                continue;
+            }
+
+            VIFDMA_DMACall(&ps2_world_dynamic_dma, surf->static_dma_addr);
+            ps2_world_dma_frame_bytes += PS2_StaticBatchQWords(surf->polys) * 16;
+            ps2_num_vu_batches += (surf->polys->num_verts - 2 + MAX_TRIS_PER_VU_BATCH - 1) / MAX_TRIS_PER_VU_BATCH;
+
+            // Keep well inside the dynamic pages. The matrix, the write cycle
+            // and the double buffer stay set, so the next chain starts with the
+            // CALLs. Fire waits for the previous chain to be taken by the VIF.
+            if (++ps2_world_dma_calls == WORLD_DMA_CALLS_PER_FIRE)
+            {
+                const u32 wait_start = Sys_Microseconds();
+                VIFDMA_Fire(&ps2_world_dynamic_dma);
+                ps2_vu_stall_usec += Sys_Microseconds() - wait_start;
+                ps2_world_dma_calls = 0;
+            }
+        }
+
+        teximage_iter->texture_chain = NULL;
+    }
+
+    u32 wait_start = Sys_Microseconds();
+    VIFDMA_Fire(&ps2_world_dynamic_dma);
+    ps2_vu_stall_usec += Sys_Microseconds() - wait_start;
+
+    // The 2D overlays go through PATH3 later in the frame, so let the world finish first.
+    wait_start = Sys_Microseconds();
+    dma_channel_wait(DMA_CHANNEL_VIF1, -1);
+    PS2_WaitGSDrawFinish();
+    ps2_vu_drain_usec += Sys_Microseconds() - wait_start;
 }
 
 /*
@@ -772,6 +919,12 @@ Remarks: Local function.
 */
 static void PS2_DrawTextureChains(void)
 {
+    if (ps2_world_static_dma_valid && r_ps2_static_world_dma->value)
+    {
+        PS2_DrawStaticSurfaces();
+        return;
+    }
+
     PS2_BeginNewVUBatch();
 
     int i;
@@ -801,19 +954,6 @@ static void PS2_DrawTextureChains(void)
                 continue;
             }
 
-            //FIXME TEMP WORK IN PROGRESS
-            const int num_triangles = poly->num_verts - 2;
-            if (num_triangles >= MAX_TRIS_PER_VU_BATCH)
-            {
-                Sys_Error("num_verts >= MAX_TRIS_PER_VU_BATCH");
-            }
-
-            if ((ps2_vu_batch_vert_count + poly->num_verts) > MAX_VERTS_PER_VU_BATCH)
-            {
-                PS2_FlushVUBatch();    // Close current
-                PS2_BeginNewVUBatch(); // Open a new one
-            }
-
             PS2_VUBatchAddSurfaceTris(surf);
         }
 
@@ -821,6 +961,13 @@ static void PS2_DrawTextureChains(void)
     }
 
     PS2_FlushVUBatch();
+
+    // Same as the static path; the world has to be drawn before the 2D overlays.
+    const u32 wait_start = Sys_Microseconds();
+    dma_channel_wait(DMA_CHANNEL_VIF1, -1);
+    PS2_WaitGSDrawFinish();
+    ps2_vu_drain_usec += Sys_Microseconds() - wait_start;
+    ps2_vu_stall_usec += vu1_stall_usec;
 }
 
 /*
@@ -990,9 +1137,12 @@ void PS2_DrawFrameSetup(const refdef_t * view_def)
     SetVUProg();
 
     ps2_num_vu_batches = 0;
+    ps2_vu_stall_usec  = 0;
+    ps2_vu_drain_usec  = 0;
+    vu1_stall_usec     = 0;
+    ps2_world_dma_frame_bytes = 0;
     ps2_vu_batch_vert_count = 0;
     ps2_current_giftag = NULL;
-    ps2_current_batch_data = NULL;
 }
 
 /*
@@ -1009,14 +1159,159 @@ void PS2_DrawWorldModel(refdef_t * view_def)
         return;
     }
 
+    if (r_ps2_vis_cache == NULL)
+    {
+        r_ps2_vis_cache = Cvar_Get("r_ps2_vis_cache", "1", 0);
+    }
+
     ps2_model_t * world_mdl = PS2_ModelGetWorld();
-    PS2_MarkLeaves(world_mdl);
-    PS2_RecursiveWorldNode(view_def, world_mdl, world_mdl->nodes);
+    if (r_ps2_vis_cache->value)
+    {
+        PS2_AddCachedWorldSurfaces(view_def, world_mdl);
+    }
+    else
+    {
+        PS2_MarkLeaves(world_mdl);
+        PS2_RecursiveWorldNode(view_def, world_mdl, world_mdl->nodes);
+    }
+
+    Prof_Begin("PS2_DrawTextureChains");
     PS2_DrawTextureChains();
+    Prof_End();
 
     PS2_DrawAltString(10, viddef.height - 30, va("batches: %d", ps2_num_vu_batches));
 }
 
+/*
+================
+PS2_WorldStaticDMASetup
+
+Called by PS2_EndRegistration, once the world model for the
+level is known. Builds the static DMA blocks for its surfaces.
+================
+*/
+void PS2_WorldStaticDMASetup(ps2_model_t * world_mdl)
+{
+    int i, qwords;
+    ps2_mdl_surface_t * surf;
+
+    if (r_ps2_static_world_dma == NULL)
+    {
+        r_ps2_static_world_dma = Cvar_Get("r_ps2_static_world_dma", "1", 0);
+    }
+    if (!ps2_world_dynamic_dma_valid)
+    {
+        VIFDMA_Initialize(&ps2_world_dynamic_dma, WORLD_DYN_DMA_PAGES, VIF_DYNAMIC_DMA);
+        ps2_world_dynamic_dma_valid = true;
+    }
+
+    // The cached visible sets point into the previous world.
+    PS2_WorldVisReset();
+
+    // Batches MSCAL the packed program, so we need its address.
+    SetVUProg();
+
+    // Nothing in flight may still be CALLing into the old blocks.
+    dma_channel_wait(DMA_CHANNEL_VIF1, -1);
+    if (ps2_world_static_dma_valid)
+    {
+        VIFDMA_Shutdown(&ps2_world_static_dma);
+        ps2_world_static_dma_valid = false;
+        ps2_world_static_dma_bytes = 0;
+    }
+    ps2_world_static_dma_needed = 0;
+
+    if (world_mdl == NULL || world_mdl->surfaces == NULL)
+    {
+        return;
+    }
+
+    // Size it up first. Every 4K page loses a qword to the stitching tag.
+    qwords = 0;
+    for (i = 0, surf = world_mdl->surfaces; i < world_mdl->num_surfaces; ++i, ++surf)
+    {
+        if (surf->polys != NULL && surf->polys->num_verts >= 3)
+        {
+            qwords += PS2_StaticBatchQWords(surf->polys);
+        }
+    }
+    if (qwords == 0)
+    {
+        return;
+    }
+
+    // The renderer tag has a hard budget. If the blocks don't fit, stay with
+    // the dynamic path instead of failing the level load with out-of-memory.
+    unsigned int footprint, in_use, budget;
+    const int num_pages = (qwords / 255) + 2;
+    PS2_MemGetSpaceUsage(MEMTAG_RENDERER, &footprint, &in_use, &budget);
+    if ((unsigned int)(num_pages * 4096) + WORLD_STATIC_DMA_HEADROOM > budget - in_use)
+    {
+        Com_Printf("WARNING: Static world DMA needs %d KB, %u KB renderer memory free. Using dynamic batches.\n",
+                   (num_pages * 4096) / 1024, (budget - in_use) / 1024);
+        ps2_world_static_dma_needed = num_pages * 4096;
+        for (i = 0, surf = world_mdl->surfaces; i < world_mdl->num_surfaces; ++i, ++surf)
+        {
+            surf->static_dma_addr = 0;
+        }
+        return;
+    }
+
+    VIFDMA_Initialize(&ps2_world_static_dma, num_pages, VIF_STATIC_DMA);
+    ps2_world_static_dma_bytes = num_pages * 4096;
+    ps2_world_static_dma_valid = true;
+
+    for (i = 0, surf = world_mdl->surfaces; i < world_mdl->num_surfaces; ++i, ++surf)
+    {
+        if (surf->polys != NULL && surf->polys->num_verts >= 3)
+        {
+            surf->static_dma_addr = PS2_StaticDMAAddSurface(surf);
+        }
+        else
+        {
+            surf->static_dma_addr = 0;
+        }
+    }
+
+    // The blocks are read by the DMAC straight from memory.
+    FlushCache(0);
+}
+
+/*
+================
+PS2_WorldDrawShutdown
+
+Called by PS2_RendererShutdown. Frees the world DMA
+buffers and the visible surfaces array of the cached path.
+================
+*/
+void PS2_WorldDrawShutdown(void)
+{
+    // Nothing in flight may still be reading from the pages.
+    dma_channel_wait(DMA_CHANNEL_VIF1, -1);
+
+    if (ps2_world_static_dma_valid)
+    {
+        VIFDMA_Shutdown(&ps2_world_static_dma);
+        ps2_world_static_dma_valid = false;
+    }
+    ps2_world_static_dma_bytes = 0;
+    ps2_world_static_dma_needed = 0;
+
+    if (ps2_world_dynamic_dma_valid)
+    {
+        VIFDMA_Shutdown(&ps2_world_dynamic_dma);
+        ps2_world_dynamic_dma_valid = false;
+    }
+
+    if (ps2_vis_surfaces != NULL)
+    {
+        PS2_MemFree(ps2_vis_surfaces, ps2_vis_surfaces_size * sizeof(ps2_mdl_surface_t *), MEMTAG_RENDERER);
+        ps2_vis_surfaces = NULL;
+    }
+    ps2_vis_surfaces_size = 0;
+}
+
 /*
 ================
 PS2_DrawViewEntities
@@ -13,25 +13,61 @@
 #ifndef PS2_VU1_H
 #define PS2_VU1_H
 
-#include "ps2/vu_prog_mgr.h"
+#include "ps2/defs_ps2.h"
+#include "game/q_shared.h" // For qboolean and stuff...
+
+// DMA hardware defines:
+#define VU1_DMA_END_TAG(COUNT) (((u64)(0x7) << 28) | COUNT)
+#define VU1_DMA_CNT_TAG(COUNT) (((u64)(0x1) << 28) | COUNT)
+#define VU1_DMA_REF_TAG(ADDR, COUNT) ((((u64)ADDR) << 32) | (0x3 << 28) | COUNT)
+
+// VIF hardware defines:
+#define VU1_VIF_NOP    0x00
+#define VU1_VIF_MPG    0x4A
+#define VU1_VIF_MSCAL  0x14
+#define VU1_VIF_STCYL  0x01
+#define VU1_VIF_OFFSET 0x02
+#define VU1_VIF_BASE   0x03
+#define VU1_VIF_ITOP   0x04
+#define VU1_VIF_FLUSH  0x11
+#define VU1_VIF_UNPACK 0x60
+#define VU1_VIF_UNPACK_V4_32 (VU1_VIF_UNPACK | 0x0C)
+#define VU1_VIF_UNPACK_TOPS  0x8000 // UNPACK address flag: relative to the free half of the double buffer.
+#define VU1_VIF_CODE(CMD, NUM, IMMEDIATE) ((((u32)(CMD)) << 24) | (((u32)(NUM)) << 16) | ((u32)(IMMEDIATE)))
+
+// We have two buffers of this size for the VIF DMAs. A list holds a single
+// program run, which can't unpack more than the 16KB of VU1 data memory,
+// so this leaves plenty of room for the tags and VIF codes.
+#define VU1_DMA_BUFFER_SIZE_BYTES (32 * 1024) // 64KB for both
 
 // Initialize local VU1 library data. Call it at renderer startup.
 void VU1_Init(void);
 void VU1_Shutdown(void);
 
 // Send program microcode to the VU1.
-void VU1_UploadProg(int dest, void * start, void * end);
+// Returns the micromem address just past the uploaded program.
+int VU1_UploadProg(int dest, void * start, void * end);
 
 // Begin a new program run;
 // End the current list and start the VU1 program (located in micromem 'start' address)
+// 'itop' is passed to the program in the ITOP register (XITOP), if not negative.
+// The VIF only waits for the previous program to end before starting this one,
+// not for its GS transfer, so lists can be sent back-to-back with a double buffer.
 void VU1_Begin(void);
-void VU1_End(int start);
+void VU1_End(int start, int itop);
+
+// Double buffer VU1 data memory: two halves of 'offset' qwords starting at 'base'.
+// Lists alternate between the halves, each going to the one not in use by the
+// running program. Only while the VU is idle, e.g. at the start of a frame.
+void VU1_ListDoubleBuffer(int base, int offset);
 
 // Begin a new primitive list:
+// 'address' is relative to the free half of the double buffer (or absolute if none set).
 void VU1_ListAddBegin(int address);
 void VU1_ListAddEnd(void);
 
 // Add data to the current list:
+// 'dest_address' is absolute, for data shared by all lists, like matrices.
 void VU1_ListData(int dest_address, void * data, int quad_size);
 void VU1_ListAdd128(u64 v1, u64 v2);
 void VU1_ListAdd64(u64 v);
@@ -43,4 +79,39 @@ void VU1_ListAddFloat(float v);
 // You can then fill it with the tag data anytime before VU1_End().
 u64 * VU1_ListAddGIFTag(void);
 
+// Bulk alternative to the VU1_ListAdd* functions: reserves 'num_qwords' in the current
+// list and returns a 16-bytes aligned pointer to them, to be written before VU1_End().
+// If a VU1_ListAdd32/64 left the list in the middle of a qword, it is zero padded first.
+u128 * VU1_ListReserve(int num_qwords);
+
+// Copy kernels to fill the reserved qwords, using 128-bit loads and stores.
+// 'src' must be 16-bytes aligned as well.
+void VU1_CopyQWords(u128 * restrict dest, const u128 * restrict src, int num_qwords);
+
+// Writes 'num_verts' vertexes in the RGBAQ | XYZ2 layout the VU1 programs read, two
+// qwords each: 'rgba' as four 32 bits integers, then the position with W = 1.
+// Positions are 3 floats, 'stride' bytes apart. If 'indexes' isn't NULL, vertex i
+// is taken from position indexes[i], which is how triangle lists index their polygons.
+void VU1_WriteColorPosVerts(u128 * restrict dest, const byte * rgba, const float * positions,
+                            int stride, const u16 * indexes, int num_verts);
+
+//
+// Shared by vu1.c and vu1_list.c. The list building half doesn't touch the hardware,
+// so it is also built on the host for ps2/tests/test_vu1_list.c.
+//
+
+extern u32 vu1_buffer_index;
+extern byte * vu1_dma_buffers[2];
+
+// Allocates/frees the two list buffers. Called by VU1_Init/VU1_Shutdown.
+void VU1_ListInit(void);
+void VU1_ListShutdown(void);
+
+// Writes the END tag that VU1_End() sends and returns the start of the chain.
+void * VU1_ListEndChain(int start, int itop);
+
+// Microseconds the EE spent in VU1_End() waiting for the previous list to
+// be taken by the VIF. Accumulated, the caller resets it when it sees fit.
+extern u32 vu1_stall_usec;
+
 #endif // PS2_VU1_H
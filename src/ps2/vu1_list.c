@@ -0,0 +1,428 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: vu1_list.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Vector Unit 1 (VU1) draw list building.
+ *
+ * The lists are DMA chains for the VIF1, built into two buffers that alternate between
+ * frames/batches (see VU1_Begin). vu1.c sends them. This half doesn't touch the hardware,
+ * so it is also built on the host for ps2/tests/test_vu1_list.c.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "ps2/vu1.h"
+#include "ps2/mem_alloc.h"
+
+//=============================================================================
+//
+// Following code is based on lib PDK by Jesper Svennevid, Daniel Collin.
+//
+//=============================================================================
+
+typedef struct
+{
+    void *   offset;
+    void *   kickbuffer;
+    int      dma_size;
+    int      cnt_dma_dest;
+    qboolean is_buiding_dma; // True when between VU1_ListAddBegin/VU1_ListAddEnd
+} vu1_context_t;
+
+// Allowed to be accessed externally.
+u32 vu1_buffer_index = 0;
+byte * vu1_dma_buffers[2] PS2_ALIGN(16);
+
+// Locals:
+static byte * vu1_current_buffer;
+static vu1_context_t vu1_local_context PS2_ALIGN(16);
+
+// One vertex of the RGBAQ | XYZ2 layout, as it goes in the list.
+typedef union
+{
+    u128 qw[2];
+    struct
+    {
+        u32   rgba[4];
+        float xyzw[4];
+    } v;
+} vu1_color_pos_vert_t;
+
+//=============================================================================
+
+/*
+================
+VU1_ListPut32 / VU1_ListPut64
+
+Local helper functions. Append to the current buffer.
+================
+*/
+static inline void VU1_ListPut32(u32 v)
+{
+    *(u32 *)vu1_current_buffer = v;
+    vu1_current_buffer += sizeof(u32);
+}
+static inline void VU1_ListPut64(u64 v)
+{
+    *(u64 *)vu1_current_buffer = v;
+    vu1_current_buffer += sizeof(u64);
+}
+
+/*
+================
+VU1_ListInit
+================
+*/
+void VU1_ListInit(void)
+{
+    int i;
+    for (i = 0; i < sizeof(vu1_dma_buffers) / sizeof(vu1_dma_buffers[0]); ++i)
+    {
+        vu1_dma_buffers[i] = PS2_MemAllocAligned(16, VU1_DMA_BUFFER_SIZE_BYTES, MEMTAG_RENDERER);
+    }
+
+    vu1_buffer_index   = 0;
+    vu1_current_buffer = vu1_dma_buffers[0];
+}
+
+/*
+================
+VU1_ListShutdown
+================
+*/
+void VU1_ListShutdown(void)
+{
+    int i;
+    for (i = 0; i < sizeof(vu1_dma_buffers) / sizeof(vu1_dma_buffers[0]); ++i)
+    {
+        PS2_MemFree(vu1_dma_buffers[i], VU1_DMA_BUFFER_SIZE_BYTES, MEMTAG_RENDERER);
+        vu1_dma_buffers[i] = NULL;
+    }
+
+    vu1_buffer_index   = 0;
+    vu1_current_buffer = NULL;
+    memset(&vu1_local_context, 0, sizeof(vu1_local_context));
+}
+
+/*
+================
+VU1_Begin
+================
+*/
+void VU1_Begin(void)
+{
+    // Switch context:
+    //  1 XOR 1 = 0
+    //  0 XOR 1 = 1
+    vu1_buffer_index ^= 1;
+    vu1_current_buffer = vu1_dma_buffers[vu1_buffer_index];
+
+    // Rest frame context:
+    vu1_local_context.dma_size       = 0;
+    vu1_local_context.cnt_dma_dest   = 0;
+    vu1_local_context.is_buiding_dma = false;
+    vu1_local_context.offset         = NULL;
+    vu1_local_context.kickbuffer     = vu1_current_buffer;
+}
+
+/*
+================
+VU1_ListEndChain
+================
+*/
+void * VU1_ListEndChain(int start, int itop)
+{
+    VU1_ListPut64(VU1_DMA_END_TAG(0));
+
+    // No FLUSH before the MSCAL. The VIF holds it until the previous program
+    // ends, but the GS can still be drawing that one while this one runs.
+    if (itop >= 0)
+    {
+        VU1_ListPut32(VU1_VIF_CODE(VU1_VIF_ITOP, 0, itop));
+    }
+    else
+    {
+        VU1_ListPut32(VU1_VIF_CODE(VU1_VIF_NOP, 0, 0));
+    }
+
+    if (start >= 0)
+    {
+        VU1_ListPut32(VU1_VIF_CODE(VU1_VIF_MSCAL, 0, start));
+    }
+    else
+    {
+        VU1_ListPut32(VU1_VIF_CODE(VU1_VIF_NOP, 0, 0));
+    }
+
+    return vu1_local_context.kickbuffer;
+}
+
+/*
+================
+VU1_ListDoubleBuffer
+================
+*/
+void VU1_ListDoubleBuffer(int base, int offset)
+{
+    if (vu1_local_context.is_buiding_dma)
+    {
+        Sys_Error("VU1_ListDoubleBuffer: Can't be called inside a DMA list!");
+    }
+
+    // Empty tag, just for the VIF codes. Setting OFFSET also
+    // points the VIF back to the first half of the buffer.
+    VU1_ListPut64(VU1_DMA_CNT_TAG(0));
+    VU1_ListPut32(VU1_VIF_CODE(VU1_VIF_BASE, 0, base));
+    VU1_ListPut32(VU1_VIF_CODE(VU1_VIF_OFFSET, 0, offset));
+}
+
+/*
+================
+VU1_ListAddBegin
+================
+*/
+void VU1_ListAddBegin(int address)
+{
+    if (vu1_local_context.is_buiding_dma)
+    {
+        Sys_Error("VU1_ListAddBegin: Already building a DMA list!");
+    }
+
+    vu1_local_context.offset         = vu1_current_buffer;
+    vu1_local_context.cnt_dma_dest   = address;
+    vu1_local_context.is_buiding_dma = true;
+
+    // These are placeholders filled later by VU1_ListAddEnd().
+    VU1_ListPut64(VU1_DMA_CNT_TAG(0));
+    VU1_ListPut32(VU1_VIF_CODE(VU1_VIF_STCYL, 0, 0x0101));
+    VU1_ListPut32(VU1_VIF_CODE(VU1_VIF_UNPACK_V4_32, 0, 0));
+}
+
+/*
+================
+VU1_ListAddEnd
+================
+*/
+void VU1_ListAddEnd(void)
+{
+    if (!vu1_local_context.is_buiding_dma)
+    {
+        Sys_Error("VU1_ListAddEnd: Missing a DMA list begin!");
+    }
+
+    // Pad to qword alignment if necessary:
+    while (vu1_local_context.dma_size & 0xF)
+    {
+        VU1_ListPut32(0);
+        vu1_local_context.dma_size += sizeof(u32);
+    }
+
+    const int dma_size_qwords = vu1_local_context.dma_size >> 4;
+    u32 * tag = (u32 *)vu1_local_context.offset;
+    *(u64 *)tag = VU1_DMA_CNT_TAG(dma_size_qwords);
+    tag[2] = VU1_VIF_CODE(VU1_VIF_STCYL, 0, 0x0101);
+    tag[3] = VU1_VIF_CODE(VU1_VIF_UNPACK_V4_32, dma_size_qwords,
+                          vu1_local_context.cnt_dma_dest | VU1_VIF_UNPACK_TOPS);
+
+    vu1_local_context.is_buiding_dma = false;
+}
+
+/*
+================
+VU1_ListData
+================
+*/
+void VU1_ListData(int dest_address, void * data, int quad_size)
+{
+    if ((size_t)data & 0xF)
+    {
+        Sys_Error("VU1_ListData: Pointer is not 16-bytes aligned!");
+    }
+
+    VU1_ListPut64(VU1_DMA_REF_TAG((u32)(size_t)data, quad_size));
+    VU1_ListPut32(VU1_VIF_CODE(VU1_VIF_STCYL, 0, 0x0101));
+    VU1_ListPut32(VU1_VIF_CODE(VU1_VIF_UNPACK_V4_32, quad_size, dest_address));
+}
+
+/*
+================
+VU1_ListAdd128
+================
+*/
+void VU1_ListAdd128(u64 v1, u64 v2)
+{
+    if (!vu1_local_context.is_buiding_dma)
+    {
+        Sys_Error("VU1_ListAdd128: Missing a DMA list begin!");
+    }
+
+    VU1_ListPut64(v1);
+    VU1_ListPut64(v2);
+    vu1_local_context.dma_size += sizeof(u64) * 2;
+}
+
+/*
+================
+VU1_ListAddGIFTag
+================
+*/
+u64 * VU1_ListAddGIFTag(void)
+{
+    if (!vu1_local_context.is_buiding_dma)
+    {
+        Sys_Error("VU1_ListAddGIFTag: Missing a DMA list begin!");
+    }
+
+    // Empty tag that the caller can fill up.
+    u64 * tag_ptr = (u64 *)vu1_current_buffer;
+    VU1_ListPut64(0);
+    VU1_ListPut64(0);
+    vu1_local_context.dma_size += sizeof(u64) * 2;
+    return tag_ptr;
+}
+
+/*
+================
+VU1_ListAdd64
+================
+*/
+void VU1_ListAdd64(u64 v)
+{
+    if (!vu1_local_context.is_buiding_dma)
+    {
+        Sys_Error("VU1_ListAdd64: Missing a DMA list begin!");
+    }
+
+    VU1_ListPut64(v);
+    vu1_local_context.dma_size += sizeof(u64);
+}
+
+/*
+================
+VU1_ListAdd32
+================
+*/
+void VU1_ListAdd32(u32 v)
+{
+    if (!vu1_local_context.is_buiding_dma)
+    {
+        Sys_Error("VU1_ListAdd32: Missing a DMA list begin!");
+    }
+
+    VU1_ListPut32(v);
+    vu1_local_context.dma_size += sizeof(u32);
+}
+
+/*
+================
+VU1_ListAddFloat
+================
+*/
+void VU1_ListAddFloat(float v)
+{
+    if (!vu1_local_context.is_buiding_dma)
+    {
+        Sys_Error("VU1_ListAddFloat: Missing a DMA list begin!");
+    }
+
+    *(float *)vu1_current_buffer = v;
+    vu1_current_buffer += sizeof(float);
+    vu1_local_context.dma_size += sizeof(float);
+}
+
+/*
+================
+VU1_ListReserve
+================
+*/
+u128 * VU1_ListReserve(int num_qwords)
+{
+    if (!vu1_local_context.is_buiding_dma)
+    {
+        Sys_Error("VU1_ListReserve: Missing a DMA list begin!");
+    }
+
+    // The list starts right after a tag, so it is aligned when its size is.
+    while (vu1_local_context.dma_size & 0xF)
+    {
+        VU1_ListPut32(0);
+        vu1_local_context.dma_size += sizeof(u32);
+    }
+
+    // One check for the whole block, instead of one per element. Leaves room for the END tag.
+    const int num_bytes = num_qwords << 4;
+    const byte * buffer_end = vu1_dma_buffers[vu1_buffer_index] + VU1_DMA_BUFFER_SIZE_BYTES - 16;
+    if (vu1_current_buffer + num_bytes > buffer_end)
+    {
+        Sys_Error("VU1_ListReserve: DMA buffer overflow! %d qwords requested.", num_qwords);
+    }
+
+    u128 * block = (u128 *)vu1_current_buffer;
+    vu1_current_buffer += num_bytes;
+    vu1_local_context.dma_size += num_bytes;
+    return block;
+}
+
+/*
+================
+VU1_CopyQWords
+================
+*/
+void VU1_CopyQWords(u128 * restrict dest, const u128 * restrict src, int num_qwords)
+{
+    // Unrolled so the loads can be scheduled ahead of the stores.
+    while (num_qwords >= 4)
+    {
+        const u128 q0 = src[0];
+        const u128 q1 = src[1];
+        const u128 q2 = src[2];
+        const u128 q3 = src[3];
+        dest[0] = q0;
+        dest[1] = q1;
+        dest[2] = q2;
+        dest[3] = q3;
+        dest += 4;
+        src  += 4;
+        num_qwords -= 4;
+    }
+    while (num_qwords-- > 0)
+    {
+        *dest++ = *src++;
+    }
+}
+
+/*
+================
+VU1_WriteColorPosVerts
+================
+*/
+void VU1_WriteColorPosVerts(u128 * restrict dest, const byte * rgba, const float * positions,
+                            int stride, const u16 * indexes, int num_verts)
+{
+    int i;
+    vu1_color_pos_vert_t vert PS2_ALIGN(16);
+    const byte * base = (const byte *)positions;
+
+    // The color qword is the same for all, so it is a single 128-bit store per vertex.
+    vert.v.rgba[0] = rgba[0];
+    vert.v.rgba[1] = rgba[1];
+    vert.v.rgba[2] = rgba[2];
+    vert.v.rgba[3] = rgba[3];
+    vert.v.xyzw[3] = 1.0f;
+    const u128 color_qw = vert.qw[0];
+
+    for (i = 0; i < num_verts; ++i, dest += 2)
+    {
+        const float * pos = (const float *)(base + ((indexes != NULL) ? indexes[i] : i) * stride);
+
+        // Positions aren't aligned, so they go as words, into the qword we store.
+        vert.v.xyzw[0] = pos[0];
+        vert.v.xyzw[1] = pos[1];
+        vert.v.xyzw[2] = pos[2];
+
+        dest[0] = color_qw;
+        dest[1] = vert.qw[1];
+    }
+}
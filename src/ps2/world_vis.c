@@ -0,0 +1,443 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: world_vis.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Cached visible surface lists for the world model.
+ *
+ * What the PVS lets through only changes when the view moves to another cluster or a
+ * door opens or closes an area, so the leafs and surfaces that pass are gathered once per
+ * (cluster, cluster2, areabits) and kept in a small LRU cache. A set is a flat array with
+ * the bounding box and mark surfaces of each leaf, plus the surfaces sorted by texture.
+ * Every frame only the frustum and the facing tests are run, as two linear passes over
+ * those arrays, instead of walking the BSP down from the root.
+ *
+ * Only reads the world arrays, so it is also built on the host for ps2/tests/test_world_vis.c.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "ps2/model_load.h"
+#include "ps2/mem_alloc.h"
+
+enum
+{
+    WORLD_VIS_CACHE_SIZE = 8 // Sets kept at once. Enough to go back and forth between a few rooms.
+};
+
+static ps2_world_vis_t ps2_world_vis_cache[WORLD_VIS_CACHE_SIZE];
+static u32 ps2_world_vis_lookups = 0; // Timestamp for the LRU.
+static int ps2_world_vis_hits    = 0;
+static int ps2_world_vis_misses  = 0;
+
+/*
+================
+PS2_WorldVisRowSize
+================
+*/
+int PS2_WorldVisRowSize(const ps2_model_t * world_mdl)
+{
+    // Whole ints, since two rows are merged an int at
+    // a time. Clusters never outnumber leafs.
+    return ((world_mdl->num_leafs + 31) / 32) * 4;
+}
+
+/*
+================
+PS2_WorldVisDecompress
+
+Remarks: Local function.
+'pvs' must hold PS2_WorldVisRowSize() bytes.
+================
+*/
+static void PS2_WorldVisDecompress(const byte * in, const ps2_model_t * world_mdl, byte * pvs)
+{
+    const int row = (world_mdl->vis->numclusters + 7) >> 3;
+    byte * out = pvs;
+
+    do
+    {
+        if (*in)
+        {
+            *out++ = *in++;
+            continue;
+        }
+
+        int c = in[1];
+        in += 2;
+        while (c)
+        {
+            *out++ = 0;
+            c--;
+        }
+    } while (out - pvs < row);
+}
+
+/*
+================
+PS2_WorldVisClusterPVS
+================
+*/
+byte * PS2_WorldVisClusterPVS(const ps2_model_t * world_mdl, int cluster, int cluster2)
+{
+    if (cluster == -1 || world_mdl->vis == NULL)
+    {
+        return NULL;
+    }
+
+    const int row_size = PS2_WorldVisRowSize(world_mdl);
+    byte * pvs = (byte *)Frame_MemAlloc(FRAME_MEM_REFRESH, row_size);
+    memset(pvs, 0, row_size);
+    PS2_WorldVisDecompress((const byte *)world_mdl->vis + world_mdl->vis->bitofs[cluster][DVIS_PVS], world_mdl, pvs);
+
+    // May have to combine two clusters because of solid water boundaries:
+    if (cluster2 != cluster && cluster2 != -1)
+    {
+        int i;
+        byte * vis2 = (byte *)Frame_MemAlloc(FRAME_MEM_REFRESH, row_size);
+        memset(vis2, 0, row_size);
+        PS2_WorldVisDecompress((const byte *)world_mdl->vis + world_mdl->vis->bitofs[cluster2][DVIS_PVS], world_mdl, vis2);
+
+        for (i = 0; i < row_size / 4; ++i)
+        {
+            ((int *)pvs)[i] |= ((int *)vis2)[i];
+        }
+    }
+    return pvs;
+}
+
+/*
+================
+PS2_WorldVisFreeSet
+
+Remarks: Local function.
+================
+*/
+static void PS2_WorldVisFreeSet(ps2_world_vis_t * vis)
+{
+    if (vis->leafs != NULL)
+    {
+        // Leafs and surfaces share one block.
+        PS2_MemFree(vis->leafs, vis->mem_bytes, MEMTAG_RENDERER);
+    }
+    memset(vis, 0, sizeof(*vis));
+}
+
+/*
+================
+PS2_WorldVisCompareSurfs
+
+Remarks: Local function.
+qsort() callback that sorts by texture, then by address
+so that the order doesn't depend on the sort.
+================
+*/
+static int PS2_WorldVisCompareSurfs(const void * a, const void * b)
+{
+    const ps2_mdl_surface_t * surf_a = *(const ps2_mdl_surface_t * const *)a;
+    const ps2_mdl_surface_t * surf_b = *(const ps2_mdl_surface_t * const *)b;
+
+    if (surf_a->texinfo->teximage != surf_b->texinfo->teximage)
+    {
+        return (surf_a->texinfo->teximage < surf_b->texinfo->teximage) ? -1 : 1;
+    }
+    if (surf_a != surf_b)
+    {
+        return (surf_a < surf_b) ? -1 : 1;
+    }
+    return 0;
+}
+
+/*
+================
+PS2_WorldVisLeafPasses
+
+Remarks: Local function.
+A NULL 'pvs' lets every cluster through.
+================
+*/
+static inline qboolean PS2_WorldVisLeafPasses(const ps2_world_vis_t * vis, const ps2_mdl_leaf_t * leaf, const byte * pvs)
+{
+    if (leaf->contents == CONTENTS_SOLID || leaf->num_mark_surfaces == 0)
+    {
+        return false;
+    }
+    if (pvs != NULL && (leaf->cluster == -1 || !(pvs[leaf->cluster >> 3] & (1 << (leaf->cluster & 7)))))
+    {
+        return false;
+    }
+    if (!vis->all_areas && !(vis->areabits[leaf->area >> 3] & (1 << (leaf->area & 7))))
+    {
+        return false; // Behind a closed door.
+    }
+    return true;
+}
+
+/*
+================
+PS2_WorldVisSurfIsOpaque
+
+Remarks: Local function.
+Sky and translucent surfaces aren't drawn from the texture chains.
+================
+*/
+static inline qboolean PS2_WorldVisSurfIsOpaque(const ps2_mdl_surface_t * surf)
+{
+    return !(surf->texinfo->flags & (SURF_SKY | SURF_TRANS33 | SURF_TRANS66));
+}
+
+/*
+================
+PS2_WorldVisBuildSet
+
+Remarks: Local function.
+Gathers the leafs that pass the PVS and area checks
+and the surfaces that they mark into 'vis'.
+================
+*/
+static void PS2_WorldVisBuildSet(ps2_world_vis_t * vis, const ps2_model_t * world_mdl)
+{
+    int i, j;
+    int num_leafs = 0;
+    int num_surfaces = 0;
+    const ps2_mdl_leaf_t * leaf;
+
+    const int mark = Frame_MemGetMark(FRAME_MEM_REFRESH);
+    const byte * pvs = PS2_WorldVisClusterPVS(world_mdl, vis->cluster, vis->cluster2);
+
+    // Surfaces can be marked by many leafs, so we need to know which ones are in already.
+    // A bit per surface, so that it fits in the frame arena even for the biggest maps.
+    const int surf_bits_size = (world_mdl->num_surfaces + 7) >> 3;
+    byte * surf_added = (byte *)Frame_MemAlloc(FRAME_MEM_REFRESH, surf_bits_size);
+    memset(surf_added, 0, surf_bits_size);
+
+    // Count first, then fill the exact sizes.
+    for (i = 0, leaf = world_mdl->leafs; i < world_mdl->num_leafs; ++i, ++leaf)
+    {
+        if (!PS2_WorldVisLeafPasses(vis, leaf, pvs))
+        {
+            continue;
+        }
+
+        ++num_leafs;
+        for (j = 0; j < leaf->num_mark_surfaces; ++j)
+        {
+            const ps2_mdl_surface_t * surf = leaf->first_mark_surface[j];
+            const int surf_index = (int)(surf - world_mdl->surfaces);
+
+            if ((surf_added[surf_index >> 3] & (1 << (surf_index & 7))) || !PS2_WorldVisSurfIsOpaque(surf))
+            {
+                continue;
+            }
+            surf_added[surf_index >> 3] |= (1 << (surf_index & 7));
+            ++num_surfaces;
+        }
+    }
+
+    vis->num_leafs    = num_leafs;
+    vis->num_surfaces = num_surfaces;
+    vis->mem_bytes    = (num_leafs * sizeof(ps2_world_vis_leaf_t)) + (num_surfaces * sizeof(ps2_mdl_surface_t *));
+
+    if (vis->mem_bytes > 0)
+    {
+        vis->leafs    = PS2_MemAlloc(vis->mem_bytes, MEMTAG_RENDERER);
+        vis->surfaces = (ps2_mdl_surface_t **)(vis->leafs + num_leafs);
+    }
+
+    num_leafs = 0;
+    num_surfaces = 0;
+    memset(surf_added, 0, surf_bits_size);
+
+    for (i = 0, leaf = world_mdl->leafs; i < world_mdl->num_leafs; ++i, ++leaf)
+    {
+        if (!PS2_WorldVisLeafPasses(vis, leaf, pvs))
+        {
+            continue;
+        }
+
+        ps2_world_vis_leaf_t * vis_leaf = &vis->leafs[num_leafs++];
+        memcpy(vis_leaf->minmaxs, leaf->minmaxs, sizeof(vis_leaf->minmaxs));
+        vis_leaf->first_mark_surface = leaf->first_mark_surface;
+        vis_leaf->num_mark_surfaces  = leaf->num_mark_surfaces;
+
+        for (j = 0; j < leaf->num_mark_surfaces; ++j)
+        {
+            ps2_mdl_surface_t * surf = leaf->first_mark_surface[j];
+            const int surf_index = (int)(surf - world_mdl->surfaces);
+
+            if ((surf_added[surf_index >> 3] & (1 << (surf_index & 7))) || !PS2_WorldVisSurfIsOpaque(surf))
+            {
+                continue;
+            }
+            surf_added[surf_index >> 3] |= (1 << (surf_index & 7));
+            vis->surfaces[num_surfaces++] = surf;
+        }
+    }
+
+    if (num_surfaces > 1)
+    {
+        qsort(vis->surfaces, num_surfaces, sizeof(ps2_mdl_surface_t *), &PS2_WorldVisCompareSurfs);
+    }
+
+    Frame_MemFreeToMark(FRAME_MEM_REFRESH, mark);
+}
+
+/*
+================
+PS2_WorldVisFind
+================
+*/
+const ps2_world_vis_t * PS2_WorldVisFind(const ps2_model_t * world_mdl, int cluster, int cluster2, const byte * areabits)
+{
+    int i;
+    ps2_world_vis_t * vis;
+    ps2_world_vis_t * oldest = &ps2_world_vis_cache[0];
+
+    // Without vis data, every cluster sees the same.
+    if (cluster == -1 || world_mdl->vis == NULL)
+    {
+        cluster = cluster2 = -1;
+    }
+    else if (cluster2 == -1)
+    {
+        cluster2 = cluster;
+    }
+
+    ++ps2_world_vis_lookups;
+
+    for (i = 0, vis = ps2_world_vis_cache; i < WORLD_VIS_CACHE_SIZE; ++i, ++vis)
+    {
+        if (vis->world_mdl == world_mdl &&
+            ((vis->cluster == cluster && vis->cluster2 == cluster2) ||
+             (vis->cluster == cluster2 && vis->cluster2 == cluster)) &&
+            (areabits == NULL ? vis->all_areas : (!vis->all_areas && memcmp(vis->areabits, areabits, sizeof(vis->areabits)) == 0)))
+        {
+            vis->last_used = ps2_world_vis_lookups;
+            ++ps2_world_vis_hits;
+            return vis;
+        }
+
+        // Free slots have last_used = 0, so they go first.
+        if (vis->last_used < oldest->last_used)
+        {
+            oldest = vis;
+        }
+    }
+
+    PS2_WorldVisFreeSet(oldest);
+
+    oldest->world_mdl = world_mdl;
+    oldest->cluster   = cluster;
+    oldest->cluster2  = cluster2;
+    oldest->all_areas = (areabits == NULL);
+    oldest->last_used = ps2_world_vis_lookups;
+    if (areabits != NULL)
+    {
+        memcpy(oldest->areabits, areabits, sizeof(oldest->areabits));
+    }
+
+    PS2_WorldVisBuildSet(oldest, world_mdl);
+    ++ps2_world_vis_misses;
+    return oldest;
+}
+
+/*
+================
+PS2_WorldVisGather
+================
+*/
+int PS2_WorldVisGather(const ps2_world_vis_t * vis, const cplane_t * frustum, int num_planes,
+                       const vec3_t vieworg, int frame_num, ps2_mdl_surface_t ** out_surfaces)
+{
+    int i, j;
+    int num_out = 0;
+
+    // Frustum: mark the surfaces of the leafs that are in.
+    const ps2_world_vis_leaf_t * leaf = vis->leafs;
+    for (i = 0; i < vis->num_leafs; ++i, ++leaf)
+    {
+        for (j = 0; j < num_planes; ++j)
+        {
+            // Doesn't write to them.
+            if (BOX_ON_PLANE_SIDE((float *)leaf->minmaxs, (float *)leaf->minmaxs + 3, (cplane_t *)&frustum[j]) == 2)
+            {
+                break;
+            }
+        }
+        if (j != num_planes)
+        {
+            continue;
+        }
+
+        ps2_mdl_surface_t ** mark = leaf->first_mark_surface;
+        for (j = leaf->num_mark_surfaces; j; --j, ++mark)
+        {
+            (*mark)->vis_frame = frame_num;
+        }
+    }
+
+    // Facing: the marked surfaces that have the viewer on their side of the plane, in texture order.
+    ps2_mdl_surface_t * const * surf_iter = vis->surfaces;
+    for (i = 0; i < vis->num_surfaces; ++i, ++surf_iter)
+    {
+        ps2_mdl_surface_t * surf = *surf_iter;
+        if (surf->vis_frame != frame_num)
+        {
+            continue;
+        }
+
+        const cplane_t * plane = surf->plane;
+        const float dot = DotProduct(vieworg, plane->normal) - plane->dist;
+        const int sidebit = (dot >= 0.0f) ? 0 : SURF_PLANEBACK;
+        if ((surf->flags & SURF_PLANEBACK) != sidebit)
+        {
+            continue; // Wrong side.
+        }
+
+        out_surfaces[num_out++] = surf;
+    }
+
+    return num_out;
+}
+
+/*
+================
+PS2_WorldVisReset
+================
+*/
+void PS2_WorldVisReset(void)
+{
+    int i;
+    for (i = 0; i < WORLD_VIS_CACHE_SIZE; ++i)
+    {
+        PS2_WorldVisFreeSet(&ps2_world_vis_cache[i]);
+    }
+
+    ps2_world_vis_lookups = 0;
+    ps2_world_vis_hits    = 0;
+    ps2_world_vis_misses  = 0;
+}
+
+/*
+================
+PS2_WorldVisGetStats
+================
+*/
+void PS2_WorldVisGetStats(ps2_world_vis_stats_t * stats)
+{
+    int i;
+    memset(stats, 0, sizeof(*stats));
+
+    stats->hits   = ps2_world_vis_hits;
+    stats->misses = ps2_world_vis_misses;
+
+    for (i = 0; i < WORLD_VIS_CACHE_SIZE; ++i)
+    {
+        if (ps2_world_vis_cache[i].world_mdl != NULL)
+        {
+            ++stats->num_sets;
+            stats->mem_bytes += ps2_world_vis_cache[i].mem_bytes;
+        }
+    }
+}
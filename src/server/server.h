@@ -264,6 +264,24 @@ void SV_BroadcastCommand(const char * fmt, ...);
 //
 void SV_Nextserver(void);
 void SV_ExecuteClientMessage(client_t * cl);
+void SV_ClientThink(client_t * cl, usercmd_t * cmd);
+
+//
+// sv_bench.c
+//
+typedef enum
+{
+    SVBENCH_GAME,  // ClientThink + G_RunFrame, minus link and trace
+    SVBENCH_LINK,  // gi.linkentity
+    SVBENCH_TRACE, // gi.trace
+    SVBENCH_BUILD, // SV_BuildClientFrame
+    SVBENCH_SEND,  // SV_SendClientMessages, minus build
+    SVBENCH_COUNT
+} sv_bench_stage_t;
+
+extern qboolean sv_bench_active;
+extern unsigned int sv_bench_usec[SVBENCH_COUNT];
+void SV_Bench_f(void);
 
 //
 // sv_ccmds.c
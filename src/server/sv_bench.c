@@ -0,0 +1,287 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: sv_bench.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Server tick benchmark. Loads a map, fills it with scripted fake
+ *        clients and runs SV_Frame back-to-back, timing each server stage.
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "server.h"
+
+qboolean sv_bench_active = false;
+unsigned int sv_bench_usec[SVBENCH_COUNT];
+
+static const char * sv_bench_stage_names[SVBENCH_COUNT] =
+{
+    "game",
+    "link",
+    "trace",
+    "build",
+    "send"
+};
+
+/*
+==================
+SV_Bench_SpawnClient
+
+Fake clients go through the same ClientConnect/ClientBegin path
+as a real connection, but they have a dummy IP address, so
+anything the server transmits to them is silently dropped.
+==================
+*/
+static client_t * SV_Bench_SpawnClient(int botnum)
+{
+    int i;
+    client_t * cl;
+    char userinfo[MAX_INFO_STRING];
+
+    for (i = 0, cl = svs.clients; i < maxclients->value; i++, cl++)
+    {
+        if (cl->state == cs_free)
+        {
+            break;
+        }
+    }
+    if (i == maxclients->value)
+    {
+        return NULL;
+    }
+
+    memset(cl, 0, sizeof(client_t));
+    cl->edict = EDICT_NUM(i + 1);
+    cl->lastframe = -1;
+
+    Com_sprintf(userinfo, sizeof(userinfo), "\\name\\bot%i\\skin\\male/grunt\\hand\\2\\rate\\15000", botnum);
+    if (!ge->ClientConnect(cl->edict, userinfo))
+    {
+        Com_Printf("sv_bench: game rejected bot%i\n", botnum);
+        return NULL;
+    }
+
+    strncpy(cl->userinfo, userinfo, sizeof(cl->userinfo) - 1);
+    SV_UserinfoChanged(cl);
+
+    {
+        netadr_t adr;
+        memset(&adr, 0, sizeof(adr));
+        adr.type = NA_IP;
+        adr.ip[0] = 10;
+        adr.ip[3] = (byte)(botnum + 1);
+        Netchan_Setup(NS_SERVER, &cl->netchan, adr, botnum);
+    }
+
+    SZ_Init(&cl->datagram, cl->datagram_buf, sizeof(cl->datagram_buf));
+    cl->datagram.allowoverflow = true;
+    cl->lastmessage = svs.realtime;
+    cl->lastconnect = svs.realtime;
+    cl->state = cs_spawned;
+
+    ge->ClientBegin(cl->edict);
+    return cl;
+}
+
+/*
+==================
+SV_Bench_AckClient
+
+Pretend the client got everything we sent last frame, like a
+perfect connection would, so reliable data and entity deltas
+behave as they do in a normal game.
+==================
+*/
+static void SV_Bench_AckClient(client_t * cl)
+{
+    netchan_t * chan = &cl->netchan;
+
+    chan->incoming_acknowledged = chan->outgoing_sequence - 1;
+    chan->incoming_reliable_acknowledged = chan->reliable_sequence;
+    chan->reliable_length = 0;
+    chan->last_received = curtime;
+
+    cl->lastframe = sv.framenum;
+    cl->lastmessage = svs.realtime;
+    memset(cl->message_size, 0, sizeof(cl->message_size)); // no rate drops
+}
+
+/*
+==================
+SV_Bench_MakeCmd
+
+Canned input: each bot cycles through running, strafing,
+turning, jumping and firing, offset by its bot number so
+they don't all move in lockstep.
+==================
+*/
+static void SV_Bench_MakeCmd(int botnum, int tick, usercmd_t * cmd)
+{
+    const int t = tick + botnum * 7;
+    const int phase = (t / 20) % 5;
+
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->msec = 100;
+    cmd->angles[YAW] = ANGLE2SHORT((botnum * 45 + t * 3) % 360);
+    cmd->forwardmove = 200;
+
+    switch (phase)
+    {
+    case 1:
+        cmd->sidemove = (botnum & 1) ? 200 : -200;
+        break;
+    case 2:
+        cmd->angles[YAW] = ANGLE2SHORT((botnum * 45 + t * 18) % 360);
+        cmd->forwardmove = 0;
+        break;
+    case 3:
+        if ((t % 10) == 0)
+        {
+            cmd->upmove = 200;
+        }
+        break;
+    case 4:
+        cmd->buttons = BUTTON_ATTACK;
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+==================
+SV_Bench_f
+
+sv_bench <map> [clients] [ticks]
+==================
+*/
+void SV_Bench_f(void)
+{
+    int i, s, tick;
+    int numbots, numticks;
+    char expanded[MAX_QPATH];
+    const char * map;
+    client_t * bots[MAX_CLIENTS];
+    usercmd_t cmd;
+    unsigned int start, tick_start, tick_usec, max_tick_usec;
+    double total_usec, other_usec;
+
+    if (Cmd_Argc() < 2)
+    {
+        Com_Printf("USAGE: sv_bench <map> [clients] [ticks]\n");
+        return;
+    }
+
+    map = Cmd_Argv(1);
+    numbots = (Cmd_Argc() > 2) ? atoi(Cmd_Argv(2)) : 4;
+    numticks = (Cmd_Argc() > 3) ? atoi(Cmd_Argv(3)) : 600;
+
+    if (numbots < 0)
+        numbots = 0;
+    if (numbots > MAX_CLIENTS)
+        numbots = MAX_CLIENTS;
+    if (numticks < 1)
+        numticks = 1;
+
+    Com_sprintf(expanded, sizeof(expanded), "maps/%s.bsp", map);
+    if (FS_LoadFile(expanded, NULL) == -1)
+    {
+        Com_Printf("Can't find %s\n", expanded);
+        return;
+    }
+
+    // Single player only has one client slot, so default to
+    // coop, which keeps the monsters. Set deathmatch for more
+    // than 4 clients.
+    if (!Cvar_VariableValue("deathmatch") && !Cvar_VariableValue("coop"))
+    {
+        Cvar_FullSet("coop", "1", CVAR_SERVERINFO | CVAR_LATCH);
+    }
+    Cvar_FullSet("maxclients", va("%i", numbots), CVAR_SERVERINFO | CVAR_LATCH);
+
+    sv.state = ss_dead;
+    SV_Map(false, map, false);
+    if (sv.state != ss_game)
+    {
+        return;
+    }
+
+    for (i = 0; i < numbots; ++i)
+    {
+        bots[i] = SV_Bench_SpawnClient(i);
+        if (!bots[i])
+        {
+            break;
+        }
+    }
+    if (i != numbots)
+    {
+        Com_Printf("sv_bench: only %i of %i clients fit (maxclients %i)\n",
+                   i, numbots, (int)maxclients->value);
+        numbots = i;
+    }
+
+    memset(sv_bench_usec, 0, sizeof(sv_bench_usec));
+    total_usec = 0.0;
+    max_tick_usec = 0;
+    sv_bench_active = true;
+
+    for (tick = 0; tick < numticks; ++tick)
+    {
+        tick_start = Sys_Microseconds();
+
+        // Make SV_Frame run a game frame every call instead of sleeping.
+        svs.realtime = sv.time;
+
+        for (i = 0; i < numbots; ++i)
+        {
+            SV_Bench_AckClient(bots[i]);
+            SV_Bench_MakeCmd(i, tick, &cmd);
+
+            start = Sys_Microseconds();
+            SV_ClientThink(bots[i], &cmd);
+            bots[i]->lastcmd = cmd;
+            sv_bench_usec[SVBENCH_GAME] += Sys_Microseconds() - start;
+        }
+
+        SV_Frame(100);
+
+        tick_usec = Sys_Microseconds() - tick_start;
+        total_usec += tick_usec;
+        if (tick_usec > max_tick_usec)
+        {
+            max_tick_usec = tick_usec;
+        }
+    }
+
+    sv_bench_active = false;
+
+    // Link and trace are called from inside the game code and
+    // snapshot building from inside send, so report exclusive times.
+    sv_bench_usec[SVBENCH_GAME] -= sv_bench_usec[SVBENCH_LINK] + sv_bench_usec[SVBENCH_TRACE];
+    sv_bench_usec[SVBENCH_SEND] -= sv_bench_usec[SVBENCH_BUILD];
+
+    Com_Printf("sv_bench: %s, %i clients, %i edicts, %i ticks\n",
+               map, numbots, ge->num_edicts, numticks);
+    Com_Printf("stage      ms/tick\n");
+
+    other_usec = total_usec;
+    for (s = 0; s < SVBENCH_COUNT; ++s)
+    {
+        Com_Printf("%-8s %9.4f\n", sv_bench_stage_names[s], sv_bench_usec[s] / 1000.0 / numticks);
+        other_usec -= sv_bench_usec[s];
+    }
+    Com_Printf("%-8s %9.4f\n", "other", other_usec / 1000.0 / numticks);
+    Com_Printf("%-8s %9.4f (max %.3f)\n", "total", total_usec / 1000.0 / numticks, max_tick_usec / 1000.0);
+
+    for (i = 0; i < numbots; ++i)
+    {
+        SV_DropClient(bots[i]);
+        bots[i]->state = cs_free;
+    }
+
+    // SV_Map deferred the rest of the command buffer until a client
+    // sends "begin", which the fake clients never do.
+    Cbuf_InsertFromDefer();
+}
@@ -306,6 +306,44 @@ void PF_StartSound(edict_t * entity, int channel, int sound_num,
     SV_StartSound(NULL, entity, channel, sound_num, volume, attenuation, timeofs);
 }
 
+/*
+===============
+PF_LinkEdict / PF_Trace
+
+LAMPERT: Timed wrappers for the sv_bench command.
+===============
+*/
+static void PF_LinkEdict(edict_t * ent)
+{
+    unsigned int start;
+
+    if (!sv_bench_active)
+    {
+        SV_LinkEdict(ent);
+        return;
+    }
+
+    start = Sys_Microseconds();
+    SV_LinkEdict(ent);
+    sv_bench_usec[SVBENCH_LINK] += Sys_Microseconds() - start;
+}
+
+static trace_t PF_Trace(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t * passedict, int contentmask)
+{
+    unsigned int start_us;
+    trace_t tr;
+
+    if (!sv_bench_active)
+    {
+        return SV_Trace(start, mins, maxs, end, passedict, contentmask);
+    }
+
+    start_us = Sys_Microseconds();
+    tr = SV_Trace(start, mins, maxs, end, passedict, contentmask);
+    sv_bench_usec[SVBENCH_TRACE] += Sys_Microseconds() - start_us;
+    return tr;
+}
+
 //==============================================
 
 void SCR_DebugGraph(float value, int color);
@@ -357,10 +395,10 @@ void SV_InitGameProgs(void)
     import.centerprintf = PF_centerprintf;
     import.error = PF_error;
 
-    import.linkentity = SV_LinkEdict;
+    import.linkentity = PF_LinkEdict;
     import.unlinkentity = SV_UnlinkEdict;
     import.BoxEdicts = SV_AreaEdicts;
-    import.trace = SV_Trace;
+    import.trace = PF_Trace;
     import.pointcontents = SV_PointContents;
     import.setmodel = PF_setmodel;
     import.inPVS = PF_inPVS;
@@ -704,6 +704,8 @@ SV_RunGameFrame
 */
 void SV_RunGameFrame(void)
 {
+    unsigned int bench_start;
+
     if (host_speeds->value)
     {
         time_before_game = Sys_Milliseconds();
@@ -719,7 +721,12 @@ void SV_RunGameFrame(void)
     // don't run if paused
     if (!sv_paused->value || maxclients->value > 1)
     {
+        bench_start = sv_bench_active ? Sys_Microseconds() : 0;
         ge->RunFrame();
+        if (sv_bench_active)
+        {
+            sv_bench_usec[SVBENCH_GAME] += Sys_Microseconds() - bench_start;
+        }
 
         // never get more than one tic behind
         if (sv.time < svs.realtime)
@@ -745,6 +752,8 @@ SV_Frame
 */
 void SV_Frame(int msec)
 {
+    unsigned int bench_start;
+
     time_before_game = time_after_game = 0;
 
     // if server is not active, do nothing
@@ -755,6 +764,9 @@ void SV_Frame(int msec)
 
     svs.realtime += msec;
 
+    // LAMPERT: scratch memory from the last frame is no longer needed.
+    Frame_MemReset(FRAME_MEM_SERVER);
+
     // keep the random time dependent
     rand();
 
@@ -790,7 +802,12 @@ void SV_Frame(int msec)
     SV_RunGameFrame();
 
     // send messages back to the clients that had packets read this frame
+    bench_start = sv_bench_active ? Sys_Microseconds() : 0;
     SV_SendClientMessages();
+    if (sv_bench_active)
+    {
+        sv_bench_usec[SVBENCH_SEND] += Sys_Microseconds() - bench_start;
+    }
 
     // save the entire world state if recording a serverdemo
     SV_RecordDemoMessage();
@@ -388,8 +388,14 @@ qboolean SV_SendClientDatagram(client_t * client)
 {
     byte msg_buf[MAX_MSGLEN];
     sizebuf_t msg;
+    unsigned int bench_start;
 
+    bench_start = sv_bench_active ? Sys_Microseconds() : 0;
     SV_BuildClientFrame(client);
+    if (sv_bench_active)
+    {
+        sv_bench_usec[SVBENCH_BUILD] += Sys_Microseconds() - bench_start;
+    }
 
     SZ_Init(&msg, msg_buf, sizeof(msg_buf));
     msg.allowoverflow = true;
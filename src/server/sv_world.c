@@ -426,17 +426,23 @@ SV_PointContents
 */
 int SV_PointContents(vec3_t p)
 {
-    edict_t *touch[MAX_EDICTS], *hit;
+    edict_t **touch, *hit;
     int i, num;
     int contents, c2;
     int headnode;
     float * angles;
+    int mark;
 
     // get base contents from world
     contents = CM_PointContents(p, sv.models[1]->headnode);
 
+    // LAMPERT: The touch list used to be a MAX_EDICTS array on the stack.
+    // Nothing can touch more than the edicts in use, so size it by that.
+    mark = Frame_MemGetMark(FRAME_MEM_SERVER);
+    touch = (edict_t **)Frame_MemAlloc(FRAME_MEM_SERVER, ge->num_edicts * sizeof(edict_t *));
+
     // or in contents from all the other entities
-    num = SV_AreaEdicts(p, p, touch, MAX_EDICTS, AREA_SOLID);
+    num = SV_AreaEdicts(p, p, touch, ge->num_edicts, AREA_SOLID);
 
     for (i = 0; i < num; i++)
     {
@@ -453,6 +459,7 @@ int SV_PointContents(vec3_t p)
         contents |= c2;
     }
 
+    Frame_MemFreeToMark(FRAME_MEM_SERVER, mark);
     return contents;
 }
 
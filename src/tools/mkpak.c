@@ -0,0 +1,383 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: mkpak.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Command line tool that packs a directory tree into a Quake 2 PAK archive,
+ *        optionally using the compressed pak format (IDPAKZHEADER). Companion to unpak.c.
+ *
+ * Build with (from src/tools/):
+ * cc -std=c99 -O2 -I.. mkpak.c ../common/pak_lz.c -o mkpak
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// For opendir/stat
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "common/pak_lz.h"
+
+/*
+ * From Quake2 (see common/q_files.h):
+ */
+
+#define MAX_FILES_IN_PAK 4096
+
+// 4CC 'PACK'
+#define PAK_HEADER_IDENT (('K' << 24) + ('C' << 16) + ('A' << 8) + 'P')
+// 4CC 'PACZ'
+#define PAKZ_HEADER_IDENT (('Z' << 24) + ('C' << 16) + ('A' << 8) + 'P')
+
+#define PAKZ_BLOCK_SIZE   (32 * 1024)
+#define PAKZ_BLOCK_STORED 0x80000000u
+#define PAKZ_COMPRESSED   1
+
+typedef struct
+{
+    char name[56];
+    int filepos;
+    int filelen;
+} pak_file_t;
+
+typedef struct
+{
+    char name[56];
+    int filepos;
+    int filelen;
+    int complen;
+    int flags;
+} pakz_file_t;
+
+typedef struct
+{
+    int ident;
+    int dirofs;
+    int dirlen;
+} pak_header_t;
+
+/*
+ * Packer code:
+ */
+
+// Files the engine streams with FS_FOpenFile instead of FS_LoadFile
+// can't be compressed; they are always stored as is.
+static const char * stored_extensions[] = { ".dm2", ".cin", NULL };
+
+static char * file_names[MAX_FILES_IN_PAK];
+static int num_files = 0;
+
+static bool add_files(const char * base_dir, const char * rel_dir)
+{
+    char dir_path[1024];
+    char rel_path[1024];
+    char full_path[1024];
+    struct dirent * entry;
+    struct stat file_stat;
+
+    snprintf(dir_path, sizeof(dir_path), "%s%s%s", base_dir, (*rel_dir ? "/" : ""), rel_dir);
+    DIR * dir = opendir(dir_path);
+    if (dir == NULL)
+    {
+        fprintf(stderr, "Can't opendir() '%s'!\n", dir_path);
+        return false;
+    }
+
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue; // Also skips hidden files.
+        }
+
+        snprintf(rel_path, sizeof(rel_path), "%s%s%s", rel_dir, (*rel_dir ? "/" : ""), entry->d_name);
+        snprintf(full_path, sizeof(full_path), "%s/%s", base_dir, rel_path);
+
+        if (stat(full_path, &file_stat) != 0)
+        {
+            continue;
+        }
+
+        if (S_ISDIR(file_stat.st_mode))
+        {
+            if (!add_files(base_dir, rel_path))
+            {
+                closedir(dir);
+                return false;
+            }
+        }
+        else if (S_ISREG(file_stat.st_mode))
+        {
+            if (strlen(rel_path) >= sizeof(((pak_file_t *)0)->name))
+            {
+                fprintf(stderr, "Warning: name too long, skipping '%s'\n", rel_path);
+                continue;
+            }
+            if (num_files == MAX_FILES_IN_PAK)
+            {
+                fprintf(stderr, "MAX_FILES_IN_PAK exceeded!\n");
+                closedir(dir);
+                return false;
+            }
+            file_names[num_files] = malloc(strlen(rel_path) + 1);
+            strcpy(file_names[num_files++], rel_path);
+        }
+    }
+
+    closedir(dir);
+    return true;
+}
+
+static int compare_names(const void * a, const void * b)
+{
+    return strcmp(*(const char * const *)a, *(const char * const *)b);
+}
+
+static bool should_compress(const char * name)
+{
+    const char * ext = strrchr(name, '.');
+    if (ext == NULL)
+    {
+        return true;
+    }
+    for (int i = 0; stored_extensions[i] != NULL; ++i)
+    {
+        if (strcmp(ext, stored_extensions[i]) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void * load_file(const char * name, int * out_len)
+{
+    FILE * file = fopen(name, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Can't fopen() the file! %s\n", name);
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    const int len = (int)ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    // +1 so that empty files still get a valid pointer.
+    void * data = malloc(len + 1);
+    if (data == NULL || fread(data, 1, len, file) != (size_t)len)
+    {
+        fprintf(stderr, "Error reading %s!\n", name);
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+
+    fclose(file);
+    *out_len = len;
+    return data;
+}
+
+static void write_le32(unsigned char * p, unsigned int v)
+{
+    p[0] = (unsigned char)(v);
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+// Compresses the entry into a run of blocks in 'out', which must have room
+// for 'len' plus 4 bytes per block. Returns the compressed size.
+static int compress_file(const unsigned char * data, int len, unsigned char * out)
+{
+    unsigned char * op = out;
+
+    for (int pos = 0; pos < len; pos += PAKZ_BLOCK_SIZE)
+    {
+        const int block_len = (len - pos < PAKZ_BLOCK_SIZE) ? (len - pos) : PAKZ_BLOCK_SIZE;
+        int comp_len = PakLZ_CompressBlock(data + pos, block_len, op + 4, block_len);
+
+        if (comp_len > 0)
+        {
+            write_le32(op, (unsigned int)comp_len);
+        }
+        else
+        {
+            comp_len = block_len;
+            write_le32(op, (unsigned int)block_len | PAKZ_BLOCK_STORED);
+            memcpy(op + 4, data + pos, block_len);
+        }
+        op += 4 + comp_len;
+    }
+
+    return (int)(op - out);
+}
+
+static bool mkpak(const char * src_dir, const char * pak_name, bool compress)
+{
+    static pak_file_t pak_entries[MAX_FILES_IN_PAK];
+    static pakz_file_t pakz_entries[MAX_FILES_IN_PAK];
+
+    pak_header_t pak_header;
+    long long total_in = 0;
+    long long total_out = 0;
+
+    if (!add_files(src_dir, ""))
+    {
+        return false;
+    }
+    qsort(file_names, num_files, sizeof(char *), compare_names);
+
+    FILE * pak_file = fopen(pak_name, "wb");
+    if (pak_file == NULL)
+    {
+        fprintf(stderr, "Can't fopen() the file! %s\n", pak_name);
+        return false;
+    }
+
+    // Header is rewritten once the directory offset is known.
+    memset(&pak_header, 0, sizeof(pak_header));
+    fwrite(&pak_header, 1, sizeof(pak_header), pak_file);
+
+    for (int i = 0; i < num_files; ++i)
+    {
+        char full_path[1024];
+        snprintf(full_path, sizeof(full_path), "%s/%s", src_dir, file_names[i]);
+
+        int len = 0;
+        unsigned char * data = load_file(full_path, &len);
+        if (data == NULL)
+        {
+            fclose(pak_file);
+            return false;
+        }
+
+        const int filepos = (int)ftell(pak_file);
+        const unsigned char * out_data = data;
+        unsigned char * comp_data = NULL;
+        int complen = len;
+        int flags = 0;
+
+        if (compress && should_compress(file_names[i]) && len > 0)
+        {
+            comp_data = malloc(len + 4 * (len / PAKZ_BLOCK_SIZE + 1));
+            if (comp_data == NULL)
+            {
+                fprintf(stderr, "Out-of-memory in mkpak!\n");
+                free(data);
+                fclose(pak_file);
+                return false;
+            }
+
+            // Only keep it if it paid off, counting the block headers.
+            const int comp_len = compress_file(data, len, comp_data);
+            if (comp_len < len)
+            {
+                out_data = comp_data;
+                complen = comp_len;
+                flags = PAKZ_COMPRESSED;
+            }
+        }
+
+        const bool write_ok = (fwrite(out_data, 1, complen, pak_file) == (size_t)complen);
+        free(comp_data);
+        free(data);
+
+        if (!write_ok)
+        {
+            fprintf(stderr, "Error writing %s!\n", pak_name);
+            fclose(pak_file);
+            return false;
+        }
+
+        strncpy(pak_entries[i].name, file_names[i], sizeof(pak_entries[i].name));
+        pak_entries[i].filepos = filepos;
+        pak_entries[i].filelen = len;
+
+        strncpy(pakz_entries[i].name, file_names[i], sizeof(pakz_entries[i].name));
+        pakz_entries[i].filepos = filepos;
+        pakz_entries[i].filelen = len;
+        pakz_entries[i].complen = complen;
+        pakz_entries[i].flags   = flags;
+
+        total_in  += len;
+        total_out += complen;
+    }
+
+    // The directory goes at the end, after the last file.
+    pak_header.ident  = compress ? PAKZ_HEADER_IDENT : PAK_HEADER_IDENT;
+    pak_header.dirofs = (int)ftell(pak_file);
+    if (compress)
+    {
+        pak_header.dirlen = num_files * (int)sizeof(pakz_file_t);
+        fwrite(pakz_entries, 1, pak_header.dirlen, pak_file);
+    }
+    else
+    {
+        pak_header.dirlen = num_files * (int)sizeof(pak_file_t);
+        fwrite(pak_entries, 1, pak_header.dirlen, pak_file);
+    }
+
+    fseek(pak_file, 0, SEEK_SET);
+    fwrite(&pak_header, 1, sizeof(pak_header), pak_file);
+
+    const bool ok = !ferror(pak_file);
+    fclose(pak_file);
+
+    printf("%s: %d files, %lld KB -> %lld KB (%.1f%%)\n", pak_name, num_files,
+           total_in / 1024, total_out / 1024, total_in ? (100.0 * total_out / total_in) : 100.0);
+    return ok;
+}
+
+int main(int argc, const char * argv[])
+{
+    bool compress = true;
+    int arg = 1;
+
+    if (arg < argc && strcmp(argv[arg], "-s") == 0)
+    {
+        compress = false;
+        ++arg;
+    }
+
+    if (arg >= argc)
+    {
+        fprintf(stderr, "No directory!\n");
+        printf("Usage: \n"
+               " $ %s [-s] <dir> [file.pak]\n"
+               "   Packs the whole directory tree into a compressed pak, named after the\n"
+               "   directory if no output name is given. Demos and cinematics are stored\n"
+               "   uncompressed, since the engine streams them.\n"
+               "   -s writes a plain uncompressed pak instead.\n",
+               argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char pak_name[512];
+    const char * src_dir = argv[arg];
+
+    if (arg + 1 < argc)
+    {
+        strncpy(pak_name, argv[arg + 1], sizeof(pak_name) - 1);
+        pak_name[sizeof(pak_name) - 1] = '\0';
+    }
+    else
+    {
+        snprintf(pak_name, sizeof(pak_name), "%s.pak", src_dir);
+    }
+
+    if (!mkpak(src_dir, pak_name, compress))
+    {
+        fprintf(stderr, "Unable to successfully pack directory %s!\n", src_dir);
+        return EXIT_FAILURE;
+    }
+
+    // Success.
+}
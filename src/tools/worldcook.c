@@ -0,0 +1,642 @@
+/* ================================================================================================
+ * -*- C -*-
+ * File: worldcook.c
+ * Author: Guilherme R. Lampert
+ * Created on: 16/10/26
+ * Brief: Command line tool that cooks BSP maps into the render-ready format loaded
+ *        by the PS2 renderer (maps/<name>.pcw, see ps2/model_load.h).
+ *
+ * The map is loaded by ps2/model_load.c itself, built for the host, so the cooked
+ * arrays are exactly what PS2_LoadBrushModel would produce on the console. This file
+ * stands in for the bits of the engine and renderer the model loader calls into.
+ *
+ * Built by 'make host-bench' (build/host/worldcook). Usage:
+ * worldcook <game dir> <map> [<map> ...]
+ *
+ * This source code is released under the GNU GPL v2 license.
+ * Check the accompanying LICENSE file for details.
+ * ================================================================================================ */
+
+#include "ps2/model_load.h"
+#include "ps2/mem_alloc.h"
+#include "common/q_files.h"
+#include "common/pak_lz.h"
+#include "common/q_ltrace.h"
+
+#include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+/*
+ * Engine/renderer stand-ins used by model_load.c:
+ */
+
+// Same as the debug checker texture in tex_image.c
+enum { DEBUG_TEX_DIM = 64 };
+
+ps2_refresh_t ps2ref;
+ps2_teximage_t * ps2_builtin_tex_debug = NULL;
+
+static const char * game_dir = ".";
+static int teximages_used = 0;
+
+void Sys_Error(const char * error, ...)
+{
+    va_list argptr;
+    va_start(argptr, error);
+    fprintf(stderr, "Error: ");
+    vfprintf(stderr, error, argptr);
+    fprintf(stderr, "\n");
+    va_end(argptr);
+    exit(EXIT_FAILURE);
+}
+
+void Com_Printf(const char * fmt, ...)
+{
+    va_list argptr;
+    va_start(argptr, fmt);
+    vprintf(fmt, argptr);
+    va_end(argptr);
+}
+
+void Com_DPrintf(const char * fmt, ...)
+{
+    (void)fmt; // Quiet.
+}
+
+int Sys_Milliseconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+// Same as sys_ps2.c
+u32 Sys_HashString(const char * str)
+{
+    u32 hash = 0;
+
+    while (*str != '\0')
+    {
+        hash += *str++;
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+
+    hash += (hash << 3);
+    hash ^= (hash >> 11);
+    hash += (hash << 15);
+
+    return hash;
+}
+
+// No load trace in the cooker, it prints its own timing.
+unsigned int LTrace_Start(void)
+{
+    return 0;
+}
+
+void LTrace_Stage(const char * stage, const char * name, int bytes, unsigned int start)
+{
+}
+
+void LTrace_Cache(const char * cache, const char * name, qboolean hit)
+{
+}
+
+int Dbg_GetDebugColorIndex(void)
+{
+    return 0; // Not stored in the cooked file.
+}
+
+// Cvars just hold their default value.
+cvar_t * Cvar_Get(const char * var_name, const char * value, int flags)
+{
+    enum { MAX_COOK_CVARS = 32 };
+    static cvar_t cvars[MAX_COOK_CVARS];
+    static int num_cvars = 0;
+
+    int i;
+    for (i = 0; i < num_cvars; ++i)
+    {
+        if (strcmp(cvars[i].name, var_name) == 0)
+        {
+            return &cvars[i];
+        }
+    }
+
+    if (num_cvars == MAX_COOK_CVARS)
+    {
+        Sys_Error("Too many cvars!");
+    }
+
+    cvar_t * var = &cvars[num_cvars++];
+    var->name   = (char *)var_name;
+    var->string = (char *)value;
+    var->flags  = flags;
+    var->value  = atof(value);
+    return var;
+}
+
+/*
+ * Minimal file system: loose files in the game dir, then pak0..pak9.
+ */
+
+static void * Cook_LoadFromPak(const char * pak_name, const char * filename, int * out_len)
+{
+    FILE * file = fopen(pak_name, "rb");
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    byte * data = NULL;
+    dpackheader_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        (header.ident != IDPAKHEADER && header.ident != IDPAKZHEADER))
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    const qboolean compressed = (header.ident == IDPAKZHEADER);
+    const int entry_size = compressed ? sizeof(dpackzfile_t) : sizeof(dpackfile_t);
+    const int num_entries = header.dirlen / entry_size;
+
+    int i;
+    for (i = 0; i < num_entries; ++i)
+    {
+        dpackzfile_t entry;
+        memset(&entry, 0, sizeof(entry));
+
+        fseek(file, header.dirofs + i * entry_size, SEEK_SET);
+        if (fread(&entry, entry_size, 1, file) != 1)
+        {
+            break;
+        }
+        if (Q_stricmp(entry.name, filename) != 0)
+        {
+            continue;
+        }
+
+        const int stored_len = (entry.flags & PAKZ_COMPRESSED) ? entry.complen : entry.filelen;
+        byte * stored = malloc(stored_len + 1);
+        fseek(file, entry.filepos, SEEK_SET);
+        if (fread(stored, 1, stored_len, file) != (size_t)stored_len)
+        {
+            free(stored);
+            break;
+        }
+
+        if (!(entry.flags & PAKZ_COMPRESSED))
+        {
+            data = stored;
+            *out_len = entry.filelen;
+            break;
+        }
+
+        // Decode the blocks (see IDPAKZHEADER):
+        data = malloc(entry.filelen + 1);
+        int in_pos, out_pos;
+        for (in_pos = 0, out_pos = 0; out_pos < entry.filelen;)
+        {
+            const unsigned int block_header = stored[in_pos] | (stored[in_pos + 1] << 8) |
+                                              (stored[in_pos + 2] << 16) | ((unsigned int)stored[in_pos + 3] << 24);
+            const int block_len = block_header & ~PAKZ_BLOCK_STORED;
+            const int out_len_block = (entry.filelen - out_pos < PAKZ_BLOCK_SIZE) ? (entry.filelen - out_pos) : PAKZ_BLOCK_SIZE;
+            in_pos += 4;
+
+            if (block_header & PAKZ_BLOCK_STORED)
+            {
+                memcpy(data + out_pos, stored + in_pos, out_len_block);
+            }
+            else if (PakLZ_DecompressBlock(stored + in_pos, block_len, data + out_pos, out_len_block) != out_len_block)
+            {
+                Sys_Error("Corrupt compressed entry '%s' in '%s'", filename, pak_name);
+            }
+
+            in_pos  += block_len;
+            out_pos += out_len_block;
+        }
+
+        free(stored);
+        *out_len = entry.filelen;
+        break;
+    }
+
+    fclose(file);
+    return data;
+}
+
+int FS_LoadFile(const char * filename, void ** buffer)
+{
+    int i, len = -1;
+    char path[MAX_OSPATH];
+    void * data = NULL;
+
+    Com_sprintf(path, sizeof(path), "%s/%s", game_dir, filename);
+    FILE * file = fopen(path, "rb");
+    if (file != NULL)
+    {
+        fseek(file, 0, SEEK_END);
+        len = (int)ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        data = malloc(len + 1);
+        if (fread(data, 1, len, file) != (size_t)len)
+        {
+            Sys_Error("Error reading '%s'", path);
+        }
+        fclose(file);
+    }
+
+    for (i = 0; data == NULL && i < 10; ++i)
+    {
+        Com_sprintf(path, sizeof(path), "%s/pak%i.pak", game_dir, i);
+        data = Cook_LoadFromPak(path, filename, &len);
+    }
+
+    *buffer = data;
+    return (data != NULL) ? len : -1;
+}
+
+void FS_FreeFile(void * buffer)
+{
+    free(buffer);
+}
+
+// Not needed, the cooker doesn't load cooked files.
+qboolean CM_MapChecksum(const char * name, unsigned * checksum)
+{
+    (void)name;
+    (void)checksum;
+    return false;
+}
+
+// Same rounding as Common8BitTexSetup/RoundToPowerOfTwo in tex_image.c
+static int Cook_TexImageSize(int x)
+{
+    int k;
+    if (x >= MAX_TEXIMAGE_SIZE)
+    {
+        return MAX_TEXIMAGE_SIZE;
+    }
+    if ((x & (x - 1)) == 0)
+    {
+        return x;
+    }
+
+    // Round nearest:
+    for (k = sizeof(int) * 8 - 1; ((1 << k) & x) == 0; --k)
+    {
+    }
+    return (((1 << (k - 1)) & x) == 0) ? (1 << k) : (1 << (k + 1));
+}
+
+/*
+==============
+PS2_TexImageFindOrLoad
+
+Only the size matters to the model loader. Walls are set up with the
+size tex_image.c will give them, rounded to a power of two and clamped
+to MAX_TEXIMAGE_SIZE, so the tex coords match the textures on the PS2.
+==============
+*/
+ps2_teximage_t * PS2_TexImageFindOrLoad(const char * name, int flags)
+{
+    int i;
+    for (i = 0; i < teximages_used; ++i)
+    {
+        if (strcmp(ps2ref.teximages[i].name, name) == 0)
+        {
+            return &ps2ref.teximages[i];
+        }
+    }
+
+    if (teximages_used == MAX_TEXIMAGES)
+    {
+        Sys_Error("Out of teximages!");
+    }
+
+    ps2_teximage_t * teximage = &ps2ref.teximages[teximages_used++];
+    strncpy(teximage->name, name, MAX_QPATH - 1);
+    teximage->type   = flags;
+    teximage->width  = DEBUG_TEX_DIM;
+    teximage->height = DEBUG_TEX_DIM;
+
+    miptex_t * wall = NULL;
+    if (FS_LoadFile(name, (void **)&wall) >= (int)sizeof(miptex_t))
+    {
+        teximage->width  = Cook_TexImageSize(LittleLong(wall->width));
+        teximage->height = Cook_TexImageSize(LittleLong(wall->height));
+    }
+    else
+    {
+        printf("Warning: Can't load '%s', using the debug texture size.\n", name);
+    }
+
+    FS_FreeFile(wall);
+    return teximage;
+}
+
+/*
+ * Cooker code:
+ */
+
+typedef struct
+{
+    FILE * file;
+    dcookedworld_t header;
+} cook_writer_t;
+
+static void Cook_WriteLump(cook_writer_t * writer, int lump, const void * data, int len)
+{
+    static const byte zeros[COOKED_WORLD_LUMP_ALIGN];
+
+    long pos = ftell(writer->file);
+    const int pad = (int)((COOKED_WORLD_LUMP_ALIGN - (pos % COOKED_WORLD_LUMP_ALIGN)) % COOKED_WORLD_LUMP_ALIGN);
+    fwrite(zeros, 1, pad, writer->file);
+
+    writer->header.lumps[lump].fileofs = (int)(pos + pad);
+    writer->header.lumps[lump].filelen = len;
+    if (len > 0)
+    {
+        fwrite(data, 1, len, writer->file);
+    }
+}
+
+static void * Cook_Alloc(int count, int elem_size)
+{
+    // +1 so that empty arrays still get a valid pointer.
+    void * mem = calloc(count + 1, elem_size);
+    if (mem == NULL)
+    {
+        Sys_Error("Out-of-memory in worldcook!");
+    }
+    return mem;
+}
+
+static qboolean Cook_World(const char * map_name)
+{
+    int i, j;
+    char bsp_name[MAX_QPATH];
+    char out_path[MAX_OSPATH];
+    void * bsp_data = NULL;
+
+    Com_sprintf(bsp_name, sizeof(bsp_name), "maps/%s.bsp", map_name);
+
+    // Only needed for its checksum and the raw lump lengths.
+    const int bsp_len = FS_LoadFile(bsp_name, &bsp_data);
+    if (bsp_data == NULL)
+    {
+        fprintf(stderr, "Can't find '%s'!\n", bsp_name);
+        return false;
+    }
+    const dheader_t * bsp_header = (const dheader_t *)bsp_data;
+    const int light_len = LittleLong(bsp_header->lumps[LUMP_LIGHTING].filelen);
+    const int vis_len   = LittleLong(bsp_header->lumps[LUMP_VISIBILITY].filelen);
+
+    const int start_time = Sys_Milliseconds();
+    const ps2_model_t * mdl = PS2_ModelFindOrLoad(bsp_name, MDL_BRUSH);
+    const int load_time = Sys_Milliseconds() - start_time;
+    if (mdl == NULL)
+    {
+        fprintf(stderr, "Failed to load '%s'!\n", bsp_name);
+        FS_FreeFile(bsp_data);
+        return false;
+    }
+
+    //
+    // Texinfos:
+    //
+    dcw_texinfo_t * texinfos = Cook_Alloc(mdl->num_texinfos, sizeof(dcw_texinfo_t));
+    for (i = 0; i < mdl->num_texinfos; ++i)
+    {
+        const ps2_mdl_texinfo_t * in = &mdl->texinfos[i];
+        memcpy(texinfos[i].vecs, in->vecs, sizeof(in->vecs));
+        texinfos[i].flags      = in->flags;
+        texinfos[i].num_frames = in->num_frames;
+        texinfos[i].next       = (in->next != NULL) ? (int)(in->next - mdl->texinfos) : -1;
+        texinfos[i].width      = in->teximage->width;
+        texinfos[i].height     = in->teximage->height;
+        strncpy(texinfos[i].texture, in->teximage->name, MAX_QPATH - 1);
+    }
+
+    //
+    // Surfaces and their polygons, which get packed into flat arrays:
+    //
+    int num_polys = 0;
+    int num_poly_verts = 0;
+    int num_triangles = 0;
+    for (i = 0; i < mdl->num_surfaces; ++i)
+    {
+        const ps2_mdl_poly_t * poly = mdl->surfaces[i].polys;
+        if (poly != NULL)
+        {
+            num_polys      += 1;
+            num_poly_verts += poly->num_verts;
+            num_triangles  += (poly->num_verts > 2) ? (poly->num_verts - 2) : 0;
+        }
+    }
+
+    dcw_surface_t      * surfaces   = Cook_Alloc(mdl->num_surfaces, sizeof(dcw_surface_t));
+    dcw_poly_t         * polys      = Cook_Alloc(num_polys, sizeof(dcw_poly_t));
+    ps2_poly_vertex_t  * poly_verts = Cook_Alloc(num_poly_verts, sizeof(ps2_poly_vertex_t));
+    ps2_mdl_triangle_t * triangles  = Cook_Alloc(num_triangles, sizeof(ps2_mdl_triangle_t));
+
+    num_polys = num_poly_verts = num_triangles = 0;
+    for (i = 0; i < mdl->num_surfaces; ++i)
+    {
+        const ps2_mdl_surface_t * in = &mdl->surfaces[i];
+        dcw_surface_t * out = &surfaces[i];
+
+        out->plane           = (int)(in->plane - mdl->planes);
+        out->flags           = in->flags;
+        out->first_edge      = in->first_edge;
+        out->num_edges       = in->num_edges;
+        out->texture_mins[0] = in->texture_mins[0];
+        out->texture_mins[1] = in->texture_mins[1];
+        out->extents[0]      = in->extents[0];
+        out->extents[1]      = in->extents[1];
+        out->light_s         = in->light_s;
+        out->light_t         = in->light_t;
+        out->texinfo         = (int)(in->texinfo - mdl->texinfos);
+        out->light_ofs       = (in->samples != NULL) ? (int)(in->samples - mdl->light_data) : -1;
+        out->poly            = -1;
+
+        for (j = 0; j < MAXLIGHTMAPS; ++j)
+        {
+            out->styles[j] = in->styles[j];
+        }
+
+        const ps2_mdl_poly_t * poly = in->polys;
+        if (poly != NULL)
+        {
+            const int num_tris = (poly->num_verts > 2) ? (poly->num_verts - 2) : 0;
+
+            out->poly = num_polys;
+            polys[num_polys].num_verts      = poly->num_verts;
+            polys[num_polys].first_vert     = num_poly_verts;
+            polys[num_polys].first_triangle = num_triangles;
+            ++num_polys;
+
+            memcpy(poly_verts + num_poly_verts, poly->vertexes, poly->num_verts * sizeof(ps2_poly_vertex_t));
+            memcpy(triangles + num_triangles, poly->triangles, num_tris * sizeof(ps2_mdl_triangle_t));
+            num_poly_verts += poly->num_verts;
+            num_triangles  += num_tris;
+        }
+    }
+
+    //
+    // Mark surfaces, leafs and nodes:
+    //
+    int * mark_surfaces = Cook_Alloc(mdl->num_mark_surfaces, sizeof(int));
+    for (i = 0; i < mdl->num_mark_surfaces; ++i)
+    {
+        mark_surfaces[i] = (int)(mdl->mark_surfaces[i] - mdl->surfaces);
+    }
+
+    dcw_leaf_t * leafs = Cook_Alloc(mdl->num_leafs, sizeof(dcw_leaf_t));
+    for (i = 0; i < mdl->num_leafs; ++i)
+    {
+        const ps2_mdl_leaf_t * in = &mdl->leafs[i];
+        memcpy(leafs[i].minmaxs, in->minmaxs, sizeof(in->minmaxs));
+        leafs[i].contents           = in->contents;
+        leafs[i].cluster            = in->cluster;
+        leafs[i].area               = in->area;
+        leafs[i].parent             = (in->parent != NULL) ? (int)(in->parent - mdl->nodes) : -1;
+        leafs[i].first_mark_surface = (int)(in->first_mark_surface - mdl->mark_surfaces);
+        leafs[i].num_mark_surfaces  = in->num_mark_surfaces;
+    }
+
+    dcw_node_t * nodes = Cook_Alloc(mdl->num_nodes, sizeof(dcw_node_t));
+    for (i = 0; i < mdl->num_nodes; ++i)
+    {
+        const ps2_mdl_node_t * in = &mdl->nodes[i];
+        memcpy(nodes[i].minmaxs, in->minmaxs, sizeof(in->minmaxs));
+        nodes[i].parent        = (in->parent != NULL) ? (int)(in->parent - mdl->nodes) : -1;
+        nodes[i].plane         = (int)(in->plane - mdl->planes);
+        nodes[i].first_surface = in->first_surface;
+        nodes[i].num_surfaces  = in->num_surfaces;
+
+        for (j = 0; j < 2; ++j)
+        {
+            const ps2_mdl_node_t * child = in->children[j];
+            if (child->contents == -1)
+            {
+                nodes[i].children[j] = (int)(child - mdl->nodes);
+            }
+            else
+            {
+                nodes[i].children[j] = -1 - (int)((const ps2_mdl_leaf_t *)child - mdl->leafs);
+            }
+        }
+    }
+
+    //
+    // Write it out next to the .bsp:
+    //
+    Com_sprintf(out_path, sizeof(out_path), "%s/maps", game_dir);
+    if (mkdir(out_path, 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Can't create '%s'!\n", out_path);
+    }
+    Com_sprintf(out_path, sizeof(out_path), "%s/maps/%s.pcw", game_dir, map_name);
+
+    cook_writer_t writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.file = fopen(out_path, "wb");
+    if (writer.file == NULL)
+    {
+        fprintf(stderr, "Can't fopen() the file! %s\n", out_path);
+        FS_FreeFile(bsp_data);
+        return false;
+    }
+
+    // Header is rewritten once the lumps are in.
+    fwrite(&writer.header, 1, sizeof(writer.header), writer.file);
+
+    Cook_WriteLump(&writer, CW_LUMP_VERTEXES,     mdl->vertexes,      mdl->num_vertexes * sizeof(ps2_mdl_vertex_t));
+    Cook_WriteLump(&writer, CW_LUMP_EDGES,        mdl->edges,         mdl->num_edges * sizeof(ps2_mdl_edge_t));
+    Cook_WriteLump(&writer, CW_LUMP_SURFEDGES,    mdl->surf_edges,    mdl->num_surf_edges * sizeof(int));
+    Cook_WriteLump(&writer, CW_LUMP_LIGHTING,     mdl->light_data,    (mdl->light_data != NULL) ? light_len : 0);
+    Cook_WriteLump(&writer, CW_LUMP_PLANES,       mdl->planes,        mdl->num_planes * sizeof(cplane_t));
+    Cook_WriteLump(&writer, CW_LUMP_TEXINFO,      texinfos,           mdl->num_texinfos * sizeof(dcw_texinfo_t));
+    Cook_WriteLump(&writer, CW_LUMP_SURFACES,     surfaces,           mdl->num_surfaces * sizeof(dcw_surface_t));
+    Cook_WriteLump(&writer, CW_LUMP_POLYS,        polys,              num_polys * sizeof(dcw_poly_t));
+    Cook_WriteLump(&writer, CW_LUMP_POLYVERTS,    poly_verts,         num_poly_verts * sizeof(ps2_poly_vertex_t));
+    Cook_WriteLump(&writer, CW_LUMP_TRIANGLES,    triangles,          num_triangles * sizeof(ps2_mdl_triangle_t));
+    Cook_WriteLump(&writer, CW_LUMP_MARKSURFACES, mark_surfaces,      mdl->num_mark_surfaces * sizeof(int));
+    Cook_WriteLump(&writer, CW_LUMP_VISIBILITY,   mdl->vis,           (mdl->vis != NULL) ? vis_len : 0);
+    Cook_WriteLump(&writer, CW_LUMP_LEAFS,        leafs,              mdl->num_leafs * sizeof(dcw_leaf_t));
+    Cook_WriteLump(&writer, CW_LUMP_NODES,        nodes,              mdl->num_nodes * sizeof(dcw_node_t));
+    Cook_WriteLump(&writer, CW_LUMP_SUBMODELS,    mdl->submodels,     mdl->num_submodels * sizeof(ps2_mdl_submod_t));
+
+    writer.header.ident   = IDCOOKEDWORLDHEADER;
+    writer.header.version = COOKED_WORLD_VERSION;
+    writer.header.bsp_len = bsp_len;
+    writer.header.bsp_checksum = LittleLong(Com_BlockChecksum(bsp_data, bsp_len));
+
+    const long out_len = ftell(writer.file);
+    fseek(writer.file, 0, SEEK_SET);
+    fwrite(&writer.header, 1, sizeof(writer.header), writer.file);
+
+    const qboolean ok = !ferror(writer.file);
+    fclose(writer.file);
+
+    printf("%s: %d surfaces, %d triangles, %d KB -> %ld KB, loaded in %d ms\n", out_path,
+           mdl->num_surfaces, num_triangles, bsp_len / 1024, out_len / 1024, load_time);
+
+    free(texinfos);
+    free(surfaces);
+    free(polys);
+    free(poly_verts);
+    free(triangles);
+    free(mark_surfaces);
+    free(leafs);
+    free(nodes);
+    FS_FreeFile(bsp_data);
+    return ok;
+}
+
+int main(int argc, const char * argv[])
+{
+    if (argc < 3)
+    {
+        printf("Usage: \n"
+               " $ %s <game dir> <map> [<map> ...]\n"
+               "   Cooks <game dir>/maps/<map>.bsp into <game dir>/maps/<map>.pcw.\n"
+               "   Maps and textures are looked up in the game dir, then in its paks.\n",
+               argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    game_dir = argv[1];
+    Swap_Init();
+
+    ps2_builtin_tex_debug = &ps2ref.teximages[teximages_used++];
+    strcpy(ps2_builtin_tex_debug->name, "pics/debug.pcx");
+    ps2_builtin_tex_debug->type   = IT_BUILTIN;
+    ps2_builtin_tex_debug->width  = DEBUG_TEX_DIM;
+    ps2_builtin_tex_debug->height = DEBUG_TEX_DIM;
+
+    int i;
+    for (i = 2; i < argc; ++i)
+    {
+        // Always start from the .bsp, never from an older cooked file.
+        PS2_ModelInit();
+        Cvar_Get("r_ps2_cooked_world", "0", 0)->value = 0;
+
+        if (!Cook_World(argv[i]))
+        {
+            fprintf(stderr, "Unable to cook map %s!\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+
+        // One world at a time.
+        PS2_ModelShutdown();
+    }
+
+    // Success.
+    return EXIT_SUCCESS;
+}